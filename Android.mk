@@ -116,6 +116,7 @@ LOCAL_SRC_FILES := \
     device/src/HapticsDevProtection.cpp \
     session/src/Session.cpp \
     session/src/PayloadBuilder.cpp \
+    session/src/PayloadArena.cpp \
     session/src/SessionAlsaPcm.cpp \
     session/src/SessionAgm.cpp \
     session/src/SessionAlsaUtils.cpp \
@@ -129,6 +130,8 @@ LOCAL_SRC_FILES := \
     session/src/ACDEngine.cpp \
     resource_manager/src/ResourceManager.cpp \
     resource_manager/src/SndCardMonitor.cpp \
+    resource_manager/src/StreamHandleTable.cpp \
+    resource_manager/src/ActiveStreamIndex.cpp \
     utils/src/SoundTriggerPlatformInfo.cpp \
     utils/src/ACDPlatformInfo.cpp \
     utils/src/VoiceUIPlatformInfo.cpp \
@@ -136,7 +139,15 @@ LOCAL_SRC_FILES := \
     utils/src/SignalHandler.cpp \
     utils/src/AudioHapticsInterface.cpp \
     utils/src/MetadataParser.cpp \
-    utils/src/MemLogBuilder.cpp
+    utils/src/MemLogBuilder.cpp \
+    utils/src/XmlSnapshot.cpp \
+    utils/src/MixerCtlCache.cpp \
+    utils/src/BtCodecPluginCache.cpp \
+    utils/src/LatencyHistogram.cpp \
+    utils/src/Reactor.cpp \
+    utils/src/NullClock.cpp \
+    utils/src/PalTrace.cpp \
+    utils/src/DataPathStats.cpp
 
 LOCAL_HEADER_LIBRARIES := \
     libarpal_headers \
@@ -225,6 +236,28 @@ LOCAL_VENDOR_MODULE := true
 
 include $(BUILD_EXECUTABLE)
 
+include $(CLEAR_VARS)
+LOCAL_USE_VNDK := true
+
+LOCAL_CFLAGS += -Wno-tautological-compare
+LOCAL_CFLAGS += -Wno-macro-redefined
+
+LOCAL_SRC_FILES  := test/PalBenchmark.c \
+                    test/PalBenchmark_main.c
+
+LOCAL_MODULE               := PalBenchmark
+LOCAL_MODULE_OWNER         := qti
+LOCAL_MODULE_TAGS          := optional
+
+LOCAL_HEADER_LIBRARIES := \
+    libarpal_headers
+
+LOCAL_SHARED_LIBRARIES := \
+                          libpalclient
+LOCAL_VENDOR_MODULE := true
+
+include $(BUILD_EXECUTABLE)
+
 include $(CLEAR_VARS)
 
 include $(PAL_BASE_PATH)/plugins/Android.mk
@@ -74,6 +74,7 @@
 #include "Device.h"
 #include "ResourceManager.h"
 #include "PalCommon.h"
+#include "PalTrace.h"
 #include "mem_logger.h"
 class Stream;
 
@@ -208,6 +209,7 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
     int status = 0;
     struct pal_stream_attributes sAttr = {};
     std::shared_ptr<ResourceManager> rm = NULL;
+    PalTraceScope trace(PAL_TRACE_STREAM_OPEN);
 
     rm = ResourceManager::getInstance();
     if (!rm) {
@@ -262,9 +264,17 @@ int32_t pal_stream_open(struct pal_stream_attributes *attributes,
     if (cb)
        s->registerCallBack(cb, cookie);
 
-    rm->initStreamUserCounter(s);
+    status = rm->initStreamUserCounter(s);
+    if (0 != status) {
+        PAL_ERR(LOG_TAG, "failed to register stream handle, status %d", status);
+        notify_concurrent_stream(sAttr.type, sAttr.direction, false);
+        s->close();
+        delete s;
+        goto exit;
+    }
     stream = reinterpret_cast<uint64_t *>(s);
     *stream_handle = stream;
+    trace.setTag((uint64_t)stream);
 exit:
     PAL_INFO(LOG_TAG, "Exit. Value of stream_handle %pK, status %d", stream, status);
     kpiEnqueue(__func__, false);
@@ -292,15 +302,11 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         return status;
     }
 
-    rm->lockActiveStream();
     if (!rm->isActiveStream(stream_handle)) {
         status = -EINVAL;
-        rm->unlockActiveStream();
         return status;
     }
 
-    rm->unlockActiveStream();
-
     s = reinterpret_cast<Stream *>(stream_handle);
     s->setCachedState(STREAM_IDLE);
     status = s->close();
@@ -332,6 +338,7 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
     struct pal_stream_attributes sAttr = {};
     std::shared_ptr<ResourceManager> rm = NULL;
     int status;
+    PalTraceScope trace(PAL_TRACE_STREAM_START, (uint64_t)stream_handle);
     if (!stream_handle) {
         status = -EINVAL;
         PAL_ERR(LOG_TAG, "Invalid stream handle status %d", status);
@@ -354,20 +361,11 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
     }
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         goto exit;
     }
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
-        goto exit;
-    }
-    rm->unlockActiveStream();
 
     s->getStreamAttributes(&sAttr);
     if (sAttr.type == PAL_STREAM_VOICE_UI)
@@ -375,9 +373,7 @@ int32_t pal_stream_start(pal_stream_handle_t *stream_handle)
 
     status = s->start();
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream start failed. status %d", status);
@@ -411,27 +407,15 @@ int32_t pal_stream_stop(pal_stream_handle_t *stream_handle)
     kpiEnqueue(__func__, true);
 
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         goto exit;
     }
-
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
-        goto exit;
-    }
-    rm->unlockActiveStream();
     s->setCachedState(STREAM_STOPPED);
     status = s->stop();
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "stream stop failed. status : %d", status);
@@ -484,6 +468,68 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
     return status;
 }
 
+ssize_t pal_stream_write_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                               uint32_t no_of_bufs)
+{
+    Stream *s = NULL;
+    int status;
+    if (!stream_handle || !bufs || !no_of_bufs) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+        return status;
+    }
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK bufs %u", stream_handle, no_of_bufs);
+    s =  reinterpret_cast<Stream *>(stream_handle);
+    status = s->writeBatch(bufs, no_of_bufs);
+    if (status < 0) {
+        PAL_ERR(LOG_TAG, "stream write batch failed status %d", status);
+        return status;
+    }
+    PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
+    return status;
+}
+
+ssize_t pal_stream_read_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                              uint32_t no_of_bufs)
+{
+    Stream *s = NULL;
+    int status;
+    if (!stream_handle || !bufs || !no_of_bufs) {
+        status = -EINVAL;
+        PAL_ERR(LOG_TAG, "Invalid input parameters status %d", status);
+        return status;
+    }
+    PAL_VERBOSE(LOG_TAG, "Enter. Stream handle :%pK bufs %u", stream_handle, no_of_bufs);
+    s =  reinterpret_cast<Stream *>(stream_handle);
+    status = s->readBatch(bufs, no_of_bufs);
+    if (status < 0) {
+        PAL_ERR(LOG_TAG, "stream read batch failed status %d", status);
+        return status;
+    }
+    PAL_VERBOSE(LOG_TAG, "Exit. status %d", status);
+    return status;
+}
+
+/* common to all stream types, the payload is freed by the caller */
+static int32_t get_data_path_stats(Stream *s, pal_param_payload **param_payload)
+{
+    pal_param_payload *payload = NULL;
+
+    if (!param_payload)
+        return -EINVAL;
+
+    payload = (pal_param_payload *)calloc(1, sizeof(pal_param_payload) +
+                                          sizeof(pal_stream_data_path_stats_t));
+    if (!payload) {
+        PAL_ERR(LOG_TAG, "failed to allocate data path stats");
+        return -ENOMEM;
+    }
+    payload->payload_size = sizeof(pal_stream_data_path_stats_t);
+    s->getDataPathStats()->getStats((pal_stream_data_path_stats_t *)payload->payload);
+    *param_payload = payload;
+    return 0;
+}
+
 int32_t pal_stream_get_param(pal_stream_handle_t *stream_handle,
                              uint32_t param_id, pal_param_payload **param_payload)
 {
@@ -504,7 +550,10 @@ int32_t pal_stream_get_param(pal_stream_handle_t *stream_handle,
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
     kpiEnqueue(__func__, true);
     s =  reinterpret_cast<Stream *>(stream_handle);
-    status = s->getParameters(param_id, (void **)param_payload);
+    if (param_id == PAL_PARAM_ID_STREAM_DATA_PATH_STATS)
+        status = get_data_path_stats(s, param_payload);
+    else
+        status = s->getParameters(param_id, (void **)param_payload);
     if (0 != status) {
         PAL_ERR(LOG_TAG, "get parameters failed status %d param_id %u", status, param_id);
         kpiEnqueue(__func__, false);
@@ -576,29 +625,17 @@ int32_t pal_stream_set_volume(pal_stream_handle_t *stream_handle,
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         return status;
     }
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
-        return status;
-    }
-    rm->unlockActiveStream();
-
     s->lockStreamMutex();
     status = s->setVolume(volume);
     s->unlockStreamMutex();
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "setVolume failed with status %d", status);
@@ -632,26 +669,14 @@ int32_t pal_stream_set_mute(pal_stream_handle_t *stream_handle, bool state)
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         goto exit;
     }
-
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
-        goto exit;
-    }
-    rm->unlockActiveStream();
     status = s->mute(state);
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "mute failed with status %d", status);
@@ -754,27 +779,15 @@ int32_t pal_stream_drain(pal_stream_handle_t *stream_handle, pal_drain_type_t ty
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
         status = -EINVAL;
         goto exit;
     }
 
-    s =  reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
-        goto exit;
-    }
-    rm->unlockActiveStream();
-
     status = s->drain(type);
 
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "drain failed with status %d", status);
@@ -911,14 +924,13 @@ int32_t pal_get_timestamp(pal_stream_handle_t *stream_handle,
     PAL_DBG(LOG_TAG, "Enter. Stream handle :%pK\n", stream_handle);
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (rm->isActiveStream(stream_handle)) {
-        s =  reinterpret_cast<Stream *>(stream_handle);
+    s = rm->acquireStream(stream_handle);
+    if (s) {
         status = s->getTimestamp(stime);
+        rm->decreaseStreamUserCounter(s);
     } else {
         PAL_ERR(LOG_TAG, "stream handle in stale state.\n");
     }
-    rm->unlockActiveStream();
 
     if (0 != status) {
         PAL_ERR(LOG_TAG, "pal_get_timestamp failed with status %d\n", status);
@@ -982,6 +994,7 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     struct pal_device *pDevices = NULL;
     struct pal_device curPalDevAttr;
     std::vector <std::shared_ptr<Device>> aDevices, palDevices;
+    PalTraceScope trace(PAL_TRACE_STREAM_SET_DEVICE, (uint64_t)stream_handle);
 
     if (!stream_handle) {
         status = -EINVAL;
@@ -1005,23 +1018,13 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     PAL_INFO(LOG_TAG, "Enter. Stream handle :%pK", stream_handle);
     kpiEnqueue(__func__, true);
 
-    rm->lockActiveStream();
-    if (!rm->isActiveStream(stream_handle)) {
-        rm->unlockActiveStream();
-        status = -EINVAL;
-        return status;
-    }
-
     /* Choose best device config for this stream */
     /* TODO: Decide whether to update device config or not based on flag */
-    s = reinterpret_cast<Stream *>(stream_handle);
-    status = rm->increaseStreamUserCounter(s);
-    if (0 != status) {
-        rm->unlockActiveStream();
-        PAL_ERR(LOG_TAG, "failed to increase stream user count");
+    s = rm->acquireStream(stream_handle);
+    if (!s) {
+        status = -EINVAL;
         return status;
     }
-    rm->unlockActiveStream();
 
     s->getStreamAttributes(&sattr);
 
@@ -1155,9 +1158,7 @@ int32_t pal_stream_set_device(pal_stream_handle_t *stream_handle,
     }
 
 exit:
-    rm->lockActiveStream();
     rm->decreaseStreamUserCounter(s);
-    rm->unlockActiveStream();
     if (pDevices)
         free(pDevices);
     PAL_INFO(LOG_TAG, "Exit. status %d", status);
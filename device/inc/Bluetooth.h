@@ -156,7 +156,6 @@ protected:
     struct pal_media_config    codecConfig;
     codec_format_t             codecFormat;
     void                       *codecInfo;
-    void                       *pluginHandler;
     bt_codec_t                 *pluginCodec;
     bool                       isAbrEnabled;
     bool                       isConfigured;
@@ -175,8 +174,7 @@ protected:
 
     int32_t getPCMId();
     int checkAndUpdateCustomPayload(uint8_t **paramData, size_t *paramSize);
-    int getPluginPayload(void **handle, bt_codec_t **btCodec,
-                         bt_enc_payload_t **out_buf,
+    int getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
                          codec_type codecType);
     int configureCOPModule(int32_t pcmId, const char *backendName, uint32_t tagId, uint32_t streamMapDir, bool isFbpayload);
     int configureRATModule(int32_t pcmId, const char *backendName, uint32_t tagId, bool isFbpayload);
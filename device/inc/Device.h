@@ -104,6 +104,13 @@ protected:
     uint32_t mSampleRate = 0;
     uint32_t mBitWidth = 0;
 
+    /*
+     * Serializes getInstance/getObject, the per type singletons are created
+     * lazily and without a lock of their own. Recursive because creating a
+     * device may look up another one.
+     */
+    static std::recursive_mutex mInstanceLock;
+
     Device(struct pal_device *device, std::shared_ptr<ResourceManager> Rm);
     Device();
     int32_t configureDeviceClockSrc(char const *mixerStrClockSrc, const uint32_t clockSrc);
@@ -39,6 +39,8 @@
 #include "Stream.h"
 #include "Session.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
+#include "BtCodecPluginCache.h"
 #include "Device.h"
 #include "kvh2xml.h"
 #include <dlfcn.h>
@@ -87,7 +89,7 @@ int Bluetooth::updateDeviceMetadata()
     struct mixer_ctl *ctrl = NULL;
 
     if (ResourceManager::isXPANEnabled) {
-        ctrl = mixer_get_ctl_by_name(hwMixerHandle,
+        ctrl = MixerCtlCache::getCtl(hwMixerHandle,
                                      MIXER_SET_CODEC_TYPE);
         if (!ctrl) {
             PAL_ERR(LOG_TAG, "ERROR %s mixer control not identified",
@@ -182,14 +184,10 @@ bool Bluetooth::isPlaceholderEncoder()
     }
 }
 
-int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
-              bt_enc_payload_t **out_buf, codec_type codecType)
+int Bluetooth::getPluginPayload(bt_codec_t **btCodec, bt_enc_payload_t **out_buf,
+                                codec_type codecType)
 {
     std::string lib_path;
-    open_fn_t plugin_open_fn = NULL;
-    int status = 0;
-    bt_codec_t *codec = NULL;
-    void *handle = NULL;
 
     lib_path = rm->getBtCodecLib(codecFormat, (codecType == ENC ? "enc" : "dec"));
     if (lib_path.empty()) {
@@ -197,42 +195,8 @@ int Bluetooth::getPluginPayload(void **libHandle, bt_codec_t **btCodec,
         return -ENOSYS;
     }
 
-    handle = dlopen(lib_path.c_str(), RTLD_NOW);
-    if (handle == NULL) {
-        PAL_ERR(LOG_TAG, "failed to dlopen lib %s. Error: %s", lib_path.c_str(), dlerror());
-        return -EINVAL;
-    }
-
-    plugin_open_fn = (open_fn_t)dlsym(handle, "plugin_open");
-    if (!plugin_open_fn) {
-        PAL_ERR(LOG_TAG, "dlsym to open fn failed, err = '%s'", dlerror());
-        status = -EINVAL;
-        goto error;
-    }
-
-    status = plugin_open_fn(&codec, codecFormat, codecType);
-    if (status) {
-        PAL_ERR(LOG_TAG, "failed to open plugin %d", status);
-        goto error;
-    }
-
-    status = codec->plugin_populate_payload(codec, codecInfo, (void **)out_buf);
-    if (status != 0) {
-        PAL_ERR(LOG_TAG, "fail to pack the encoder config %d", status);
-        goto error;
-    }
-    *btCodec = codec;
-    *libHandle = handle;
-    goto done;
-
-error:
-    if (codec)
-        codec->close_plugin(codec);
-
-    if (handle)
-        dlclose(handle);
-done:
-    return status;
+    return BtCodecPluginCache::getCodec(lib_path, codecFormat, codecType, codecInfo,
+                                        btCodec, out_buf);
 }
 
 int Bluetooth::checkAndUpdateCustomPayload(uint8_t **paramData, size_t *paramSize)
@@ -475,10 +439,16 @@ int Bluetooth::configureGraphModules()
     stream = static_cast<Stream *>(activestreams[0]);
     stream->getAssociatedSession(&session);
 
+    /* a reconfigure replaces the codec of the previous config */
+    if (pluginCodec) {
+        BtCodecPluginCache::putCodec(pluginCodec);
+        pluginCodec = NULL;
+    }
+
     /* Retrieve plugin library from resource manager.
      * Map to interested symbols.
      */
-    status = getPluginPayload(&pluginHandler, &pluginCodec, &out_buf, codecType);
+    status = getPluginPayload(&pluginCodec, &out_buf, codecType);
     if (status) {
         PAL_ERR(LOG_TAG, "failed to payload from plugin");
         goto error;
@@ -806,7 +776,6 @@ void Bluetooth::startAbr()
     std::ostringstream disconnectCtrlName;
     unsigned int flags;
     uint32_t tagId = 0, miid = 0, streamMapDir = 0;
-    void *pluginLibHandle = NULL;
     bt_codec_t *codec = NULL;
     bt_enc_payload_t *out_buf = NULL;
     custom_block_t *blk = NULL;
@@ -907,13 +876,14 @@ void Bluetooth::startAbr()
     }
 
     connectCtrlName << "PCM" << fbpcmDevIds.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtualMixerHandle, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtualMixerHandle, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
 
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
                 connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -922,7 +892,7 @@ void Bluetooth::startAbr()
 
     // Notify ABR usecase information to BT driver to distinguish
     // between SCO and feedback usecase
-    btSetFeedbackChannelCtrl = mixer_get_ctl_by_name(hwMixerHandle,
+    btSetFeedbackChannelCtrl = MixerCtlCache::getCtl(hwMixerHandle,
                                         MIXER_SET_FEEDBACK_CHANNEL);
     if (!btSetFeedbackChannelCtrl) {
         PAL_ERR(LOG_TAG, "ERROR %s mixer control not identified",
@@ -975,7 +945,7 @@ void Bluetooth::startAbr()
             break;
         }
 
-        ret = getPluginPayload(&pluginLibHandle, &codec, &out_buf, (codecType == DEC ? ENC : DEC));
+        ret = getPluginPayload(&codec, &out_buf, (codecType == DEC ? ENC : DEC));
         if (ret) {
             PAL_ERR(LOG_TAG, "getPluginPayload failed");
             goto disconnect_fe;
@@ -984,6 +954,7 @@ void Bluetooth::startAbr()
         /* SWB Encoder/Decoder has only 1 param, read block 0 */
         if (out_buf->num_blks != 1) {
             PAL_ERR(LOG_TAG, "incorrect block size %d", out_buf->num_blks);
+            BtCodecPluginCache::putCodec(codec);
             goto disconnect_fe;
         }
         fbDev->codecConfig.sample_rate = out_buf->sample_rate;
@@ -995,8 +966,7 @@ void Bluetooth::startAbr()
         builder->payloadCustomParam(&paramData, &paramSize,
                   (uint32_t *)blk->payload, blk->payload_sz, miid, blk->param_id);
 
-        codec->close_plugin(codec);
-        dlclose(pluginLibHandle);
+        BtCodecPluginCache::putCodec(codec);
 
         if (!paramData) {
             PAL_ERR(LOG_TAG, "Failed to populateAPMHeader");
@@ -1111,9 +1081,10 @@ err_pcm_open:
     fbPcm = NULL;
 disconnect_fe:
     disconnectCtrlName << "PCM" << fbpcmDevIds.at(0) << " disconnect";
-    disconnectCtrl = mixer_get_ctl_by_name(virtualMixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = MixerCtlCache::getCtl(virtualMixerHandle, disconnectCtrlName.str().data());
     if(disconnectCtrl != NULL){
        mixer_ctl_set_enum_by_string(disconnectCtrl, backEndName.c_str());
+       SessionAlsaUtils::invalidateMiidCache();
     }
 free_fe:
     rm->freeFrontEndIds(fbpcmDevIds, sAttr, dir);
@@ -1170,7 +1141,7 @@ void Bluetooth::stopAbr()
     fbPcm = NULL;
 
     // Reset BT driver mixer control for ABR usecase
-    btSetFeedbackChannelCtrl = mixer_get_ctl_by_name(hwMixerHandle,
+    btSetFeedbackChannelCtrl = MixerCtlCache::getCtl(hwMixerHandle,
                                         MIXER_SET_FEEDBACK_CHANNEL);
     if (!btSetFeedbackChannelCtrl) {
         PAL_ERR(LOG_TAG, "%s mixer control not identified",
@@ -1288,7 +1259,6 @@ BtA2dp::BtA2dp(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
 {
     a2dpRole = ((device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) || (device->id == PAL_DEVICE_IN_BLUETOOTH_BLE)) ? SINK : SOURCE;
     codecType = ((device->id == PAL_DEVICE_IN_BLUETOOTH_A2DP) || (device->id == PAL_DEVICE_IN_BLUETOOTH_BLE)) ? DEC : ENC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 
     param_bt_a2dp.reconfig = false;
@@ -1834,13 +1804,9 @@ int BtA2dp::stopPlayback()
         }
 
         if (pluginCodec) {
-            pluginCodec->close_plugin(pluginCodec);
+            BtCodecPluginCache::putCodec(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
 
     PAL_DBG(LOG_TAG, "Stop A2DP playback, total active sessions :%d",
@@ -2032,13 +1998,9 @@ int BtA2dp::stopCapture()
         param_bt_a2dp.latency = 0;
 
         if (pluginCodec) {
-            pluginCodec->close_plugin(pluginCodec);
+            BtCodecPluginCache::putCodec(pluginCodec);
             pluginCodec = NULL;
         }
-        if (pluginHandler) {
-            dlclose(pluginHandler);
-            pluginHandler = NULL;
-        }
     }
     PAL_DBG(LOG_TAG, "Stop A2DP capture, total active sessions :%d",
             totalActiveSessionRequests);
@@ -2501,7 +2463,6 @@ BtSco::BtSco(struct pal_device *device, std::shared_ptr<ResourceManager> Rm)
     : Bluetooth(device, Rm)
 {
     codecType = (device->id == PAL_DEVICE_OUT_BLUETOOTH_SCO) ? ENC : DEC;
-    pluginHandler = NULL;
     pluginCodec = NULL;
 }
 
@@ -2787,13 +2748,9 @@ int BtSco::stop()
         stopAbr();
 
     if (pluginCodec) {
-        pluginCodec->close_plugin(pluginCodec);
+        BtCodecPluginCache::putCodec(pluginCodec);
         pluginCodec = NULL;
     }
-    if (pluginHandler) {
-        dlclose(pluginHandler);
-        pluginHandler = NULL;
-    }
 
     Device::stop_l();
     if (isAbrEnabled == false)
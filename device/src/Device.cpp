@@ -66,6 +66,7 @@
 #include <tinyalsa/asoundlib.h>
 #include "ResourceManager.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "Device.h"
 #include "Speaker.h"
 #include "SpeakerProtection.h"
@@ -92,6 +93,8 @@
 #define MAX_CHANNEL_SUPPORTED 2
 #define DEFAULT_OUTPUT_SAMPLING_RATE 48000
 
+std::recursive_mutex Device::mInstanceLock;
+
 std::shared_ptr<Device> Device::getInstance(struct pal_device *device,
                                                  std::shared_ptr<ResourceManager> Rm)
 {
@@ -100,6 +103,7 @@ std::shared_ptr<Device> Device::getInstance(struct pal_device *device,
         return NULL;
     }
 
+    std::lock_guard<std::recursive_mutex> lock(mInstanceLock);
     PAL_VERBOSE(LOG_TAG, "Enter device id %d", device->id);
 
     //TBD: decide on supported devices from XML and not in code
@@ -211,6 +215,7 @@ std::shared_ptr<Device> Device::getInstance(struct pal_device *device,
 
 std::shared_ptr<Device> Device::getObject(pal_device_id_t dev_id)
 {
+    std::lock_guard<std::recursive_mutex> lock(mInstanceLock);
 
     switch(dev_id) {
     case PAL_DEVICE_NONE:
@@ -676,7 +681,7 @@ int32_t Device::configureDeviceClockSrc(char const *mixerStrClockSrc, const uint
     /* Hw mixer control registration is optional in case
      * clock source selection is not required
      */
-    clockSrcCtrl = mixer_get_ctl_by_name(hwMixerHandle, mixerStrClockSrc);
+    clockSrcCtrl = MixerCtlCache::getCtl(hwMixerHandle, mixerStrClockSrc);
     if (!clockSrcCtrl) {
         PAL_DBG(LOG_TAG, "%s hw mixer control not identified", mixerStrClockSrc);
         goto exit;
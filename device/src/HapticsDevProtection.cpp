@@ -39,6 +39,7 @@
 #include "PalAudioRoute.h"
 #include "ResourceManager.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "kvh2xml.h"
 #include <agm/agm_api.h>
 
@@ -218,7 +219,7 @@ int HapticsDevProtection::getDevTemperature(int haptics_dev_pos)
 
     PAL_DBG(LOG_TAG, "audio_mixer %pK", hwMixer);
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
+    ctl = MixerCtlCache::getCtl(hwMixer, mixer_ctl_name.c_str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_ctl_name.c_str());
         status = -EINVAL;
@@ -255,7 +256,7 @@ void HapticsDevProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlNameBe<< backEndName << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, disconnectCtrlNameBe.str().data());
     if (!beMetaDataMixerCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control %s", ret, backEndName.c_str());
@@ -265,6 +266,7 @@ void HapticsDevProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     }else {
@@ -273,13 +275,14 @@ void HapticsDevProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlName << "PCM" << pcmDevIds.at(0) << " disconnect";
-    disconnectCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlName.str().data());
+    disconnectCtrl = MixerCtlCache::getCtl(virtMixer, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control: %s", ret, disconnectCtrlName.str().data());
         goto exit;
     }
     ret = mixer_ctl_set_enum_by_string(disconnectCtrl, backEndName.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Error: %d, Mixer control %s set with %s failed", ret,
         disconnectCtrlName.str().data(), backEndName.c_str());
@@ -425,7 +428,7 @@ int HapticsDevProtection::HapticsDevStartCalibration()
     }
 
     connectCtrlNameBeVI<< backEndNameTx << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBeVI.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameBeVI.str().data());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndNameTx.c_str());
         ret = -EINVAL;
@@ -435,6 +438,7 @@ int HapticsDevProtection::HapticsDevStartCalibration()
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     }
@@ -461,12 +465,13 @@ int HapticsDevProtection::HapticsDevStartCalibration()
     }
 
     connectCtrlName << "PCM" << pcmDevIdsTx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameTx.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlName.str().data(), backEndNameTx.c_str(), ret);
@@ -690,7 +695,7 @@ int HapticsDevProtection::HapticsDevStartCalibration()
 
     connectCtrlNameBe<< backEndNameRx << " metadata";
 
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameBe.str().data());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", backEndNameRx.c_str());
         ret = -EINVAL;
@@ -700,6 +705,7 @@ int HapticsDevProtection::HapticsDevStartCalibration()
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     }
@@ -727,13 +733,14 @@ int HapticsDevProtection::HapticsDevStartCalibration()
     }
 
     connectCtrlNameRx << "PCM" << pcmDevIdsRx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameRx.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameRx.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlNameRx.str().data());
         ret = -ENOSYS;
         goto err_pcm_open;
     }
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameRx.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlNameRx.str().data(), backEndNameRx.c_str(), ret);
@@ -1266,7 +1273,7 @@ int32_t HapticsDevProtection::HapticsDevProtProcessingMode(bool flag)
             goto exit;
         }
         connectCtrlNameBeVI<< backEndName << " metadata";
-        beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer,
+        beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer,
                                     connectCtrlNameBeVI.str().data());
         if (!beMetaDataMixerCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndName.c_str());
@@ -1277,6 +1284,7 @@ int32_t HapticsDevProtection::HapticsDevProtProcessingMode(bool flag)
         if (deviceMetaData.size) {
             ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
+            SessionAlsaUtils::invalidateMiidCache();
             free(deviceMetaData.buf);
             deviceMetaData.buf = nullptr;
         }
@@ -1304,13 +1312,14 @@ int32_t HapticsDevProtection::HapticsDevProtProcessingMode(bool flag)
         }
 
         connectCtrlName << "PCM" << pcmDevIdTx.at(0) << " connect";
-        connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+        connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlName.str().data());
         if (!connectCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
             goto free_fe;
         }
 
         ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+        SessionAlsaUtils::invalidateMiidCache();
         if (ret) {
             PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
             connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -1684,7 +1693,7 @@ int32_t HapticsDevProtection::getAndsetPersistentParameter(bool flag)
         goto exit;
     }
 
-    ctl = mixer_get_ctl_by_name(virtMixer, cntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(virtMixer, cntrlName.str().data());
     if (!ctl) {
         status = -ENOENT;
         PAL_ERR(LOG_TAG, "Error: %d Invalid mixer control: %s\n", status,cntrlName.str().data());
@@ -68,6 +68,7 @@
 #include "PalAudioRoute.h"
 #include "ResourceManager.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "kvh2xml.h"
 #include <agm/agm_api.h>
 
@@ -287,7 +288,7 @@ void SpeakerProtection::handleSPCallback (uint64_t hdl __unused, uint32_t event_
     case EVENT_ID_SPv5_SPEAKER_DIAGNOSTICS:
         struct mixer_ctl *ctl;
 
-        ctl = mixer_get_ctl_by_name(hwMixer, SPKR_LEFT_WSA_DC_DET);
+        ctl = MixerCtlCache::getCtl(hwMixer, SPKR_LEFT_WSA_DC_DET);
         diag_data = (param_id_sp_vi_spkr_diag_getpkt_param_t *) event_data;
         if (diag_data->num_ch == 1) {
                 PAL_DBG(LOG_TAG, "Calibration state %d", diag_data->spkr_cond[0]);
@@ -296,7 +297,7 @@ void SpeakerProtection::handleSPCallback (uint64_t hdl __unused, uint32_t event_
                     PAL_ERR(LOG_TAG, "OVERTEMP detected on Spkr Right");
 
                 if (diag_data->spkr_cond[0] == SPKR_DC) {
-                    ctl = mixer_get_ctl_by_name(hwMixer, SPKR_RIGHT_WSA_DC_DET);
+                    ctl = MixerCtlCache::getCtl(hwMixer, SPKR_RIGHT_WSA_DC_DET);
                     if (!ctl) {
                          PAL_ERR(LOG_TAG, "invalid mixer control for DC : %s", SPKR_RIGHT_WSA_DC_DET);
                          return;
@@ -312,7 +313,7 @@ void SpeakerProtection::handleSPCallback (uint64_t hdl __unused, uint32_t event_
                      PAL_ERR(LOG_TAG, "OVERTEMP detected on Spkr Left");
 
                  if (diag_data->spkr_cond[0] == SPKR_DC) {
-                     ctl = mixer_get_ctl_by_name(hwMixer, SPKR_LEFT_WSA_DC_DET);
+                     ctl = MixerCtlCache::getCtl(hwMixer, SPKR_LEFT_WSA_DC_DET);
                      if (!ctl) {
                          PAL_ERR(LOG_TAG, "invalid mixer control for DC : %s", SPKR_LEFT_WSA_DC_DET);
                          goto spkr_right;
@@ -325,7 +326,7 @@ spkr_right:
                      PAL_ERR(LOG_TAG, "OVERTEMP detected on Spkr Right");
 
                  if (diag_data->spkr_cond[1] == SPKR_DC) {
-                     ctl = mixer_get_ctl_by_name(hwMixer, SPKR_RIGHT_WSA_DC_DET);
+                     ctl = MixerCtlCache::getCtl(hwMixer, SPKR_RIGHT_WSA_DC_DET);
                      if (!ctl) {
                          PAL_ERR(LOG_TAG, "invalid mixer control for DC : %s", SPKR_RIGHT_WSA_DC_DET);
                          return;
@@ -350,7 +351,7 @@ int SpeakerProtection::getCpsDevNumber(std::string mixer_name)
     PAL_DBG(LOG_TAG, "Mixer control %s", mixer_name.c_str());
     PAL_DBG(LOG_TAG, "audio_hw_mixer %pK", hwMixer);
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_name.c_str());
+    ctl = MixerCtlCache::getCtl(hwMixer, mixer_name.c_str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_name.c_str());
         status = -ENOENT;
@@ -381,7 +382,7 @@ int SpeakerProtection::getSpeakerTemperature(int spkr_pos)
 
     PAL_DBG(LOG_TAG, "audio_mixer %pK", hwMixer);
 
-    ctl = mixer_get_ctl_by_name(hwMixer, mixer_ctl_name.c_str());
+    ctl = MixerCtlCache::getCtl(hwMixer, mixer_ctl_name.c_str());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_ctl_name.c_str());
         status = -EINVAL;
@@ -418,7 +419,7 @@ void SpeakerProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlNameBe<< backEndName << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, disconnectCtrlNameBe.str().data());
     if (!beMetaDataMixerCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control %s", ret, backEndName.c_str());
@@ -426,13 +427,14 @@ void SpeakerProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     }
 
     disconnectCtrlName << "PCM" << pcmDevIds.at(0) << " disconnect";
-    disconnectCtrl = mixer_get_ctl_by_name(virtMixer, disconnectCtrlName.str().data());
+    disconnectCtrl = MixerCtlCache::getCtl(virtMixer, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         ret = -EINVAL;
         PAL_ERR(LOG_TAG, "Error: %d, invalid mixer control: %s", ret, disconnectCtrlName.str().data());
         goto exit;
     }
     ret = mixer_ctl_set_enum_by_string(disconnectCtrl, backEndName.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Error: %d, Mixer control %s set with %s failed", ret,
         disconnectCtrlName.str().data(), backEndName.c_str());
@@ -441,6 +443,7 @@ void SpeakerProtection::disconnectFeandBe(std::vector<int> pcmDevIds,
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     } else {
@@ -589,7 +592,7 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlNameBeVI<< backEndNameTx << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBeVI.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameBeVI.str().data());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s", backEndNameTx.c_str());
         ret = -EINVAL;
@@ -599,6 +602,7 @@ int SpeakerProtection::spkrStartCalibration()
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     }
@@ -625,12 +629,13 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlName << "PCM" << pcmDevIdsTx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameTx.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlName.str().data(), backEndNameTx.c_str(), ret);
@@ -856,7 +861,7 @@ int SpeakerProtection::spkrStartCalibration()
 
     connectCtrlNameBe<< backEndNameRx << " metadata";
 
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameBe.str().data());
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameBe.str().data());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", backEndNameRx.c_str());
         ret = -EINVAL;
@@ -866,6 +871,7 @@ int SpeakerProtection::spkrStartCalibration()
     if (deviceMetaData.size) {
         ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
+        SessionAlsaUtils::invalidateMiidCache();
         free(deviceMetaData.buf);
         deviceMetaData.buf = nullptr;
     }
@@ -893,13 +899,14 @@ int SpeakerProtection::spkrStartCalibration()
     }
 
     connectCtrlNameRx << "PCM" << pcmDevIdsRx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlNameRx.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlNameRx.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlNameRx.str().data());
         ret = -ENOSYS;
         goto err_pcm_open;
     }
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndNameRx.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlNameRx.str().data(), backEndNameRx.c_str(), ret);
@@ -1580,7 +1587,7 @@ int SpeakerProtection::viTxSetupThreadLoop()
     }
 
     connectCtrlNameBeVI<< backEndName << " metadata";
-    beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer,
+    beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer,
                                 connectCtrlNameBeVI.str().data());
     if (!beMetaDataMixerCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control for VI : %s",
@@ -1597,6 +1604,7 @@ int SpeakerProtection::viTxSetupThreadLoop()
 
     ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
                 deviceMetaData.size);
+    SessionAlsaUtils::invalidateMiidCache();
     free(deviceMetaData.buf);
     deviceMetaData.buf = nullptr;
 
@@ -1618,13 +1626,14 @@ int SpeakerProtection::viTxSetupThreadLoop()
     }
 
     connectCtrlName << "PCM" << pcmDevIdTx.at(0) << " connect";
-    connectCtrl = mixer_get_ctl_by_name(virtMixer, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(virtMixer, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         goto free_fe;
     }
 
     ret = mixer_ctl_set_enum_by_string(connectCtrl, backEndName.c_str());
+    SessionAlsaUtils::invalidateMiidCache();
     if (ret) {
         PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
         connectCtrlName.str().data(), backEndName.c_str(), ret);
@@ -2187,7 +2196,7 @@ cps_dev_setup:
             goto err_pcm_open;
         }
         connectCtrlNameBeCPS<< backEndNameCPS << " metadata";
-        beMetaDataMixerCtrl = mixer_get_ctl_by_name(virtMixer,
+        beMetaDataMixerCtrl = MixerCtlCache::getCtl(virtMixer,
                                     connectCtrlNameBeCPS.str().data());
         if (!beMetaDataMixerCtrl) {
             PAL_ERR(LOG_TAG, "invalid mixer control for CPS : %s", backEndNameCPS.c_str());
@@ -2198,6 +2207,7 @@ cps_dev_setup:
         if (deviceMetaData.size) {
             ret = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
+            SessionAlsaUtils::invalidateMiidCache();
             free(deviceMetaData.buf);
             deviceMetaData.buf = nullptr;
         }
@@ -2225,7 +2235,7 @@ cps_dev_setup:
         }
 
         connectCtrlNameCPS << "PCM" << pcmDevIdCPS.at(0) << " connect";
-        connectCtrl2 = mixer_get_ctl_by_name(virtMixer, connectCtrlNameCPS.str().data());
+        connectCtrl2 = MixerCtlCache::getCtl(virtMixer, connectCtrlNameCPS.str().data());
 
         if (!connectCtrl2) {
             PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlNameCPS.str().data());
@@ -2233,6 +2243,7 @@ cps_dev_setup:
         }
 
         ret = mixer_ctl_set_enum_by_string(connectCtrl2, backEndNameCPS.c_str());
+        SessionAlsaUtils::invalidateMiidCache();
         if (ret) {
             PAL_ERR(LOG_TAG, "Mixer control %s set with %s failed: %d",
             connectCtrlNameCPS.str().data(), backEndNameCPS.c_str(), ret);
@@ -2581,7 +2592,7 @@ int32_t SpeakerProtection::getFTMParameter(void **param)
         goto exit;
     }
 
-    ctl = mixer_get_ctl_by_name(virtMixer, cntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(virtMixer, cntrlName.str().data());
     if (!ctl) {
         status = -ENOENT;
         PAL_ERR(LOG_TAG, "Error: %d Invalid mixer control: %s\n", status,cntrlName.str().data());
@@ -331,6 +331,38 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
   */
 ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *buf);
 
+/**
+  * Read several audio buffers of a stream in one call. The stream lock
+  * and stream attributes are taken once for the whole batch and the
+  * buffers are filled back to back.
+  *
+  * \param[in] stream_handle - Valid stream handle obtained
+  *       from pal_stream_open
+  * \param[in] bufs - array of no_of_bufs pal_buffers to fill.
+  * \param[in] no_of_bufs - number of buffers in bufs.
+  *
+  * \return - total number of bytes read, or error code if no
+  *       buffer could be read.
+  */
+ssize_t pal_stream_read_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                              uint32_t no_of_bufs);
+
+/**
+  * Write several audio buffers of a stream in one call. The stream lock
+  * and stream attributes are taken once for the whole batch and all
+  * periods are submitted in a single pass.
+  *
+  * \param[in] stream_handle - Valid stream handle obtained
+  *       from pal_stream_open
+  * \param[in] bufs - array of no_of_bufs pal_buffers to render.
+  * \param[in] no_of_bufs - number of buffers in bufs.
+  *
+  * \return - total number of bytes written, or error code if no
+  *       buffer could be written.
+  */
+ssize_t pal_stream_write_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                               uint32_t no_of_bufs);
+
 /**
   * \brief get current device on stream.
   *
@@ -1048,6 +1048,9 @@ typedef enum {
     PAL_PARAM_ID_LATENCY_MODE = 73,
     PAL_PARAM_ID_PROXY_RECORD_SESSION = 74,
     PAL_PARAM_ID_ULTRASOUND_SET_GAIN = 75,
+    PAL_PARAM_ID_LATENCY_STATS = 76,
+    PAL_PARAM_ID_LATENCY_TRACE = 77,
+    PAL_PARAM_ID_STREAM_DATA_PATH_STATS = 78,
 } pal_param_id_type_t;
 
 /** HDMI/DP */
@@ -1289,6 +1292,75 @@ typedef struct pal_param_latency_mode {
     uint32_t        modes[PAL_MAX_LATENCY_MODES]; /* list of supported modes or use mode[0] for set latency mode */
 } pal_param_latency_mode_t;
 
+#define PAL_LATENCY_STAT_NAME_LEN 32
+#define PAL_MAX_LATENCY_STATS 32
+#define PAL_MAX_TRACE_EVENTS 512
+
+#define PAL_MAX_CACHE_STATS 8
+
+/* Payload For ID: PAL_PARAM_ID_LATENCY_STATS
+ * Description   : Latency distribution of each traced phase of stream
+ *                 open/start/set_device and device switch, since boot,
+ *                 and the hit/miss counters of PAL's lookup caches.
+ *                 Allocated by PAL, to be freed by the caller.
+*/
+typedef struct pal_latency_stat {
+    char     name[PAL_LATENCY_STAT_NAME_LEN];
+    uint64_t count;
+    uint64_t min_us;
+    uint64_t mean_us;
+    uint64_t p50_us; /* percentiles are power of two bucket bounds */
+    uint64_t p90_us;
+    uint64_t p99_us;
+    uint64_t max_us;
+} pal_latency_stat_t;
+
+typedef struct pal_cache_stat {
+    char     name[PAL_LATENCY_STAT_NAME_LEN];
+    uint64_t hits;
+    uint64_t misses;
+} pal_cache_stat_t;
+
+typedef struct pal_param_latency_stats {
+    uint32_t           num_stats;
+    pal_latency_stat_t stats[PAL_MAX_LATENCY_STATS]; /* indexed by phase */
+    uint32_t           num_caches;
+    pal_cache_stat_t   caches[PAL_MAX_CACHE_STATS];
+} pal_param_latency_stats_t;
+
+/* Payload For ID: PAL_PARAM_ID_LATENCY_TRACE
+ * Description   : Most recent traced phases of all threads, oldest first.
+ *                 Allocated by PAL, to be freed by the caller.
+*/
+typedef struct pal_trace_event {
+    uint64_t start_ns;    /* CLOCK_MONOTONIC */
+    uint64_t duration_ns;
+    uint64_t tag;         /* stream handle or 0 */
+    uint32_t phase;       /* index into pal_param_latency_stats_t stats */
+    uint32_t tid;
+} pal_trace_event_t;
+
+typedef struct pal_param_latency_trace {
+    uint32_t          num_events;
+    pal_trace_event_t events[PAL_MAX_TRACE_EVENTS];
+} pal_param_latency_trace_t;
+
+/* Payload For ID: PAL_PARAM_ID_STREAM_DATA_PATH_STATS
+ * Description   : Read/write path counters of a stream since it was opened.
+ *                 Returned in a pal_param_payload allocated by PAL, to be
+ *                 freed by the caller.
+*/
+typedef struct pal_stream_data_path_stats {
+    uint64_t transfers;       /* successful reads or writes */
+    uint64_t bytes;
+    uint64_t xruns;           /* underruns for playback, overruns for capture */
+    uint64_t dropped_buffers; /* discarded while the card is down (SSR) or a2dp suspended */
+    uint64_t dropped_bytes;
+    pal_latency_stat_t transfer_time;     /* duration of one read or write */
+    pal_latency_stat_t transfer_interval; /* start to start, its spread is the jitter */
+    pal_latency_stat_t lock_wait;         /* wait for the stream mutex */
+} pal_stream_data_path_stats_t;
+
 typedef struct pal_param_upd_event_detection {
     bool     register_status;
 } pal_param_upd_event_detection_t;
@@ -68,6 +68,9 @@ using PalMessageQueueFlagBits = ::vendor::qti::hardware::pal::V1_0::PalMessageQu
 using PalReadWriteDoneResult = ::vendor::qti::hardware::pal::V1_0::PalReadWriteDoneResult;
 using PalReadWriteDoneCommand = ::vendor::qti::hardware::pal::V1_0::PalReadWriteDoneCommand;
 using PalCallbackBuffer = ::vendor::qti::hardware::pal::V1_0::PalCallbackBuffer;
+using PalDataPathCommandId = ::vendor::qti::hardware::pal::V1_0::PalDataPathCommandId;
+using PalDataPathCommand = ::vendor::qti::hardware::pal::V1_0::PalDataPathCommand;
+using PalDataPathStatus = ::vendor::qti::hardware::pal::V1_0::PalDataPathStatus;
 using IPALCallback = ::vendor::qti::hardware::pal::V1_0::IPALCallback;
 using android::hardware::hidl_handle;
 using android::hardware::hidl_memory;
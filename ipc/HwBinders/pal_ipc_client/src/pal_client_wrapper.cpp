@@ -39,6 +39,9 @@
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
 #include <log/log.h>
+#include <cutils/properties.h>
+#include <atomic>
+#include <unordered_map>
 #include "PalApi.h"
 #include "inc/PalCallback.h"
 
@@ -56,13 +59,51 @@ using ::android::hidl::allocator::V1_0::IAllocator;
 using ::android::hidl::memory::V1_0::IMemory;
 using android::hardware::hidl_memory;
 
-bool pal_server_died = false;
+std::atomic<bool> pal_server_died(false);
 android::sp<IPAL> pal_client = NULL;
 sp<server_death_notifier> Server_death_notifier = NULL;
 sp<IAllocator> ashmemAllocator = NULL;
 
 std::mutex gLock;
 
+/*
+ * Client end of the shared memory stream data path. Enabled with
+ * vendor.audio.pal.ipc.data_path, streams the server cannot serve this way
+ * stay on ipc_pal_stream_write/read.
+ *
+ * Both directions share the event flag word of the data MQ: the client sets
+ * NOT_EMPTY after posting a command and the server waits for it, the server
+ * sets NOT_FULL after posting the status and the client waits for that.
+ * EventFlag::wait clears only the bits it waits for, so a wake in one
+ * direction cannot be consumed by the other waiter. The blocking MQ
+ * read/write calls, which would also use the word, are not used.
+ */
+#define DATA_PATH_WAIT_TIMEOUT_NS 100000000LL
+
+struct StreamDataPath {
+    typedef MessageQueue<uint8_t, kSynchronizedReadWrite> DataMQ;
+    typedef MessageQueue<PalDataPathCommand, kSynchronizedReadWrite> CommandMQ;
+    typedef MessageQueue<PalDataPathStatus, kSynchronizedReadWrite> StatusMQ;
+
+    std::mutex lock;
+    std::unique_ptr<DataMQ> dataMQ = nullptr;
+    std::unique_ptr<CommandMQ> commandMQ = nullptr;
+    std::unique_ptr<StatusMQ> statusMQ = nullptr;
+    EventFlag* efGroup = nullptr;
+    /* guards efGroup for server_death_notifier, lock is held across the wait */
+    std::mutex efLock;
+    bool disabled = false;
+
+    ~StreamDataPath()
+    {
+        if (efGroup)
+            EventFlag::deleteEventFlag(&efGroup);
+    }
+};
+
+std::mutex gDataPathLock;
+std::unordered_map<PalStreamHandle, std::shared_ptr<StreamDataPath>> gDataPaths;
+
 class DataTransferThread : public Thread {
    public:
     DataTransferThread(std::atomic<bool>* stop, PalStreamHandle streamHandle,
@@ -165,6 +206,16 @@ void server_death_notifier::serviceDied(uint64_t cookie,
 {
     ALOGE("%s : PAL Service died ,cookie : %lu",__func__,cookie);
     pal_server_died = true;
+    {
+        /* release data path transfers still waiting for a status */
+        std::lock_guard<std::mutex> guard(gDataPathLock);
+        for (auto &dataPath : gDataPaths) {
+            std::lock_guard<std::mutex> efGuard(dataPath.second->efLock);
+            if (dataPath.second->efGroup)
+                dataPath.second->efGroup->wake(
+                        static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_FULL));
+        }
+    }
     // We exit the client process here, so that it also can restart
     // leading to a fresh start on both the sides.
     _exit(1);
@@ -461,6 +512,10 @@ int32_t pal_stream_close(pal_stream_handle_t *stream_handle)
         if (pal_client == nullptr)
             return -EINVAL;
 
+        {
+            std::lock_guard<std::mutex> guard(gDataPathLock);
+            gDataPaths.erase((PalStreamHandle)stream_handle);
+        }
         return pal_client->ipc_pal_stream_close((PalStreamHandle)stream_handle);
     }
     return -EINVAL;
@@ -611,6 +666,147 @@ int32_t pal_stream_set_buffer_size(pal_stream_handle_t *stream_handle,
     return ret;
 }
 
+static std::shared_ptr<StreamDataPath> get_stream_data_path(PalStreamHandle streamHandle)
+{
+    static const bool enabled = property_get_bool("vendor.audio.pal.ipc.data_path", false);
+
+    if (!enabled)
+        return nullptr;
+
+    std::lock_guard<std::mutex> guard(gDataPathLock);
+    auto &dataPath = gDataPaths[streamHandle];
+    if (!dataPath)
+        dataPath = std::make_shared<StreamDataPath>();
+    return dataPath;
+}
+
+/*
+ * Called with dataPath->lock held. Sets up, or grows, the data path so a
+ * period of size bytes fits. Returns false if the hidl path must be used.
+ */
+static bool prepare_stream_data_path(android::sp<IPAL> pal_client, PalStreamHandle streamHandle,
+                                     StreamDataPath *dataPath, size_t size)
+{
+    int32_t ret = -EINVAL;
+    EventFlag *efGroup = nullptr;
+
+    if (dataPath->disabled || !size)
+        return false;
+    if (dataPath->dataMQ && size <= dataPath->dataMQ->getQuantumCount())
+        return true;
+
+    {
+        std::lock_guard<std::mutex> efGuard(dataPath->efLock);
+        if (dataPath->efGroup)
+            EventFlag::deleteEventFlag(&dataPath->efGroup);
+    }
+    dataPath->dataMQ.reset();
+    dataPath->commandMQ.reset();
+    dataPath->statusMQ.reset();
+
+    auto transStatus = pal_client->ipc_pal_stream_prepare_data_path(streamHandle, size,
+             [&](int32_t ret_, const StreamDataPath::DataMQ::Descriptor& dataMQ,
+                 const StreamDataPath::CommandMQ::Descriptor& commandMQ,
+                 const StreamDataPath::StatusMQ::Descriptor& statusMQ)
+                {
+                    ret = ret_;
+                    if (!ret) {
+                        dataPath->dataMQ.reset(new StreamDataPath::DataMQ(dataMQ));
+                        dataPath->commandMQ.reset(new StreamDataPath::CommandMQ(commandMQ));
+                        dataPath->statusMQ.reset(new StreamDataPath::StatusMQ(statusMQ));
+                    }
+                });
+    if (!transStatus.isOk() || ret ||
+        !dataPath->dataMQ->isValid() || !dataPath->commandMQ->isValid() ||
+        !dataPath->statusMQ->isValid() ||
+        EventFlag::createEventFlag(dataPath->dataMQ->getEventFlagWord(), &efGroup) != android::OK) {
+        ALOGW("%s: stream %p falls back to hidl transfers, ret %d", __func__,
+              (void *)streamHandle, ret);
+        dataPath->dataMQ.reset();
+        dataPath->commandMQ.reset();
+        dataPath->statusMQ.reset();
+        dataPath->disabled = true;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> efGuard(dataPath->efLock);
+        dataPath->efGroup = efGroup;
+    }
+    return true;
+}
+
+/*
+ * Posts one command and waits for the server to process it. The wait is
+ * bounded so a server that died without waking us is still noticed.
+ */
+static int32_t stream_data_path_transact(StreamDataPath *dataPath,
+                                         const PalDataPathCommand &cmd,
+                                         PalDataPathStatus *status)
+{
+    uint32_t efState = 0;
+
+    if (!dataPath->commandMQ->write(&cmd)) {
+        ALOGE("%s: command MQ write failed", __func__);
+        return -EIO;
+    }
+    dataPath->efGroup->wake(static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_EMPTY));
+    while (!dataPath->statusMQ->read(status)) {
+        if (pal_server_died)
+            return -EPIPE;
+        dataPath->efGroup->wait(static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_FULL),
+                                &efState, DATA_PATH_WAIT_TIMEOUT_NS);
+    }
+    return 0;
+}
+
+static ssize_t stream_data_path_write(StreamDataPath *dataPath, struct pal_buffer *buf)
+{
+    PalDataPathCommand cmd = {};
+    PalDataPathStatus status = {};
+    int32_t ret;
+
+    if (!dataPath->dataMQ->write(buf->buffer, buf->size)) {
+        ALOGE("%s: data MQ write of %zu bytes failed", __func__, buf->size);
+        return -EIO;
+    }
+    cmd.id = PalDataPathCommandId::WRITE;
+    cmd.size = buf->size;
+    cmd.flags = buf->flags;
+    cmd.frame_index = buf->frame_index;
+    if (buf->ts) {
+        cmd.timeStamp.tvSec = buf->ts->tv_sec;
+        cmd.timeStamp.tvNSec = buf->ts->tv_nsec;
+    }
+    ret = stream_data_path_transact(dataPath, cmd, &status);
+    return ret ? ret : status.ret;
+}
+
+static ssize_t stream_data_path_read(StreamDataPath *dataPath, struct pal_buffer *buf)
+{
+    PalDataPathCommand cmd = {};
+    PalDataPathStatus status = {};
+    int32_t ret;
+
+    cmd.id = PalDataPathCommandId::READ;
+    cmd.size = buf->size;
+    ret = stream_data_path_transact(dataPath, cmd, &status);
+    if (ret)
+        return ret;
+    if (status.ret > 0) {
+        if (status.size > buf->size ||
+            !dataPath->dataMQ->read(buf->buffer, status.size)) {
+            ALOGE("%s: data MQ read of %u bytes failed", __func__, status.size);
+            return -EIO;
+        }
+        buf->flags = status.flags;
+        if (buf->ts) {
+            buf->ts->tv_sec = status.timeStamp.tvSec;
+            buf->ts->tv_nsec = status.timeStamp.tvNSec;
+        }
+    }
+    return status.ret;
+}
+
 ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *buf)
 {
     int ret = -EINVAL;
@@ -624,6 +820,14 @@ ssize_t pal_stream_write(pal_stream_handle_t *stream_handle, struct pal_buffer *
         if (!pal_client)
             return ret;
 
+        auto dataPath = get_stream_data_path((PalStreamHandle)stream_handle);
+        if (dataPath && buf->buffer) {
+            std::lock_guard<std::mutex> lock(dataPath->lock);
+            if (prepare_stream_data_path(pal_client, (PalStreamHandle)stream_handle,
+                                         dataPath.get(), buf->size))
+                return stream_data_path_write(dataPath.get(), buf);
+        }
+
         hidl_vec<PalBuffer> buf_hidl;
         buf_hidl.resize(sizeof(struct pal_buffer));
         PalBuffer *palBuff = buf_hidl.data();
@@ -673,6 +877,14 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
         if (!pal_client)
             return ret;
 
+        auto dataPath = get_stream_data_path((PalStreamHandle)stream_handle);
+        if (dataPath && buf->buffer) {
+            std::lock_guard<std::mutex> lock(dataPath->lock);
+            if (prepare_stream_data_path(pal_client, (PalStreamHandle)stream_handle,
+                                         dataPath.get(), buf->size))
+                return stream_data_path_read(dataPath.get(), buf);
+        }
+
         hidl_vec<PalBuffer> buf_hidl;
         buf_hidl.resize(sizeof(struct pal_buffer));
         PalBuffer *palBuff = buf_hidl.data();
@@ -729,6 +941,127 @@ ssize_t pal_stream_read(pal_stream_handle_t *stream_handle, struct pal_buffer *b
     return ret;
 }
 
+/* Falls back to one call per buffer when the server cannot batch the stream. */
+ssize_t pal_stream_write_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                               uint32_t no_of_bufs)
+{
+    int ret = -EINVAL;
+    ssize_t size = 0;
+
+    if (!stream_handle || !bufs || !no_of_bufs)
+        return ret;
+
+    if (!pal_server_died) {
+        android::sp<IPAL> pal_client = get_pal_server();
+        if (!pal_client)
+            return ret;
+
+        hidl_vec<PalBuffer> bufs_hidl;
+        bufs_hidl.resize(no_of_bufs);
+        for (uint32_t i = 0; i < no_of_bufs; i++) {
+            PalBuffer &palBuff = bufs_hidl[i];
+
+            palBuff.size = bufs[i].size;
+            palBuff.offset = bufs[i].offset;
+            palBuff.flags = bufs[i].flags;
+            palBuff.frame_index = bufs[i].frame_index;
+            if (bufs[i].ts) {
+                palBuff.timeStamp.tvSec = bufs[i].ts->tv_sec;
+                palBuff.timeStamp.tvNSec = bufs[i].ts->tv_nsec;
+            }
+            /* serialized straight from the caller's buffer */
+            if (bufs[i].size && bufs[i].buffer)
+                palBuff.buffer.setToExternal(bufs[i].buffer, bufs[i].size);
+        }
+        auto transStatus = pal_client->ipc_pal_stream_write_batch((PalStreamHandle)stream_handle,
+                                                                  bufs_hidl);
+        if (!transStatus.isOk()) {
+            ALOGE("%s: IPC call failed.", __func__);
+            return ret;
+        }
+        ret = transStatus;
+        if (ret != -ENOTSUP)
+            return ret;
+
+        for (uint32_t i = 0; i < no_of_bufs; i++) {
+            ret = pal_stream_write(stream_handle, &bufs[i]);
+            if (ret < 0)
+                return size ? size : ret;
+            size += ret;
+        }
+        return size;
+    }
+    return ret;
+}
+
+ssize_t pal_stream_read_batch(pal_stream_handle_t *stream_handle, struct pal_buffer *bufs,
+                              uint32_t no_of_bufs)
+{
+    int ret = -EINVAL;
+    ssize_t size = 0;
+
+    if (!stream_handle || !bufs || !no_of_bufs)
+        return ret;
+
+    if (!pal_server_died) {
+        android::sp<IPAL> pal_client = get_pal_server();
+        if (!pal_client)
+            return ret;
+
+        hidl_vec<uint32_t> sizes_hidl;
+        sizes_hidl.resize(no_of_bufs);
+        for (uint32_t i = 0; i < no_of_bufs; i++)
+            sizes_hidl[i] = bufs[i].size;
+
+        auto transStatus = pal_client->ipc_pal_stream_read_batch((PalStreamHandle)stream_handle,
+               sizes_hidl,
+               [&](int32_t ret_, const hidl_vec<PalBuffer>& ret_bufs_hidl)
+                  {
+                      if (ret_ > 0) {
+                          if (ret_bufs_hidl.size() != no_of_bufs) {
+                              ALOGE("ret buf count %zu does not match request %u",
+                                     ret_bufs_hidl.size(), no_of_bufs);
+                              ret_ = -ENOMEM;
+                          }
+                          for (uint32_t i = 0; ret_ > 0 && i < no_of_bufs; i++) {
+                              const PalBuffer &palBuff = ret_bufs_hidl[i];
+
+                              if (palBuff.buffer.size() > bufs[i].size) {
+                                  ALOGE("ret buf sz %zu bigger than request buf sz %zu",
+                                         palBuff.buffer.size(), bufs[i].size);
+                                  ret_ = -ENOMEM;
+                                  break;
+                              }
+                              if (bufs[i].ts) {
+                                  bufs[i].ts->tv_sec = palBuff.timeStamp.tvSec;
+                                  bufs[i].ts->tv_nsec = palBuff.timeStamp.tvNSec;
+                              }
+                              bufs[i].flags = palBuff.flags;
+                              if (bufs[i].buffer)
+                                  memcpy(bufs[i].buffer, palBuff.buffer.data(),
+                                         palBuff.buffer.size());
+                          }
+                      }
+                      ret = ret_;
+                  });
+        if (!transStatus.isOk()) {
+            ALOGE("%s: IPC call failed.", __func__);
+            return -EINVAL;
+        }
+        if (ret != -ENOTSUP)
+            return ret;
+
+        for (uint32_t i = 0; i < no_of_bufs; i++) {
+            ret = pal_stream_read(stream_handle, &bufs[i]);
+            if (ret < 0)
+                return size ? size : ret;
+            size += ret;
+        }
+        return size;
+    }
+    return ret;
+}
+
 int32_t mapToHidlMemory(void* inp_data, int32_t size, const hidl_memory& mem)
 {
     void *data = NULL;
@@ -818,7 +1151,10 @@ int32_t pal_stream_get_param(pal_stream_handle_t *stream_handle,
 {
     int32_t ret = -EINVAL;
     ALOGV("%s:%d:", __func__, __LINE__);
-    if (stream_handle == NULL || !(*param_payload))
+    if (stream_handle == NULL || !param_payload)
+       goto done;
+    /* data path stats are allocated here like on the PAL side */
+    if (!(*param_payload) && param_id != PAL_PARAM_ID_STREAM_DATA_PATH_STATS)
        goto done;
 
     if (!pal_server_died) {
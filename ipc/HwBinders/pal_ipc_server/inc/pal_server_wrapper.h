@@ -47,6 +47,8 @@
 #include <utils/Thread.h>
 #include <utils/RefBase.h>
 #include <mutex>
+#include <atomic>
+#include <unordered_map>
 #include "PalApi.h"
 #include<log/log.h>
 
@@ -79,6 +81,8 @@ class SrvrClbk : public ::android::RefBase {
     public :
     typedef MessageQueue<uint8_t, kSynchronizedReadWrite> DataMQ;
     typedef MessageQueue<PalReadWriteDoneCommand, kSynchronizedReadWrite> CommandMQ;
+    typedef MessageQueue<PalDataPathCommand, kSynchronizedReadWrite> DataPathCommandMQ;
+    typedef MessageQueue<PalDataPathStatus, kSynchronizedReadWrite> DataPathStatusMQ;
     sp<IPALCallback> clbk_binder;
     uint64_t client_data_;
     struct pal_stream_attributes session_attr;
@@ -88,6 +92,35 @@ class SrvrClbk : public ::android::RefBase {
     std::unique_ptr<DataMQ> mDataMQ = nullptr;
     std::unique_ptr<CommandMQ> mCommandMQ = nullptr;
     EventFlag* mEfGroup = nullptr;
+    /*
+     * Buffers reused by every ipc_pal_stream_write/read on this session so
+     * the steady state data path does not allocate. Guarded by mDataPathLock,
+     * which is held across pal_stream_write/read because PAL copies from or
+     * fills these buffers during the call. That adds no serialization: PAL
+     * holds the stream mutex for the whole transfer anyway. The callback path
+     * (pal_callback, callReadWriteTransferThread) and stop/close never take
+     * it, so a transfer blocked in PAL can still be released by them.
+     */
+    std::mutex mDataPathLock;
+    std::vector<uint8_t> mDataBuffer;
+    std::vector<uint8_t> mMetadataBuffer;
+    struct timespec mTimeStamp;
+    hidl_vec<PalBuffer> mReadBuffer;
+    std::vector<struct pal_buffer> mBatchBuffers;
+    std::vector<struct timespec> mBatchTimeStamps;
+    hidl_vec<PalBuffer> mReadBatchBuffers;
+    /*
+     * Shared memory stream data path, see ipc_pal_stream_prepare_data_path.
+     * Set up and torn down under mDataPathSetupLock, a binder thread may
+     * prepare it while a close or the client death tears it down.
+     */
+    std::mutex mDataPathSetupLock;
+    std::unique_ptr<DataMQ> mStreamDataMQ = nullptr;
+    std::unique_ptr<DataPathCommandMQ> mStreamCommandMQ = nullptr;
+    std::unique_ptr<DataPathStatusMQ> mStreamStatusMQ = nullptr;
+    EventFlag* mStreamEfGroup = nullptr;
+    std::atomic<bool> mStopDataPath = false;
+    sp<Thread> mDataPathThread = nullptr;
 
     SrvrClbk()
     {
@@ -110,9 +143,15 @@ class SrvrClbk : public ::android::RefBase {
     int32_t callReadWriteTransferThread(PalReadWriteDoneCommand cmd,
                             const uint8_t* data, size_t dataSize);
     int32_t prepare_mq_for_transfer(uint64_t streamHandle, uint64_t cookie);
+    uint8_t *getDataBuffer(size_t size);
+    uint8_t *getMetadataBuffer(size_t size);
+    int32_t prepareDataPath_l(uint64_t streamHandle, uint32_t bufferSize);
+    void stopDataPath();
+    void stopDataPath_l();
     ~SrvrClbk()
     {
         ALOGV("%s:%d",__func__,__LINE__);
+        stopDataPath();
         if (mEfGroup) {
             EventFlag::deleteEventFlag(&mEfGroup);
         }
@@ -120,6 +159,7 @@ class SrvrClbk : public ::android::RefBase {
 };
 
 typedef struct session_info {
+    int pid;
     uint64_t session_handle;
     sp<SrvrClbk> callback_binder;
 }session_info;
@@ -176,6 +216,14 @@ struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
     Return<void> ipc_pal_stream_read(const uint64_t streamHandle,
                                      const hidl_vec<PalBuffer>& buffer,
                                     ipc_pal_stream_read_cb _hidl_cb) override;
+    Return<int32_t> ipc_pal_stream_write_batch(const uint64_t streamHandle,
+                                    const hidl_vec<PalBuffer>& buffers) override;
+    Return<void> ipc_pal_stream_read_batch(const uint64_t streamHandle,
+                                    const hidl_vec<uint32_t>& sizes,
+                                    ipc_pal_stream_read_batch_cb _hidl_cb) override;
+    Return<void> ipc_pal_stream_prepare_data_path(const uint64_t streamHandle,
+                                    uint32_t bufferSize,
+                                    ipc_pal_stream_prepare_data_path_cb _hidl_cb) override;
     Return<int32_t> ipc_pal_stream_set_param(const uint64_t streamHandle, uint32_t param_id,
                       uint32_t payloadSize, const hidl_memory& paramPayload) override;
     Return<void> ipc_pal_stream_get_param(const uint64_t streamHandle, uint32_t param_id,
@@ -220,8 +268,11 @@ struct PAL : public IPAL /*, public android::hardware::hidl_death_recipient*/{
                                      ipc_pal_stream_get_tags_with_module_info_cb _hidl_cb) override;
     sp<PalClientDeathRecipient> mDeathRecipient;
     std::vector<std::shared_ptr<client_info>> mPalClients;
+    /* handle -> session lookup for the data path, guarded by mClientLock */
+    std::unordered_map<uint64_t, session_info> mSessionMap;
 private:
     static PAL* sInstance;
+    sp<SrvrClbk> getSessionClbk(const uint64_t streamHandle);
     int find_dup_fd_from_input_fd(const uint64_t streamHandle, int input_fd, int *dup_fd);
     void add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int dup_fd);
     bool isValidstreamHandle(const uint64_t streamHandle);
@@ -103,7 +103,9 @@ void PalClientDeathRecipient::serviceDied(uint64_t cookie,
     std::lock_guard<std::mutex> guard(mLock);
     ALOGD("%s : client died pid : %d", __func__, cookie);
     int pid = (int) cookie;
-    std::lock_guard<std::mutex> lock(mPalInstance->mClientLock);
+    std::vector<session_info> sessions;
+
+    mPalInstance->mClientLock.lock();
     auto &clients = mPalInstance->mPalClients;
     for (auto itr = clients.begin(); itr != clients.end(); itr++) {
         auto client = *itr;
@@ -112,17 +114,9 @@ void PalClientDeathRecipient::serviceDied(uint64_t cookie,
                 std::lock_guard<std::mutex> lock(client->mActiveSessionsLock);
                 for (auto sItr = client->mActiveSessions.begin();
                           sItr != client->mActiveSessions.end(); sItr++) {
-                   ALOGD("Closing the session %p", sItr->session_handle);
-                   ALOGV("hdle %x binder %p", sItr->session_handle, sItr->callback_binder.get());
                    sItr->callback_binder->client_died = true;
-                   pal_stream_stop((pal_stream_handle_t *)sItr->session_handle);
-                   pal_stream_close((pal_stream_handle_t *)sItr->session_handle);
-                   /*close the dupped fds in PAL server context*/
-                   for (int i = 0; i < sItr->callback_binder->sharedMemFdList.size(); i++) {
-                       close(sItr->callback_binder->sharedMemFdList[i].second);
-                   }
-                   sItr->callback_binder->sharedMemFdList.clear();
-                   sItr->callback_binder.clear();
+                   sessions.push_back(*sItr);
+                   mPalInstance->mSessionMap.erase(sItr->session_handle);
                 }
                 client->mActiveSessions.clear();
             }
@@ -130,27 +124,42 @@ void PalClientDeathRecipient::serviceDied(uint64_t cookie,
             break;
         }
     }
+    mPalInstance->mClientLock.unlock();
+
+    /*
+     * Outside mClientLock, like ipc_pal_stream_close: stopDataPath joins a
+     * thread that may be in pal_stream_write waiting for pal_callback, which
+     * takes mClientLock.
+     */
+    for (auto &session : sessions) {
+        ALOGD("Closing the session %p", session.session_handle);
+        ALOGV("hdle %x binder %p", session.session_handle, session.callback_binder.get());
+        session.callback_binder->stopDataPath();
+        pal_stream_stop((pal_stream_handle_t *)session.session_handle);
+        pal_stream_close((pal_stream_handle_t *)session.session_handle);
+        /*close the dupped fds in PAL server context*/
+        for (int i = 0; i < session.callback_binder->sharedMemFdList.size(); i++) {
+            close(session.callback_binder->sharedMemFdList[i].second);
+        }
+        session.callback_binder->sharedMemFdList.clear();
+        session.callback_binder.clear();
+    }
 }
 
 void PAL::add_input_and_dup_fd(const uint64_t streamHandle, int input_fd, int dup_fd)
 {
-    std::vector<std::pair<int, int>>::iterator it;
     std::lock_guard<std::mutex> guard(mClientLock);
-    for (auto& s: mPalClients) {
-        std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
-        for (int i = 0; i < s->mActiveSessions.size(); i++) {
-            session_info session = s->mActiveSessions[i];
-            if (session.session_handle == streamHandle) {
-                /*If number of FDs increase than the MAX Cache size we delete the oldest one
-                  NOTE: We still create a new fd for every input fd*/
-                if (session.callback_binder->sharedMemFdList.size() > MAX_CACHE_SIZE) {
-                    ALOGE("%s cache limit exceeded handle %p fd [input %d - dup %d]",
-                            __func__ , streamHandle, input_fd, dup_fd );
-                }
-                session.callback_binder->sharedMemFdList.push_back(
-                                            std::make_pair(input_fd, dup_fd));
-            }
+    auto sItr = mSessionMap.find(streamHandle);
+    if (sItr != mSessionMap.end()) {
+        session_info &session = sItr->second;
+        /*If number of FDs increase than the MAX Cache size we delete the oldest one
+          NOTE: We still create a new fd for every input fd*/
+        if (session.callback_binder->sharedMemFdList.size() > MAX_CACHE_SIZE) {
+            ALOGE("%s cache limit exceeded handle %p fd [input %d - dup %d]",
+                    __func__ , streamHandle, input_fd, dup_fd );
         }
+        session.callback_binder->sharedMemFdList.push_back(
+                                    std::make_pair(input_fd, dup_fd));
     }
 }
 
@@ -238,6 +247,217 @@ int32_t SrvrClbk::prepare_mq_for_transfer(uint64_t streamHandle, uint64_t cookie
     return 0;
 }
 
+/* Grow only, so the buffers settle at the stream's period size. */
+uint8_t *SrvrClbk::getDataBuffer(size_t size)
+{
+    if (mDataBuffer.size() < size)
+        mDataBuffer.resize(size);
+    return mDataBuffer.data();
+}
+
+uint8_t *SrvrClbk::getMetadataBuffer(size_t size)
+{
+    if (mMetadataBuffer.size() < size)
+        mMetadataBuffer.resize(size);
+    return mMetadataBuffer.data();
+}
+
+static MetadataParser sMetadataParser;
+
+/*
+ * Serves the shared memory data path of one stream: waits for a
+ * PalDataPathCommand, moves the period through the data MQ and runs
+ * pal_stream_write/read, then posts a PalDataPathStatus back.
+ *
+ * The event flag word of the data MQ carries both directions, NOT_EMPTY
+ * for a posted command and NOT_FULL for a posted status. Each side waits
+ * on its own bit only and EventFlag::wait clears just the waited bits, so
+ * a wake meant for the client is never consumed here and vice versa.
+ */
+class DataPathThread : public Thread {
+   public:
+    DataPathThread(SrvrClbk *clbk, uint64_t streamHandle)
+        : Thread(false),
+          mClbk(clbk),
+          mStreamHandle(streamHandle) {}
+    virtual ~DataPathThread() {}
+
+   private:
+    SrvrClbk *mClbk;
+    uint64_t mStreamHandle;
+
+    bool threadLoop() override;
+    void doWrite(const PalDataPathCommand &cmd, PalDataPathStatus &status);
+    void doRead(const PalDataPathCommand &cmd, PalDataPathStatus &status);
+};
+
+void DataPathThread::doWrite(const PalDataPathCommand &cmd, PalDataPathStatus &status)
+{
+    struct pal_buffer buf = {0};
+
+    if (cmd.size > mClbk->mStreamDataMQ->availableToRead()) {
+        ALOGE("%s: command size %u exceeds queued data %zu", __func__,
+              cmd.size, mClbk->mStreamDataMQ->availableToRead());
+        status.ret = -EINVAL;
+        return;
+    }
+    buf.size = cmd.size;
+    buf.buffer = mClbk->getDataBuffer(buf.size);
+    if (buf.size && !mClbk->mStreamDataMQ->read(buf.buffer, buf.size)) {
+        ALOGE("%s: data MQ read failed", __func__);
+        status.ret = -EIO;
+        return;
+    }
+    mClbk->mTimeStamp.tv_sec = cmd.timeStamp.tvSec;
+    mClbk->mTimeStamp.tv_nsec = cmd.timeStamp.tvNSec;
+    buf.ts = &mClbk->mTimeStamp;
+    buf.flags = cmd.flags;
+    buf.frame_index = cmd.frame_index;
+    buf.metadata_size = MetadataParser::WRITE_METADATA_MAX_SIZE();
+    buf.metadata = mClbk->getMetadataBuffer(buf.metadata_size);
+    sMetadataParser.fillMetaData(buf.metadata, buf.frame_index, buf.size,
+                                 &mClbk->session_attr.out_media_config);
+    buf.alloc_info.alloc_handle = -1;
+
+    status.ret = pal_stream_write((pal_stream_handle_t *)mStreamHandle, &buf);
+}
+
+void DataPathThread::doRead(const PalDataPathCommand &cmd, PalDataPathStatus &status)
+{
+    struct pal_buffer buf = {0};
+    struct timespec ts = {0};
+
+    if (cmd.size > mClbk->mStreamDataMQ->getQuantumCount()) {
+        ALOGE("%s: read size %u exceeds data MQ size %zu", __func__,
+              cmd.size, mClbk->mStreamDataMQ->getQuantumCount());
+        status.ret = -EINVAL;
+        return;
+    }
+    buf.size = cmd.size;
+    buf.buffer = mClbk->getDataBuffer(buf.size);
+    buf.ts = &ts;
+    buf.metadata_size = MetadataParser::READ_METADATA_MAX_SIZE();
+    buf.alloc_info.alloc_handle = -1;
+
+    status.ret = pal_stream_read((pal_stream_handle_t *)mStreamHandle, &buf);
+    if (status.ret > 0) {
+        if (!mClbk->mStreamDataMQ->write(buf.buffer, buf.size)) {
+            ALOGE("%s: data MQ write failed", __func__);
+            status.ret = -EIO;
+            return;
+        }
+        status.size = (uint32_t)buf.size;
+        status.flags = buf.flags;
+        status.timeStamp.tvSec = ts.tv_sec;
+        status.timeStamp.tvNSec = ts.tv_nsec;
+    }
+}
+
+bool DataPathThread::threadLoop()
+{
+    while (!mClbk->mStopDataPath.load(std::memory_order_acquire)) {
+        uint32_t efState = 0;
+        mClbk->mStreamEfGroup->wait(static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_EMPTY),
+                                    &efState);
+        if (!(efState & static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_EMPTY)))
+            continue;
+        PalDataPathCommand cmd;
+        if (!mClbk->mStreamCommandMQ->read(&cmd))
+            continue;
+
+        PalDataPathStatus status = {};
+        {
+            std::lock_guard<std::mutex> lock(mClbk->mDataPathLock);
+            if (cmd.id == PalDataPathCommandId::WRITE)
+                doWrite(cmd, status);
+            else if (cmd.id == PalDataPathCommandId::READ)
+                doRead(cmd, status);
+            else
+                status.ret = -EINVAL;
+        }
+        if (!mClbk->mStreamStatusMQ->write(&status))
+            ALOGE("%s: status MQ write failed", __func__);
+        mClbk->mStreamEfGroup->wake(static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_FULL));
+    }
+
+    return false;
+}
+
+int32_t SrvrClbk::prepareDataPath_l(uint64_t streamHandle, uint32_t bufferSize)
+{
+    std::unique_ptr<DataMQ> tempDataMQ;
+    std::unique_ptr<DataPathCommandMQ> tempCommandMQ;
+    std::unique_ptr<DataPathStatusMQ> tempStatusMQ;
+    EventFlag *tempEfGroup = nullptr;
+    sp<Thread> tempThread;
+    status_t status;
+
+    /* Buffers of these streams are owned by the client, keep them on hidl. */
+    if (session_attr.type == PAL_STREAM_NON_TUNNEL ||
+        (session_attr.flags & PAL_STREAM_FLAG_EXTERN_MEM)) {
+        ALOGE("%s: data path not supported for stream type %d flags %x",
+              __func__, session_attr.type, session_attr.flags);
+        return -ENOTSUP;
+    }
+
+    stopDataPath_l();
+    tempDataMQ.reset(new DataMQ(bufferSize, true /* EventFlag */));
+    tempCommandMQ.reset(new DataPathCommandMQ(1));
+    tempStatusMQ.reset(new DataPathStatusMQ(1));
+    if (!tempDataMQ->isValid() || !tempCommandMQ->isValid() || !tempStatusMQ->isValid()) {
+        ALOGE_IF(!tempDataMQ->isValid(), "stream data MQ is invalid");
+        ALOGE_IF(!tempCommandMQ->isValid(), "stream command MQ is invalid");
+        ALOGE_IF(!tempStatusMQ->isValid(), "stream status MQ is invalid");
+        return -ENOMEM;
+    }
+    status = EventFlag::createEventFlag(tempDataMQ->getEventFlagWord(), &tempEfGroup);
+    if (status != OK || !tempEfGroup) {
+        ALOGE("%s: failed creating event flag for data MQ: %d", __func__, status);
+        return -ENOMEM;
+    }
+    mStreamDataMQ = std::move(tempDataMQ);
+    mStreamCommandMQ = std::move(tempCommandMQ);
+    mStreamStatusMQ = std::move(tempStatusMQ);
+    mStreamEfGroup = tempEfGroup;
+    mStopDataPath.store(false, std::memory_order_release);
+
+    tempThread = new DataPathThread(this, streamHandle);
+    status = tempThread->run("pal_data_path", android::PRIORITY_URGENT_AUDIO);
+    if (status != OK) {
+        ALOGE("%s: failed to start data path thread: %d", __func__, status);
+        stopDataPath_l();
+        return -EINVAL;
+    }
+    mDataPathThread = tempThread;
+    ALOGD("%s: handle %p data MQ size %u", __func__, streamHandle, bufferSize);
+    return 0;
+}
+
+void SrvrClbk::stopDataPath()
+{
+    std::lock_guard<std::mutex> lock(mDataPathSetupLock);
+
+    stopDataPath_l();
+}
+
+void SrvrClbk::stopDataPath_l()
+{
+    mStopDataPath.store(true, std::memory_order_release);
+    if (mDataPathThread.get()) {
+        mStreamEfGroup->wake(static_cast<uint32_t>(PalMessageQueueFlagBits::NOT_EMPTY));
+        status_t status = mDataPathThread->join();
+        ALOGE_IF(status, "data path thread exit error: %s", strerror(-status));
+        mDataPathThread.clear();
+    }
+    if (mStreamEfGroup) {
+        EventFlag::deleteEventFlag(&mStreamEfGroup);
+        mStreamEfGroup = nullptr;
+    }
+    mStreamDataMQ.reset();
+    mStreamCommandMQ.reset();
+    mStreamStatusMQ.reset();
+}
+
 static int32_t pal_callback(pal_stream_handle_t *stream_handle,
                             uint32_t event_id, uint32_t *event_data,
                             uint32_t event_data_size,
@@ -249,15 +469,8 @@ static int32_t pal_callback(pal_stream_handle_t *stream_handle,
            return false;
         }
         std::lock_guard<std::mutex> guard(PAL::getInstance()->mClientLock);
-        for (auto& s: PAL::getInstance()->mPalClients) {
-            std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
-            for (int idx = 0; idx < s->mActiveSessions.size(); idx++) {
-                session_info session = s->mActiveSessions[idx];
-                if (session.session_handle == stream_handle)
-                    return true;
-            }
-        }
-        return false;
+        auto &sessionMap = PAL::getInstance()->mSessionMap;
+        return sessionMap.find(stream_handle) != sessionMap.end();
     };
 
     if (!isPalSessionActive((uint64_t)stream_handle)) {
@@ -282,26 +495,20 @@ static int32_t pal_callback(pal_stream_handle_t *stream_handle,
          * input and dup fd list and send that back.
          */
         PAL::getInstance()->mClientLock.lock();
-        for (auto& s: PAL::getInstance()->mPalClients) {
-            std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
-            for (int idx = 0; idx < s->mActiveSessions.size(); idx++) {
-                session_info session = s->mActiveSessions[idx];
-                if (session.session_handle != (uint64_t)stream_handle) {
-                    continue;
-                }
-                std::vector<std::pair<int, int>>::iterator it;
-                for (int i = 0; i < sr_clbk_dat->sharedMemFdList.size(); i++) {
-                    if (sr_clbk_dat->sharedMemFdList[i].second ==
-                            rw_done_payload->buff.alloc_info.alloc_handle) {
-                        input_fd = sr_clbk_dat->sharedMemFdList[i].first;
-                        it = (sr_clbk_dat->sharedMemFdList.begin() + i);
-                        if (it != sr_clbk_dat->sharedMemFdList.end()) {
-                            fdToBeClosed = sr_clbk_dat->sharedMemFdList[i].second;
-                            sr_clbk_dat->sharedMemFdList.erase(it);
-                            ALOGV("Removing fd [input %d - dup %d]", input_fd, fdToBeClosed);
-                        }
-                        break;
+        auto &sessionMap = PAL::getInstance()->mSessionMap;
+        if (sessionMap.find((uint64_t)stream_handle) != sessionMap.end()) {
+            std::vector<std::pair<int, int>>::iterator it;
+            for (int i = 0; i < sr_clbk_dat->sharedMemFdList.size(); i++) {
+                if (sr_clbk_dat->sharedMemFdList[i].second ==
+                        rw_done_payload->buff.alloc_info.alloc_handle) {
+                    input_fd = sr_clbk_dat->sharedMemFdList[i].first;
+                    it = (sr_clbk_dat->sharedMemFdList.begin() + i);
+                    if (it != sr_clbk_dat->sharedMemFdList.end()) {
+                        fdToBeClosed = sr_clbk_dat->sharedMemFdList[i].second;
+                        sr_clbk_dat->sharedMemFdList.erase(it);
+                        ALOGV("Removing fd [input %d - dup %d]", input_fd, fdToBeClosed);
                     }
+                    break;
                 }
             }
         }
@@ -337,17 +544,16 @@ static int32_t pal_callback(pal_stream_handle_t *stream_handle,
         }
 
         if (!rwDonePayload->status) {
-            auto metadataParser = std::make_unique<MetadataParser>();
             if (event_id == PAL_STREAM_CBK_EVENT_READ_DONE) {
-                auto cb_buf_info = std::make_unique<pal_clbk_buffer_info>();
-                rwDonePayload->status = metadataParser->parseMetadata(
+                pal_clbk_buffer_info cb_buf_info = {};
+                rwDonePayload->status = sMetadataParser.parseMetadata(
                             rw_done_payload->buff.metadata,
                             rw_done_payload->buff.metadata_size,
-                            cb_buf_info.get());
-                rwDonePayload->cbBufInfo.frame_index = cb_buf_info->frame_index;
-                rwDonePayload->cbBufInfo.sample_rate = cb_buf_info->sample_rate;
-                rwDonePayload->cbBufInfo.channel_count = cb_buf_info->channel_count;
-                rwDonePayload->cbBufInfo.bit_width = cb_buf_info->bit_width;
+                            &cb_buf_info);
+                rwDonePayload->cbBufInfo.frame_index = cb_buf_info.frame_index;
+                rwDonePayload->cbBufInfo.sample_rate = cb_buf_info.sample_rate;
+                rwDonePayload->cbBufInfo.channel_count = cb_buf_info.channel_count;
+                rwDonePayload->cbBufInfo.bit_width = cb_buf_info.bit_width;
             } else if (event_id == PAL_STREAM_CBK_EVENT_WRITE_READY) {
                 rwDonePayload->status = getInputBufferIndex(
                             rw_done_payload->buff.alloc_info.alloc_handle,
@@ -451,30 +657,34 @@ static void print_attr(struct pal_stream_attributes *attr)
    print_media_config(&attr->out_media_config);
 }
 
-bool PAL::isValidstreamHandle(const uint64_t streamHandle) {
+/*
+ * Returns the callback object of the session if streamHandle was opened
+ * by the calling client, nullptr otherwise.
+ */
+sp<SrvrClbk> PAL::getSessionClbk(const uint64_t streamHandle) {
     int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
 
     std::lock_guard<std::mutex> guard(mClientLock);
-    for (auto itr = mPalClients.begin(); itr != mPalClients.end(); ) {
-        auto client = *itr;
-        if (client->pid == pid) {
-            std::lock_guard<std::mutex> lock(client->mActiveSessionsLock);
-            auto sItr = client->mActiveSessions.begin();
-            for (; sItr != client->mActiveSessions.end(); sItr++) {
-                if (sItr->session_handle == streamHandle) {
-                    return true;
-                }
-            }
-            ALOGE("%s: streamHandle: %pK for pid %d not found",
-                    __func__, streamHandle, pid);
-            return false;
-        }
-        itr++;
+    auto sItr = mSessionMap.find(streamHandle);
+    if (sItr == mSessionMap.end() || sItr->second.pid != pid) {
+        ALOGE("%s: streamHandle: %pK for pid %d not found",
+                __func__, streamHandle, pid);
+        return nullptr;
     }
+    return sItr->second.callback_binder;
+}
 
-    ALOGE("%s: client info for pid %d not found",
-            __func__, pid);
-    return false;
+bool PAL::isValidstreamHandle(const uint64_t streamHandle) {
+    int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
+
+    std::lock_guard<std::mutex> guard(mClientLock);
+    auto sItr = mSessionMap.find(streamHandle);
+    if (sItr == mSessionMap.end() || sItr->second.pid != pid) {
+        ALOGE("%s: streamHandle: %pK for pid %d not found",
+                __func__, streamHandle, pid);
+        return false;
+    }
+    return true;
 }
 
 Return<void> PAL::ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attr_hidl,
@@ -596,6 +806,7 @@ Return<void> PAL::ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attr_
                 ALOGI("Add session for existing client %d session %p total sessions %d", pid,
                         (uint64_t)stream_handle, client->mActiveSessions.size());
                 struct session_info session;
+                session.pid = pid;
                 session.session_handle = (uint64_t)stream_handle;
                 session.callback_binder = sr_clbk_data;
                 ALOGV("hdle %x binder %p", session.session_handle, session.callback_binder.get());
@@ -603,6 +814,7 @@ Return<void> PAL::ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attr_
                     std::lock_guard<std::mutex> lock(client->mActiveSessionsLock);
                     client->mActiveSessions.push_back(session);
                 }
+                mSessionMap[session.session_handle] = session;
                 new_client = false;
                 break;
             }
@@ -612,6 +824,7 @@ Return<void> PAL::ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attr_
             struct session_info session;
             ALOGI("Add session from new client %d session %p", pid, (uint64_t)stream_handle);
             client->pid = pid;
+            session.pid = pid;
             session.session_handle = (uint64_t)stream_handle;
             session.callback_binder = sr_clbk_data;
             ALOGV("hdle %x binder %p", session.session_handle, session.callback_binder.get());
@@ -619,6 +832,7 @@ Return<void> PAL::ipc_pal_stream_open(const hidl_vec<PalStreamAttributes>& attr_
                 std::lock_guard<std::mutex> lock(client->mActiveSessionsLock);
                 client->mActiveSessions.push_back(session);
             }
+            mSessionMap[session.session_handle] = session;
             mPalClients.push_back(client);
             if (cb != NULL) {
                 if (this->mDeathRecipient.get() == nullptr) {
@@ -645,6 +859,7 @@ exit:
 Return<int32_t> PAL::ipc_pal_stream_close(const uint64_t streamHandle)
 {
     int pid = ::android::hardware::IPCThreadState::self()->getCallingPid();
+    sp<SrvrClbk> sr_clbk_dat = nullptr;
 
     if (!isValidstreamHandle(streamHandle)) {
         ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
@@ -666,12 +881,14 @@ Return<int32_t> PAL::ipc_pal_stream_close(const uint64_t streamHandle)
                         }
                         ALOGV("Closing the session %p", streamHandle);
                         sItr->callback_binder->sharedMemFdList.clear();
+                        sr_clbk_dat = sItr->callback_binder;
                         sItr->callback_binder.clear();
                         break;
                     }
                 }
                 if (sItr != client->mActiveSessions.end()) {
                     ALOGV("Delete session info %p", sItr->session_handle);
+                    mSessionMap.erase(sItr->session_handle);
                     client->mActiveSessions.erase(sItr);
                 }
             }
@@ -686,6 +903,10 @@ Return<int32_t> PAL::ipc_pal_stream_close(const uint64_t streamHandle)
     }
     mClientLock.unlock();
 
+    /* Outside mClientLock, pal_callback may need it to finish a pending write. */
+    if (sr_clbk_dat != nullptr)
+        sr_clbk_dat->stopDataPath();
+
     Return<int32_t> status = pal_stream_close((pal_stream_handle_t *)streamHandle);
 
     return status;
@@ -823,45 +1044,28 @@ Return<void> PAL::ipc_pal_stream_get_buffer_size(const uint64_t streamHandle,
 Return<int32_t> PAL::ipc_pal_stream_write(const uint64_t streamHandle,
                                           const hidl_vec<PalBuffer>& buff_hidl) {
     struct pal_buffer buf = {0};
+    sp<SrvrClbk> sr_clbk_dat = getSessionClbk(streamHandle);
 
-    if (!isValidstreamHandle(streamHandle)) {
+    if (sr_clbk_dat == nullptr) {
         ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
         return -EINVAL;
     }
 
+    std::lock_guard<std::mutex> lock(sr_clbk_dat->mDataPathLock);
     buf.size = buff_hidl.data()->size;
-    std::vector<uint8_t> dataBuffer;
-    if (buff_hidl.data()->buffer.size() == buf.size) {
-        dataBuffer.resize(buf.size);
-        buf.buffer = dataBuffer.data();
-    }
+    if (buff_hidl.data()->buffer.size() == buf.size)
+        buf.buffer = sr_clbk_dat->getDataBuffer(buf.size);
     buf.offset = (size_t)buff_hidl.data()->offset;
-    auto timeStamp = std::make_unique<timespec>();
-    timeStamp->tv_sec =  buff_hidl.data()->timeStamp.tvSec;
-    timeStamp->tv_nsec = buff_hidl.data()->timeStamp.tvNSec;
-    buf.ts = timeStamp.get();
+    sr_clbk_dat->mTimeStamp.tv_sec =  buff_hidl.data()->timeStamp.tvSec;
+    sr_clbk_dat->mTimeStamp.tv_nsec = buff_hidl.data()->timeStamp.tvNSec;
+    buf.ts = &sr_clbk_dat->mTimeStamp;
     buf.flags = buff_hidl.data()->flags;
     buf.frame_index = buff_hidl.data()->frame_index;
 
     buf.metadata_size = MetadataParser::WRITE_METADATA_MAX_SIZE();
-    std::vector<uint8_t> bufMetadata(buf.metadata_size, 0);
-    buf.metadata = bufMetadata.data();
-    auto stream_media_config = std::make_shared<pal_media_config>();
-    mClientLock.lock();
-    for (auto& s: PAL::getInstance()->mPalClients) {
-        std::lock_guard<std::mutex> lock(s->mActiveSessionsLock);
-        for (auto session : s->mActiveSessions) {
-            if (session.session_handle == streamHandle) {
-                memcpy((uint8_t *)stream_media_config.get(),
-                       (uint8_t *)&session.callback_binder->session_attr.out_media_config,
-                       sizeof(pal_media_config));
-            }
-        }
-    }
-    mClientLock.unlock();
-    auto metadataParser = std::make_unique<MetadataParser>();
-    metadataParser->fillMetaData(buf.metadata, buf.frame_index, buf.size,
-                                 stream_media_config.get());
+    buf.metadata = sr_clbk_dat->getMetadataBuffer(buf.metadata_size);
+    sMetadataParser.fillMetaData(buf.metadata, buf.frame_index, buf.size,
+                                 &sr_clbk_dat->session_attr.out_media_config);
     const native_handle *allochandle = buff_hidl.data()->alloc_info.alloc_handle.handle();
 
     buf.alloc_info.alloc_handle = dup(allochandle->data[0]);
@@ -886,15 +1090,16 @@ Return<void> PAL::ipc_pal_stream_read(const uint64_t streamHandle,
                                       ipc_pal_stream_read_cb _hidl_cb) {
     struct pal_buffer buf = {0};
     hidl_vec<PalBuffer> outBuff_hidl;
+    sp<SrvrClbk> sr_clbk_dat = getSessionClbk(streamHandle);
 
-    if (!isValidstreamHandle(streamHandle)) {
+    if (sr_clbk_dat == nullptr) {
         ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
         return Void();
     }
 
+    std::lock_guard<std::mutex> lock(sr_clbk_dat->mDataPathLock);
     buf.size = inBuff_hidl.data()->size;
-    std::vector<uint8_t> dataBuffer(buf.size, 0);
-    buf.buffer = dataBuffer.data();
+    buf.buffer = sr_clbk_dat->getDataBuffer(buf.size);
     buf.metadata_size = MetadataParser::READ_METADATA_MAX_SIZE();
 
     const native_handle *allochandle = inBuff_hidl.data()->alloc_info.alloc_handle.handle();
@@ -908,21 +1113,184 @@ Return<void> PAL::ipc_pal_stream_read(const uint64_t streamHandle,
 
     int32_t ret = pal_stream_read((pal_stream_handle_t *)streamHandle, &buf);
     if (ret > 0) {
-        outBuff_hidl.resize(sizeof(struct pal_buffer));
-        outBuff_hidl.data()->size = (uint32_t)buf.size;
-        outBuff_hidl.data()->offset = (uint32_t)buf.offset;
-        outBuff_hidl.data()->buffer.resize(buf.size);
-        memcpy(outBuff_hidl.data()->buffer.data(), buf.buffer,
-               buf.size);
-        if (buf.ts) {
-          outBuff_hidl.data()->timeStamp.tvSec = buf.ts->tv_sec;
-          outBuff_hidl.data()->timeStamp.tvNSec = buf.ts->tv_nsec;
+        /*
+         * The reply is serialized before _hidl_cb returns, so the session
+         * buffer is handed out by reference instead of being copied.
+         */
+        hidl_vec<PalBuffer> &readBuff = sr_clbk_dat->mReadBuffer;
+        if (readBuff.size() == 0)
+            readBuff.resize(1);
+        readBuff.data()->size = (uint32_t)buf.size;
+        readBuff.data()->offset = (uint32_t)buf.offset;
+        readBuff.data()->buffer.setToExternal((uint8_t *)buf.buffer, buf.size);
+        readBuff.data()->timeStamp.tvSec = buf.ts ? buf.ts->tv_sec : 0;
+        readBuff.data()->timeStamp.tvNSec = buf.ts ? buf.ts->tv_nsec : 0;
+        _hidl_cb(ret, readBuff);
+        readBuff.data()->buffer.setToExternal(nullptr, 0);
+        return Void();
+    }
+    _hidl_cb(ret, outBuff_hidl);
+    return Void();
+}
+
+/*
+ * Batches carry plain PCM/compressed payloads only. Streams whose buffers
+ * are client owned shared memory keep using ipc_pal_stream_write/read.
+ */
+static bool isBatchSupported(const sp<SrvrClbk> &sr_clbk_dat)
+{
+    return !(sr_clbk_dat->session_attr.type == PAL_STREAM_NON_TUNNEL ||
+             (sr_clbk_dat->session_attr.flags & PAL_STREAM_FLAG_EXTERN_MEM));
+}
+
+Return<int32_t> PAL::ipc_pal_stream_write_batch(const uint64_t streamHandle,
+                                                const hidl_vec<PalBuffer>& buffers) {
+    sp<SrvrClbk> sr_clbk_dat = getSessionClbk(streamHandle);
+    size_t count = buffers.size();
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
+        return -EINVAL;
+    }
+    if (!isBatchSupported(sr_clbk_dat))
+        return -ENOTSUP;
+    if (!count)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(sr_clbk_dat->mDataPathLock);
+    auto &bufs = sr_clbk_dat->mBatchBuffers;
+    auto &timeStamps = sr_clbk_dat->mBatchTimeStamps;
+    if (bufs.size() < count) {
+        bufs.resize(count);
+        timeStamps.resize(count);
+    }
+    for (size_t i = 0; i < count; i++) {
+        const PalBuffer &palBuff = buffers[i];
+        struct pal_buffer &buf = bufs[i];
+
+        memset(&buf, 0, sizeof(buf));
+        buf.size = palBuff.size;
+        /* the payload is only read, use it in place from the hidl parcel */
+        if (palBuff.buffer.size() == buf.size)
+            buf.buffer = const_cast<uint8_t *>(palBuff.buffer.data());
+        buf.offset = (size_t)palBuff.offset;
+        timeStamps[i].tv_sec = palBuff.timeStamp.tvSec;
+        timeStamps[i].tv_nsec = palBuff.timeStamp.tvNSec;
+        buf.ts = &timeStamps[i];
+        buf.flags = palBuff.flags;
+        buf.frame_index = palBuff.frame_index;
+        buf.alloc_info.alloc_handle = -1;
+    }
+    ALOGV("%s: handle %p count %zu", __func__, streamHandle, count);
+
+    return pal_stream_write_batch((pal_stream_handle_t *)streamHandle, bufs.data(), count);
+}
+
+Return<void> PAL::ipc_pal_stream_read_batch(const uint64_t streamHandle,
+                                            const hidl_vec<uint32_t>& sizes,
+                                            ipc_pal_stream_read_batch_cb _hidl_cb) {
+    sp<SrvrClbk> sr_clbk_dat = getSessionClbk(streamHandle);
+    hidl_vec<PalBuffer> outBuff_hidl;
+    size_t count = sizes.size();
+    size_t totalSize = 0, offset = 0;
+    int32_t ret = -EINVAL;
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
+        goto exit;
+    }
+    if (!isBatchSupported(sr_clbk_dat)) {
+        ret = -ENOTSUP;
+        goto exit;
+    }
+    if (!count)
+        goto exit;
+
+    {
+        std::lock_guard<std::mutex> lock(sr_clbk_dat->mDataPathLock);
+        auto &bufs = sr_clbk_dat->mBatchBuffers;
+        auto &timeStamps = sr_clbk_dat->mBatchTimeStamps;
+        hidl_vec<PalBuffer> &readBuffs = sr_clbk_dat->mReadBatchBuffers;
+        uint8_t *data = nullptr;
+
+        if (bufs.size() < count) {
+            bufs.resize(count);
+            timeStamps.resize(count);
+        }
+        for (size_t i = 0; i < count; i++)
+            totalSize += sizes[i];
+        data = sr_clbk_dat->getDataBuffer(totalSize);
+        for (size_t i = 0; i < count; i++) {
+            struct pal_buffer &buf = bufs[i];
+
+            memset(&buf, 0, sizeof(buf));
+            buf.size = sizes[i];
+            buf.buffer = data + offset;
+            timeStamps[i] = {0, 0};
+            buf.ts = &timeStamps[i];
+            buf.alloc_info.alloc_handle = -1;
+            offset += sizes[i];
+        }
+
+        ret = pal_stream_read_batch((pal_stream_handle_t *)streamHandle, bufs.data(), count);
+        if (ret > 0) {
+            /* reply straight from the session buffer, see ipc_pal_stream_read */
+            if (readBuffs.size() != count)
+                readBuffs.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                readBuffs[i].size = (uint32_t)bufs[i].size;
+                readBuffs[i].offset = (uint32_t)bufs[i].offset;
+                readBuffs[i].flags = bufs[i].flags;
+                readBuffs[i].buffer.setToExternal(bufs[i].buffer, bufs[i].size);
+                readBuffs[i].timeStamp.tvSec = timeStamps[i].tv_sec;
+                readBuffs[i].timeStamp.tvNSec = timeStamps[i].tv_nsec;
+            }
+            _hidl_cb(ret, readBuffs);
+            for (size_t i = 0; i < count; i++)
+                readBuffs[i].buffer.setToExternal(nullptr, 0);
+            return Void();
         }
     }
+exit:
     _hidl_cb(ret, outBuff_hidl);
     return Void();
 }
 
+Return<void> PAL::ipc_pal_stream_prepare_data_path(const uint64_t streamHandle,
+                                      uint32_t bufferSize,
+                                      ipc_pal_stream_prepare_data_path_cb _hidl_cb) {
+    int32_t ret = -EINVAL;
+    sp<SrvrClbk> sr_clbk_dat = getSessionClbk(streamHandle);
+
+    if (sr_clbk_dat == nullptr) {
+        ALOGE("%s: Invalid streamHandle: %pK", __func__, streamHandle);
+        goto exit;
+    }
+
+    if (!bufferSize) {
+        ALOGE("%s: Invalid bufferSize", __func__);
+        goto exit;
+    }
+
+    {
+        /* a close or client death may tear the queues down once unlocked */
+        std::lock_guard<std::mutex> lock(sr_clbk_dat->mDataPathSetupLock);
+
+        ret = sr_clbk_dat->prepareDataPath_l(streamHandle, bufferSize);
+        if (!ret) {
+            _hidl_cb(ret, *sr_clbk_dat->mStreamDataMQ->getDesc(),
+                     *sr_clbk_dat->mStreamCommandMQ->getDesc(),
+                     *sr_clbk_dat->mStreamStatusMQ->getDesc());
+            return Void();
+        }
+    }
+exit:
+    _hidl_cb(ret, SrvrClbk::DataMQ::Descriptor(),
+             SrvrClbk::DataPathCommandMQ::Descriptor(),
+             SrvrClbk::DataPathStatusMQ::Descriptor());
+    return Void();
+}
+
 Return<int32_t> PAL::ipc_pal_stream_set_param(const uint64_t streamHandle, uint32_t paramId,
                      uint32_t payloadSize, const hidl_memory& paramPayload)
 {
@@ -966,7 +1334,7 @@ Return<void> PAL::ipc_pal_stream_get_param(const uint64_t streamHandle,
                                          ipc_pal_stream_get_param_cb _hidl_cb)
 {
     int32_t ret = 0;
-    pal_param_payload *param_payload;
+    pal_param_payload *param_payload = NULL;
     hidl_vec<PalParamPayload> paramPayload;
 
     if (!isValidstreamHandle(streamHandle)) {
@@ -981,6 +1349,9 @@ Return<void> PAL::ipc_pal_stream_get_param(const uint64_t streamHandle,
         paramPayload.data()->size = param_payload->payload_size;
         memcpy(paramPayload.data()->payload.data(), param_payload->payload,
                param_payload->payload_size);
+        /* allocated by PAL for this param, the others are owned by the stream */
+        if (paramId == PAL_PARAM_ID_STREAM_DATA_PATH_STATS)
+            free(param_payload);
     }
     _hidl_cb(ret, paramPayload);
     return Void();
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef ACTIVE_STREAM_INDEX_H
+#define ACTIVE_STREAM_INDEX_H
+
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "PalDefs.h"
+
+class Stream;
+class Device;
+
+/*
+ * Stream types sharing the same session limits are tracked together,
+ * in the order the resource manager has always walked them.
+ */
+typedef enum {
+    ACTIVE_STREAM_GROUP_LL = 0,         /* low latency, voip, voice call */
+    ACTIVE_STREAM_GROUP_ULL,
+    ACTIVE_STREAM_GROUP_ULLA,           /* generic */
+    ACTIVE_STREAM_GROUP_DB,
+    ACTIVE_STREAM_GROUP_SA,
+    ACTIVE_STREAM_GROUP_RAW,
+    ACTIVE_STREAM_GROUP_COMP,
+    ACTIVE_STREAM_GROUP_ST,
+    ACTIVE_STREAM_GROUP_ACD,
+    ACTIVE_STREAM_GROUP_PO,             /* pcm offload, loopback */
+    ACTIVE_STREAM_GROUP_PROXY,
+    ACTIVE_STREAM_GROUP_INCALL_RECORD,
+    ACTIVE_STREAM_GROUP_NON_TUNNEL,
+    ACTIVE_STREAM_GROUP_INCALL_MUSIC,
+    ACTIVE_STREAM_GROUP_HAPTICS,
+    ACTIVE_STREAM_GROUP_ULTRASOUND,
+    ACTIVE_STREAM_GROUP_SENSOR_PCM_DATA,
+    ACTIVE_STREAM_GROUP_VOICE_REC,
+    ACTIVE_STREAM_GROUP_CONTEXT_PROXY,
+    ACTIVE_STREAM_GROUP_COMMON_PROXY,
+    ACTIVE_STREAM_GROUP_MAX,
+} active_stream_group_t;
+
+/*
+ * Index of the registered streams by group and direction, plus the
+ * stream/device pairs registered through registerDevice. Every bucket is a
+ * flat vector kept in registration order so walks stay cache friendly and
+ * keep the ordering of the per type lists they replace. Not thread safe,
+ * callers hold the same lock as for mActiveStreams/active_devices.
+ */
+class ActiveStreamIndex
+{
+public:
+    static active_stream_group_t getGroup(pal_stream_type_t type);
+
+    int add(Stream *s, pal_stream_type_t type, pal_stream_direction_t dir);
+    int remove(Stream *s);
+    bool contains(Stream *s) const;
+    size_t size(active_stream_group_t group) const;
+    const std::vector<Stream *> &getStreams(active_stream_group_t group) const;
+    const std::vector<Stream *> &getStreams(pal_stream_direction_t dir) const;
+
+    int attachDevice(Device *d, int devId, Stream *s);
+    int detachDevice(Device *d, int devId, Stream *s);
+    bool isDeviceAttached(int devId) const;
+    bool isDeviceAttached(Device *d, Stream *s) const;
+    const std::vector<Stream *> &getAttachedStreams(Device *d) const;
+
+private:
+    struct entry {
+        active_stream_group_t group;
+        pal_stream_direction_t dir;
+    };
+
+    static void eraseStream(std::vector<Stream *> &streams, Stream *s);
+
+    std::unordered_map<Stream *, struct entry> mEntries;
+    std::vector<Stream *> mGroups[ACTIVE_STREAM_GROUP_MAX];
+    std::vector<Stream *> mDirections[PAL_AUDIO_INPUT_OUTPUT + 1];
+    std::unordered_map<Device *, std::vector<Stream *>> mAttached;
+    std::unordered_map<int, uint32_t> mAttachedCount;
+    const std::vector<Stream *> mEmpty;
+};
+
+#endif /* ACTIVE_STREAM_INDEX_H */
@@ -58,10 +58,13 @@
 #include "PalDefs.h"
 #include "ChargerListener.h"
 #include "SndCardMonitor.h"
+#include "StreamHandleTable.h"
+#include "ActiveStreamIndex.h"
 #include "ContextManager.h"
 #include "SoundTriggerPlatformInfo.h"
 #include "SignalHandler.h"
 #include "MemLogBuilder.h"
+#include "PalTrace.h"
 
 typedef enum {
     RX_HOSTLESS = 1,
@@ -91,6 +94,7 @@ typedef enum {
 #define AUDIO_PARAMETER_KEY_HAPTICS_PRIORITY "haptics_priority"
 #define AUDIO_PARAMETER_KEY_WSA_HAPTICS "haptics_through_wsa"
 #define AUDIO_PARAMETER_KEY_DUMMY_DEV_ENABLE "dummy_dev_enable"
+#define AUDIO_PARAMETER_KEY_PARALLEL_DEV_SWITCH "parallel_device_switch"
 #define AUDIO_PARAMETER_MULTI_SR_COMBO_SUPPORTED "multiple_sample_rate_combo_supported"
 #define MAX_PCM_NAME_SIZE 50
 #define MAX_STREAM_INSTANCES (sizeof(uint64_t) << 3)
@@ -223,7 +227,6 @@ struct xml_userdata {
     group_dev_config_idx_t group_dev_idx;
     resource_xml_tags_t tag;
     bool inCustomConfig;
-    XML_Parser parser;
 };
 
 typedef enum {
@@ -493,6 +496,7 @@ private:
     int32_t streamDevConnect(std::vector <std::tuple<Stream *, struct pal_device *>> streamDevConnectList);
     int32_t streamDevDisconnect_l(std::vector <std::tuple<Stream *, uint32_t>> streamDevDisconnectList);
     int32_t streamDevConnect_l(std::vector <std::tuple<Stream *, struct pal_device *>> streamDevConnectList);
+    int32_t streamDevConnectParallel_l(std::vector <std::tuple<Stream *, struct pal_device *>> &streamDevConnectList);
     void ssrHandlingLoop(std::shared_ptr<ResourceManager> rm);
     int updateECDeviceMap(std::shared_ptr<Device> rx_dev,
                         std::shared_ptr<Device> tx_dev,
@@ -513,30 +517,14 @@ private:
     bool checkDeviceSwitchForHaptics(struct pal_device *inDevAttr, struct pal_device *curDevAttr);
 protected:
     std::list <Stream*> mActiveStreams;
-    std::list <StreamPCM*> active_streams_ll;
-    std::list <StreamPCM*> active_streams_ulla;
-    std::list <StreamPCM*> active_streams_ull;
-    std::list <StreamPCM*> active_streams_db;
-    std::list <StreamPCM*> active_streams_sa;
-    std::list <StreamPCM*> active_streams_po;
-    std::list <StreamPCM*> active_streams_proxy;
-    std::list <StreamPCM*> active_streams_haptics;
-    std::list <StreamPCM*> active_streams_raw;
-    std::list <StreamPCM*> active_streams_voice_rec;
-    std::list <StreamInCall*> active_streams_incall_record;
-    std::list <StreamNonTunnel*> active_streams_non_tunnel;
-    std::list <StreamInCall*> active_streams_incall_music;
-    std::list <StreamCompress*> active_streams_comp;
+    ActiveStreamIndex mStreamIndex;
     std::list <StreamSoundTrigger*> active_streams_st;
     std::list <StreamACD*> active_streams_acd;
-    std::list <StreamUltraSound*> active_streams_ultrasound;
     std::list <StreamSensorPCMData*> active_streams_sensor_pcm_data;
-    std::list <StreamContextProxy*> active_streams_context_proxy;
-    std::list <StreamCommonProxy*> active_streams_afs;
     std::vector <std::pair<std::shared_ptr<Device>, Stream*>> active_devices;
     std::vector <std::shared_ptr<Device>> plugin_devices_;
     std::vector <pal_device_id_t> avail_devices_;
-    std::map<Stream*, std::pair<uint32_t, bool>> mActiveStreamUserCounter;
+    StreamHandleTable mStreamHandles;
     bool bOverwriteFlag;
     bool screen_state_ = true;
     bool charging_state_;
@@ -660,6 +648,7 @@ public:
     static bool isXPANEnabled;
     static bool isCRSCallEnabled;
     static bool isDummyDevEnabled;
+    static bool isParallelDevSwitchEnabled;
     static bool isProxyRecordActive;
     static std::mutex mChargerBoostMutex;
     /* Variable to store which speaker side is being used for call audio.
@@ -769,6 +758,7 @@ public:
     int deactivateStreamUserCounter(Stream *s);
     int eraseStreamUserCounter(Stream *s);
     int increaseStreamUserCounter(Stream* s);
+    Stream* acquireStream(pal_stream_handle_t *handle);
     int decreaseStreamUserCounter(Stream* s);
     int getStreamUserCounter(Stream *s);
     int printStreamUserCounter(Stream *s);
@@ -824,6 +814,8 @@ public:
                      uint32_t instance_id, bool is_param_write, bool is_play);
     int getParameter(uint32_t param_id, void **param_payload,
                      size_t *payload_size, void *query = nullptr);
+    int getTraceParameter(uint32_t param_id, void **param_payload,
+                          size_t *payload_size);
     int getParameter(uint32_t param_id, void *param_payload,
                      size_t payload_size, pal_device_id_t pal_device_id,
                      pal_stream_type_t pal_stream_type);
@@ -984,6 +976,7 @@ public:
     static int setHapticsDrivenParam(struct str_parms *parms,char *value, int len);
     static void setXPANEnableParam(struct str_parms *parms,char *value, int len);
     static void setDummyDevEnableParam(struct str_parms *parms,char *value, int len);
+    static void setParallelDevSwitchEnableParam(struct str_parms *parms,char *value, int len);
     static bool isLpiLoggingEnabled();
     static void processConfigParams(const XML_Char **attr);
     static bool isValidDevId(int deviceId);
@@ -1016,6 +1009,8 @@ public:
     int32_t a2dpCaptureResume(pal_device_id_t dev_id);
     int32_t a2dpCaptureResumeFromDummy(pal_device_id_t dev_id);
     int32_t a2dpReconfig();
+    void waitForStaleDataDrained(std::vector<std::pair<Stream*, uint64_t>> &drainTargets,
+                                 bool fixedWait, uint32_t maxLatencyMs);
     bool isPluginDevice(pal_device_id_t id);
     bool isDpDevice(pal_device_id_t id);
     bool isPluginPlaybackDevice(pal_device_id_t id);
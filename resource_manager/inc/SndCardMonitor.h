@@ -30,7 +30,9 @@
 #ifndef SNDCARD_MONITOR_H
 #define SNDCARD_MONITOR_H
 #include <list>
+#include <memory>
 #include "PalDefs.h"
+#include "Reactor.h"
 
 typedef struct {
     int card;
@@ -38,11 +40,20 @@ typedef struct {
     card_status_t status;
 } sndcard_t;
 
+/*
+ * Watches the snd card state sysfs node from the shared Reactor and hands
+ * card state changes to ResourceManager::ssrHandler.
+ */
 class SndCardMonitor
 {
 private :
-    std::thread mThread;
-    void monitorThreadLoop();
+    std::shared_ptr<Reactor> mReactor;
+    int mFd;
+    int mHandle;
+    int mRetryTimer;
+    int mTries;
+    void openNode();
+    void onCardState(uint32_t events);
 
 public :
     SndCardMonitor(int sndNum);
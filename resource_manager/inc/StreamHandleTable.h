@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef STREAM_HANDLE_TABLE_H
+#define STREAM_HANDLE_TABLE_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define STREAM_HANDLE_TABLE_SIZE 1024
+#define STREAM_HANDLE_TABLE_WORDS (STREAM_HANDLE_TABLE_SIZE / 64)
+
+class Stream;
+
+/*
+ * Open addressed table of live stream handles. The handle handed out to
+ * clients is the Stream pointer itself, so lookups only compare the key
+ * and never dereference a stale handle.
+ *
+ * Each slot carries a 64 bit state word:
+ *   [63:32] generation, bumped every time the slot is (re)used
+ *   [31]    active, cleared once the stream starts closing
+ *   [30:0]  user count
+ * acquire() increments the user count with a CAS on the state snapshot it
+ * validated the key against, so a slot recycled in between is detected by
+ * the generation change. None of the operations take a lock.
+ */
+class StreamHandleTable
+{
+public:
+    StreamHandleTable();
+    int insert(Stream *s);
+    int erase(Stream *s);
+    bool isActive(const void *handle);
+    /* returns the stream with its user count raised, or nullptr */
+    Stream *acquire(const void *handle);
+    /* lastUser is set when the last user of a deactivated stream left */
+    int release(Stream *s, bool *lastUser);
+    /* returns the number of users still holding the stream */
+    int deactivate(Stream *s);
+    int getUserCount(Stream *s);
+    void dump();
+
+private:
+    struct slot {
+        std::atomic<uintptr_t> key;
+        std::atomic<uint64_t> state;
+    };
+
+    static const uint64_t kActive = 1ULL << 31;
+    static const uint64_t kCountMask = kActive - 1;
+
+    static uint32_t hash(uintptr_t key);
+    static uint32_t getGeneration(uint64_t state) { return (uint32_t)(state >> 32); }
+    static uint32_t getCount(uint64_t state) { return (uint32_t)(state & kCountMask); }
+    struct slot *find(uintptr_t key);
+    void setLive(uint32_t index, bool live);
+
+    struct slot mSlots[STREAM_HANDLE_TABLE_SIZE];
+    /* one bit per slot holding a key, so dump() skips the empty ones */
+    std::atomic<uint64_t> mLive[STREAM_HANDLE_TABLE_WORDS];
+    /* longest probe sequence any insert has needed, lookups stop there */
+    std::atomic<uint32_t> mMaxProbe;
+};
+
+#endif /* STREAM_HANDLE_TABLE_H */
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: ActiveStreamIndex"
+
+#include <errno.h>
+#include <algorithm>
+#include "ActiveStreamIndex.h"
+#include "PalCommon.h"
+
+active_stream_group_t ActiveStreamIndex::getGroup(pal_stream_type_t type)
+{
+    switch (type) {
+        case PAL_STREAM_LOW_LATENCY:
+        case PAL_STREAM_VOIP_RX:
+        case PAL_STREAM_VOIP_TX:
+        case PAL_STREAM_VOICE_CALL:
+            return ACTIVE_STREAM_GROUP_LL;
+        case PAL_STREAM_PCM_OFFLOAD:
+        case PAL_STREAM_LOOPBACK:
+            return ACTIVE_STREAM_GROUP_PO;
+        case PAL_STREAM_DEEP_BUFFER:
+            return ACTIVE_STREAM_GROUP_DB;
+        case PAL_STREAM_SPATIAL_AUDIO:
+            return ACTIVE_STREAM_GROUP_SA;
+        case PAL_STREAM_COMPRESSED:
+            return ACTIVE_STREAM_GROUP_COMP;
+        case PAL_STREAM_GENERIC:
+            return ACTIVE_STREAM_GROUP_ULLA;
+        case PAL_STREAM_VOICE_UI:
+            return ACTIVE_STREAM_GROUP_ST;
+        case PAL_STREAM_ULTRA_LOW_LATENCY:
+            return ACTIVE_STREAM_GROUP_ULL;
+        case PAL_STREAM_PROXY:
+            return ACTIVE_STREAM_GROUP_PROXY;
+        case PAL_STREAM_VOICE_CALL_MUSIC:
+            return ACTIVE_STREAM_GROUP_INCALL_MUSIC;
+        case PAL_STREAM_VOICE_CALL_RECORD:
+            return ACTIVE_STREAM_GROUP_INCALL_RECORD;
+        case PAL_STREAM_NON_TUNNEL:
+            return ACTIVE_STREAM_GROUP_NON_TUNNEL;
+        case PAL_STREAM_HAPTICS:
+            return ACTIVE_STREAM_GROUP_HAPTICS;
+        case PAL_STREAM_ACD:
+            return ACTIVE_STREAM_GROUP_ACD;
+        case PAL_STREAM_ULTRASOUND:
+            return ACTIVE_STREAM_GROUP_ULTRASOUND;
+        case PAL_STREAM_RAW:
+            return ACTIVE_STREAM_GROUP_RAW;
+        case PAL_STREAM_SENSOR_PCM_DATA:
+            return ACTIVE_STREAM_GROUP_SENSOR_PCM_DATA;
+        case PAL_STREAM_CONTEXT_PROXY:
+            return ACTIVE_STREAM_GROUP_CONTEXT_PROXY;
+        case PAL_STREAM_VOICE_RECOGNITION:
+            return ACTIVE_STREAM_GROUP_VOICE_REC;
+        case PAL_STREAM_COMMON_PROXY:
+            return ACTIVE_STREAM_GROUP_COMMON_PROXY;
+        default:
+            return ACTIVE_STREAM_GROUP_MAX;
+    }
+}
+
+void ActiveStreamIndex::eraseStream(std::vector<Stream *> &streams, Stream *s)
+{
+    auto iter = std::find(streams.begin(), streams.end(), s);
+
+    if (iter != streams.end())
+        streams.erase(iter);
+}
+
+/*
+ * Streams of an unknown type are still indexed for lookups, they just do
+ * not land in any group. -EINVAL is returned for them.
+ */
+int ActiveStreamIndex::add(Stream *s, pal_stream_type_t type,
+                           pal_stream_direction_t dir)
+{
+    struct entry e;
+
+    if (!s)
+        return -EINVAL;
+    if (mEntries.find(s) != mEntries.end())
+        return -EEXIST;
+
+    e.group = getGroup(type);
+    e.dir = dir;
+    mEntries[s] = e;
+    if (e.group != ACTIVE_STREAM_GROUP_MAX)
+        mGroups[e.group].push_back(s);
+    if (dir >= PAL_AUDIO_OUTPUT && dir <= PAL_AUDIO_INPUT_OUTPUT)
+        mDirections[dir].push_back(s);
+
+    return e.group == ACTIVE_STREAM_GROUP_MAX ? -EINVAL : 0;
+}
+
+int ActiveStreamIndex::remove(Stream *s)
+{
+    auto iter = mEntries.find(s);
+    struct entry e;
+
+    if (iter == mEntries.end())
+        return -ENOENT;
+
+    e = iter->second;
+    mEntries.erase(iter);
+    if (e.group != ACTIVE_STREAM_GROUP_MAX)
+        eraseStream(mGroups[e.group], s);
+    if (e.dir >= PAL_AUDIO_OUTPUT && e.dir <= PAL_AUDIO_INPUT_OUTPUT)
+        eraseStream(mDirections[e.dir], s);
+
+    return e.group == ACTIVE_STREAM_GROUP_MAX ? -EINVAL : 0;
+}
+
+bool ActiveStreamIndex::contains(Stream *s) const
+{
+    return mEntries.find(s) != mEntries.end();
+}
+
+size_t ActiveStreamIndex::size(active_stream_group_t group) const
+{
+    if (group >= ACTIVE_STREAM_GROUP_MAX)
+        return 0;
+    return mGroups[group].size();
+}
+
+const std::vector<Stream *> &ActiveStreamIndex::getStreams(active_stream_group_t group) const
+{
+    if (group >= ACTIVE_STREAM_GROUP_MAX)
+        return mEmpty;
+    return mGroups[group];
+}
+
+const std::vector<Stream *> &ActiveStreamIndex::getStreams(pal_stream_direction_t dir) const
+{
+    if (dir < PAL_AUDIO_OUTPUT || dir > PAL_AUDIO_INPUT_OUTPUT)
+        return mEmpty;
+    return mDirections[dir];
+}
+
+int ActiveStreamIndex::attachDevice(Device *d, int devId, Stream *s)
+{
+    std::vector<Stream *> &streams = mAttached[d];
+
+    if (std::find(streams.begin(), streams.end(), s) != streams.end())
+        return -EINVAL;
+
+    streams.push_back(s);
+    mAttachedCount[devId]++;
+    return 0;
+}
+
+int ActiveStreamIndex::detachDevice(Device *d, int devId, Stream *s)
+{
+    auto iter = mAttached.find(d);
+    std::vector<Stream *>::iterator sIter;
+
+    if (iter == mAttached.end())
+        return -ENOENT;
+
+    sIter = std::find(iter->second.begin(), iter->second.end(), s);
+    if (sIter == iter->second.end())
+        return -ENOENT;
+
+    iter->second.erase(sIter);
+    if (iter->second.empty())
+        mAttached.erase(iter);
+    if (--mAttachedCount[devId] == 0)
+        mAttachedCount.erase(devId);
+    return 0;
+}
+
+bool ActiveStreamIndex::isDeviceAttached(int devId) const
+{
+    return mAttachedCount.find(devId) != mAttachedCount.end();
+}
+
+bool ActiveStreamIndex::isDeviceAttached(Device *d, Stream *s) const
+{
+    auto iter = mAttached.find(d);
+
+    if (iter == mAttached.end())
+        return false;
+    return std::find(iter->second.begin(), iter->second.end(), s) != iter->second.end();
+}
+
+const std::vector<Stream *> &ActiveStreamIndex::getAttachedStreams(Device *d) const
+{
+    auto iter = mAttached.find(d);
+
+    if (iter == mAttached.end())
+        return mEmpty;
+    return iter->second;
+}
@@ -40,11 +40,17 @@
 #include <unistd.h>
 #include <dlfcn.h>
 #include <mutex>
+#include <chrono>
+#include <future>
+#include <system_error>
 #include <iostream>
 #include <fstream>
 #include <sys/ioctl.h>
 #include "ResourceManager.h"
 #include "Session.h"
+#include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
+#include "BtCodecPluginCache.h"
 #include "Device.h"
 #include "Stream.h"
 #include "StreamPCM.h"
@@ -61,6 +67,7 @@
 #include "gsl_intf.h"
 #include "Headphone.h"
 #include "PayloadBuilder.h"
+#include "XmlSnapshot.h"
 #include "Bluetooth.h"
 #include "SpeakerMic.h"
 #include "Speaker.h"
@@ -544,6 +551,7 @@ bool ResourceManager::isUPDVirtualPortEnabled = false;
 bool ResourceManager::isUpdSetCustomGainEnabled = false;
 bool ResourceManager::isXPANEnabled = false;
 bool ResourceManager::isDummyDevEnabled = false;
+bool ResourceManager::isParallelDevSwitchEnabled = false;
 bool ResourceManager::isProxyRecordActive = false;
 int ResourceManager::max_voice_vol = -1;     /* Variable to store max volume index for voice call */
 bool ResourceManager::isSignalHandlerEnabled = false;
@@ -697,7 +705,7 @@ int32_t ResourceManager::secureZoneEventCb(const uint32_t peripheral,
 
     PAL_INFO(LOG_TAG,"Received Notification from TZ... secureState: %d", secureState);
 
-    ctl = mixer_get_ctl_by_name(audio_hw_mixer, "VOTE Against Sleep");
+    ctl = MixerCtlCache::getCtl(audio_hw_mixer, "VOTE Against Sleep");
     if (!ctl) {
        PAL_ERR(LOG_TAG, "Invalid mixer control: VOTE Against Sleep");
        return -ENOENT;
@@ -1388,6 +1396,9 @@ void ResourceManager::ssrHandlingLoop(std::shared_ptr<ResourceManager> rm)
             mActiveStreamMutex.lock();
             rm->cardState = state;
             if (state != prevState) {
+                /* graphs are torn down/rebuilt by the DSP restart */
+                SessionAlsaUtils::invalidateMiidCache();
+                MixerCtlCache::invalidate();
                 if (rm->globalCb) {
                     PAL_DBG(LOG_TAG, "Notifying client about sound card state %d global cb %pK",
                                       rm->cardState, rm->globalCb);
@@ -2042,6 +2053,14 @@ int ResourceManager::init()
     PAL_INFO(LOG_TAG, "Initialize Audio Feature Stats");
     AudioFeatureStatsInit();
 
+    // Load BT codec plugins now rather than on the first BT connect
+    std::vector<std::string> btCodecLibs;
+    for (auto &codec : btCodecMap) {
+        if (std::find(btCodecLibs.begin(), btCodecLibs.end(), codec.second) == btCodecLibs.end())
+            btCodecLibs.push_back(codec.second);
+    }
+    BtCodecPluginCache::prewarm(btCodecLibs);
+
     return 0;
 }
 
@@ -3232,71 +3251,71 @@ bool ResourceManager::isStreamSupported(struct pal_stream_attributes *attributes
         case PAL_STREAM_VOIP:
         case PAL_STREAM_VOIP_RX:
         case PAL_STREAM_VOIP_TX:
-            cur_sessions = active_streams_ll.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_LL);
             max_sessions = MAX_SESSIONS_LOW_LATENCY;
             break;
         case PAL_STREAM_ULTRA_LOW_LATENCY:
-            cur_sessions = active_streams_ull.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_ULL);
             max_sessions = MAX_SESSIONS_ULTRA_LOW_LATENCY;
             break;
         case PAL_STREAM_DEEP_BUFFER:
-            cur_sessions = active_streams_db.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_DB);
             max_sessions = MAX_SESSIONS_DEEP_BUFFER;
             break;
         case PAL_STREAM_SPATIAL_AUDIO:
-            cur_sessions = active_streams_sa.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_SA);
             max_sessions = MAX_SESSIONS_SPATIAL_AUDIO;
             break;
         case PAL_STREAM_COMPRESSED:
-            cur_sessions = active_streams_comp.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_COMP);
             max_sessions = MAX_SESSIONS_COMPRESSED;
             break;
         case PAL_STREAM_GENERIC:
-            cur_sessions = active_streams_ulla.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_ULLA);
             max_sessions = MAX_SESSIONS_GENERIC;
             break;
         case PAL_STREAM_RAW:
-            cur_sessions = active_streams_raw.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_RAW);
             max_sessions = MAX_SESSIONS_RAW;
             break;
         case PAL_STREAM_VOICE_RECOGNITION:
-            cur_sessions = active_streams_voice_rec.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_VOICE_REC);
             max_sessions = MAX_SESSIONS_VOICE_RECOGNITION;
             break;
         case PAL_STREAM_LOOPBACK:
         case PAL_STREAM_TRANSCODE:
         case PAL_STREAM_VOICE_UI:
-            cur_sessions = active_streams_st.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_ST);
             max_sessions = MAX_SESSIONS_VOICE_UI;
             break;
         case PAL_STREAM_ACD:
-            cur_sessions = active_streams_acd.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_ACD);
             max_sessions = MAX_SESSIONS_ACD;
             break;
         case PAL_STREAM_PCM_OFFLOAD:
-            cur_sessions = active_streams_po.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_PO);
             max_sessions = MAX_SESSIONS_PCM_OFFLOAD;
             break;
         case PAL_STREAM_PROXY:
-            cur_sessions = active_streams_proxy.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_PROXY);
             max_sessions = MAX_SESSIONS_PROXY;
             break;
          case PAL_STREAM_VOICE_CALL:
             break;
         case PAL_STREAM_VOICE_CALL_MUSIC:
-            cur_sessions = active_streams_incall_music.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_INCALL_MUSIC);
             max_sessions = MAX_SESSIONS_INCALL_MUSIC;
             break;
         case PAL_STREAM_VOICE_CALL_RECORD:
-            cur_sessions = active_streams_incall_record.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_INCALL_RECORD);
             max_sessions = MAX_SESSIONS_INCALL_RECORD;
             break;
         case PAL_STREAM_NON_TUNNEL:
-            cur_sessions = active_streams_non_tunnel.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_NON_TUNNEL);
             max_sessions = max_nt_sessions;
             break;
         case PAL_STREAM_HAPTICS:
-            cur_sessions = active_streams_haptics.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_HAPTICS);
             max_sessions = MAX_SESSIONS_HAPTICS;
             break;
         case PAL_STREAM_CONTEXT_PROXY:
@@ -3304,7 +3323,7 @@ bool ResourceManager::isStreamSupported(struct pal_stream_attributes *attributes
         case PAL_STREAM_COMMON_PROXY:
             return true;
         case PAL_STREAM_ULTRASOUND:
-            cur_sessions = active_streams_ultrasound.size();
+            cur_sessions = mStreamIndex.size(ACTIVE_STREAM_GROUP_ULTRASOUND);
             max_sessions = MAX_SESSIONS_ULTRASOUND;
             break;
         default:
@@ -3313,7 +3332,7 @@ bool ResourceManager::isStreamSupported(struct pal_stream_attributes *attributes
     }
     if (cur_sessions == max_sessions && type != PAL_STREAM_VOICE_CALL) {
         if (type == PAL_STREAM_VOICE_RECOGNITION &&
-            active_streams_db.size() < MAX_SESSIONS_DEEP_BUFFER) {
+            mStreamIndex.size(ACTIVE_STREAM_GROUP_DB) < MAX_SESSIONS_DEEP_BUFFER) {
                 attributes->type = PAL_STREAM_DEEP_BUFFER;
                 type = PAL_STREAM_DEEP_BUFFER;
         } else {
@@ -3504,7 +3523,9 @@ int registerstream(T s, std::list<T> &streams)
 int ResourceManager::registerStream(Stream *s)
 {
     int ret = 0;
+    int status = 0;
     pal_stream_type_t type;
+    pal_stream_direction_t dir = PAL_AUDIO_OUTPUT;
     PAL_DBG(LOG_TAG, "Enter. stream %pK", s);
     ret = s->getStreamType(&type);
     if (ret != 0)
@@ -3512,50 +3533,11 @@ int ResourceManager::registerStream(Stream *s)
         PAL_ERR(LOG_TAG, "getStreamType failed with status = %d", ret);
         return ret;
     }
+    s->getStreamDirection(&dir);
     PAL_DBG(LOG_TAG, "stream type %d", type);
 
     mActiveStreamMutex.lock();
     switch (type) {
-        case PAL_STREAM_LOW_LATENCY:
-        case PAL_STREAM_VOIP_RX:
-        case PAL_STREAM_VOIP_TX:
-        case PAL_STREAM_VOICE_CALL:
-        {
-            StreamPCM* sPCM = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sPCM, active_streams_ll);
-            break;
-        }
-        case PAL_STREAM_PCM_OFFLOAD:
-        case PAL_STREAM_LOOPBACK:
-        {
-            StreamPCM* sPCM = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sPCM, active_streams_po);
-            break;
-        }
-        case PAL_STREAM_DEEP_BUFFER:
-        {
-            StreamPCM* sDB = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sDB, active_streams_db);
-            break;
-        }
-        case PAL_STREAM_SPATIAL_AUDIO:
-        {
-            StreamPCM* sSA = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sSA, active_streams_sa);
-            break;
-        }
-        case PAL_STREAM_COMPRESSED:
-        {
-            StreamCompress* sComp = dynamic_cast<StreamCompress*>(s);
-            ret = registerstream(sComp, active_streams_comp);
-            break;
-        }
-        case PAL_STREAM_GENERIC:
-        {
-            StreamPCM* sULLA = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sULLA, active_streams_ulla);
-            break;
-        }
         case PAL_STREAM_VOICE_UI:
         {
             if (active_streams_st.size() == 0)
@@ -3564,90 +3546,26 @@ int ResourceManager::registerStream(Stream *s)
             ret = registerstream(sST, active_streams_st);
             break;
         }
-        case PAL_STREAM_ULTRA_LOW_LATENCY:
-        {
-            StreamPCM* sULL = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sULL, active_streams_ull);
-            break;
-        }
-        case PAL_STREAM_PROXY:
-        {
-            StreamPCM* sProxy = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sProxy, active_streams_proxy);
-            break;
-        }
-        case PAL_STREAM_VOICE_CALL_MUSIC:
-        {
-            StreamInCall* sPCM = dynamic_cast<StreamInCall*>(s);
-            ret = registerstream(sPCM, active_streams_incall_music);
-            break;
-        }
-        case PAL_STREAM_VOICE_CALL_RECORD:
-        {
-            StreamInCall* sPCM = dynamic_cast<StreamInCall*>(s);
-            ret = registerstream(sPCM, active_streams_incall_record);
-            break;
-        }
-        case PAL_STREAM_NON_TUNNEL:
-        {
-            StreamNonTunnel* sNonTunnel = dynamic_cast<StreamNonTunnel*>(s);
-            ret = registerstream(sNonTunnel, active_streams_non_tunnel);
-            break;
-        }
-        case PAL_STREAM_HAPTICS:
-        {
-            StreamPCM* sHap = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sHap, active_streams_haptics);
-            break;
-        }
         case PAL_STREAM_ACD:
         {
             StreamACD* sAcd = dynamic_cast<StreamACD*>(s);
             ret = registerstream(sAcd, active_streams_acd);
             break;
         }
-        case PAL_STREAM_ULTRASOUND:
-        {
-            StreamUltraSound* sUPD = dynamic_cast<StreamUltraSound*>(s);
-            ret = registerstream(sUPD, active_streams_ultrasound);
-            break;
-        }
-        case PAL_STREAM_RAW:
-        {
-            StreamPCM* sRaw = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sRaw, active_streams_raw);
-            break;
-        }
         case PAL_STREAM_SENSOR_PCM_DATA:
         {
             StreamSensorPCMData* sPCM = dynamic_cast<StreamSensorPCMData*>(s);
             ret = registerstream(sPCM, active_streams_sensor_pcm_data);
             break;
         }
-        case PAL_STREAM_CONTEXT_PROXY:
-        {
-            StreamContextProxy* sCtxt = dynamic_cast<StreamContextProxy*>(s);
-            ret = registerstream(sCtxt, active_streams_context_proxy);
-            break;
-        }
-        case PAL_STREAM_VOICE_RECOGNITION:
-        {
-            StreamPCM* sVR = dynamic_cast<StreamPCM*>(s);
-            ret = registerstream(sVR, active_streams_voice_rec);
-            break;
-        }
-        case PAL_STREAM_COMMON_PROXY:
-        {
-            StreamCommonProxy* sAFS = dynamic_cast<StreamCommonProxy*>(s);
-            ret = registerstream(sAFS, active_streams_afs);
-            break;
-        }
-
         default:
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "Invalid stream type = %d ret %d", type, ret);
             break;
     }
+    status = mStreamIndex.add(s, type, dir);
+    if (status == -EINVAL)
+        PAL_ERR(LOG_TAG, "Invalid stream type = %d ret %d", type, status);
+    if (!ret)
+        ret = status;
     mActiveStreams.push_back(s);
 
 #if 0
@@ -3691,6 +3609,7 @@ int ResourceManager::deregisterStream(Stream *s)
 {
     struct pal_state_queue que;
     int ret = 0;
+    int status = 0;
     pal_stream_type_t type;
     PAL_DBG(LOG_TAG, "Enter. stream %pK", s);
     ret = s->getStreamType(&type);
@@ -3699,50 +3618,9 @@ int ResourceManager::deregisterStream(Stream *s)
         PAL_ERR(LOG_TAG, "getStreamType failed with status = %d", ret);
         goto exit;
     }
-
     PAL_INFO(LOG_TAG, "stream type %d", type);
     mActiveStreamMutex.lock();
     switch (type) {
-        case PAL_STREAM_LOW_LATENCY:
-        case PAL_STREAM_VOIP_RX:
-        case PAL_STREAM_VOIP_TX:
-        case PAL_STREAM_VOICE_CALL:
-        {
-            StreamPCM* sPCM = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sPCM, active_streams_ll);
-            break;
-        }
-        case PAL_STREAM_PCM_OFFLOAD:
-        case PAL_STREAM_LOOPBACK:
-        {
-            StreamPCM* sPCM = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sPCM, active_streams_po);
-            break;
-        }
-        case PAL_STREAM_DEEP_BUFFER:
-        {
-            StreamPCM* sDB = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sDB, active_streams_db);
-            break;
-        }
-        case PAL_STREAM_SPATIAL_AUDIO:
-        {
-            StreamPCM* sSA = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sSA, active_streams_sa);
-            break;
-        }
-        case PAL_STREAM_COMPRESSED:
-        {
-            StreamCompress* sComp = dynamic_cast<StreamCompress*>(s);
-            ret = deregisterstream(sComp, active_streams_comp);
-            break;
-        }
-        case PAL_STREAM_GENERIC:
-        {
-            StreamPCM* sULLA = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sULLA, active_streams_ulla);
-            break;
-        }
         case PAL_STREAM_VOICE_UI:
         {
             StreamSoundTrigger* sST = dynamic_cast<StreamSoundTrigger*>(s);
@@ -3753,91 +3631,26 @@ int ResourceManager::deregisterStream(Stream *s)
             }
             break;
         }
-        case PAL_STREAM_ULTRA_LOW_LATENCY:
-        {
-            StreamPCM* sULL = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sULL, active_streams_ull);
-            break;
-        }
-        case PAL_STREAM_PROXY:
-        {
-            StreamPCM* sProxy = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sProxy, active_streams_proxy);
-            break;
-        }
-        case PAL_STREAM_VOICE_CALL_MUSIC:
-        {
-            StreamInCall* sPCM = dynamic_cast<StreamInCall*>(s);
-            ret = deregisterstream(sPCM, active_streams_incall_music);
-            break;
-        }
-        case PAL_STREAM_VOICE_CALL_RECORD:
-        {
-            StreamInCall* sPCM = dynamic_cast<StreamInCall*>(s);
-            ret = deregisterstream(sPCM, active_streams_incall_record);
-            break;
-        }
-        case PAL_STREAM_NON_TUNNEL:
-        {
-            StreamNonTunnel* sNonTunnel = dynamic_cast<StreamNonTunnel*>(s);
-            ret = deregisterstream(sNonTunnel, active_streams_non_tunnel);
-            break;
-        }
-        case PAL_STREAM_HAPTICS:
-        {
-            StreamPCM* sHap = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sHap, active_streams_haptics);
-            break;
-        }
         case PAL_STREAM_ACD:
         {
             StreamACD* sAcd = dynamic_cast<StreamACD*>(s);
             ret = deregisterstream(sAcd, active_streams_acd);
             break;
         }
-        case PAL_STREAM_ULTRASOUND:
-        {
-            StreamUltraSound* sUPD = dynamic_cast<StreamUltraSound*>(s);
-            ret = deregisterstream(sUPD, active_streams_ultrasound);
-            break;
-        }
-        case PAL_STREAM_RAW:
-        {
-            StreamPCM* sRaw = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sRaw, active_streams_raw);
-            break;
-        }
         case PAL_STREAM_SENSOR_PCM_DATA:
         {
             StreamSensorPCMData* sPCM = dynamic_cast<StreamSensorPCMData*>(s);
             ret = deregisterstream(sPCM, active_streams_sensor_pcm_data);
             break;
         }
-        case PAL_STREAM_CONTEXT_PROXY:
-        {
-            StreamContextProxy* sCtxt = dynamic_cast<StreamContextProxy*>(s);
-            ret = deregisterstream(sCtxt, active_streams_context_proxy);
-            break;
-        }
-        case PAL_STREAM_VOICE_RECOGNITION:
-        {
-            StreamPCM* sVR = dynamic_cast<StreamPCM*>(s);
-            ret = deregisterstream(sVR, active_streams_voice_rec);
-            break;
-        }
-        case PAL_STREAM_COMMON_PROXY:
-        {
-            StreamCommonProxy* sAFS = dynamic_cast<StreamCommonProxy*>(s);
-            ret = deregisterstream(sAFS, active_streams_afs);
-            break;
-        }
-
         default:
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "Invalid stream type = %d ret %d", type, ret);
             break;
     }
-
+    status = mStreamIndex.remove(s);
+    if (status == -EINVAL)
+        PAL_ERR(LOG_TAG, "Invalid stream type = %d ret %d", type, status);
+    if (!ret)
+        ret = status;
     deregisterstream(s, mActiveStreams);
 
     mActiveStreamMutex.unlock();
@@ -3849,146 +3662,98 @@ exit:
     return ret;
 }
 
-template <class T>
-bool isStreamActive(T s, std::list<T> &streams)
-{
-    bool ret = false;
-
-    PAL_DBG(LOG_TAG, "Enter.");
-    typename std::list<T>::iterator iter =
-        std::find(streams.begin(), streams.end(), s);
-    if (iter != streams.end()) {
-        ret = true;
-    }
-
-    PAL_DBG(LOG_TAG, "Exit, ret %d", ret);
-    return ret;
-}
-
 int ResourceManager::isActiveStream(pal_stream_handle_t *handle) {
-    for (auto &s : mActiveStreams) {
-        if (handle == reinterpret_cast<uint64_t *>(s)) {
-            return true;
-        }
-    }
-    return false;
+    return mStreamHandles.isActive(handle);
 }
 
 int ResourceManager::initStreamUserCounter(Stream *s)
 {
-    lockActiveStream();
-    mActiveStreamUserCounter.insert(std::make_pair(s, std::make_pair(0, true)));
+    int status;
+
     s->initStreamSmph();
-    unlockActiveStream();
-    return 0;
+    status = mStreamHandles.insert(s);
+    if (status)
+        s->deinitStreamSmph();
+    return status;
 }
 
 int ResourceManager::deactivateStreamUserCounter(Stream *s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockActiveStream();
+    int users;
+
     printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() && it->second.second == true) {
-        PAL_DBG(LOG_TAG, "stream %p is to be deactivated.", s);
-        it->second.second = false;
-        unlockActiveStream();
-        s->waitStreamSmph();
-        PAL_DBG(LOG_TAG, "stream %p is inactive.", s);
-        s->deinitStreamSmph();
-        return 0;
-    } else {
+    users = mStreamHandles.deactivate(s);
+    if (users < 0) {
         PAL_ERR(LOG_TAG, "stream %p is not found or inactive", s);
-        unlockActiveStream();
         return -EINVAL;
     }
+
+    PAL_DBG(LOG_TAG, "stream %p is to be deactivated, %d users left.", s, users);
+    if (users)
+        s->waitStreamSmph();
+    PAL_DBG(LOG_TAG, "stream %p is inactive.", s);
+    s->deinitStreamSmph();
+    return 0;
 }
 
 int ResourceManager::eraseStreamUserCounter(Stream *s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    lockActiveStream();
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        mActiveStreamUserCounter.erase(it);
-        PAL_DBG(LOG_TAG, "stream counter for %p is erased.", s);
-        unlockActiveStream();
-        return 0;
-    } else {
+    if (mStreamHandles.erase(s)) {
         PAL_ERR(LOG_TAG, "stream counter for %p is not found.", s);
-        unlockActiveStream();
         return -EINVAL;
     }
+
+    PAL_DBG(LOG_TAG, "stream counter for %p is erased.", s);
+    return 0;
+}
+
+/*
+ * Validates the handle and takes a user reference in one lock free step.
+ * The handle is not dereferenced unless it names a live stream.
+ */
+Stream* ResourceManager::acquireStream(pal_stream_handle_t *handle)
+{
+    Stream *s = mStreamHandles.acquire(handle);
+
+    if (!s)
+        PAL_ERR(LOG_TAG, "stream %p is not found or inactive.", handle);
+    return s;
 }
 
 int ResourceManager::increaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end() &&
-        it->second.second) {
-        if (0 == it->second.first) {
-            s->waitStreamSmph();
-            PAL_DBG(LOG_TAG, "stream %p in use", s);
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        it->second.first = it->second.first + 1;
-        PAL_DBG(LOG_TAG, "stream %p counter increased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found or inactive.", s);
-        return -EINVAL;
-    }
+    return acquireStream(reinterpret_cast<pal_stream_handle_t *>(s)) ? 0 : -EINVAL;
 }
 
 int ResourceManager::decreaseStreamUserCounter(Stream* s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        PAL_DBG(LOG_TAG, "stream %p counter was %d", s, it->second.first);
-        if (0 == it->second.first) {
-            PAL_ERR(LOG_TAG, "counter of stream %p has already been 0.", s);
-            return -EINVAL;
-        }
+    bool lastUser = false;
 
-        it->second.first = it->second.first - 1;
-        if (0 == it->second.first) {
-            PAL_DBG(LOG_TAG, "stream %p not in use", s);
-            s->postStreamSmph();
-        }
-        PAL_DBG(LOG_TAG, "stream %p counter decreased to %d", s, it->second.first);
-        return 0;
-    } else {
-        PAL_ERR(LOG_TAG, "stream %p is not found.", s);
+    if (mStreamHandles.release(s, &lastUser)) {
+        PAL_ERR(LOG_TAG, "stream %p is not found or not in use.", s);
         return -EINVAL;
     }
+
+    /* wake up the close waiting in deactivateStreamUserCounter */
+    if (lastUser) {
+        PAL_DBG(LOG_TAG, "stream %p not in use", s);
+        s->postStreamSmph();
+    }
+    return 0;
 }
 
 int ResourceManager::getStreamUserCounter(Stream *s)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    printStreamUserCounter(s);
-    it = mActiveStreamUserCounter.find(s);
-    if (it != mActiveStreamUserCounter.end()) {
-        return it->second.first;
-    } else {
+    int count = mStreamHandles.getUserCount(s);
+
+    if (count < 0)
         PAL_ERR(LOG_TAG, "stream %p is not found.", s);
-        return -EINVAL;
-    }
+    return count;
 }
 
-int ResourceManager::printStreamUserCounter(Stream *s)
+int ResourceManager::printStreamUserCounter(Stream *s __unused)
 {
-    std::map<Stream*, std::pair<uint32_t, bool>>::iterator it;
-    for (it = mActiveStreamUserCounter.begin();
-            it != mActiveStreamUserCounter.end(); it++) {
-        PAL_VERBOSE(LOG_TAG, "stream = %p count = %d active = %d",
-                    it->first, it->second.first, it->second.second);
-    }
-
+    mStreamHandles.dump();
     return 0;
 }
 
@@ -4336,7 +4101,7 @@ int ResourceManager::checkandEnableECForRXStream_l(std::shared_ptr<Device> rx_de
     tx_streams_list = getConcurrentTxStream_l(rx_stream, rx_dev);
     for (auto tx_stream: tx_streams_list) {
         tx_devices.clear();
-        if (!tx_stream || !isStreamActive(tx_stream, mActiveStreams)) {
+        if (!tx_stream || !mStreamIndex.contains(tx_stream)) {
             PAL_ERR(LOG_TAG, "TX Stream Empty or is not active\n");
             continue;
         }
@@ -4461,9 +4226,7 @@ int ResourceManager::registerDevice_l(std::shared_ptr<Device> d, Stream *s)
     int ret = 0;
     PAL_DBG(LOG_TAG, "Enter.");
 
-    auto iter = std::find(active_devices.begin(),
-        active_devices.end(), std::make_pair(d, s));
-    if (iter == active_devices.end())
+    if (!mStreamIndex.attachDevice(d.get(), d->getSndDeviceId(), s))
         active_devices.push_back(std::make_pair(d, s));
     else
         ret = -EINVAL;
@@ -4503,11 +4266,12 @@ int ResourceManager::deregisterDevice_l(std::shared_ptr<Device> d, Stream *s)
     int ret = 0;
     PAL_VERBOSE(LOG_TAG, "Enter.");
 
-    auto iter = std::find(active_devices.begin(),
-        active_devices.end(), std::make_pair(d, s));
-    if (iter != active_devices.end())
-        active_devices.erase(iter);
-    else {
+    if (!mStreamIndex.detachDevice(d.get(), d->getSndDeviceId(), s)) {
+        auto iter = std::find(active_devices.begin(),
+            active_devices.end(), std::make_pair(d, s));
+        if (iter != active_devices.end())
+            active_devices.erase(iter);
+    } else {
         ret = -ENOENT;
         PAL_ERR(LOG_TAG, "no device %d found in active device list ret %d",
                 d->getSndDeviceId(), ret);
@@ -4543,19 +4307,12 @@ int ResourceManager::deregisterDevice(std::shared_ptr<Device> d, Stream *s)
 bool ResourceManager::isDeviceActive(pal_device_id_t deviceId)
 {
     bool is_active = false;
-    int candidateDeviceId;
     PAL_DBG(LOG_TAG, "Enter.");
 
     mResourceManagerMutex.lock();
-    for (int i = 0; i < active_devices.size(); i++) {
-        candidateDeviceId = active_devices[i].first->getSndDeviceId();
-        if (deviceId == candidateDeviceId) {
-            is_active = true;
-            PAL_INFO(LOG_TAG, "deviceid of %d is active", deviceId);
-            break;
-        }
-    }
-
+    is_active = mStreamIndex.isDeviceAttached(deviceId);
+    if (is_active)
+        PAL_INFO(LOG_TAG, "deviceid of %d is active", deviceId);
     mResourceManagerMutex.unlock();
     PAL_DBG(LOG_TAG, "Exit.");
     return is_active;
@@ -4579,11 +4336,7 @@ bool ResourceManager::isDeviceActive_l(std::shared_ptr<Device> d, Stream *s)
     int deviceId = d->getSndDeviceId();
 
     PAL_DBG(LOG_TAG, "Enter.");
-    auto iter = std::find(active_devices.begin(),
-        active_devices.end(), std::make_pair(d, s));
-    if (iter != active_devices.end()) {
-        is_active = true;
-    }
+    is_active = mStreamIndex.isDeviceAttached(d.get(), s);
 
     PAL_DBG(LOG_TAG, "Exit. device %d is active %d", deviceId, is_active);
     return is_active;
@@ -5274,7 +5027,7 @@ int ResourceManager::handleMixerEvent(struct mixer *mixer, char *mixer_str) {
     std::map<int, std::pair<session_callback, uint64_t>>::iterator it;
 
     PAL_DBG(LOG_TAG, "Enter");
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s", mixer_str);
         status = -EINVAL;
@@ -5379,7 +5132,7 @@ int ResourceManager::HandleDetectionStreamAction(pal_stream_type_t type, int32_t
 
     PAL_DBG(LOG_TAG, "Enter");
     for (auto& str: mActiveStreams) {
-        if (!isStreamActive(str, mActiveStreams))
+        if (!mStreamIndex.contains(str))
             continue;
 
         str->getStreamAttributes(&st_attr);
@@ -5832,7 +5585,7 @@ std::vector<Stream*> ResourceManager::getConcurrentTxStream_l(
         goto exit;
     }
 
-    for (auto& tx_str: mActiveStreams) {
+    for (auto& tx_str: mStreamIndex.getStreams(PAL_AUDIO_INPUT)) {
         tx_device_list.clear();
         tx_str->getStreamAttributes(&tx_attr);
         if (tx_attr.type == PAL_STREAM_PROXY ||
@@ -6087,29 +5840,55 @@ void ResourceManager::getHigherPriorityActiveStreams(const int inComingStreamPri
 #endif
 
 
-template <class T>
-void getActiveStreams(std::shared_ptr<Device> d, std::vector<Stream*> &activestreams,
-                      std::list<T> sourcestreams)
-{
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
-                 iter != sourcestreams.end(); iter++) {
-        std::vector <std::shared_ptr<Device>> devices;
-
-        if (NULL != *iter) {
-            (*iter)->getAssociatedDevices(devices);
-            if (d == NULL) {
-                 if((*iter)->isAlive() && !devices.empty())
-                    activestreams.push_back(*iter);
-            } else {
-                typename std::vector<std::shared_ptr<Device>>::iterator result =
-                         std::find(devices.begin(), devices.end(), d);
-                if ((result != devices.end()) && (*iter)->isAlive())
-                    activestreams.push_back(*iter);
-            }
-        } else {
-            // remove element from the list if it's a NULL pointer
-            sourcestreams.erase(iter);
-        }
+/* stream groups considered by getActiveStream_l, in lookup order */
+static const active_stream_group_t activeStreamGroups[] = {
+    ACTIVE_STREAM_GROUP_LL,
+    ACTIVE_STREAM_GROUP_ULL,
+    ACTIVE_STREAM_GROUP_ULLA,
+    ACTIVE_STREAM_GROUP_DB,
+    ACTIVE_STREAM_GROUP_SA,
+    ACTIVE_STREAM_GROUP_RAW,
+    ACTIVE_STREAM_GROUP_COMP,
+    ACTIVE_STREAM_GROUP_ST,
+    ACTIVE_STREAM_GROUP_ACD,
+    ACTIVE_STREAM_GROUP_PO,
+    ACTIVE_STREAM_GROUP_PROXY,
+    ACTIVE_STREAM_GROUP_INCALL_RECORD,
+    ACTIVE_STREAM_GROUP_NON_TUNNEL,
+    ACTIVE_STREAM_GROUP_INCALL_MUSIC,
+    ACTIVE_STREAM_GROUP_HAPTICS,
+    ACTIVE_STREAM_GROUP_ULTRASOUND,
+    ACTIVE_STREAM_GROUP_SENSOR_PCM_DATA,
+    ACTIVE_STREAM_GROUP_VOICE_REC,
+};
+
+/* stream groups considered by getOrphanStream_l, in lookup order */
+static const active_stream_group_t orphanStreamGroups[] = {
+    ACTIVE_STREAM_GROUP_LL,
+    ACTIVE_STREAM_GROUP_ULL,
+    ACTIVE_STREAM_GROUP_ULLA,
+    ACTIVE_STREAM_GROUP_DB,
+    ACTIVE_STREAM_GROUP_SA,
+    ACTIVE_STREAM_GROUP_COMP,
+    ACTIVE_STREAM_GROUP_ST,
+    ACTIVE_STREAM_GROUP_ACD,
+    ACTIVE_STREAM_GROUP_PO,
+    ACTIVE_STREAM_GROUP_PROXY,
+    ACTIVE_STREAM_GROUP_INCALL_RECORD,
+    ACTIVE_STREAM_GROUP_NON_TUNNEL,
+    ACTIVE_STREAM_GROUP_INCALL_MUSIC,
+    ACTIVE_STREAM_GROUP_HAPTICS,
+    ACTIVE_STREAM_GROUP_ULTRASOUND,
+};
+
+static void getActiveStreams(std::shared_ptr<Device> d, std::vector<Stream*> &activestreams,
+                             const std::vector<Stream*> &sourcestreams)
+{
+    for (auto str : sourcestreams) {
+        if (!str->isAlive())
+            continue;
+        if (d == NULL ? str->hasAssociatedDevices() : str->isDeviceAssociated(d))
+            activestreams.push_back(str);
     }
 }
 
@@ -6121,24 +5900,8 @@ int ResourceManager::getActiveStream_l(std::vector<Stream*> &activestreams,
     activestreams.clear();
 
     // merge all types of active streams into activestreams
-    getActiveStreams(d, activestreams, active_streams_ll);
-    getActiveStreams(d, activestreams, active_streams_ull);
-    getActiveStreams(d, activestreams, active_streams_ulla);
-    getActiveStreams(d, activestreams, active_streams_db);
-    getActiveStreams(d, activestreams, active_streams_sa);
-    getActiveStreams(d, activestreams, active_streams_raw);
-    getActiveStreams(d, activestreams, active_streams_comp);
-    getActiveStreams(d, activestreams, active_streams_st);
-    getActiveStreams(d, activestreams, active_streams_acd);
-    getActiveStreams(d, activestreams, active_streams_po);
-    getActiveStreams(d, activestreams, active_streams_proxy);
-    getActiveStreams(d, activestreams, active_streams_incall_record);
-    getActiveStreams(d, activestreams, active_streams_non_tunnel);
-    getActiveStreams(d, activestreams, active_streams_incall_music);
-    getActiveStreams(d, activestreams, active_streams_haptics);
-    getActiveStreams(d, activestreams, active_streams_ultrasound);
-    getActiveStreams(d, activestreams, active_streams_sensor_pcm_data);
-    getActiveStreams(d, activestreams, active_streams_voice_rec);
+    for (auto group : activeStreamGroups)
+        getActiveStreams(d, activestreams, mStreamIndex.getStreams(group));
 
     if (activestreams.empty()) {
         ret = -ENOENT;
@@ -6164,26 +5927,16 @@ int ResourceManager::getActiveStream(std::vector<Stream*> &activestreams,
     return ret;
 }
 
-template <class T>
-void getOrphanStreams(std::vector<Stream*> &orphanstreams,
-                      std::vector<Stream*> &retrystreams,
-                      std::list<T> sourcestreams)
+static void getOrphanStreams(std::vector<Stream*> &orphanstreams,
+                             std::vector<Stream*> &retrystreams,
+                             const std::vector<Stream*> &sourcestreams)
 {
-    for (typename std::list<T>::iterator iter = sourcestreams.begin();
-                 iter != sourcestreams.end(); iter++) {
-        std::vector <std::shared_ptr<Device>> devices;
-
-        if (NULL != *iter) {
-            (*iter)->getAssociatedDevices(devices);
-            if (devices.empty())
-                orphanstreams.push_back(*iter);
+    for (auto str : sourcestreams) {
+        if (!str->hasAssociatedDevices())
+            orphanstreams.push_back(str);
 
-            if ((*iter)->suspendedDevIds.size() > 0)
-                retrystreams.push_back(*iter);
-        } else {
-            // remove element from the list if it's a NULL pointer
-            sourcestreams.erase(iter);
-        }
+        if (str->suspendedDevIds.size() > 0)
+            retrystreams.push_back(str);
     }
 }
 
@@ -6194,21 +5947,8 @@ int ResourceManager::getOrphanStream_l(std::vector<Stream*> &orphanstreams,
 
     orphanstreams.clear();
     retrystreams.clear();
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ll);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ull);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ulla);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_db);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_sa);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_comp);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_st);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_acd);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_po);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_proxy);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_incall_record);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_non_tunnel);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_incall_music);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_haptics);
-    getOrphanStreams(orphanstreams, retrystreams, active_streams_ultrasound);
+    for (auto group : orphanStreamGroups)
+        getOrphanStreams(orphanstreams, retrystreams, mStreamIndex.getStreams(group));
 
     if (orphanstreams.empty() && retrystreams.empty()) {
         ret = -ENOENT;
@@ -6848,6 +6588,7 @@ void ResourceManager::deinit()
     card_status_t state = CARD_STATUS_NONE;
 
     mixerClosed = true;
+    MixerCtlCache::invalidate();
     mixer_close(audio_virt_mixer);
     mixer_close(audio_hw_mixer);
     if (audio_route) {
@@ -7502,14 +7243,9 @@ void ResourceManager::getSharedBEActiveStreamDevs(std::vector <std::tuple<Stream
         if (backEndName == listAllBackEndIds[i].second) {
             dev = Device::getObject((pal_device_id_t) i);
             if(dev) {
-                std::list<Stream*>::iterator it;
-                for(it = mActiveStreams.begin(); it != mActiveStreams.end(); it++) {
-                    std::vector <std::shared_ptr<Device>> devices;
-                    (*it)->getAssociatedDevices(devices);
-                    typename std::vector<std::shared_ptr<Device>>::iterator result =
-                             std::find(devices.begin(), devices.end(), dev);
-                    if (result != devices.end())
-                        activeStreams.push_back(*it);
+                for (auto str : mActiveStreams) {
+                    if (str->isDeviceAssociated(dev))
+                        activeStreams.push_back(str);
                 }
                 PAL_DBG(LOG_TAG, "got dev %d active streams on dev is %zu", i, activeStreams.size() );
                 for (int j=0; j < activeStreams.size(); j++) {
@@ -8025,7 +7761,7 @@ int32_t ResourceManager::streamDevDisconnect(std::vector <std::tuple<Stream *, u
 
     /* disconnect active list from the current devices they are attached to */
     for (sIter = streamDevDisconnectList.begin(); sIter != streamDevDisconnectList.end(); sIter++) {
-        if ((std::get<0>(*sIter) != NULL) && isStreamActive(std::get<0>(*sIter), mActiveStreams)) {
+        if ((std::get<0>(*sIter) != NULL) && mStreamIndex.contains(std::get<0>(*sIter))) {
             status = (std::get<0>(*sIter))->disconnectStreamDevice(std::get<0>(*sIter), (pal_device_id_t)std::get<1>(*sIter));
             if (status) {
                 PAL_ERR(LOG_TAG, "failed to disconnect stream %pK from device %d",
@@ -8049,7 +7785,7 @@ int32_t ResourceManager::streamDevConnect(std::vector <std::tuple<Stream *, stru
     PAL_DBG(LOG_TAG, "Enter");
     /* connect active list from the current devices they are attached to */
     for (sIter = streamDevConnectList.begin(); sIter != streamDevConnectList.end(); sIter++) {
-        if ((std::get<0>(*sIter) != NULL) && isStreamActive(std::get<0>(*sIter), mActiveStreams)) {
+        if ((std::get<0>(*sIter) != NULL) && mStreamIndex.contains(std::get<0>(*sIter))) {
             status = std::get<0>(*sIter)->connectStreamDevice(std::get<0>(*sIter), std::get<1>(*sIter));
             if (status) {
                 PAL_ERR(LOG_TAG,"failed to connect stream %pK from device %d",
@@ -8074,7 +7810,7 @@ int32_t ResourceManager::streamDevDisconnect_l(std::vector <std::tuple<Stream *,
 
     /* disconnect active list from the current devices they are attached to */
     for (sIter = streamDevDisconnectList.begin(); sIter != streamDevDisconnectList.end(); sIter++) {
-        if ((std::get<0>(*sIter) != NULL) && isStreamActive(std::get<0>(*sIter), mActiveStreams)) {
+        if ((std::get<0>(*sIter) != NULL) && mStreamIndex.contains(std::get<0>(*sIter))) {
             status = (std::get<0>(*sIter))->disconnectStreamDevice_l(std::get<0>(*sIter), (pal_device_id_t)std::get<1>(*sIter));
             if (status) {
                 PAL_ERR(LOG_TAG, "failed to disconnect stream %pK from device %d",
@@ -8098,7 +7834,7 @@ int32_t ResourceManager::streamDevConnect_l(std::vector <std::tuple<Stream *, st
     PAL_DBG(LOG_TAG, "Enter");
     /* connect active list from the current devices they are attached to */
     for (sIter = streamDevConnectList.begin(); sIter != streamDevConnectList.end(); sIter++) {
-        if ((std::get<0>(*sIter) != NULL) && isStreamActive(std::get<0>(*sIter), mActiveStreams)) {
+        if ((std::get<0>(*sIter) != NULL) && mStreamIndex.contains(std::get<0>(*sIter))) {
             status = std::get<0>(*sIter)->connectStreamDevice_l(std::get<0>(*sIter), std::get<1>(*sIter));
             if (status) {
                 PAL_ERR(LOG_TAG,"failed to connect stream %pK from device %d",
@@ -8126,6 +7862,94 @@ void SortAndUnique(std::vector<T> &streams)
     return;
 }
 
+/* true if there is more than one stream to connect and none is listed twice */
+template <class T>
+static bool isEachStreamOnce(const std::vector<std::tuple<Stream *, T>> &list)
+{
+    std::vector<Stream *> streams;
+
+    for (auto &elem : list)
+        streams.push_back(std::get<0>(elem));
+    SortAndUnique(streams);
+    return streams.size() > 1 && streams.size() == list.size();
+}
+
+/*
+ * streamDevConnect_l with the prepare step of every connect (device open,
+ * KV lookup and session setup, see Stream::prepareStreamDevice_l) fanned
+ * out to one thread per stream. The device objects are resolved and their
+ * attributes applied here first, in list order, so every prepare gets the
+ * same object the serial connect would have used. The commit steps then
+ * run here in list order once all prepares are done: they serialize on
+ * the graph lock anyway, and registering a device walks the devices of
+ * other streams, which must not change under it. The connect phase thus
+ * takes about the slowest prepare plus the commits rather than the sum of
+ * full connects. Each stream must be listed once, see isEachStreamOnce.
+ */
+int32_t ResourceManager::streamDevConnectParallel_l(std::vector <std::tuple<Stream *, struct pal_device *>> &streamDevConnectList)
+{
+    int status = 0;
+    std::vector <std::tuple<Stream *, struct pal_device *>> connectList;
+    std::vector <std::future<std::pair<int32_t, std::shared_ptr<Device>>>> prepared;
+
+    for (auto &elem : streamDevConnectList) {
+        if ((std::get<0>(elem) != NULL) && mStreamIndex.contains(std::get<0>(elem)))
+            connectList.push_back(elem);
+    }
+
+    PAL_DBG(LOG_TAG, "Enter, preparing %zu streams", connectList.size());
+    for (auto &elem : connectList) {
+        Stream *s = std::get<0>(elem);
+        struct pal_device *dattr = std::get<1>(elem);
+        std::shared_ptr<Device> dev = nullptr;
+        int32_t resolved = s->resolveStreamDevice_l(dattr, dev);
+        auto prepare = [s, dattr, dev]() {
+            std::shared_ptr<Device> devToCommit = nullptr;
+            int32_t ret = s->prepareStreamDevice_l(s, dattr, dev, devToCommit);
+
+            return std::make_pair(ret, devToCommit);
+        };
+
+        /* nothing to prepare, the result is known already */
+        if (resolved || !dev) {
+            prepared.push_back(std::async(std::launch::deferred, [resolved]() {
+                return std::make_pair(resolved, std::shared_ptr<Device>(nullptr));
+            }));
+            continue;
+        }
+        try {
+            prepared.push_back(std::async(std::launch::async, prepare));
+        } catch (const std::system_error &e) {
+            PAL_ERR(LOG_TAG, "no thread for stream %pK, %s", s, e.what());
+            prepared.push_back(std::async(std::launch::deferred, prepare));
+        }
+    }
+
+    for (size_t i = 0; i < connectList.size(); i++) {
+        Stream *s = std::get<0>(connectList[i]);
+        struct pal_device *dattr = std::get<1>(connectList[i]);
+        std::pair<int32_t, std::shared_ptr<Device>> prep = prepared[i].get();
+
+        status = prep.first;
+        if (!status && prep.second)
+            status = s->commitStreamDevice_l(s, dattr, prep.second);
+        if (status) {
+            PAL_ERR(LOG_TAG,"failed to connect stream %pK from device %d",
+                    s, dattr->id);
+        } else {
+            PAL_DBG(LOG_TAG,"connected stream %pK from device %d",
+                    s, dattr->id);
+        }
+    }
+
+    /* stream mutexes are unlocked by the thread that locked them */
+    for (auto &elem : connectList)
+        std::get<0>(elem)->unlockStreamMutex();
+
+    PAL_DBG(LOG_TAG, "Exit status: %d", status);
+    return status;
+}
+
 int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint32_t>> streamDevDisconnectList,
                                          std::vector <std::tuple<Stream *, struct pal_device *>> streamDevConnectList)
 {
@@ -8137,6 +7961,9 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
     std::vector <Stream*> uniqueStreamsList;
     std::vector <struct pal_device *> uniqueDevConnectionList;
     pal_stream_attributes sAttr;
+    auto tStart = std::chrono::steady_clock::now();
+    auto tPlanned = tStart, tDisconnected = tStart, tConnected = tStart;
+    size_t numStreams = 0;
 
     PAL_INFO(LOG_TAG, "Enter");
 
@@ -8151,14 +7978,14 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
      * middle of the switch
      */
     for (sIter1 = streamDevDisconnectList.begin(); sIter1 != streamDevDisconnectList.end(); sIter1++) {
-        if ((std::get<0>(*sIter1) != NULL) && isStreamActive(std::get<0>(*sIter1), mActiveStreams)) {
+        if ((std::get<0>(*sIter1) != NULL) && mStreamIndex.contains(std::get<0>(*sIter1))) {
             uniqueStreamsList.push_back(std::get<0>(*sIter1));
             PAL_VERBOSE(LOG_TAG, "streamDevDisconnectList stream %pK", std::get<0>(*sIter1));
         }
     }
 
     for (sIter2 = streamDevConnectList.begin(); sIter2 != streamDevConnectList.end(); sIter2++) {
-        if ((std::get<0>(*sIter2) != NULL) && isStreamActive(std::get<0>(*sIter2), mActiveStreams)) {
+        if ((std::get<0>(*sIter2) != NULL) && mStreamIndex.contains(std::get<0>(*sIter2))) {
             uniqueStreamsList.push_back(std::get<0>(*sIter2));
             PAL_VERBOSE(LOG_TAG, "streamDevConnectList stream %pK", std::get<0>(*sIter2));
             uniqueDevConnectionList.push_back(std::get<1>(*sIter2));
@@ -8186,6 +8013,7 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
     }
 
     // lock all stream mutexes
+    numStreams = uniqueStreamsList.size();
     for (sIter = uniqueStreamsList.begin(); sIter != uniqueStreamsList.end(); sIter++) {
         PAL_DBG(LOG_TAG, "uniqueStreamsList stream %pK lock", (*sIter));
         (*sIter)->lockStreamMutex();
@@ -8206,18 +8034,24 @@ int32_t ResourceManager::streamDevSwitch(std::vector <std::tuple<Stream *, uint3
         }
     }
 
+    tPlanned = std::chrono::steady_clock::now();
     status = streamDevDisconnect_l(streamDevDisconnectList);
+    tDisconnected = std::chrono::steady_clock::now();
     if (status) {
         PAL_ERR(LOG_TAG, "disconnect failed");
         goto exit;
     }
-    status = streamDevConnect_l(streamDevConnectList);
+    if (isParallelDevSwitchEnabled && isEachStreamOnce(streamDevConnectList))
+        status = streamDevConnectParallel_l(streamDevConnectList);
+    else
+        status = streamDevConnect_l(streamDevConnectList);
+    tConnected = std::chrono::steady_clock::now();
     if (status) {
         PAL_ERR(LOG_TAG, "Connect failed");
     }
 
     for (sIter2 = streamDevConnectList.begin(); sIter2 != streamDevConnectList.end(); sIter2++) {
-        if ((std::get<0>(*sIter2) != NULL) && isStreamActive(std::get<0>(*sIter2), mActiveStreams)) {
+        if ((std::get<0>(*sIter2) != NULL) && mStreamIndex.contains(std::get<0>(*sIter2))) {
             for (sIter = uniqueStreamsList.begin(); sIter != uniqueStreamsList.end(); sIter++) {
                 if (*sIter == std::get<0>(*sIter2)) {
                     uniqueStreamsList.erase(sIter);
@@ -8236,6 +8070,27 @@ exit:
     }
     isDeviceSwitch = false;
     mActiveStreamMutex.unlock();
+    if (tConnected > tStart) {
+        auto us = [](std::chrono::steady_clock::duration d) {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(d).count();
+        };
+
+        auto ns = [](std::chrono::steady_clock::time_point t) {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    t.time_since_epoch()).count();
+        };
+
+        PalTrace::record(PAL_TRACE_DEVSWITCH_PLAN, ns(tStart), ns(tPlanned));
+        PalTrace::record(PAL_TRACE_DEVSWITCH_DISCONNECT, ns(tPlanned), ns(tDisconnected));
+        PalTrace::record(PAL_TRACE_DEVSWITCH_CONNECT, ns(tDisconnected), ns(tConnected));
+        PalTrace::record(PAL_TRACE_DEVSWITCH_TOTAL, ns(tStart), ns(tConnected));
+        PAL_INFO(LOG_TAG, "%zu streams switched in %lluus: plan %lluus disconnect %lluus connect %lluus",
+                 numStreams,
+                 (unsigned long long)us(tConnected - tStart),
+                 (unsigned long long)us(tPlanned - tStart),
+                 (unsigned long long)us(tDisconnected - tPlanned),
+                 (unsigned long long)us(tConnected - tDisconnected));
+    }
 exit_no_unlock:
     PAL_INFO(LOG_TAG, "Exit status: %d", status);
     return status;
@@ -8394,7 +8249,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     if (!status) {
         mActiveStreamMutex.lock();
         for (sIter = activeStreams.begin(); sIter != activeStreams.end(); sIter++) {
-            if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+            if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
                 (*sIter)->lockStreamMutex();
                 if (ResourceManager::isDummyDevEnabled) {
                     (*sIter)->removePalDevice(*sIter, inDev->getSndDeviceId());
@@ -8432,7 +8287,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     // create dev switch vectors
     mActiveStreamMutex.lock();
     for (sIter = prevActiveStreams.begin(); sIter != prevActiveStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive((*sIter), mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains((*sIter))) {
             if (!isValidDeviceSwitchForStream((*sIter), newDevAttr->id)) {
                 if (*sIter != NULL)
                     streamsSkippingSwitch.push_back({(*sIter), inDev->getSndDeviceId()});
@@ -8483,7 +8338,7 @@ int32_t ResourceManager::forceDeviceSwitch(std::shared_ptr<Device> inDev,
     if (!status) {
         mActiveStreamMutex.lock();
         for (sIter = prevActiveStreams.begin(); sIter != prevActiveStreams.end(); sIter++) {
-            if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+            if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
                 (*sIter)->lockStreamMutex();
                 if (ResourceManager::isDummyDevEnabled) {
                     (*sIter)->removePalDevice(*sIter, inDev->getSndDeviceId());
@@ -8775,6 +8630,7 @@ int ResourceManager::setConfigParams(struct str_parms *parms)
     ret = setUpdVirtualPortParam(parms, value, len);
     setXPANEnableParam(parms, value, len);
     setDummyDevEnableParam(parms, value, len);
+    setParallelDevSwitchEnableParam(parms, value, len);
 
     ret = setHapticsPriorityParam(parms, value, len);
     ret = setHapticsDrivenParam(parms, value, len);
@@ -9048,6 +8904,26 @@ void ResourceManager::setDummyDevEnableParam(struct str_parms *parms, char *valu
     }
 }
 
+void ResourceManager::setParallelDevSwitchEnableParam(struct str_parms *parms, char *value, int len)
+{
+    int ret = -EINVAL;
+
+    if (!value || !parms)
+        return;
+
+    ret = str_parms_get_str(parms, AUDIO_PARAMETER_KEY_PARALLEL_DEV_SWITCH,
+                            value, len);
+
+    if (ret >= 0) {
+        PAL_VERBOSE(LOG_TAG," value %s", value);
+
+        if (value && !strncmp(value, "true", sizeof("true")))
+            ResourceManager::isParallelDevSwitchEnabled = true;
+
+        str_parms_del(parms, AUDIO_PARAMETER_KEY_PARALLEL_DEV_SWITCH);
+    }
+}
+
 
 
 
@@ -9253,6 +9129,9 @@ int32_t ResourceManager::a2dpReconfig()
 {
     int status = 0;
     uint32_t latencyMs = 0, maxLatencyMs = 0;
+    uint64_t posUs = 0;
+    bool fixedWait = false;
+    std::vector<std::pair<Stream*, uint64_t>> drainTargets;
     std::shared_ptr<Device> a2dpDev = nullptr;
     struct pal_device a2dpDattr;
     std::vector <Stream*> activeA2dpStreams;
@@ -9292,7 +9171,7 @@ int32_t ResourceManager::a2dpReconfig()
         goto exit;
     }
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             if (!((*sIter)->a2dpMuted)) {
                 struct pal_stream_attributes sAttr;
@@ -9320,6 +9199,12 @@ int32_t ResourceManager::a2dpReconfig()
                     // Mute
                     (*sIter)->mute_l(true);
                     (*sIter)->a2dpMuted = true;
+                    // what was queued when muting is out once this much more is rendered
+                    if (!(*sIter)->getRenderPosition(&posUs))
+                        drainTargets.push_back(std::make_pair(*sIter,
+                                posUs + (uint64_t)latencyMs * 1000));
+                    else
+                        fixedWait = true;
                 }
             }
             (*sIter)->unlockStreamMutex();
@@ -9329,18 +9214,14 @@ int32_t ResourceManager::a2dpReconfig()
     mActiveStreamMutex.unlock();
 
     // wait for stale pcm drained before switching to speaker
-    if (maxLatencyMs > 0) {
-        // multiplication factor applied to latency when calculating a safe mute delay
-        // TODO: It's not needed if latency is accurate.
-        const int latencyMuteFactor = 2;
-        usleep(maxLatencyMs * 1000 * latencyMuteFactor);
-    }
+    if (maxLatencyMs > 0)
+        waitForStaleDataDrained(drainTargets, fixedWait, maxLatencyMs);
 
     forceDeviceSwitch(a2dpDev, &a2dpDattr);
 
     mActiveStreamMutex.lock();
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             struct pal_stream_attributes sAttr;
             (*sIter)->getStreamAttributes(&sAttr);
@@ -9426,7 +9307,7 @@ int32_t ResourceManager::a2dpSuspendToDummy(pal_device_id_t dev_id)
     }
 
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             associatedDevices.clear();
             status = (*sIter)->getAssociatedDevices(associatedDevices);
@@ -9463,7 +9344,7 @@ int32_t ResourceManager::a2dpSuspendToDummy(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             (*sIter)->removePalDevice(*sIter, a2dpDattr.id);
             if ((*sIter)->suspendedDevIds.size() == 1) {
@@ -9619,7 +9500,7 @@ int32_t ResourceManager::a2dpResumeFromDummy(pal_device_id_t dev_id)
         PAL_ERR(LOG_TAG, "Sound card offline");
         mActiveStreamMutex.lock();
         for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-            if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+            if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
                 (*sIter)->lockStreamMutex();
                 if (std::find((*sIter)->suspendedDevIds.begin(), (*sIter)->suspendedDevIds.end(),
                     a2dpDattr.id) != (*sIter)->suspendedDevIds.end()) {
@@ -9651,7 +9532,7 @@ int32_t ResourceManager::a2dpResumeFromDummy(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             // update PAL devices for the restored streams
             if ((*sIter)->suspendedDevIds.size() == 1 /* non-combo */) {
@@ -9735,7 +9616,7 @@ int32_t ResourceManager::a2dpCaptureSuspendToDummy(pal_device_id_t dev_id)
     }
 
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             if (!((*sIter)->a2dpMuted) && !((*sIter)->mute_l(true))) {
                 (*sIter)->a2dpMuted = true;
@@ -9756,7 +9637,7 @@ int32_t ResourceManager::a2dpCaptureSuspendToDummy(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             (*sIter)->removePalDevice(*sIter, a2dpDattr.id);
             (*sIter)->addPalDevice(*sIter, &switchDevDattr);
@@ -9859,7 +9740,7 @@ int32_t ResourceManager::a2dpCaptureResumeFromDummy(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             (*sIter)->removePalDevice(*sIter, activeDattr.id);
             (*sIter)->addPalDevice(*sIter, &a2dpDattr);
@@ -9877,10 +9758,49 @@ exit:
     return status;
 }
 
+/*
+ * Waits for the audio queued ahead of the a2dp suspend mute to be rendered,
+ * i.e. until the render position of every muted stream passes the target
+ * recorded when it was muted. If a stream cannot report its position the
+ * fixed latency based sleep is kept, which also bounds the whole wait.
+ * mActiveStreamMutex is only held around each position query, a stream
+ * closed meanwhile has nothing left to drain.
+ */
+void ResourceManager::waitForStaleDataDrained(std::vector<std::pair<Stream*, uint64_t>> &drainTargets,
+                                              bool fixedWait, uint32_t maxLatencyMs)
+{
+    // multiplication factor applied to latency when calculating a safe mute delay
+    const int latencyMuteFactor = 2;
+    uint64_t timeoutUs = (uint64_t)maxLatencyMs * 1000 * latencyMuteFactor;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(timeoutUs);
+
+    if (fixedWait || drainTargets.empty()) {
+        usleep(timeoutUs);
+        return;
+    }
+
+    for (auto &target : drainTargets) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (now >= deadline)
+            break;
+        Stream::waitForRenderPosition([this, &target](uint64_t *posUs) {
+                std::lock_guard<std::mutex> lock(mActiveStreamMutex);
+                if (!mStreamIndex.contains(target.first))
+                    return (int32_t)-ENOENT;
+                return target.first->getRenderPosition(posUs);
+            }, target.second,
+            std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+    }
+}
+
 int32_t ResourceManager::a2dpSuspend(pal_device_id_t dev_id)
 {
     int status = 0;
     uint32_t latencyMs = 0, maxLatencyMs = 0;
+    uint64_t posUs = 0;
+    bool fixedWait = false;
+    std::vector<std::pair<Stream*, uint64_t>> drainTargets;
     std::shared_ptr<Device> a2dpDev = nullptr;
     struct pal_device a2dpDattr;
     struct pal_device switchDevDattr;
@@ -9966,7 +9886,7 @@ int32_t ResourceManager::a2dpSuspend(pal_device_id_t dev_id)
         switchDevDattr.id);
 
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             associatedDevices.clear();
             status = (*sIter)->getAssociatedDevices(associatedDevices);
             if ((0 != status) ||
@@ -10013,6 +9933,12 @@ int32_t ResourceManager::a2dpSuspend(pal_device_id_t dev_id)
                     // Mute
                     if (!(*sIter)->mute_l(true))
                         (*sIter)->a2dpMuted = true;
+                    // what was queued when muting is out once this much more is rendered
+                    if (!(*sIter)->getRenderPosition(&posUs))
+                        drainTargets.push_back(std::make_pair(*sIter,
+                                posUs + (uint64_t)latencyMs * 1000));
+                    else
+                        fixedWait = true;
                 }
             }
             (*sIter)->unlockStreamMutex();
@@ -10022,18 +9948,14 @@ int32_t ResourceManager::a2dpSuspend(pal_device_id_t dev_id)
     mActiveStreamMutex.unlock();
 
     // wait for stale pcm drained before switching to speaker
-    if (maxLatencyMs > 0) {
-        // multiplication factor applied to latency when calculating a safe mute delay
-        // TODO: It's not needed if latency is accurate.
-        const int latencyMuteFactor = 2;
-        usleep(maxLatencyMs * 1000 * latencyMuteFactor);
-    }
+    if (maxLatencyMs > 0)
+        waitForStaleDataDrained(drainTargets, fixedWait, maxLatencyMs);
 
     forceDeviceSwitch(a2dpDev, &switchDevDattr, activeA2dpStreams);
 
     mActiveStreamMutex.lock();
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             struct pal_stream_attributes sAttr;
             (*sIter)->getStreamAttributes(&sAttr);
@@ -10210,7 +10132,7 @@ int32_t ResourceManager::a2dpResume(pal_device_id_t dev_id)
         PAL_ERR(LOG_TAG, "Sound card offline");
         mActiveStreamMutex.lock();
         for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-            if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+            if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
                 (*sIter)->lockStreamMutex();
                 if (std::find((*sIter)->suspendedDevIds.begin(), (*sIter)->suspendedDevIds.end(),
                     a2dpDattr.id) != (*sIter)->suspendedDevIds.end()) {
@@ -10242,7 +10164,7 @@ int32_t ResourceManager::a2dpResume(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             // update PAL devices for the restored streams
             if ((*sIter)->suspendedDevIds.size() == 1 /* non-combo */) {
@@ -10344,7 +10266,7 @@ int32_t ResourceManager::a2dpCaptureSuspend(pal_device_id_t dev_id)
     }
 
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             if (!((*sIter)->a2dpMuted)) {
                 (*sIter)->mute_l(true);
@@ -10360,7 +10282,7 @@ int32_t ResourceManager::a2dpCaptureSuspend(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = activeA2dpStreams.begin(); sIter != activeA2dpStreams.end(); sIter++) {
-        if (((*sIter) != NULL) && isStreamActive(*sIter, mActiveStreams)) {
+        if (((*sIter) != NULL) && mStreamIndex.contains(*sIter)) {
             (*sIter)->suspendedDevIds.clear();
             (*sIter)->suspendedDevIds.push_back(a2dpDattr.id);
         }
@@ -10475,7 +10397,7 @@ int32_t ResourceManager::a2dpCaptureResume(pal_device_id_t dev_id)
 
     mActiveStreamMutex.lock();
     for (sIter = restoredStreams.begin(); sIter != restoredStreams.end(); sIter++) {
-        if ((*sIter) && isStreamActive(*sIter, mActiveStreams)) {
+        if ((*sIter) && mStreamIndex.contains(*sIter)) {
             (*sIter)->lockStreamMutex();
             (*sIter)->suspendedDevIds.clear();
             (*sIter)->mute_l(false);
@@ -10490,6 +10412,58 @@ exit:
     return status;
 }
 
+static void addCacheStat(pal_param_latency_stats_t *stats, const char *name,
+                         uint64_t hits, uint64_t misses)
+{
+    pal_cache_stat_t *cache;
+
+    if (stats->num_caches >= PAL_MAX_CACHE_STATS)
+        return;
+    cache = &stats->caches[stats->num_caches++];
+    strlcpy(cache->name, name, sizeof(cache->name));
+    cache->hits = hits;
+    cache->misses = misses;
+}
+
+int ResourceManager::getTraceParameter(uint32_t param_id, void **param_payload,
+                                       size_t *payload_size)
+{
+    if (!param_payload || !payload_size)
+        return -EINVAL;
+
+    if (param_id == PAL_PARAM_ID_LATENCY_STATS) {
+        pal_param_latency_stats_t *stats =
+            (pal_param_latency_stats_t *)calloc(1, sizeof(pal_param_latency_stats_t));
+        uint64_t hits = 0, misses = 0;
+
+        if (!stats) {
+            PAL_ERR(LOG_TAG, "failed to allocate latency stats");
+            return -ENOMEM;
+        }
+        PalTrace::getLatencyStats(stats);
+        SessionAlsaUtils::getMiidCacheStats(&hits, &misses);
+        addCacheStat(stats, "miid", hits, misses);
+        MixerCtlCache::getStats(&hits, &misses);
+        addCacheStat(stats, "mixer_ctl", hits, misses);
+        BtCodecPluginCache::getStats(&hits, &misses);
+        addCacheStat(stats, "bt_codec", hits, misses);
+        *param_payload = stats;
+        *payload_size = sizeof(pal_param_latency_stats_t);
+    } else {
+        pal_param_latency_trace_t *trace =
+            (pal_param_latency_trace_t *)calloc(1, sizeof(pal_param_latency_trace_t));
+
+        if (!trace) {
+            PAL_ERR(LOG_TAG, "failed to allocate latency trace");
+            return -ENOMEM;
+        }
+        PalTrace::getEvents(trace);
+        *param_payload = trace;
+        *payload_size = sizeof(pal_param_latency_trace_t);
+    }
+    return 0;
+}
+
 int ResourceManager::getParameter(uint32_t param_id, void **param_payload,
                      size_t *payload_size, void *query __unused)
 {
@@ -10500,6 +10474,11 @@ int ResourceManager::getParameter(uint32_t param_id, void **param_payload,
         param_id == PAL_PARAM_ID_VUI_CAPTURE_META_DATA) {
         return VUIGetParameters(param_id, param_payload, payload_size);
     }
+    /* trace data is lock free, no need to wait on the RM mutex */
+    if (param_id == PAL_PARAM_ID_LATENCY_STATS ||
+        param_id == PAL_PARAM_ID_LATENCY_TRACE) {
+        return getTraceParameter(param_id, param_payload, payload_size);
+    }
 
     mResourceManagerMutex.lock();
     switch (param_id) {
@@ -11475,7 +11454,7 @@ int ResourceManager::setParameter(uint32_t param_id, void *param_payload,
                        (pal_param_haptics_intensity *)param_payload;
                 PAL_DBG(LOG_TAG, "Haptics Intensity %d", hInt->intensity);
                 char mixer_ctl_name[128] =  "Haptics Amplitude Step";
-                struct mixer_ctl *ctl = mixer_get_ctl_by_name(audio_hw_mixer, mixer_ctl_name);
+                struct mixer_ctl *ctl = MixerCtlCache::getCtl(audio_hw_mixer, mixer_ctl_name);
                 if (!ctl) {
                     PAL_ERR(LOG_TAG, "Could not get ctl for mixer cmd - %s", mixer_ctl_name);
                     status = -EINVAL;
@@ -13660,7 +13639,10 @@ void ResourceManager::startTag(void *userdata, const XML_Char *tag_name,
     } else if(strcmp(tag_name, "param") == 0) {
         processConfigParams(attr);
     } else if (strcmp(tag_name, "codec") == 0) {
-        processBTCodecInfo(attr, XML_GetSpecifiedAttributeCount(data->parser));
+        int attr_count = 0;
+        while (attr[attr_count])
+            attr_count++;
+        processBTCodecInfo(attr, attr_count);
         return;
     } else if (strcmp(tag_name, "config_gapless") == 0) {
         setGaplessMode(attr);
@@ -13826,63 +13808,15 @@ void ResourceManager::snd_data_handler(void *userdata, const XML_Char *s, int le
 
 int ResourceManager::XmlParser(std::string xmlFile)
 {
-    XML_Parser parser;
-    FILE *file = NULL;
     int ret = 0;
-    int bytes_read;
-    void *buf = NULL;
     struct xml_userdata data;
     memset(&data, 0, sizeof(data));
 
     PAL_INFO(LOG_TAG, "XML parsing started - file name %s", xmlFile.c_str());
-    file = fopen(xmlFile.c_str(), "r");
-    if(!file) {
-        ret = -ENOENT;
-        PAL_ERR(LOG_TAG, "Failed to open xml file name %s ret %d", xmlFile.c_str(), ret);
-        goto done;
-    }
-
-    parser = XML_ParserCreate(NULL);
-    if (!parser) {
-        ret = -EINVAL;
-        PAL_ERR(LOG_TAG, "Failed to create XML ret %d", ret);
-        goto closeFile;
-    }
-
-    data.parser = parser;
-    XML_SetUserData(parser, &data);
-    XML_SetElementHandler(parser, startTag, endTag);
-    XML_SetCharacterDataHandler(parser, snd_data_handler);
-
-    while (1) {
-        buf = XML_GetBuffer(parser, 1024);
-        if(buf == NULL) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "XML_Getbuffer failed ret %d", ret);
-            goto freeParser;
-        }
-
-        bytes_read = fread(buf, 1, 1024, file);
-        if(bytes_read < 0) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "fread failed ret %d", ret);
-            goto freeParser;
-        }
-
-        if(XML_ParseBuffer(parser, bytes_read, bytes_read == 0) == XML_STATUS_ERROR) {
-            ret = -EINVAL;
-            PAL_ERR(LOG_TAG, "XML ParseBuffer failed for %s file ret %d", xmlFile.c_str(), ret);
-            goto freeParser;
-        }
-        if (bytes_read == 0)
-            break;
-    }
+    ret = XmlSnapshot::parse(xmlFile, &data, startTag, endTag, snd_data_handler);
+    if (ret)
+        PAL_ERR(LOG_TAG, "XML parsing failed for %s file ret %d", xmlFile.c_str(), ret);
 
-freeParser:
-    XML_ParserFree(parser);
-closeFile:
-    fclose(file);
-done:
     return ret;
 }
 
@@ -37,100 +37,87 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <fcntl.h>
-#include <sys/poll.h>
+#include <sys/epoll.h>
 #include <list>
-#include <sys/eventfd.h>
 #include "ResourceManager.h"
 #include "PalCommon.h"
 #include "SndCardMonitor.h"
 
 #define SNDCARD_PATH "/sys/kernel/snd_card/card_state"
 #define MAX_SLEEP_RETRY 100
+#define SNDCARD_OPEN_RETRY_MS 500
 
-static int fd = -1, efd = -1;
-static int exit_thread = 0; //by default exit thread is made false
-
-void SndCardMonitor::monitorThreadLoop()
+void SndCardMonitor::onCardState(uint32_t events)
 {
-    struct pollfd *poll_fds;
-    int rv = 0;
     char buf[12];
     int card_status = 0;
-    int tries = MAX_SLEEP_RETRY;
-
     card_status_t status = CARD_STATUS_NONE;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
-    while(--tries) {
-        if (exit_thread == 1)
-            break;
-        if ((fd = open(SNDCARD_PATH, O_RDWR)) < 0) {
-            PAL_ERR(LOG_TAG, "Open failed snd sysfs node");
-        }
-        else {
-            PAL_VERBOSE(LOG_TAG, "snd sysfs node open successful");
-            break;
-        }
-        usleep(500000);
-    }
-    efd = eventfd(0, EFD_CLOEXEC);
-    if (fd == -1 || efd == -1)
-        goto Done;
-    poll_fds = (struct pollfd*) calloc(2, sizeof(struct pollfd));
-    if(NULL == poll_fds) {
-        PAL_ERR(LOG_TAG, "Memory allocation failed");
-        goto Done;
-    }
 
-    while(1) {
-        memset(buf , 0 ,sizeof(buf));
-        read(fd, buf, 10);
-        lseek(fd,0L,SEEK_SET);
+    if (!(events & EPOLLPRI))
+        return;
 
-        poll_fds[0].fd = fd;
-        poll_fds[0].events = POLLERR | POLLPRI;
-        poll_fds[0].revents = 0;
-        poll_fds[1].fd = efd;
-        poll_fds[1].events = POLLERR | POLLIN;
-        poll_fds[1].revents = 0;
+    memset(buf, 0, sizeof(buf));
+    lseek(mFd, 0L, SEEK_SET);
+    read(mFd, buf, 10);
+    sscanf(buf, "%d", &card_status);
+    PAL_INFO(LOG_TAG, "card status %d\n", card_status);
+    if (card_status == 0) {
+        status = CARD_STATUS_OFFLINE;
+    } else if (card_status == 1) {
+        status = CARD_STATUS_ONLINE;
+    } else if (card_status == 2) {
+        status = CARD_STATUS_STANDBY;
+    } else if (card_status == 3) {
+        PAL_INFO(LOG_TAG, "stop monitoring snd card state");
+        mReactor->remove(mHandle);
+        mHandle = -1;
+        return;
+    }
+
+    rm->ssrHandler(status);
+}
 
-        PAL_VERBOSE(LOG_TAG, "waiting sys_notify event\n");
-        if (( rv = poll(poll_fds, 2, -1)) < 0 ) {
-             PAL_ERR(LOG_TAG, "snd sysfs node poll error\n");
-        } else if ((poll_fds[0].revents & POLLPRI)) {
-            lseek(poll_fds[0].fd,0L,SEEK_SET);
-            read(poll_fds[0].fd, buf, 1);
-            sscanf(buf , "%d", &card_status);
-            PAL_INFO(LOG_TAG, "card status %d\n",card_status);
-            if (card_status == 0)
-                status = CARD_STATUS_OFFLINE;
-            else if (card_status == 1)
-                status = CARD_STATUS_ONLINE;
-            else if (card_status == 2)
-                status = CARD_STATUS_STANDBY;
-            else if (card_status == 3)
-                break;
+void SndCardMonitor::openNode()
+{
+    char buf[12];
 
-            rm->ssrHandler(status);
-        } else if((poll_fds[1].revents & POLLIN)) {
-            uint64_t eval;
-            read(poll_fds[1].fd, &eval, 8);
-            if (eval == 1) {
-                free(poll_fds);
-                poll_fds = NULL;
-                close(efd);
-                close(fd);
-                break;
-            }
-       }
+    if ((mFd = open(SNDCARD_PATH, O_RDWR)) < 0) {
+        PAL_ERR(LOG_TAG, "Open failed snd sysfs node");
+        if (--mTries > 0)
+            mReactor->armTimer(mRetryTimer, SNDCARD_OPEN_RETRY_MS);
+        return;
     }
-Done:
-    return;
+    PAL_VERBOSE(LOG_TAG, "snd sysfs node open successful");
+
+    /* sysfs only reports POLLPRI for changes after the node was read */
+    memset(buf, 0, sizeof(buf));
+    read(mFd, buf, 10);
+    lseek(mFd, 0L, SEEK_SET);
+
+    mHandle = mReactor->addFd(mFd, EPOLLPRI | EPOLLERR,
+        [this](uint32_t events) { onCardState(events); });
+    if (mHandle < 0)
+        PAL_ERR(LOG_TAG, "failed to watch snd sysfs node, %d", mHandle);
 }
 
 SndCardMonitor::SndCardMonitor(int sndNum)
+    : mFd(-1), mHandle(-1), mRetryTimer(-1), mTries(MAX_SLEEP_RETRY)
 {
     sndNum = 0; //not used at present.
-    mThread = std::thread(&SndCardMonitor::monitorThreadLoop, this);
+    mReactor = Reactor::getInstance();
+    if (!mReactor) {
+        PAL_ERR(LOG_TAG, "no reactor, snd card state is not monitored");
+        return;
+    }
+
+    mRetryTimer = mReactor->addTimer([this](uint32_t events __unused) { openNode(); });
+    if (mRetryTimer < 0) {
+        PAL_ERR(LOG_TAG, "failed to create retry timer, %d", mRetryTimer);
+        return;
+    }
+    /* first attempt from the reactor as well, the node may show up late */
+    mReactor->armTimer(mRetryTimer, 0);
     PAL_VERBOSE(LOG_TAG, "Snd card monitor init done.");
     return;
 }
@@ -138,9 +125,13 @@ SndCardMonitor::SndCardMonitor(int sndNum)
 
 SndCardMonitor::~SndCardMonitor()
 {
-   uint64_t eval = 1;
-   exit_thread = 1;
-   if(efd != -1)
-      write(efd, &eval, 8);
-   mThread.join();
+    if (!mReactor)
+        return;
+
+    if (mRetryTimer >= 0)
+        mReactor->remove(mRetryTimer);
+    if (mHandle >= 0)
+        mReactor->remove(mHandle);
+    if (mFd >= 0)
+        close(mFd);
 }
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: StreamHandleTable"
+
+#include <errno.h>
+#include "StreamHandleTable.h"
+#include "PalCommon.h"
+
+#define STREAM_HANDLE_TABLE_MASK (STREAM_HANDLE_TABLE_SIZE - 1)
+
+static_assert((STREAM_HANDLE_TABLE_SIZE & STREAM_HANDLE_TABLE_MASK) == 0,
+              "stream handle table size must be a power of two");
+
+StreamHandleTable::StreamHandleTable()
+{
+    for (int i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        mSlots[i].key.store(0, std::memory_order_relaxed);
+        mSlots[i].state.store(0, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < STREAM_HANDLE_TABLE_WORDS; i++)
+        mLive[i].store(0, std::memory_order_relaxed);
+    mMaxProbe.store(0, std::memory_order_release);
+}
+
+uint32_t StreamHandleTable::hash(uintptr_t key)
+{
+    return (uint32_t)(((uint64_t)key * 0x9e3779b97f4a7c15ULL) >> 32);
+}
+
+struct StreamHandleTable::slot *StreamHandleTable::find(uintptr_t key)
+{
+    uint32_t h = hash(key);
+    uint32_t probe = mMaxProbe.load(std::memory_order_acquire);
+
+    for (uint32_t i = 0; i <= probe; i++) {
+        struct slot *sl = &mSlots[(h + i) & STREAM_HANDLE_TABLE_MASK];
+        if (sl->key.load(std::memory_order_acquire) == key)
+            return sl;
+    }
+    return nullptr;
+}
+
+void StreamHandleTable::setLive(uint32_t index, bool live)
+{
+    uint64_t bit = 1ULL << (index % 64);
+
+    if (live)
+        mLive[index / 64].fetch_or(bit, std::memory_order_relaxed);
+    else
+        mLive[index / 64].fetch_and(~bit, std::memory_order_relaxed);
+}
+
+int StreamHandleTable::insert(Stream *s)
+{
+    uintptr_t key = reinterpret_cast<uintptr_t>(s);
+    uint32_t h, probe, index;
+    uint64_t state;
+
+    if (!key)
+        return -EINVAL;
+
+    h = hash(key);
+    for (uint32_t i = 0; i < STREAM_HANDLE_TABLE_SIZE; i++) {
+        struct slot *sl;
+        uintptr_t expected = 0;
+
+        index = (h + i) & STREAM_HANDLE_TABLE_MASK;
+        sl = &mSlots[index];
+        if (!sl->key.compare_exchange_strong(expected, key, std::memory_order_acq_rel))
+            continue;
+        setLive(index, true);
+
+        state = sl->state.load(std::memory_order_relaxed);
+        sl->state.store(((uint64_t)(getGeneration(state) + 1) << 32) | kActive,
+                        std::memory_order_release);
+
+        probe = mMaxProbe.load(std::memory_order_relaxed);
+        while (i > probe && !mMaxProbe.compare_exchange_weak(probe, i,
+                                                            std::memory_order_release));
+        return 0;
+    }
+
+    PAL_ERR(LOG_TAG, "no free slot for stream %p", s);
+    return -ENOSPC;
+}
+
+int StreamHandleTable::erase(Stream *s)
+{
+    struct slot *sl = find(reinterpret_cast<uintptr_t>(s));
+    uint64_t state;
+
+    if (!sl)
+        return -EINVAL;
+
+    state = sl->state.load(std::memory_order_acquire);
+    if (getCount(state))
+        PAL_ERR(LOG_TAG, "stream %p erased with %u users", s, getCount(state));
+
+    sl->state.store((uint64_t)getGeneration(state) << 32, std::memory_order_release);
+    /* before the key is freed, a new owner of the slot sets the bit again */
+    setLive((uint32_t)(sl - mSlots), false);
+    sl->key.store(0, std::memory_order_release);
+    return 0;
+}
+
+bool StreamHandleTable::isActive(const void *handle)
+{
+    struct slot *sl = find(reinterpret_cast<uintptr_t>(handle));
+
+    if (!sl || !handle)
+        return false;
+
+    return sl->state.load(std::memory_order_acquire) & kActive;
+}
+
+Stream *StreamHandleTable::acquire(const void *handle)
+{
+    uintptr_t key = reinterpret_cast<uintptr_t>(handle);
+    uint32_t h, probe, gen;
+    uint64_t state;
+
+    if (!key)
+        return nullptr;
+
+    h = hash(key);
+retry:
+    probe = mMaxProbe.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i <= probe; i++) {
+        struct slot *sl = &mSlots[(h + i) & STREAM_HANDLE_TABLE_MASK];
+
+        /*
+         * Snapshot the state before checking the key: the slot can only
+         * change owner after its state changed, which fails the CAS below.
+         */
+        state = sl->state.load(std::memory_order_acquire);
+        if (sl->key.load(std::memory_order_acquire) != key)
+            continue;
+
+        gen = getGeneration(state);
+        while (state & kActive) {
+            if (getCount(state) == kCountMask)
+                return nullptr;
+            if (sl->state.compare_exchange_weak(state, state + 1,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+                return reinterpret_cast<Stream *>(key);
+            if (getGeneration(state) != gen)
+                goto retry;
+        }
+        return nullptr;
+    }
+    return nullptr;
+}
+
+int StreamHandleTable::release(Stream *s, bool *lastUser)
+{
+    struct slot *sl = find(reinterpret_cast<uintptr_t>(s));
+    uint64_t state, next;
+
+    if (!sl)
+        return -EINVAL;
+
+    state = sl->state.load(std::memory_order_acquire);
+    do {
+        if (!getCount(state))
+            return -EINVAL;
+        next = state - 1;
+    } while (!sl->state.compare_exchange_weak(state, next,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire));
+
+    if (lastUser)
+        *lastUser = !getCount(next) && !(next & kActive);
+    return 0;
+}
+
+int StreamHandleTable::deactivate(Stream *s)
+{
+    struct slot *sl = find(reinterpret_cast<uintptr_t>(s));
+    uint64_t state;
+
+    if (!sl)
+        return -EINVAL;
+
+    state = sl->state.load(std::memory_order_acquire);
+    do {
+        if (!(state & kActive))
+            return -EINVAL;
+    } while (!sl->state.compare_exchange_weak(state, state & ~kActive,
+                                              std::memory_order_acq_rel,
+                                              std::memory_order_acquire));
+
+    return getCount(state);
+}
+
+int StreamHandleTable::getUserCount(Stream *s)
+{
+    struct slot *sl = find(reinterpret_cast<uintptr_t>(s));
+
+    if (!sl)
+        return -EINVAL;
+
+    return getCount(sl->state.load(std::memory_order_acquire));
+}
+
+void StreamHandleTable::dump()
+{
+    for (int w = 0; w < STREAM_HANDLE_TABLE_WORDS; w++) {
+        uint64_t live = mLive[w].load(std::memory_order_relaxed);
+
+        while (live) {
+            struct slot *sl = &mSlots[w * 64 + __builtin_ctzll(live)];
+            uintptr_t key = sl->key.load(std::memory_order_acquire);
+            uint64_t state = sl->state.load(std::memory_order_acquire);
+
+            live &= live - 1;
+            if (!key)
+                continue;
+            PAL_VERBOSE(LOG_TAG, "stream = %p count = %u active = %d gen = %u",
+                        reinterpret_cast<void *>(key), getCount(state),
+                        !!(state & kActive), getGeneration(state));
+        }
+    }
+}
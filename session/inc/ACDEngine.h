@@ -69,7 +69,7 @@ public:
     int32_t ReconfigureEngine(Stream *s, void *old_config, void *new_config);
 
 private:
-    static void EventProcessingThread(ACDEngine *engine);
+    void OnSessionEvent();
     static void HandleSessionCallBack(uint64_t hdl, uint32_t event_id, void *data,
                                       uint32_t event_size);
 
@@ -46,6 +46,7 @@
 #include "SoundTriggerUtils.h"
 #include "ACDPlatformInfo.h"
 #include "PayloadBuilder.h"
+#include "Reactor.h"
 
 typedef enum {
     ENG_IDLE,
@@ -109,9 +110,10 @@ protected:
     int32_t dev_disconnect_count_;
 
     eng_state_t eng_state_;
-    std::thread event_thread_handler_;
+    std::shared_ptr<Reactor> reactor_;
+    /* Reactor event handle, signaled when a session event is queued */
+    int event_handle_;
     std::mutex mutex_;
-    std::condition_variable cv_;
     bool exit_thread_;
 };
 
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAYLOAD_ARENA_H
+#define PAYLOAD_ARENA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#define PAYLOAD_ARENA_CHUNK_SIZE 4096
+
+/*
+ * Bump allocator for set/get param payloads of one session. Allocations
+ * are zeroed and 8 byte aligned, and are never freed one by one: a Scope
+ * hands back everything allocated while it was alive, chunks are kept for
+ * the next user. Not thread safe, callers hold the stream lock as they do
+ * for customPayload.
+ */
+class PayloadArena
+{
+public:
+    class Scope
+    {
+    public:
+        explicit Scope(PayloadArena &arena);
+        ~Scope();
+    private:
+        PayloadArena &mArena;
+        size_t mChunk;
+        size_t mOffset;
+    };
+
+    PayloadArena();
+    ~PayloadArena();
+    void *alloc(size_t size);
+    /* grows ptr, in place when it is the latest allocation and fits */
+    void *grow(void *ptr, size_t oldSize, size_t newSize);
+    size_t getFootprint() const;
+
+private:
+    struct chunk {
+        uint8_t *buf;
+        size_t size;
+    };
+
+    std::vector<struct chunk> mChunks;
+    size_t mCur;
+    size_t mOffset;
+    void *mLast;
+};
+
+/*
+ * Packs several apm_module_param_data_t entries back to back, each padded
+ * to 8 bytes, so they can go to the DSP with a single setParam. The buffer
+ * lives in the arena and is released with the enclosing Scope.
+ */
+class MultiParamPayload
+{
+public:
+    explicit MultiParamPayload(PayloadArena &arena);
+    /* appends a zeroed param and returns a pointer to its data */
+    void *addParam(uint32_t miid, uint32_t paramId, size_t paramSize);
+    /* appends an already built, 8 byte padded param blob */
+    int append(const uint8_t *payload, size_t size);
+    uint8_t *data() const { return mBuf; }
+    size_t size() const { return mSize; }
+    uint32_t count() const { return mCount; }
+
+private:
+    uint8_t *reserve(size_t size);
+
+    PayloadArena &mArena;
+    uint8_t *mBuf;
+    size_t mSize;
+    size_t mCapacity;
+    uint32_t mCount;
+};
+
+#endif /* PAYLOAD_ARENA_H */
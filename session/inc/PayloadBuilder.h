@@ -40,6 +40,8 @@
 #include <algorithm>
 #include <expat.h>
 #include <map>
+#include <unordered_map>
+#include <array>
 #include <regex>
 #include <sstream>
 #include "PalDefs.h"
@@ -53,6 +55,7 @@
 #include "congestion_buf_api.h"
 #include "jitter_buf_api.h"
 #include "AudioHapticsInterface.h"
+#include "PayloadArena.h"
 
 #define PAL_ALIGN_8BYTE(x) (((x) + 7) & (~7))
 #define PAL_PADDING_8BYTE_ALIGN(x)  ((((x) + 7) & 7) ^ 7)
@@ -153,6 +156,68 @@ struct allKVs {
     std::vector<kvInfo> keys_values;
 };
 
+/*
+ * Compiled form of usecaseKvManager.xml, built once in PayloadBuilder::init.
+ * Selector values are interned to integers so that a selector pair becomes a
+ * single code ((selector_type << 32) | value id) and lookups never compare
+ * strings. Every tuple the xml spells out is resolved at init into a hash
+ * keyed by the sorted codes. Nothing here is written after init, so lookups
+ * take no lock; other tuples are resolved once per thread.
+ */
+#define KV_INDEX_MAX_QUERY_SELECTORS 16
+
+typedef uint64_t selector_code_t;
+
+typedef enum {
+    KV_TABLE_STREAM = 0,
+    KV_TABLE_STREAMPP,
+    KV_TABLE_DEVICE,
+    KV_TABLE_DEVICEPP,
+    KV_TABLE_MAX,
+} kv_table_t;
+
+struct compiledKVInfo {
+    std::vector<selector_code_t> selector_codes; /* sorted */
+    std::vector<kvPairs> kv_pairs;
+};
+
+struct kvQueryKey {
+    uint32_t table;
+    int32_t type;
+    uint32_t num_codes;
+    std::array<selector_code_t, KV_INDEX_MAX_QUERY_SELECTORS> codes;
+    bool operator==(const kvQueryKey &rhs) const {
+        return table == rhs.table && type == rhs.type && num_codes == rhs.num_codes &&
+            std::equal(codes.begin(), codes.begin() + num_codes, rhs.codes.begin());
+    }
+};
+
+struct kvQueryKeyHash {
+    size_t operator()(const kvQueryKey &key) const {
+        uint64_t h = 1469598103934665603ULL;
+        auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ULL; };
+        mix(key.table);
+        mix((uint32_t)key.type);
+        for (uint32_t i = 0; i < key.num_codes; i++)
+            mix(key.codes[i]);
+        return (size_t)h;
+    }
+};
+
+struct kvLookupResult {
+    bool found;
+    std::vector<kvPairs> kv_pairs;
+};
+
+struct kvIndexTable {
+    /* one entry per <stream>/<device> block, keys_values in XML sort order */
+    std::vector<std::vector<compiledKVInfo>> blocks;
+    /* id type -> indices into blocks, in XML order */
+    std::unordered_map<int32_t, std::vector<uint32_t>> type_to_blocks;
+    /* id type -> de-duplicated selector names of all blocks listing it */
+    std::unordered_map<int32_t, std::vector<std::string>> type_to_selectors;
+};
+
 typedef enum {
     TAG_USECASEXML_ROOT,
     TAG_STREAM_SEL,
@@ -186,6 +251,11 @@ protected:
    static std::vector<allKVs> all_streampps;
    static std::vector<allKVs> all_devices;
    static std::vector<allKVs> all_devicepps;
+   static kvIndexTable kvIndex[KV_TABLE_MAX];
+   static std::unordered_map<std::string, uint32_t> selectorValueIds;
+   static std::unordered_map<kvQueryKey, kvLookupResult, kvQueryKeyHash> kvResolved;
+   static uint32_t kvIndexGeneration;
+   static bool kvIndexReady;
 
 public:
     void payloadUsbAudioConfig(uint8_t** payload, size_t* size,
@@ -194,7 +264,7 @@ public:
     void payloadDpAudioConfig(uint8_t** payload, size_t* size,
                            uint32_t miid,
                            struct dpAudioConfig *data);
-    void payloadVolumeCtrlRamp(uint8_t** payload, size_t* size,
+    static int payloadVolumeCtrlRamp(MultiParamPayload &params,
          uint32_t miid, uint32_t ramp_period_ms);
     void payloadMFCConfig(uint8_t** payload, size_t* size,
                            uint32_t miid,
@@ -203,13 +273,13 @@ public:
                            uint32_t miid, int numCh, int rotationType);
     void payloadCRSMFCMixerCoeff(uint8_t** payload, size_t* size,
                            uint32_t miid);
-    void payloadVolumeConfig(uint8_t** payload, size_t* size,
+    static int payloadVolumeConfig(MultiParamPayload &params,
                            uint32_t miid,
                            struct pal_volume_data * data);
-    void payloadMultichVolumemConfig(uint8_t** payload, size_t* size,
+    static int payloadMultichVolumemConfig(MultiParamPayload &params,
                            uint32_t miid,
                            struct pal_volume_data * data);
-    void payloadGainConfig(uint8_t** payload, size_t* size,
+    static int payloadGainConfig(MultiParamPayload &params,
                            uint32_t miid,
                            struct pal_gain_data * data);
     int payloadCustomParam(uint8_t **alsaPayload, size_t *size,
@@ -260,9 +330,9 @@ public:
             uint32_t miid, uint32_t enable);
     int payloadPopSuppressorConfig(uint8_t** payload, size_t* size,
                                    uint32_t miid, bool enable);
-    void payloadMSPPConfig(uint8_t** payload, size_t* size,
+    static int payloadMSPPConfig(MultiParamPayload &params,
                           uint32_t miid, uint32_t gain);
-    void payloadSoftPauseConfig(uint8_t** payload, size_t* size,
+    static int payloadSoftPauseConfig(MultiParamPayload &params,
                           uint32_t miid, uint32_t delayMs);
     std::unique_ptr<uint8_t[]> getPayloadEncoderBitrate(
         uint32_t encoderMIID, uint32_t newBitrate, size_t &outputPayloadSize);
@@ -295,7 +365,7 @@ public:
     void payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& module_payload, size_t *size, uint32_t moduleId);
     void payloadCABConfig(uint8_t** payload, size_t* size, uint32_t miid, bt_enc_payload_t *bt_enc_payload);
     void payloadJBMConfig(uint8_t** payload, size_t* size, uint32_t miid, bt_enc_payload_t *bt_enc_payload);
-    static int init();
+    static int init(const char *xmlFile = NULL);
     static void endTag(void *userdata, const XML_Char *tag_name);
     static void startTag(void *userdata, const XML_Char *tag_name, const XML_Char **attr);
     static void handleData(void *userdata, const char *s, int len);
@@ -317,6 +387,13 @@ public:
     static bool findKVs(std::vector<std::pair<selector_type_t, std::string>>
         &filled_selector_pairs, uint32_t type, std::vector<allKVs> &any_type,
         std::vector<std::pair<int32_t, int32_t>> &keyVector);
+    static void buildKVIndex();
+    static int getKVTableId(const std::vector<allKVs> &any_type);
+    static bool encodeSelectorPairs(const std::vector<std::pair<selector_type_t, std::string>>
+        &filled_selector_pairs, kvQueryKey &key);
+    static void resolveKVIndex(const kvQueryKey &key, kvLookupResult &result);
+    static bool lookupKVIndex(const kvQueryKey &key,
+        std::vector<std::pair<int32_t, int32_t>> &keyVector);
     static std::string removeSpaces(const std::string& str);
     static std::vector<std::string> splitStrings(const std::string& str);
     static int getBtDeviceKV(int dev_id, std::vector<std::pair<int, int>> &deviceKV,
@@ -110,6 +110,7 @@ protected:
     std::vector<std::pair<int32_t, std::string>> txAifBackEnds;
     void *customPayload;
     size_t customPayloadSize;
+    PayloadArena payloadArena;
     int updateCustomPayload(void *payload, size_t size);
     int freeCustomPayload(uint8_t **payload, size_t *payloadSize);
     uint32_t eventId;
@@ -125,6 +126,7 @@ protected:
     bool frontEndIdAllocated = false;
     struct pal_param_haptics_cnfg_t *hpCnfg;
     void setInitialVolume();
+    int setInitialVolumeBatch(struct pal_stream_attributes *sAttr);
 public:
     bool isMixerEventCbRegd;
     bool isPauseRegistrationDone;
@@ -160,6 +162,8 @@ public:
     virtual int writeBufferInit(Stream *s __unused, size_t noOfBuf __unused, size_t bufSize __unused, int flag __unused) {return 0;};
     virtual int read(Stream *s __unused, int tag __unused, struct pal_buffer *buf __unused, int * size __unused) {return 0;};
     virtual int write(Stream *s __unused, int tag __unused, struct pal_buffer *buf __unused, int * size __unused, int flag __unused) {return 0;};
+    virtual int readBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size);
+    virtual int writeBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size);
     virtual int getParameters(Stream *s __unused, int tagId __unused, uint32_t param_id __unused, void **payload __unused) {return 0;};
     virtual int setParameters(Stream *s __unused, int tagId __unused, uint32_t param_id __unused, void *payload __unused) {return 0;};
     virtual int registerCallBack(session_callback cb __unused, uint64_t cookie __unused) {return 0;};
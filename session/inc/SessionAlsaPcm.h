@@ -79,6 +79,23 @@
 class Stream;
 class Session;
 
+/*
+ * Per period constants of the read/write path. Snapshotted from the stream
+ * attributes and the opened pcm at start, refreshed lazily after a stream
+ * attribute or device change invalidates them. Only valid for the pcm it
+ * was built from, so a pcm opened after start gets its frame size.
+ */
+struct session_data_path {
+    struct pcm *pcm; /* pcm the descriptor was built from, NULL when stale */
+    bool isMmap;
+    uint32_t frameSize;
+    uint32_t inSampleRate;
+    uint32_t outSampleRate;
+    long inPeriodNs;
+    long outPeriodNs;
+    int xruns; /* pcm xruns already reported to the stream */
+};
+
 class SessionAlsaPcm : public Session
 {
 private:
@@ -105,6 +122,14 @@ private:
     static std::mutex pcmLpmRefCntMtx;
     static int pcmLpmRefCnt;
     int32_t configureInCallRxMFC();
+    struct session_data_path dataPath;
+    int updateDataPath(Stream *s);
+    void invalidateDataPath() { dataPath.pcm = NULL; }
+    bool isDataPathValid() const { return pcm && dataPath.pcm == pcm; }
+    long bytesToNs(size_t bytes, uint32_t sampleRate);
+    int readPcm(Stream *s, struct pal_buffer *buf, int *size);
+    int writePcm(Stream *s, struct pal_buffer *buf, int *size);
+    void updateXruns(Stream *s);
 public:
 
     SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm);
@@ -123,6 +148,8 @@ public:
     int writeBufferInit(Stream *s, size_t noOfBuf, size_t bufSize, int flag) override;
     int read(Stream *s, int tag, struct pal_buffer *buf, int * size) override;
     int write(Stream *s, int tag, struct pal_buffer *buf, int * size, int flag) override;
+    int readBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size) override;
+    int writeBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size) override;
     int setParameters(Stream *s, int tagId, uint32_t param_id, void *payload) override;
     int getParameters(Stream *s, int tagId, uint32_t param_id, void **payload) override;
     int setECRef(Stream *s, std::shared_ptr<Device> rx_dev, bool is_enable) override;
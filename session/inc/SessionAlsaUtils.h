@@ -36,6 +36,9 @@
 
 #include <tinyalsa/asoundlib.h>
 #include <sound/asound.h>
+#include <map>
+#include <mutex>
+#include <atomic>
 
 
 class Stream;
@@ -83,6 +86,14 @@ private:
     static struct mixer_ctl *getBeMixerControl(struct mixer *am, std::string beName,
         uint32_t idx);
     static struct mixer_ctl *getStaticMixerControl(struct mixer *am, std::string name);
+    static int fetchModuleInstanceIds(struct mixer *mixer, int device,
+                       std::map<int, uint32_t> &miids);
+    /* tag -> MIID tables per (FE device, stream metadata type) */
+    static std::map<std::pair<int, std::string>, std::map<int, uint32_t>> miidCache;
+    static std::mutex miidCacheMutex;
+    static uint32_t miidCacheGeneration;
+    static std::atomic<uint64_t> miidCacheHits;
+    static std::atomic<uint64_t> miidCacheMisses;
 public:
     ~SessionAlsaUtils();
     static bool isRxDevice(uint32_t devId);
@@ -111,8 +122,13 @@ public:
                        int tag_id, uint32_t *miid);
     static int getTagsWithModuleInfo(struct mixer *mixer, int device, const char *intf_name,
                        uint8_t *payload);
+    static void invalidateMiidCache();
+    static void getMiidCacheStats(uint64_t *hits, uint64_t *misses);
     static int setMixerParameter(struct mixer *mixer, int device,
                                  void *payload, int size);
+    /* sends every param packed in params with one setParam */
+    static int setMixerParameter(struct mixer *mixer, int device,
+                                 MultiParamPayload &params);
     static int setStreamMetadataType(struct mixer *mixer, int device, const char *val);
     static int registerMixerEvent(struct mixer *mixer, int device, const char *intf_name, int tag_id, void *payload, int payload_size);
     static int registerMixerEvent(struct mixer *mixer, int device, void *payload, int payload_size);
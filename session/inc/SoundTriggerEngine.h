@@ -110,6 +110,7 @@ public:
     virtual bool CheckForStartRecognition() { return false; }
 
     uint32_t UsToBytes(uint64_t input_us);
+    uint64_t BytesToUs(uint64_t bytes);
     uint32_t FrameToBytes(uint32_t frames);
     uint32_t BytesToFrames(uint32_t bytes);
 
@@ -105,6 +105,9 @@ private:
     int32_t StopSoundEngine();
     int32_t StartKeywordDetection();
     int32_t StartUserVerification();
+    int32_t GetProcessInput(char **copy_buff, size_t copy_buff_size, size_t size,
+                            char **data, bool *in_place);
+    bool IsRejectedEarly(uint32_t processed_sz, uint32_t decision_sz);
     int32_t UpdateConfThreshold(Stream *s);
     static void BufferThreadLoop(SoundTriggerEngineCapi *capi_engine);
 
@@ -127,6 +130,7 @@ private:
     uint32_t data_after_kw_end_;
     int32_t det_conf_score_;
     int32_t detection_state_;
+    uint64_t detected_ns_;
     stage2_uv_wrapper_scratch_param_t in_model_buffer_param_;
     stage2_uv_wrapper_scratch_param_t scratch_param_;
 };
@@ -63,6 +63,7 @@
 #ifndef SOUNDTRIGGERENGINEGSL_H
 #define SOUNDTRIGGERENGINEGSL_H
 
+#include <algorithm>
 #include <map>
 #include <queue>
 #include "SoundTriggerEngine.h"
@@ -70,6 +71,7 @@
 #include "StreamSoundTrigger.h"
 #include "PalRingBuffer.h"
 #include "PayloadBuilder.h"
+#include "LatencyHistogram.h"
 #include "detection_cmn_api.h"
 
 typedef enum {
@@ -146,6 +148,10 @@ class SoundTriggerEngineGsl : public SoundTriggerEngine {
     void ProcessEventTask();
     void HandleSessionEvent(uint32_t event_id __unused, void *data, uint32_t size);
     int32_t StartBuffering(Stream *s);
+    size_t WriteLabData(Stream *s, uint8_t *data, size_t size, bool is_ftrt,
+        uint32_t *bytes_to_drop, FILE *dump_fd);
+    void WaitForBufferingEvent(uint64_t wait_us);
+    void StopBuffering();
     int32_t RestartRecognition_l(Stream *s);
     int32_t UpdateSessionPayload(Stream *s, st_param_id_type_t param);
 
@@ -199,6 +205,13 @@ class SoundTriggerEngineGsl : public SoundTriggerEngine {
     size_t mmap_buffer_size_;
     uint32_t mmap_write_position_;
     uint64_t kw_transfer_latency_;
+    /* wakes StartBuffering on stop and on consecutive detections */
+    std::condition_variable buffering_cv_;
+    bool kw_first_byte_written_;
+    /* detection event to first byte in the ring buffer */
+    static LatencyHistogram kw_first_byte_hist_;
+    /* kw_transfer_begin to kw_transfer_end, i.e. the whole FTRT transfer */
+    static LatencyHistogram kw_ftrt_hist_;
     int32_t ec_ref_count_;
     std::map<Stream*, ChronoSteadyClock_t> detection_time_map_;
     std::mutex state_mutex_;
@@ -339,29 +339,14 @@ void ACDEngine::ParseEventAndNotifyClient()
     mutex_.lock();
 }
 
-void ACDEngine::EventProcessingThread(ACDEngine *engine)
+void ACDEngine::OnSessionEvent()
 {
-    PAL_INFO(LOG_TAG, "Enter. start thread loop");
-    if (!engine) {
-        PAL_ERR(LOG_TAG, "Error:%d Invalid engine", -EINVAL);
-        return;
-    }
+    std::unique_lock<std::mutex> lck(mutex_);
 
-    std::unique_lock<std::mutex> lck(engine->mutex_);
-    while (!engine->exit_thread_) {
-        if (engine->eventQ.empty()) {
-            PAL_DBG(LOG_TAG, "waiting on cond");
-            engine->cv_.wait(lck);
-            PAL_DBG(LOG_TAG, "done waiting on cond");
+    if (exit_thread_ || eventQ.empty())
+        return;
 
-            if (engine->exit_thread_) {
-                PAL_VERBOSE(LOG_TAG, "Exit thread");
-                break;
-            }
-        }
-        engine->ParseEventAndNotifyClient();
-    }
-    PAL_DBG(LOG_TAG, "Exit");
+    ParseEventAndNotifyClient();
 }
 
 void ACDEngine::HandleSessionEvent(uint32_t event_id __unused,
@@ -376,7 +361,8 @@ void ACDEngine::HandleSessionEvent(uint32_t event_id __unused,
     std::unique_lock<std::mutex> lck(mutex_);
     memcpy(event_data, data, size);
     eventQ.push(event_data);
-    cv_.notify_one();
+    if (event_handle_ > 0)
+        reactor_->signal(event_handle_);
 }
 
 void ACDEngine::HandleSessionCallBack(uint64_t hdl, uint32_t event_id,
@@ -1095,11 +1081,16 @@ int32_t ACDEngine::SetupEngine(Stream *st, void *config)
         goto exit;
     }
     exit_thread_ = false;
-    event_thread_handler_ = std::thread(ACDEngine::EventProcessingThread, this);
-
-    if (!event_thread_handler_.joinable()) {
-        PAL_ERR(LOG_TAG, "Error:%d failed to create event processing thread",
-                status);
+    reactor_ = Reactor::getInstance();
+    if (reactor_)
+        /* detections are passed on to the streams and their clients */
+        event_handle_ = reactor_->addEvent([this](uint32_t events __unused) {
+            OnSessionEvent();
+        }, true);
+
+    if (event_handle_ < 0) {
+        PAL_ERR(LOG_TAG, "Error:%d failed to create event handler",
+                event_handle_);
         session_->close(s);
         status = -EINVAL;
         goto exit;
@@ -1162,12 +1153,12 @@ int32_t ACDEngine::TeardownEngine(Stream *st, void *config)
     }
 
     exit_thread_ = true;
-    if (event_thread_handler_.joinable()) {
-        cv_.notify_one();
+    if (event_handle_ > 0) {
         lck.unlock();
-        event_thread_handler_.join();
+        reactor_->remove(event_handle_);
         lck.lock();
-        PAL_INFO(LOG_TAG, "Thread joined");
+        event_handle_ = -1;
+        PAL_INFO(LOG_TAG, "Event handler removed");
     }
 
     /* No need to unload soundmodel as the graph/engine instance will get closed */
@@ -74,6 +74,8 @@ ContextDetectionEngine::ContextDetectionEngine(
     eng_state_ = ENG_IDLE;
     sm_cfg_ = sm_cfg;
     exit_thread_ = false;
+    reactor_ = nullptr;
+    event_handle_ = -1;
     stream_handle_ = s;
     eng_state_ = ENG_IDLE;
     builder_ = new PayloadBuilder();
@@ -107,14 +109,13 @@ ContextDetectionEngine::~ContextDetectionEngine()
 {
     PAL_INFO(LOG_TAG, "Enter");
 
-    if (event_thread_handler_.joinable()) {
+    if (event_handle_ > 0) {
         std::unique_lock<std::mutex> lck(mutex_);
         exit_thread_ = true;
-        cv_.notify_one();
         lck.unlock();
-        event_thread_handler_.join();
-        lck.lock();
-        PAL_INFO(LOG_TAG, "Thread joined");
+        reactor_->remove(event_handle_);
+        event_handle_ = -1;
+        PAL_INFO(LOG_TAG, "Event handler removed");
     }
 
     if (session_) {
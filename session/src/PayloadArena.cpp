@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: PayloadArena"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PayloadArena.h"
+#include "PalCommon.h"
+#include "apm_api.h"
+
+#define PAYLOAD_ALIGN_8BYTE(x) (((x) + 7) & (~7))
+#define MULTI_PARAM_MIN_CAPACITY 256
+
+PayloadArena::Scope::Scope(PayloadArena &arena)
+    : mArena(arena), mChunk(arena.mCur), mOffset(arena.mOffset)
+{
+}
+
+PayloadArena::Scope::~Scope()
+{
+    mArena.mCur = mChunk;
+    mArena.mOffset = mOffset;
+    mArena.mLast = nullptr;
+}
+
+PayloadArena::PayloadArena()
+    : mCur(0), mOffset(0), mLast(nullptr)
+{
+}
+
+PayloadArena::~PayloadArena()
+{
+    for (auto &c : mChunks)
+        free(c.buf);
+}
+
+void *PayloadArena::alloc(size_t size)
+{
+    uint8_t *ptr = nullptr;
+
+    size = PAYLOAD_ALIGN_8BYTE(size);
+    if (!size)
+        return nullptr;
+
+    if (mCur < mChunks.size() && mOffset + size > mChunks[mCur].size) {
+        mCur++;
+        mOffset = 0;
+    }
+    /* skip chunks too small for this request, they stay for later scopes */
+    while (mCur < mChunks.size() && size > mChunks[mCur].size)
+        mCur++;
+
+    if (mCur >= mChunks.size()) {
+        struct chunk c;
+
+        c.size = size > PAYLOAD_ARENA_CHUNK_SIZE ? size : PAYLOAD_ARENA_CHUNK_SIZE;
+        c.buf = (uint8_t *)malloc(c.size);
+        if (!c.buf) {
+            PAL_ERR(LOG_TAG, "failed to allocate %zu byte chunk", c.size);
+            return nullptr;
+        }
+        mChunks.push_back(c);
+        mCur = mChunks.size() - 1;
+        mOffset = 0;
+    }
+
+    ptr = mChunks[mCur].buf + mOffset;
+    mOffset += size;
+    memset(ptr, 0, size);
+    mLast = ptr;
+    return ptr;
+}
+
+void *PayloadArena::grow(void *ptr, size_t oldSize, size_t newSize)
+{
+    uint8_t *p = (uint8_t *)ptr;
+    uint8_t *grown = nullptr;
+    size_t start;
+
+    if (!ptr)
+        return alloc(newSize);
+    if (newSize <= oldSize)
+        return ptr;
+
+    if (ptr == mLast) {
+        start = p - mChunks[mCur].buf;
+        if (start + PAYLOAD_ALIGN_8BYTE(newSize) <= mChunks[mCur].size) {
+            memset(p + oldSize, 0, PAYLOAD_ALIGN_8BYTE(newSize) - oldSize);
+            mOffset = start + PAYLOAD_ALIGN_8BYTE(newSize);
+            return ptr;
+        }
+    }
+
+    grown = (uint8_t *)alloc(newSize);
+    if (grown)
+        memcpy(grown, p, oldSize);
+    return grown;
+}
+
+size_t PayloadArena::getFootprint() const
+{
+    size_t total = 0;
+
+    for (auto &c : mChunks)
+        total += c.size;
+    return total;
+}
+
+MultiParamPayload::MultiParamPayload(PayloadArena &arena)
+    : mArena(arena), mBuf(nullptr), mSize(0), mCapacity(0), mCount(0)
+{
+}
+
+uint8_t *MultiParamPayload::reserve(size_t size)
+{
+    size_t capacity = mCapacity ? mCapacity : MULTI_PARAM_MIN_CAPACITY;
+    uint8_t *buf = nullptr;
+
+    if (mSize + size <= mCapacity)
+        return mBuf + mSize;
+
+    while (capacity < mSize + size)
+        capacity <<= 1;
+
+    buf = (uint8_t *)mArena.grow(mBuf, mSize, capacity);
+    if (!buf) {
+        PAL_ERR(LOG_TAG, "failed to grow multi param payload to %zu", capacity);
+        return nullptr;
+    }
+    mBuf = buf;
+    mCapacity = capacity;
+    return mBuf + mSize;
+}
+
+void *MultiParamPayload::addParam(uint32_t miid, uint32_t paramId, size_t paramSize)
+{
+    struct apm_module_param_data_t *header = nullptr;
+    size_t size = PAYLOAD_ALIGN_8BYTE(sizeof(struct apm_module_param_data_t) + paramSize);
+    uint8_t *entry = reserve(size);
+
+    if (!entry)
+        return nullptr;
+
+    /* the arena hands out zeroed memory, padding included */
+    header = (struct apm_module_param_data_t *)entry;
+    header->module_instance_id = miid;
+    header->param_id = paramId;
+    header->error_code = 0x0;
+    header->param_size = paramSize;
+    mSize += size;
+    mCount++;
+    PAL_VERBOSE(LOG_TAG, "IID:%x param_id:%x param_size:%zu total %zu",
+                miid, paramId, paramSize, mSize);
+
+    return entry + sizeof(struct apm_module_param_data_t);
+}
+
+int MultiParamPayload::append(const uint8_t *payload, size_t size)
+{
+    uint8_t *entry = nullptr;
+
+    if (!payload || !size || (size & 7))
+        return -EINVAL;
+
+    entry = reserve(size);
+    if (!entry)
+        return -ENOMEM;
+
+    memcpy(entry, payload, size);
+    mSize += size;
+    mCount++;
+    return 0;
+}
@@ -80,6 +80,8 @@
 #include "mspp_module_calibration_api.h"
 #include "tsm_module_api.h"
 #include "USBAudio.h"
+#include "XmlSnapshot.h"
+#include "PalTrace.h"
 
 #if defined(FEATURE_IPQ_OPENWRT) || defined(LINUX_ENABLED)
 #define USECASE_XML_FILE "/etc/usecaseKvManager.xml"
@@ -293,6 +295,11 @@ std::vector<allKVs> PayloadBuilder::all_streams;
 std::vector<allKVs> PayloadBuilder::all_streampps;
 std::vector<allKVs> PayloadBuilder::all_devices;
 std::vector<allKVs> PayloadBuilder::all_devicepps;
+kvIndexTable PayloadBuilder::kvIndex[KV_TABLE_MAX];
+std::unordered_map<std::string, uint32_t> PayloadBuilder::selectorValueIds;
+std::unordered_map<kvQueryKey, kvLookupResult, kvQueryKeyHash> PayloadBuilder::kvResolved;
+uint32_t PayloadBuilder::kvIndexGeneration = 0;
+bool PayloadBuilder::kvIndexReady = false;
 
 template <typename T>
 void PayloadBuilder::populateChannelMixerCoeff(T pcmChannel, uint8_t numChannel,
@@ -531,15 +538,12 @@ void PayloadBuilder::payloadDpAudioConfig(uint8_t** payload, size_t* size,
 }
 
 #define PLAYBACK_VOLUME_MAX 0x2000
-void PayloadBuilder::payloadVolumeConfig(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadVolumeConfig(MultiParamPayload &params,
         uint32_t miid, struct pal_volume_data* voldata)
 {
-    struct apm_module_param_data_t* header = nullptr;
     volume_ctrl_master_gain_t *volConf = nullptr;
     float voldB = 0.0f;
     long vol = 0;
-    uint8_t* payloadInfo = NULL;
-    size_t payloadSize = 0, padBytes = 0;
 
     if (voldata->no_of_volpair == 1) {
         voldB = (voldata->volume_pair[0].vol);
@@ -550,58 +554,31 @@ void PayloadBuilder::payloadVolumeConfig(uint8_t** payload, size_t* size,
     }
     PAL_VERBOSE(LOG_TAG,"volume sent:%f \n",voldB);
     vol = (long)(voldB * (PLAYBACK_VOLUME_MAX*1.0));
-    payloadSize = sizeof(struct apm_module_param_data_t) +
-                  sizeof(struct volume_ctrl_master_gain_t);
-    padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
-        return;
-    }
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = PARAM_ID_VOL_CTRL_MASTER_GAIN;
-    header->error_code = 0x0;
-    header->param_size = payloadSize -  sizeof(struct apm_module_param_data_t);
-    volConf = (volume_ctrl_master_gain_t *) (payloadInfo + sizeof(struct apm_module_param_data_t));
+    volConf = (volume_ctrl_master_gain_t *)params.addParam(miid,
+                  PARAM_ID_VOL_CTRL_MASTER_GAIN, sizeof(struct volume_ctrl_master_gain_t));
+    if (!volConf)
+        return -ENOMEM;
     volConf->master_gain = vol;
-    PAL_VERBOSE(LOG_TAG, "header params IID:%x param_id:%x error_code:%d param_size:%d",
-                  header->module_instance_id, header->param_id,
-                  header->error_code, header->param_size);
-    *size = payloadSize + padBytes;;
-    *payload = payloadInfo;
-    PAL_DBG(LOG_TAG, "payload %pK size %zu", *payload, *size);
+    PAL_DBG(LOG_TAG, "IID:%x master gain %ld, payload size %zu", miid, vol, params.size());
+    return 0;
 }
 
-void PayloadBuilder::payloadMultichVolumemConfig(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadMultichVolumemConfig(MultiParamPayload &params,
         uint32_t miid, struct pal_volume_data* voldata)
 {
     const uint32_t PLAYBACK_MULTI_VOLUME_GAIN = 1 << 28;
-    struct apm_module_param_data_t* header = nullptr;
     volume_ctrl_multichannel_gain_t *volConf = nullptr;
-    struct apm_module_param_data_t* muteheader = nullptr;
     volume_ctrl_master_mute_t *muteConf = nullptr;
     int numChannels;
-    uint8_t* payloadInfo = NULL;
-    size_t payloadSize = 0, padBytes = 0, mutePayloadSize = 0, mutePadBytes = 0;
     uint32_t mute_flag = 1;
 
     numChannels = voldata->no_of_volpair;
-    payloadSize = sizeof(struct apm_module_param_data_t) +
+    volConf = (volume_ctrl_multichannel_gain_t *)params.addParam(miid,
+                  PARAM_ID_VOL_CTRL_MULTICHANNEL_GAIN,
                   sizeof(struct volume_ctrl_multichannel_gain_t) +
-                  numChannels * sizeof(volume_ctrl_channels_gain_config_t);
-    padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
-        return;
-    }
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = PARAM_ID_VOL_CTRL_MULTICHANNEL_GAIN;
-    header->error_code = 0x0;
-    header->param_size = payloadSize -  sizeof(struct apm_module_param_data_t);
-    volConf = (volume_ctrl_multichannel_gain_t *) (payloadInfo + sizeof(struct apm_module_param_data_t));
+                  numChannels * sizeof(volume_ctrl_channels_gain_config_t));
+    if (!volConf)
+        return -ENOMEM;
     volConf->num_config = numChannels;
     PAL_DBG(LOG_TAG, "num_config %d", numChannels);
     /*
@@ -618,101 +595,50 @@ void PayloadBuilder::payloadMultichVolumemConfig(uint8_t** payload, size_t* size
              mute_flag = 0;
 
     }
-    PAL_DBG(LOG_TAG, "header params IID:%x param_id:%x error_code:%d param_size:%d",
-                  header->module_instance_id, header->param_id,
-                  header->error_code, header->param_size);
 
     //always unmute when set multi channel gain
-    mutePayloadSize = sizeof(struct apm_module_param_data_t) +
-                      sizeof(struct volume_ctrl_master_mute_t);
-    mutePadBytes = PAL_PADDING_8BYTE_ALIGN(mutePayloadSize);
-    payloadInfo = (uint8_t*) realloc(payloadInfo, payloadSize + padBytes +
-                                        mutePayloadSize + mutePadBytes);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "payloadInfo realloc failed %s", strerror(errno));
-        return;
-    }
-    muteheader = (struct apm_module_param_data_t*) (payloadInfo + payloadSize + padBytes);
-    muteheader->module_instance_id = miid;
-    muteheader->param_id = PARAM_ID_VOL_CTRL_MASTER_MUTE;
-    muteheader->error_code = 0x0;
-    muteheader->param_size = mutePayloadSize -  sizeof(struct apm_module_param_data_t);
-    muteConf = (volume_ctrl_master_mute_t *) (payloadInfo + payloadSize + padBytes +
-                                                sizeof(struct apm_module_param_data_t));
+    muteConf = (volume_ctrl_master_mute_t *)params.addParam(miid,
+                  PARAM_ID_VOL_CTRL_MASTER_MUTE, sizeof(struct volume_ctrl_master_mute_t));
+    if (!muteConf)
+        return -ENOMEM;
     muteConf->mute_flag = mute_flag;
-    PAL_DBG(LOG_TAG, "header params IID:%x param_id:%x error_code:%d param_size:%d",
-                  muteheader->module_instance_id, muteheader->param_id,
-                  muteheader->error_code, muteheader->param_size);
-    *size = payloadSize + padBytes + mutePayloadSize + mutePadBytes;
-    *payload = payloadInfo;
-    PAL_DBG(LOG_TAG, "payload %pK size %zu", *payload, *size);
+    PAL_DBG(LOG_TAG, "IID:%x mute_flag %d, payload size %zu", miid, mute_flag, params.size());
+    return 0;
 }
 
-void PayloadBuilder::payloadGainConfig(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadGainConfig(MultiParamPayload &params,
         uint32_t miid, struct pal_gain_data* gaindata)
 
 {
-    struct apm_module_param_data_t* header = nullptr;
     struct param_id_module_gain_cfg_t *gainConf = nullptr;
-    uint8_t* payloadInfo = NULL;
-    size_t payloadSize = 0, padBytes = 0;
 
     PAL_VERBOSE(LOG_TAG,"Gain set:%f \n",gaindata->gain);
     uint16_t gainQ13 = gaindata->gain;
-    payloadSize = sizeof(struct apm_module_param_data_t) +
-                  sizeof(struct param_id_module_gain_cfg_t);
-    padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
-        return;
-    }
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = PARAM_ID_GAIN_MODULE_GAIN;
-    header->error_code = 0x0;
-    header->param_size = payloadSize -  sizeof(struct apm_module_param_data_t);
-    gainConf = (param_id_module_gain_cfg_t *) (payloadInfo + sizeof(struct apm_module_param_data_t));
+    gainConf = (param_id_module_gain_cfg_t *)params.addParam(miid,
+                  PARAM_ID_GAIN_MODULE_GAIN, sizeof(struct param_id_module_gain_cfg_t));
+    if (!gainConf)
+        return -ENOMEM;
     gainConf->gain = gainQ13;
-    PAL_DBG(LOG_TAG, "header params IID:%x param_id:%x error_code:%d param_size:%d",
-                  header->module_instance_id, header->param_id,
-                  header->error_code, header->param_size);
-    *size = payloadSize + padBytes;;
-    *payload = payloadInfo;
-    PAL_DBG(LOG_TAG, "payload %pK size %zu", *payload, *size);
+    PAL_DBG(LOG_TAG, "IID:%x gain %d, payload size %zu", miid, gainQ13, params.size());
+    return 0;
 }
 
-void PayloadBuilder::payloadVolumeCtrlRamp(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadVolumeCtrlRamp(MultiParamPayload &params,
         uint32_t miid, uint32_t ramp_period_ms)
 {
-    struct apm_module_param_data_t* header = NULL;
     struct volume_ctrl_gain_ramp_params_t *rampParams;
-    uint8_t* payloadInfo = NULL;
-    size_t payloadSize = 0, padBytes = 0;
 
-    payloadSize = sizeof(struct apm_module_param_data_t) +
-                  sizeof(struct volume_ctrl_gain_ramp_params_t);
-    padBytes = PAL_PADDING_8BYTE_ALIGN(payloadSize);
-    payloadInfo = (uint8_t*) calloc(1, payloadSize + padBytes);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "payloadInfo malloc failed %s", strerror(errno));
-        return;
-    }
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = PARAM_ID_VOL_CTRL_GAIN_RAMP_PARAMETERS;
-    header->error_code = 0x0;
-    header->param_size = payloadSize -  sizeof(struct apm_module_param_data_t);
-    rampParams = (struct volume_ctrl_gain_ramp_params_t*) (payloadInfo + sizeof(struct apm_module_param_data_t));
+    rampParams = (struct volume_ctrl_gain_ramp_params_t *)params.addParam(miid,
+                  PARAM_ID_VOL_CTRL_GAIN_RAMP_PARAMETERS,
+                  sizeof(struct volume_ctrl_gain_ramp_params_t));
+    if (!rampParams)
+        return -ENOMEM;
     rampParams->period_ms = ramp_period_ms;
     rampParams->step_us = 0;
     rampParams->ramping_curve = PARAM_VOL_CTRL_RAMPINGCURVE_LINEAR;
-    PAL_VERBOSE(LOG_TAG, "header params IID:%x param_id:%x error_code:%d param_size:%d",
-                  header->module_instance_id, header->param_id,
-                  header->error_code, header->param_size);
-    *size = payloadSize + padBytes;;
-    *payload = payloadInfo;
-    PAL_DBG(LOG_TAG, "payload %pK size %zu", *payload, *size);
+    PAL_DBG(LOG_TAG, "IID:%x ramp %d ms, payload size %zu", miid, ramp_period_ms,
+            params.size());
+    return 0;
 }
 
 void PayloadBuilder::payloadMFCMixerCoeff(uint8_t** payload, size_t* size,
@@ -1318,67 +1244,200 @@ void PayloadBuilder::handleData(void *userdata, const char *s, int len)
    }
 }
 
-int PayloadBuilder::init()
+int PayloadBuilder::init(const char *xmlFile)
 {
-    XML_Parser parser;
-    FILE *file = NULL;
     int ret = 0;
-    int bytes_read;
-    void *buf = NULL;
     struct user_xml_data tag_data;
+    const char *file = xmlFile ? xmlFile : USECASE_XML_FILE;
     memset(&tag_data, 0, sizeof(tag_data));
+    kvIndexReady = false;
     all_streams.clear();
     all_streampps.clear();
     all_devices.clear();
     all_devicepps.clear();
 
-    PAL_INFO(LOG_TAG, "XML parsing started %s", USECASE_XML_FILE);
-    file = fopen(USECASE_XML_FILE, "r");
-    if (!file) {
-        PAL_ERR(LOG_TAG, "Failed to open xml");
+    PAL_INFO(LOG_TAG, "XML parsing started %s", file);
+    ret = XmlSnapshot::parse(file, &tag_data, startTag, endTag, handleData);
+    if (ret) {
+        PAL_ERR(LOG_TAG, "Failed to parse xml ret %d", ret);
         ret = -EINVAL;
         goto done;
     }
 
-    parser = XML_ParserCreate(NULL);
-    if (!parser) {
-        PAL_ERR(LOG_TAG, "Failed to create XML");
-        goto closeFile;
+    buildKVIndex();
+
+done:
+    return ret;
+}
+
+int PayloadBuilder::getKVTableId(const std::vector<allKVs> &any_type)
+{
+    if (&any_type == &all_streams)
+        return KV_TABLE_STREAM;
+    if (&any_type == &all_streampps)
+        return KV_TABLE_STREAMPP;
+    if (&any_type == &all_devices)
+        return KV_TABLE_DEVICE;
+    if (&any_type == &all_devicepps)
+        return KV_TABLE_DEVICEPP;
+    return -1;
+}
+
+static bool matchSelectorCodes(const std::vector<selector_code_t> &selector_codes,
+    const kvQueryKey &key)
+{
+    /* same rules as compareSelectorPairs, on sorted integer codes */
+    if (key.num_codes == 0)
+        return selector_codes.empty();
+
+    if (key.num_codes == selector_codes.size())
+        return std::equal(selector_codes.begin(), selector_codes.end(), key.codes.begin());
+
+    for (uint32_t i = 0; i < key.num_codes; i++) {
+        if (!std::binary_search(selector_codes.begin(), selector_codes.end(), key.codes[i]))
+            return false;
     }
-    XML_SetUserData(parser,&tag_data);
-    XML_SetElementHandler(parser, startTag, endTag);
-    XML_SetCharacterDataHandler(parser, handleData);
+    return true;
+}
 
-    while (1) {
-        buf = XML_GetBuffer(parser, 1024);
-        if (buf == NULL) {
-            PAL_ERR(LOG_TAG, "XML_Getbuffer failed");
-            ret = -EINVAL;
-            goto freeParser;
-        }
+bool PayloadBuilder::encodeSelectorPairs(
+    const std::vector<std::pair<selector_type_t, std::string>> &filled_selector_pairs,
+    kvQueryKey &key)
+{
+    if (filled_selector_pairs.size() > KV_INDEX_MAX_QUERY_SELECTORS)
+        return false;
+
+    key.num_codes = filled_selector_pairs.size();
+    for (uint32_t i = 0; i < key.num_codes; i++) {
+        auto id = selectorValueIds.find(filled_selector_pairs[i].second);
+        /* a value never seen in the xml gets an id no selector can match */
+        uint32_t value_id = (id != selectorValueIds.end()) ? id->second : UINT32_MAX;
+        key.codes[i] = ((selector_code_t)filled_selector_pairs[i].first << 32) | value_id;
+    }
+    std::sort(key.codes.begin(), key.codes.begin() + key.num_codes);
+    return true;
+}
+
+void PayloadBuilder::resolveKVIndex(const kvQueryKey &key, kvLookupResult &result)
+{
+    const kvIndexTable &table = kvIndex[key.table];
+    auto blocks = table.type_to_blocks.find(key.type);
+
+    result.found = false;
+    result.kv_pairs.clear();
+    if (blocks == table.type_to_blocks.end())
+        return;
 
-        bytes_read = fread(buf, 1, 1024, file);
-        if (bytes_read < 0) {
-            PAL_ERR(LOG_TAG, "fread failed");
-            ret = -EINVAL;
-            goto freeParser;
+    for (uint32_t b : blocks->second) {
+        for (auto &info : table.blocks[b]) {
+            if (matchSelectorCodes(info.selector_codes, key)) {
+                result.kv_pairs.insert(result.kv_pairs.end(), info.kv_pairs.begin(),
+                    info.kv_pairs.end());
+                result.found = true;
+                break;
+            }
         }
+    }
+}
 
-        if (XML_ParseBuffer(parser, bytes_read, bytes_read == 0) == XML_STATUS_ERROR) {
-            PAL_ERR(LOG_TAG, "XML ParseBuffer failed ");
-            ret = -EINVAL;
-            goto freeParser;
+bool PayloadBuilder::lookupKVIndex(const kvQueryKey &key,
+    std::vector<std::pair<int32_t, int32_t>> &keyVector)
+{
+    /* tuples not spelled out in the xml, resolved by this thread before */
+    static thread_local std::unordered_map<kvQueryKey, kvLookupResult, kvQueryKeyHash> misses;
+    static thread_local uint32_t missesGeneration = 0;
+    const kvLookupResult *result = NULL;
+
+    auto resolved = kvResolved.find(key);
+    if (resolved != kvResolved.end()) {
+        result = &resolved->second;
+    } else {
+        if (missesGeneration != kvIndexGeneration) {
+            misses.clear();
+            missesGeneration = kvIndexGeneration;
         }
-        if (bytes_read == 0)
-            break;
+        auto miss = misses.find(key);
+        if (miss == misses.end()) {
+            miss = misses.emplace(key, kvLookupResult()).first;
+            resolveKVIndex(key, miss->second);
+        }
+        result = &miss->second;
     }
 
-freeParser:
-    XML_ParserFree(parser);
-closeFile:
-    fclose(file);
-done:
-    return ret;
+    for (auto &kv : result->kv_pairs)
+        keyVector.push_back(std::make_pair(kv.key, kv.value));
+    return result->found;
+}
+
+void PayloadBuilder::buildKVIndex()
+{
+    std::vector<allKVs> *tables[KV_TABLE_MAX] = {&all_streams, &all_streampps,
+        &all_devices, &all_devicepps};
+    kvQueryKey key = {};
+
+    kvResolved.clear();
+    kvIndexGeneration++;
+    selectorValueIds.clear();
+
+    for (int t = 0; t < KV_TABLE_MAX; t++) {
+        kvIndexTable &table = kvIndex[t];
+
+        table.blocks.clear();
+        table.type_to_blocks.clear();
+        table.type_to_selectors.clear();
+        for (uint32_t b = 0; b < tables[t]->size(); b++) {
+            allKVs &block = (*tables[t])[b];
+            std::vector<compiledKVInfo> compiled;
+
+            for (auto &info : block.keys_values) {
+                compiledKVInfo ci;
+
+                for (auto &sel : info.selector_pairs) {
+                    auto id = selectorValueIds.emplace(sel.second, selectorValueIds.size());
+                    ci.selector_codes.push_back(((selector_code_t)sel.first << 32) |
+                        id.first->second);
+                }
+                std::sort(ci.selector_codes.begin(), ci.selector_codes.end());
+                ci.kv_pairs = info.kv_pairs;
+                compiled.push_back(std::move(ci));
+            }
+            table.blocks.push_back(std::move(compiled));
+
+            for (int32_t type : block.id_type) {
+                table.type_to_blocks[type].push_back(b);
+                std::vector<std::string> &names = table.type_to_selectors[type];
+                for (auto &info : block.keys_values)
+                    names.insert(names.end(), info.selector_names.begin(),
+                        info.selector_names.end());
+            }
+        }
+        for (auto &sel : table.type_to_selectors)
+            removeDuplicateSelectors(sel.second);
+    }
+
+    /* resolve every tuple the xml spells out, plus the empty tuple */
+    for (int t = 0; t < KV_TABLE_MAX; t++) {
+        for (auto &types : kvIndex[t].type_to_blocks) {
+            key.table = t;
+            key.type = types.first;
+            key.num_codes = 0;
+            resolveKVIndex(key, kvResolved[key]);
+            for (uint32_t b : types.second) {
+                for (auto &info : kvIndex[t].blocks[b]) {
+                    if (info.selector_codes.size() > KV_INDEX_MAX_QUERY_SELECTORS)
+                        continue;
+                    key.num_codes = info.selector_codes.size();
+                    std::copy(info.selector_codes.begin(), info.selector_codes.end(),
+                        key.codes.begin());
+                    if (kvResolved.find(key) == kvResolved.end())
+                        resolveKVIndex(key, kvResolved[key]);
+                }
+            }
+        }
+    }
+    kvIndexReady = true;
+    PAL_INFO(LOG_TAG, "KV index built, %zu selector values, %zu resolved tuples",
+        selectorValueIds.size(), kvResolved.size());
 }
 
 void PayloadBuilder::payloadTimestamp(std::shared_ptr<std::vector<uint8_t>>& payload,
@@ -2556,6 +2615,7 @@ int PayloadBuilder::populateStreamKV(Stream* s, std::vector<std::pair<int,int>>
     struct pal_stream_attributes *sattr = NULL;
     std::vector<std::string> selector_names;
     std::vector<std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
 
     PAL_DBG(LOG_TAG, "Enter");
@@ -2622,6 +2682,7 @@ int PayloadBuilder::populateStreamPPKV(Stream* s, std::vector <std::pair<int,int
     struct pal_stream_attributes *sattr = NULL;
     std::vector <std::string> selectors;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_DBG(LOG_TAG, "Enter");
     sattr = new struct pal_stream_attributes();
@@ -2698,6 +2759,15 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
     std::vector<std::pair<int, int>> &keyVector)
 {
     bool found = false;
+    int table = getKVTableId(any_type);
+    kvQueryKey key;
+
+    if (kvIndexReady && table >= 0) {
+        key.table = table;
+        key.type = type;
+        if (encodeSelectorPairs(filled_selector_pairs, key))
+            return lookupKVIndex(key, keyVector);
+    }
 
     for (int32_t i = 0; i < any_type.size(); i++) {
         if (isIdTypeAvailable(type, any_type[i].id_type)) {
@@ -2709,7 +2779,7 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
                             keyVector.push_back(
                                 std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
+                            PAL_DBG(LOG_TAG, "key: 0x%x value: 0x%x\n",
                                 any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value);
                         }
@@ -2722,7 +2792,7 @@ bool PayloadBuilder::findKVs(std::vector<std::pair<selector_type_t, std::string>
                             keyVector.push_back(
                                 std::make_pair(any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value));
-                            PAL_INFO(LOG_TAG, "key: 0x%x value: 0x%x\n",
+                            PAL_DBG(LOG_TAG, "key: 0x%x value: 0x%x\n",
                                 any_type[i].keys_values[j].kv_pairs[k].key,
                                 any_type[i].keys_values[j].kv_pairs[k].value);
                         }
@@ -2962,6 +3032,14 @@ std::vector<std::string> PayloadBuilder::retrieveSelectors(int32_t type, std::ve
     std::vector<std::string> gkv_selectors;
     PAL_DBG(LOG_TAG, "Enter: size_of_all :%zu type:%d", any_type.size(), type);
 
+    int table = getKVTableId(any_type);
+    if (kvIndexReady && table >= 0) {
+        auto sel = kvIndex[table].type_to_selectors.find(type);
+        if (sel != kvIndex[table].type_to_selectors.end())
+            gkv_selectors = sel->second;
+        return gkv_selectors;
+    }
+
     /* looping for all keys_and_values selectors and store in the gkv_selectors */
     for (int32_t i = 0; i < any_type.size(); i++) {
          if (isIdTypeAvailable(type, any_type[i].id_type)) {
@@ -2990,6 +3068,7 @@ int PayloadBuilder::populateStreamKV(Stream* s,
     struct pal_stream_attributes *sattr = NULL;
     std::vector <std::string> selectors;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_DBG(LOG_TAG, "enter");
     sattr = new struct pal_stream_attributes;
@@ -3036,6 +3115,7 @@ int PayloadBuilder::populateStreamKVTunnel(Stream* s,
     std::vector <std::string> selectors;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     std::stringstream st;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_DBG(LOG_TAG, "enter");
     sattr = new struct pal_stream_attributes;
@@ -3094,6 +3174,7 @@ int PayloadBuilder::populateStreamDeviceKV(Stream* s, int32_t rxBeDevId,
     int status = 0;
     std::vector <std::pair<int, int>> emptyKV;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_VERBOSE(LOG_TAG,"Enter");
     if (rm->isOutputDevId(rxBeDevId)) {
@@ -3125,6 +3206,7 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t beDevId,
     std::shared_ptr<Device> dev = nullptr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
     uint32_t soundCardId = 0;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     if (s)
         soundCardId = s->getSoundCardId();
@@ -3168,6 +3250,7 @@ int PayloadBuilder::populateDeviceKV(Stream* s, int32_t rxBeDevId,
     int status = 0;
     struct pal_stream_attributes sAttr;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_DBG(LOG_TAG, "Enter");
 
@@ -3204,6 +3287,7 @@ int PayloadBuilder::populateDeviceKVTunnel(Stream* s, int32_t beDevId,
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
     struct pal_device dAttr;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     /* For BT devices, device KV will be populated from Bluetooth device only so skip here */
     if (rm->isBtDevice((pal_device_id_t)beDevId)) {
@@ -3237,6 +3321,7 @@ int PayloadBuilder::populateDevicePPKVTunnel(Stream* s, int32_t rxBeDevId,
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
     std::vector <std::string> selectors;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     /* Populate Rx Device PP KV */
     if (rxBeDevId > 0) {
@@ -3266,6 +3351,7 @@ int PayloadBuilder::populateDevicePPKV(Stream* s, int32_t rxBeDevId,
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
     std::vector <std::string> selectors;
     std::vector <std::pair<selector_type_t, std::string>> filled_selector_pairs;
+    PalTraceScope trace(PAL_TRACE_KV_LOOKUP, (uint64_t)s);
 
     PAL_DBG(LOG_TAG, "Enter");
     /* Populate Rx Device PP KV */
@@ -4315,82 +4401,30 @@ void PayloadBuilder::payloadSPConfig(uint8_t** payload, size_t* size, uint32_t m
     *payload = payloadInfo;
 }
 
-void PayloadBuilder::payloadMSPPConfig(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadMSPPConfig(MultiParamPayload &params,
         uint32_t miid, uint32_t gain)
 {
-    struct apm_module_param_data_t* header = NULL;
-    uint8_t* payloadInfo = NULL;
-    uint32_t param_id = 0;
-    size_t payloadSize = 0, customPayloadSize = 0;
     mspp_volume_ctrl_gain_t *mspp_payload;
 
-    param_id = PARAM_ID_MSPP_VOLUME;
-    customPayloadSize = sizeof(mspp_volume_ctrl_gain_t);
-
-    payloadSize = PAL_ALIGN_8BYTE(sizeof(struct apm_module_param_data_t)
-                                        + customPayloadSize);
-    payloadInfo = (uint8_t *)calloc(1, (size_t)payloadSize);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "failed to allocate memory.");
-        return;
-    }
-
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = param_id;
-    header->error_code = 0x0;
-    header->param_size = customPayloadSize;
-
-    mspp_payload =
-        (mspp_volume_ctrl_gain_t *)(payloadInfo +
-         sizeof(struct apm_module_param_data_t));
+    mspp_payload = (mspp_volume_ctrl_gain_t *)params.addParam(miid,
+                  PARAM_ID_MSPP_VOLUME, sizeof(mspp_volume_ctrl_gain_t));
+    if (!mspp_payload)
+        return -ENOMEM;
     mspp_payload->vol_lin_gain = gain;
-    ar_mem_cpy(payloadInfo + sizeof(struct apm_module_param_data_t),
-                     customPayloadSize,
-                     mspp_payload,
-                     customPayloadSize);
-
-    *size = payloadSize;
-    *payload = payloadInfo;
+    return 0;
 }
 
-void PayloadBuilder::payloadSoftPauseConfig(uint8_t** payload, size_t* size,
+int PayloadBuilder::payloadSoftPauseConfig(MultiParamPayload &params,
         uint32_t miid, uint32_t delayMs)
 {
-    struct apm_module_param_data_t* header = NULL;
-    uint8_t* payloadInfo = NULL;
-    uint32_t param_id = 0;
-    size_t payloadSize = 0, customPayloadSize = 0;
     pause_downstream_delay_t *pause_payload;
 
-    param_id = PARAM_ID_SOFT_PAUSE_DOWNSTREAM_DELAY;
-    customPayloadSize = sizeof(pause_downstream_delay_t);
-
-    payloadSize = PAL_ALIGN_8BYTE(sizeof(struct apm_module_param_data_t)
-                                        + customPayloadSize);
-    payloadInfo = (uint8_t *)calloc(1, (size_t)payloadSize);
-    if (!payloadInfo) {
-        PAL_ERR(LOG_TAG, "failed to allocate memory.");
-        return;
-    }
-
-    header = (struct apm_module_param_data_t*)payloadInfo;
-    header->module_instance_id = miid;
-    header->param_id = param_id;
-    header->error_code = 0x0;
-    header->param_size = customPayloadSize;
-
-    pause_payload =
-        (pause_downstream_delay_t *)(payloadInfo +
-         sizeof(struct apm_module_param_data_t));
+    pause_payload = (pause_downstream_delay_t *)params.addParam(miid,
+                  PARAM_ID_SOFT_PAUSE_DOWNSTREAM_DELAY, sizeof(pause_downstream_delay_t));
+    if (!pause_payload)
+        return -ENOMEM;
     pause_payload->delay_ms = delayMs;
-    ar_mem_cpy(payloadInfo + sizeof(struct apm_module_param_data_t),
-                     customPayloadSize,
-                     pause_payload,
-                     customPayloadSize);
-
-    *size = payloadSize;
-    *payload = payloadInfo;
+    return 0;
 }
 
 void PayloadBuilder::payloadPlaybackRateParametersConfig(uint8_t** payload, size_t* size,
@@ -71,6 +71,7 @@
 #include "SessionAlsaCompress.h"
 #include "SessionAgm.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "SessionAlsaVoice.h"
 
 #include <sstream>
@@ -292,6 +293,40 @@ exit:
     return status;
 }
 
+/*
+ * Generic batch transfers for sessions without a native batch path, one
+ * read/write per buffer. *size holds the bytes moved before any error.
+ */
+int Session::readBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size)
+{
+    int status = 0;
+    int bytesRead = 0;
+
+    *size = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        status = read(s, tag, &bufs[i], &bytesRead);
+        if (status)
+            break;
+        *size += bytesRead;
+    }
+    return status;
+}
+
+int Session::writeBatch(Stream *s, int tag, struct pal_buffer *bufs, uint32_t count, int *size)
+{
+    int status = 0;
+    int bytesWritten = 0;
+
+    *size = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        status = write(s, tag, &bufs[i], &bytesWritten, 0);
+        if (status)
+            break;
+        *size += bytesWritten;
+    }
+    return status;
+}
+
 int Session::getEffectParameters(Stream *s __unused, effect_pal_payload_t *effectPayload)
 {
     int status = 0;
@@ -814,7 +849,7 @@ int Session::setSlotMask(const std::shared_ptr<ResourceManager>& rm, struct pal_
 
     // set FE ctl to BE first in case this is called from connectionSessionDevice
     rm->getBackendName(dAttr.id, backendname);
-    ctl = mixer_get_ctl_by_name(mixer, feName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, feName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", feName.str().data());
         status = -EINVAL;
@@ -824,7 +859,7 @@ int Session::setSlotMask(const std::shared_ptr<ResourceManager>& rm, struct pal_
     ctl = NULL;
 
     // set tag data
-    ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
         status = -EINVAL;
@@ -1250,6 +1285,10 @@ void Session::setInitialVolume() {
                 vol_set_param_info.streams_.end(), sAttr.type) !=
                 vol_set_param_info.streams_.end());
     if ((isStreamAvail && vol_set_param_info.isVolumeUsingSetParam) || forceSetParameters) {
+        if (sAttr.direction == PAL_AUDIO_OUTPUT && streamHandle->mVolumeData &&
+            !setInitialVolumeBatch(&sAttr))
+            goto exit;
+
         if (sAttr.direction == PAL_AUDIO_OUTPUT) {
            /* DSP default volume is highest value, non-0 rampping period
             * brings volume burst from highest amplitude to new volume
@@ -1315,6 +1354,48 @@ exit:
     PAL_DBG(LOG_TAG, "Exit status: %d", status);
 }
 
+/*
+ * Ramp period 0, the cached volume and the default ramp period packed in
+ * one setParam for output streams. The volume module applies them in
+ * order, as it did for the three separate setParameters calls.
+ */
+int Session::setInitialVolumeBatch(struct pal_stream_attributes *sAttr)
+{
+    PayloadArena::Scope arenaScope(payloadArena);
+    MultiParamPayload params(payloadArena);
+    struct pal_volume_data *vdata = streamHandle->mVolumeData;
+    int32_t device = getFrontEndId(RX_HOSTLESS);
+    uint32_t miid = 0;
+    int status = 0;
+
+    if (device < 0 || rxAifBackEnds.empty())
+        return -EINVAL;
+
+    status = SessionAlsaUtils::getModuleInstanceId(mixer, device,
+                 rxAifBackEnds[0].second.data(), TAG_STREAM_VOLUME, &miid);
+    if (status) {
+        PAL_ERR(LOG_TAG, "Failed to get volume module miid, status %d", status);
+        return status;
+    }
+
+    status = PayloadBuilder::payloadVolumeCtrlRamp(params, miid, 0);
+    if (!status) {
+        if (vdata->no_of_volpair > 1 && sAttr->out_media_config.ch_info.channels > 1)
+            status = PayloadBuilder::payloadMultichVolumemConfig(params, miid, vdata);
+        else
+            status = PayloadBuilder::payloadVolumeConfig(params, miid, vdata);
+    }
+    if (!status)
+        status = PayloadBuilder::payloadVolumeCtrlRamp(params, miid, DEFAULT_RAMP_PERIOD);
+    if (status)
+        return status;
+
+    status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+    PAL_DBG(LOG_TAG, "%u params, %zu bytes, status %d", params.count(), params.size(),
+            status);
+    return status;
+}
+
 #if 0
 int setConfig(Stream * s, pal_stream_type_t sType, configType type, uint32_t tag1,
         uint32_t tag2, uint32_t tag3)
@@ -1356,7 +1437,7 @@ int setConfig(Stream * s, pal_stream_type_t sType, configType type, uint32_t tag
                 goto exit;
             }
             tagCntrlName << stream << pcmDevIds.at(0) << " " << setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 return -ENOENT;
@@ -36,6 +36,7 @@
 
 #include "SessionAlsaCompress.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "Stream.h"
 #include "ResourceManager.h"
 #include "media_fmt_api.h"
@@ -1084,7 +1085,7 @@ int SessionAlsaCompress::setTKV(Stream * s __unused, configType type, effect_pal
                 goto exit;
             }
             tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1162,7 +1163,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, uint32_t tag1,
                 goto exit;
             }
             tagCntrlName << stream << compressDevIds.at(0) << " " << setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1228,7 +1229,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
     }
     beCntrlName<<stream<<compressDevIds.at(0)<<" "<<setBEControl;
 
-    ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, beCntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
         return -ENOENT;
@@ -1265,7 +1266,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             }
             //TODO: how to get the id '5'
             tagCntrlName<<stream<<compressDevIds.at(0)<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 if (tagConfig)
@@ -1307,7 +1308,7 @@ int SessionAlsaCompress::setConfig(Stream * s, configType type, int tag)
             status = SessionAlsaUtils::getCalMetadata(ckv, calConfig);
             //TODO: how to get the id '0'
             calCntrlName<<stream<<compressDevIds.at(0)<<" "<<setCalibrationControl;
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, calCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 status = -ENOENT;
@@ -1535,65 +1536,31 @@ int SessionAlsaCompress::start(Stream * s)
                 }
 
                 if (PAL_DEVICE_OUT_SPEAKER == dAttr.id && !strcmp(dAttr.custom_config.custom_key, "mspp")) {
-
-                    uint8_t* payload = NULL;
-                    size_t payloadSize = 0;
+                    PayloadArena::Scope arenaScope(payloadArena);
+                    MultiParamPayload params(payloadArena);
                     uint32_t miid;
                     int32_t volStatus;
+
                     volStatus = SessionAlsaUtils::getModuleInstanceId(mixer, compressDevIds.at(0),
                                                                     rxAifBackEnds[0].second.data(), TAG_MODULE_MSPP, &miid);
                     if (volStatus != 0) {
                         PAL_ERR(LOG_TAG,"get MSPP ModuleInstanceId failed");
                         break;
                     }
-
-                    builder->payloadMSPPConfig(&payload, &payloadSize, miid, rm->linear_gain.gain);
-                    if (payloadSize && payload) {
-                        volStatus = updateCustomPayload(payload, payloadSize);
-                        free(payload);
-                        if (0 != volStatus) {
-                            PAL_ERR(LOG_TAG,"updateCustomPayload Failed\n");
-                            break;
-                        }
-                    }
-                    volStatus = SessionAlsaUtils::setMixerParameter(mixer, compressDevIds.at(0),
-                                                                 customPayload, customPayloadSize);
-                    if (customPayload) {
-                        free(customPayload);
-                        customPayload = NULL;
-                        customPayloadSize = 0;
-                    }
-                    if (volStatus != 0) {
-                        PAL_ERR(LOG_TAG,"setMixerParameter failed for MSPP module");
-                        break;
-                    }
+                    PayloadBuilder::payloadMSPPConfig(params, miid, rm->linear_gain.gain);
 
                     //to set soft pause delay for MSPP use case.
                     status = SessionAlsaUtils::getModuleInstanceId(mixer, compressDevIds.at(0),
                                                                     rxAifBackEnds[0].second.data(), TAG_PAUSE, &miid);
-                    if (status != 0) {
+                    if (status != 0)
                         PAL_ERR(LOG_TAG,"get Soft Pause ModuleInstanceId failed");
-                        break;
-                    }
+                    else
+                        PayloadBuilder::payloadSoftPauseConfig(params, miid, MSPP_SOFT_PAUSE_DELAY);
 
-                    builder->payloadSoftPauseConfig(&payload, &payloadSize, miid, MSPP_SOFT_PAUSE_DELAY);
-                    if (payloadSize && payload) {
-                        status = updateCustomPayload(payload, payloadSize);
-                        free(payload);
-                        if (0 != status) {
-                            PAL_ERR(LOG_TAG,"updateCustomPayload Failed\n");
-                            break;
-                        }
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, compressDevIds.at(0),
-                                                                 customPayload, customPayloadSize);
-                    if (customPayload) {
-                        free(customPayload);
-                        customPayload = NULL;
-                        customPayloadSize = 0;
-                    }
-                    if (status != 0) {
-                        PAL_ERR(LOG_TAG,"setMixerParameter failed for soft Pause module");
+                    /* MSPP gain and soft pause delay share one setParam */
+                    volStatus = SessionAlsaUtils::setMixerParameter(mixer, compressDevIds.at(0), params);
+                    if (volStatus != 0) {
+                        PAL_ERR(LOG_TAG,"setMixerParameter failed for MSPP module");
                         break;
                     }
                 }
@@ -2086,7 +2053,7 @@ struct mixer_ctl* SessionAlsaCompress::getFEMixerCtl(const char *controlName, in
 
     *device = compressDevIds.at(0);
     CntrlName << "COMPRESS" << compressDevIds.at(0) << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return nullptr;
@@ -2286,19 +2253,17 @@ int SessionAlsaCompress::setParameters(Stream *s __unused, int tagId, uint32_t p
                 goto exit;
             }
 
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
             if (vdata->no_of_volpair > 1 && sAttr.out_media_config.ch_info.channels > 1) {
-                builder->payloadMultichVolumemConfig(&alsaParamData, &alsaPayloadSize, miid, vdata);
+                PayloadBuilder::payloadMultichVolumemConfig(params, miid, vdata);
             } else {
-                builder->payloadVolumeConfig(&alsaParamData, &alsaPayloadSize, miid, vdata);
+                PayloadBuilder::payloadVolumeConfig(params, miid, vdata);
             }
 
-            if (alsaPayloadSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               alsaParamData, alsaPayloadSize);
-                PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
-                freeCustomPayload(&alsaParamData, &alsaPayloadSize);
-                alsaPayloadSize = 0;
-            }
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
         }
         break;
         case PAL_PARAM_ID_MSPP_LINEAR_GAIN:
@@ -2320,13 +2285,12 @@ int SessionAlsaCompress::setParameters(Stream *s __unused, int tagId, uint32_t p
                 return status;
             }
 
-            builder->payloadMSPPConfig(&alsaParamData, &alsaPayloadSize, miid, linear_gain->gain);
-            if (alsaPayloadSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               alsaParamData, alsaPayloadSize);
-                PAL_INFO(LOG_TAG, "mixer set MSPP config status=%d\n", status);
-                free(alsaParamData);
-            }
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
+            PayloadBuilder::payloadMSPPConfig(params, miid, linear_gain->gain);
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set MSPP config status=%d\n", status);
             return 0;
         }
         break;
@@ -2342,14 +2306,12 @@ int SessionAlsaCompress::setParameters(Stream *s __unused, int tagId, uint32_t p
             struct pal_vol_ctrl_ramp_param *rampParam = (struct pal_vol_ctrl_ramp_param *)payload;
             status = SessionAlsaUtils::getModuleInstanceId(mixer, device,
                                rxAifBackEnds[0].second.data(), tagId, &miid);
-            builder->payloadVolumeCtrlRamp(&alsaParamData, &alsaPayloadSize,
-                 miid, rampParam->ramp_period_ms);
-            if (alsaPayloadSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               alsaParamData, alsaPayloadSize);
-                PAL_INFO(LOG_TAG, "mixer set vol ctrl ramp status=%d\n", status);
-                freeCustomPayload(&alsaParamData, &alsaPayloadSize);
-            }
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
+            PayloadBuilder::payloadVolumeCtrlRamp(params, miid, rampParam->ramp_period_ms);
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set vol ctrl ramp status=%d\n", status);
             break;
         }
         case PAL_PARAM_ID_RECONFIG_ENCODER: {
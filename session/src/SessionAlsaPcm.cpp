@@ -48,6 +48,8 @@
 #include "us_gen_api.h"
 #include "SessionAlsaPcm.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
+#include "PalTrace.h"
 #include "Stream.h"
 #include "ResourceManager.h"
 #include "detection_cmn_api.h"
@@ -62,6 +64,35 @@ int SessionAlsaPcm::pcmLpmRefCnt = 0;
 #define SESSION_ALSA_MMAP_PERIOD_COUNT_MAX 2048
 #define SESSION_ALSA_MMAP_PERIOD_COUNT_DEFAULT (SESSION_ALSA_MMAP_PERIOD_COUNT_MAX)
 
+static struct pcm *openPcm(Stream *s, unsigned int card, unsigned int device,
+                           unsigned int flags, struct pcm_config *config)
+{
+    PalTraceScope trace(PAL_TRACE_PCM_OPEN, (uint64_t)s);
+
+    return pcm_open(card, device, flags, config);
+}
+
+/*
+ * pcm_start prepares a pcm that is not prepared yet, doing it up front is
+ * free and lets the two be traced apart.
+ */
+static int startPcm(Stream *s, struct pcm *pcm)
+{
+    int status = 0;
+
+    {
+        PalTraceScope trace(PAL_TRACE_PCM_PREPARE, (uint64_t)s);
+
+        status = pcm_prepare(pcm);
+    }
+    if (status)
+        return status;
+
+    PalTraceScope trace(PAL_TRACE_PCM_START, (uint64_t)s);
+
+    return pcm_start(pcm);
+}
+
 SessionAlsaPcm::SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm)
 {
    rm = Rm;
@@ -77,6 +108,7 @@ SessionAlsaPcm::SessionAlsaPcm(std::shared_ptr<ResourceManager> Rm)
    ecRefDevId = PAL_DEVICE_OUT_MIN;
    streamHandle = NULL;
    vaMicChannels = 0;
+   memset(&dataPath, 0, sizeof(dataPath));
 }
 
 SessionAlsaPcm::~SessionAlsaPcm()
@@ -384,7 +416,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, uint32_t tag1,
                 status = -EINVAL;
                 goto exit;
             }
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -439,7 +471,7 @@ struct mixer_ctl* SessionAlsaPcm::getFEMixerCtl(const char *controlName, int *de
     }
 
     CntrlName << "PCM" << *device << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return NULL;
@@ -594,6 +626,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
     int tag_config_size = 0;
     int cal_config_size = 0;
 
+    invalidateDataPath();
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
@@ -617,7 +650,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 beCntrlName << stream << pcmDevIds.at(0) << " " << setBEControl;
         }
 
-        ctl = mixer_get_ctl_by_name(mixer, beCntrlName.str().data());
+        ctl = MixerCtlCache::getCtl(mixer, beCntrlName.str().data());
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", beCntrlName.str().data());
             return -ENOENT;
@@ -668,7 +701,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -739,7 +772,7 @@ int SessionAlsaPcm::setConfig(Stream * s, configType type, int tag)
                 goto unlock_kvMutex;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, calCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, calCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", calCntrlName.str().data());
                 status = -ENOENT;
@@ -831,7 +864,7 @@ int SessionAlsaPcm::setTKV(Stream * s, configType type, effect_pal_payload_t *ef
                 goto exit;
             }
 
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 status = -ENOENT;
@@ -1000,10 +1033,10 @@ int SessionAlsaPcm::start(Stream * s)
                     config.silence_threshold = 0;
                     config.silence_size = 0;
                     config.avail_min = config.period_size;
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+                    pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0),
                         PCM_IN |PCM_MMAP| PCM_NOIRQ, &config);
                 } else {
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_IN, &config);
+                    pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_IN, &config);
                 }
 
                 if (!pcm) {
@@ -1030,10 +1063,10 @@ int SessionAlsaPcm::start(Stream * s)
                     config.silence_threshold = 0;
                     config.silence_size = 0;
                     config.avail_min = config.period_size;
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+                    pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0),
                         PCM_OUT |PCM_MMAP| PCM_NOIRQ, &config);
                 } else {
-                    pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_OUT, &config);
+                    pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_OUT, &config);
                 }
 
                 if (!pcm) {
@@ -1050,7 +1083,7 @@ int SessionAlsaPcm::start(Stream * s)
                 break;
             case PAL_AUDIO_INPUT | PAL_AUDIO_OUTPUT:
                 if (!pcmDevRxIds.empty()) {
-                    pcmRx = pcm_open(rm->getVirtualSndCard(), pcmDevRxIds.at(0), PCM_OUT, &config);
+                    pcmRx = openPcm(s, rm->getVirtualSndCard(), pcmDevRxIds.at(0), PCM_OUT, &config);
                     if (!pcmRx) {
                         PAL_ERR(LOG_TAG, "pcm-rx open failed");
                         status = errno;
@@ -1064,7 +1097,7 @@ int SessionAlsaPcm::start(Stream * s)
                     }
                 }
                 if (!pcmDevTxIds.empty()) {
-                    pcmTx = pcm_open(rm->getVirtualSndCard(), pcmDevTxIds.at(0), PCM_IN, &config);
+                    pcmTx = openPcm(s, rm->getVirtualSndCard(), pcmDevTxIds.at(0), PCM_IN, &config);
                     if (!pcmTx) {
                         PAL_ERR(LOG_TAG, "pcm-tx open failed");
                         status = errno;
@@ -1485,7 +1518,7 @@ set_mixer:
             }
 
             if (pcm) {
-                status = pcm_start(pcm);
+                status = startPcm(s, pcm);
                 if (status) {
                     status = errno;
                     PAL_ERR(LOG_TAG, "pcm_start failed %d", status);
@@ -1618,6 +1651,10 @@ set_mixer:
                 (sAttr.type == PAL_STREAM_DEEP_BUFFER))) {
                 // Set MSPP volume during initlization.
                 if (!strcmp(dAttr.custom_config.custom_key, "mspp")) {
+                    PayloadArena::Scope arenaScope(payloadArena);
+                    MultiParamPayload params(payloadArena);
+                    int32_t pauseStatus = 0;
+
                     status = SessionAlsaUtils::getModuleInstanceId(mixer, pcmDevIds.at(0),
                                 rxAifBackEnds[0].second.data(), TAG_MODULE_MSPP, &miid);
                     if (status != 0) {
@@ -1625,57 +1662,26 @@ set_mixer:
                         goto pcm_start;
                     }
                     PAL_INFO(LOG_TAG, "miid : %x id = %d\n", miid, pcmDevIds.at(0));
+                    PayloadBuilder::payloadMSPPConfig(params, miid, rm->linear_gain.gain);
 
-                    builder->payloadMSPPConfig(&payload, &payloadSize, miid, rm->linear_gain.gain);
-                    if (payloadSize && payload) {
-                        status = updateCustomPayload(payload, payloadSize);
-                        free(payload);
-                        if (0 != status) {
-                            PAL_ERR(LOG_TAG,"updateCustomPayload Failed\n");
-                            goto pcm_start;
-                        }
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                                 customPayload, customPayloadSize);
-                    if (customPayload) {
-                        free(customPayload);
-                        customPayload = NULL;
-                        customPayloadSize = 0;
-                    }
-                    if (status != 0) {
-                        PAL_ERR(LOG_TAG,"setMixerParameter failed for MSPP module");
-                        goto pcm_start;
-                    }
-
-                    status = SessionAlsaUtils::getModuleInstanceId(mixer, pcmDevIds.at(0),
+                    pauseStatus = SessionAlsaUtils::getModuleInstanceId(mixer, pcmDevIds.at(0),
                                             rxAifBackEnds[0].second.data(), TAG_PAUSE, &miid);
-                    if (status != 0) {
+                    if (pauseStatus != 0) {
                         PAL_ERR(LOG_TAG,"get Soft Pause ModuleInstanceId failed");
-                        goto pcm_start;
+                    } else {
+                        PAL_INFO(LOG_TAG, "miid : %x id = %d\n", miid, pcmDevIds.at(0));
+                        PayloadBuilder::payloadSoftPauseConfig(params, miid,
+                                                                MSPP_SOFT_PAUSE_DELAY);
                     }
-                    PAL_INFO(LOG_TAG, "miid : %x id = %d\n", miid, pcmDevIds.at(0));
 
-                    builder->payloadSoftPauseConfig(&payload, &payloadSize, miid,
-                                                            MSPP_SOFT_PAUSE_DELAY);
-                    if (payloadSize && payload) {
-                        status = updateCustomPayload(payload, payloadSize);
-                        free(payload);
-                        if (0 != status) {
-                            PAL_ERR(LOG_TAG,"updateCustomPayload Failed\n");
-                            goto pcm_start;
-                        }
-                    }
-                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0),
-                                                                 customPayload, customPayloadSize);
-                    if (customPayload) {
-                        free(customPayload);
-                        customPayload = NULL;
-                        customPayloadSize = 0;
-                    }
+                    /* MSPP gain and soft pause delay share one setParam */
+                    status = SessionAlsaUtils::setMixerParameter(mixer, pcmDevIds.at(0), params);
                     if (status != 0) {
-                        PAL_ERR(LOG_TAG,"setMixerParameter failed for soft Pause module");
+                        PAL_ERR(LOG_TAG,"setMixerParameter failed for MSPP module");
                         goto pcm_start;
                     }
+                    if (pauseStatus != 0)
+                        goto pcm_start;
 
                     s->setOrientation(rm->mOrientation);
                     PAL_DBG(LOG_TAG,"MSPP set device orientation %d", s->getOrientation());
@@ -1778,7 +1784,7 @@ pcm_start:
             }
 
             if (pcm) {
-                status = pcm_start(pcm);
+                status = startPcm(s, pcm);
                 if (status) {
                     status = errno;
                     PAL_ERR(LOG_TAG, "pcm_start failed %d", status);
@@ -1871,14 +1877,14 @@ pcm_start:
             }
 
             if (pcmRx) {
-                status = pcm_start(pcmRx);
+                status = startPcm(s, pcmRx);
                 if (status) {
                     status = errno;
                     PAL_ERR(LOG_TAG, "pcm_start rx failed %d", status);
                 }
             }
             if (pcmTx) {
-                status = pcm_start(pcmTx);
+                status = startPcm(s, pcmTx);
                 if (status) {
                     status = errno;
                     PAL_ERR(LOG_TAG, "pcm_start tx failed %d", status);
@@ -1890,6 +1896,7 @@ pcm_start:
         setInitialVolume();
     }
     mState = SESSION_STARTED;
+    updateDataPath(s);
 
 exit:
     if (status != 0)
@@ -1990,6 +1997,7 @@ int SessionAlsaPcm::stop(Stream * s)
     }
     rm->voteSleepMonitor(s, false);
     mState = SESSION_STOPPED;
+    invalidateDataPath();
 
     if (sAttr.type == PAL_STREAM_VOICE_UI) {
         payload_size = sizeof(struct agm_event_reg_cfg);
@@ -2085,6 +2093,7 @@ int SessionAlsaPcm::close(Stream * s)
     bool isStreamAvail = false;
     int devCount = 0;
 
+    invalidateDataPath();
     PAL_DBG(LOG_TAG, "Enter");
     if (!frontEndIdAllocated) {
         PAL_DBG(LOG_TAG, "Session not opened or already closed");
@@ -2302,6 +2311,7 @@ int SessionAlsaPcm::disconnectSessionDevice(Stream *streamHandle,
     std::vector<std::pair<int32_t, std::string>> txAifBackEndsToDisconnect;
     int32_t status = 0;
 
+    invalidateDataPath();
     deviceList.push_back(deviceToDisconnect);
     rm->getBackEndNames(deviceList, rxAifBackEndsToDisconnect,
             txAifBackEndsToDisconnect);
@@ -2377,6 +2387,7 @@ int SessionAlsaPcm::setupSessionDevice(Stream* streamHandle, pal_stream_type_t s
     std::vector<std::pair<int32_t, std::string>> txAifBackEndsToConnect;
     int32_t status = 0;
 
+    invalidateDataPath();
     deviceList.push_back(deviceToConnect);
     rm->getBackEndNames(deviceList, rxAifBackEndsToConnect,
             txAifBackEndsToConnect);
@@ -2402,6 +2413,7 @@ int SessionAlsaPcm::connectSessionDevice(Stream* streamHandle, pal_stream_type_t
     std::vector<std::pair<int32_t, std::string>> txAifBackEndsToConnect;
     int32_t status = 0;
 
+    invalidateDataPath();
     deviceList.push_back(deviceToConnect);
     rm->getBackEndNames(deviceList, rxAifBackEndsToConnect,
             txAifBackEndsToConnect);
@@ -2467,17 +2479,54 @@ int SessionAlsaPcm::connectSessionDevice(Stream* streamHandle, pal_stream_type_t
     return status;
 }
 
-int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, int * size)
+int SessionAlsaPcm::updateDataPath(Stream *s)
 {
-    int status = 0, bytesRead = 0, bytesToRead = 0, offset = 0, pcmReadSize = 0;
+    int status = 0;
     struct pal_stream_attributes sAttr = {};
 
-    PAL_VERBOSE(LOG_TAG, "Enter")
     status = s->getStreamAttributes(&sAttr);
     if (status != 0) {
         PAL_ERR(LOG_TAG, "stream get attributes failed");
         return status;
     }
+    dataPath.isMmap = SessionAlsaUtils::isMmapUsecase(sAttr);
+    dataPath.frameSize = pcm ? pcm_frames_to_bytes(pcm, 1) : 0;
+    dataPath.inSampleRate = sAttr.in_media_config.sample_rate;
+    dataPath.outSampleRate = sAttr.out_media_config.sample_rate;
+    /* without a pcm there is no frame size yet, the next read/write rebuilds */
+    dataPath.pcm = pcm;
+    dataPath.inPeriodNs = bytesToNs(in_buf_size, dataPath.inSampleRate);
+    dataPath.outPeriodNs = bytesToNs(out_buf_size, dataPath.outSampleRate);
+    dataPath.xruns = pcm ? pcm_get_xruns(pcm) : 0;
+    PAL_DBG(LOG_TAG, "mmap %d frame size %u period ns in %ld out %ld", dataPath.isMmap,
+            dataPath.frameSize, dataPath.inPeriodNs, dataPath.outPeriodNs);
+    return status;
+}
+
+/*
+ * tinyalsa recovers from an xrun inside pcm_read/pcm_write and only counts
+ * it, hand the new ones to the stream's data path stats.
+ */
+void SessionAlsaPcm::updateXruns(Stream *s)
+{
+    int xruns = pcm_get_xruns(pcm);
+
+    if (xruns > dataPath.xruns)
+        s->getDataPathStats()->recordXruns(xruns - dataPath.xruns);
+    dataPath.xruns = xruns;
+}
+
+long SessionAlsaPcm::bytesToNs(size_t bytes, uint32_t sampleRate)
+{
+    if (!dataPath.frameSize || !sampleRate)
+        return 0;
+    return (bytes / dataPath.frameSize) * 1000000000LL / sampleRate;
+}
+
+int SessionAlsaPcm::readPcm(Stream *s, struct pal_buffer *buf, int *size)
+{
+    int status = 0, bytesRead = 0, bytesToRead = 0, offset = 0, pcmReadSize = 0;
+
     while (1) {
         offset = bytesRead + buf->offset;
         bytesToRead = buf->size - offset;
@@ -2490,12 +2539,10 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
         void *data = buf->buffer;
         data = static_cast<char*>(data) + offset;
 
-        if(SessionAlsaUtils::isMmapUsecase(sAttr))
+        if (dataPath.isMmap)
         {
-            long ns = 0;
-            if (sAttr.in_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, pcmReadSize)*1000000000LL/
-                    sAttr.in_media_config.sample_rate;
+            long ns = (pcmReadSize == in_buf_size) ? dataPath.inPeriodNs :
+                          bytesToNs(pcmReadSize, dataPath.inSampleRate);
             requestAdmFocus(s, ns);
             status =  pcm_mmap_read(pcm, data,  pcmReadSize);
             releaseAdmFocus(s);
@@ -2511,31 +2558,56 @@ int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, in
         bytesRead += pcmReadSize;
     }
 
+    updateXruns(s);
     *size = bytesRead;
-    PAL_VERBOSE(LOG_TAG, "exit bytesRead:%d status:%d ", bytesRead, status);
     return status;
 }
 
-int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size,
-                          int flag)
+int SessionAlsaPcm::read(Stream *s, int tag __unused, struct pal_buffer *buf, int * size)
 {
     int status = 0;
-    size_t bytesWritten = 0, bytesRemaining = 0, offset = 0, sizeWritten = 0;
-    struct pal_stream_attributes sAttr = {};
-
-    PAL_VERBOSE(LOG_TAG, "Enter buf:%p tag:%d flag:%d", buf, tag, flag);
 
-    status = s->getStreamAttributes(&sAttr);
-    if (status != 0) {
-        PAL_ERR(LOG_TAG, "stream get attributes failed");
-        return status;
+    PAL_VERBOSE(LOG_TAG, "Enter")
+    if (!isDataPathValid()) {
+        status = updateDataPath(s);
+        if (status != 0)
+            return status;
     }
+    status = readPcm(s, buf, size);
+    PAL_VERBOSE(LOG_TAG, "exit bytesRead:%d status:%d ", *size, status);
+    return status;
+}
 
-    if (pcm == NULL) {
-        PAL_ERR(LOG_TAG, "PCM is NULL");
-        return -EINVAL;
+/*
+ * Reads a batch of buffers back to back. *size holds the bytes read
+ * before any error.
+ */
+int SessionAlsaPcm::readBatch(Stream *s, int tag __unused, struct pal_buffer *bufs,
+                              uint32_t count, int *size)
+{
+    int status = 0, bytesRead = 0;
+
+    PAL_VERBOSE(LOG_TAG, "Enter count:%u", count);
+    *size = 0;
+    if (!isDataPathValid()) {
+        status = updateDataPath(s);
+        if (status != 0)
+            return status;
     }
+    for (uint32_t i = 0; i < count; i++) {
+        status = readPcm(s, &bufs[i], &bytesRead);
+        *size += bytesRead;
+        if (status)
+            break;
+    }
+    PAL_VERBOSE(LOG_TAG, "exit bytesRead:%d status:%d ", *size, status);
+    return status;
+}
 
+int SessionAlsaPcm::writePcm(Stream *s, struct pal_buffer *buf, int *size)
+{
+    int status = 0;
+    size_t bytesWritten = 0, bytesRemaining = 0, offset = 0, sizeWritten = 0;
     void *data = nullptr;
 
     bytesRemaining = buf->size;
@@ -2552,11 +2624,8 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
             goto exit;
         }
 
-        if (SessionAlsaUtils::isMmapUsecase(sAttr)) {
-            long ns = 0;
-            if (sAttr.out_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, sizeWritten)*1000000000LL/
-                    sAttr.out_media_config.sample_rate;
+        if (dataPath.isMmap) {
+            long ns = dataPath.outPeriodNs;
             PAL_DBG(LOG_TAG, "1.bufsize:%u ns:%ld", sizeWritten, ns);
             requestAdmFocus(s, ns);
             status =  pcm_mmap_write(pcm, data,  sizeWritten);
@@ -2583,12 +2652,10 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
     }
 
     data = static_cast<char *>(data) + offset;
-    if (SessionAlsaUtils::isMmapUsecase(sAttr)) {
+    if (dataPath.isMmap) {
         if (sizeWritten) {
-            long ns = 0;
-            if (sAttr.out_media_config.sample_rate)
-                ns = pcm_bytes_to_frames(pcm, sizeWritten)*1000000000LL/
-                    sAttr.out_media_config.sample_rate;
+            long ns = (sizeWritten == out_buf_size) ? dataPath.outPeriodNs :
+                          bytesToNs(sizeWritten, dataPath.outSampleRate);
             PAL_DBG(LOG_TAG, "2.bufsize:%u ns:%ld", sizeWritten, ns);
             requestAdmFocus(s, ns);
             status =  pcm_mmap_write(pcm, data,  sizeWritten);
@@ -2606,8 +2673,64 @@ int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size
         }
     }
     bytesWritten += sizeWritten;
-    *size = bytesWritten;
 exit:
+    if (pcm)
+        updateXruns(s);
+    *size = bytesWritten;
+    return status;
+}
+
+int SessionAlsaPcm::write(Stream *s, int tag, struct pal_buffer *buf, int * size,
+                          int flag)
+{
+    int status = 0;
+
+    PAL_VERBOSE(LOG_TAG, "Enter buf:%p tag:%d flag:%d", buf, tag, flag);
+
+    if (pcm == NULL) {
+        PAL_ERR(LOG_TAG, "PCM is NULL");
+        return -EINVAL;
+    }
+
+    if (!isDataPathValid()) {
+        status = updateDataPath(s);
+        if (status != 0)
+            return status;
+    }
+
+    status = writePcm(s, buf, size);
+    PAL_VERBOSE(LOG_TAG, "exit status: %d", status);
+    return status;
+}
+
+/*
+ * Writes a batch of buffers back to back. *size holds the bytes written
+ * before any error.
+ */
+int SessionAlsaPcm::writeBatch(Stream *s, int tag, struct pal_buffer *bufs,
+                               uint32_t count, int *size)
+{
+    int status = 0, bytesWritten = 0;
+
+    PAL_VERBOSE(LOG_TAG, "Enter bufs:%p tag:%d count:%u", bufs, tag, count);
+    *size = 0;
+    if (pcm == NULL) {
+        PAL_ERR(LOG_TAG, "PCM is NULL");
+        return -EINVAL;
+    }
+
+    if (!isDataPathValid()) {
+        status = updateDataPath(s);
+        if (status != 0)
+            return status;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        status = writePcm(s, &bufs[i], &bytesWritten);
+        *size += bytesWritten;
+        if (status)
+            break;
+    }
     PAL_VERBOSE(LOG_TAG, "exit status: %d", status);
     return status;
 }
@@ -2807,19 +2930,17 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 goto exit;
             }
 
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
             if (vdata->no_of_volpair > 1 && sAttr.out_media_config.ch_info.channels > 1) {
-                builder->payloadMultichVolumemConfig(&paramData, &paramSize, miid, vdata);
+                PayloadBuilder::payloadMultichVolumemConfig(params, miid, vdata);
             } else {
-                builder->payloadVolumeConfig(&paramData, &paramSize, miid, vdata);
+                PayloadBuilder::payloadVolumeConfig(params, miid, vdata);
             }
 
-            if (paramSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               paramData, paramSize);
-                PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
-                freeCustomPayload(&paramData, &paramSize);
-                paramSize = 0;
-            }
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set volume config status=%d\n", status);
             return 0;
         }
         case PAL_PARAM_ID_MSPP_LINEAR_GAIN:
@@ -2835,13 +2956,12 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 return status;
             }
 
-            builder->payloadMSPPConfig(&paramData, &paramSize, miid, linear_gain->gain);
-            if (paramSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               paramData, paramSize);
-                PAL_INFO(LOG_TAG, "mixer set MSPP config status=%d\n", status);
-                free(paramData);
-            }
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
+            PayloadBuilder::payloadMSPPConfig(params, miid, linear_gain->gain);
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set MSPP config status=%d\n", status);
             return 0;
         }
         case PAL_PARAM_ID_SET_UPD_DUTY_CYCLE:
@@ -2873,7 +2993,7 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
 
             // set UPD RX tag data
             tagCntrlNameRx<<streamPcm<<pcmDevRxIds.at(0)<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlNameRx.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlNameRx.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlNameRx.str().data());
                 status = -EINVAL;
@@ -2889,7 +3009,7 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
 
             // set UPD TX tag data
             tagCntrlNameTx<<streamPcm<<pcmDevTxIds.at(0)<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlNameTx.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlNameTx.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlNameTx.str().data());
                 status = -EINVAL;
@@ -2944,14 +3064,12 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 PAL_ERR(LOG_TAG, "Failed to get tag info %x, status = %d", tagId, status);
                 return status;
             }
-            builder->payloadVolumeCtrlRamp(&paramData, &paramSize,
-                 miid, rampParam->ramp_period_ms);
-            if (paramSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               paramData, paramSize);
-                PAL_INFO(LOG_TAG, "mixer set vol ctrl ramp status=%d\n", status);
-                freeCustomPayload(&paramData, &paramSize);
-            }
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
+
+            PayloadBuilder::payloadVolumeCtrlRamp(params, miid, rampParam->ramp_period_ms);
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_INFO(LOG_TAG, "mixer set vol ctrl ramp status=%d\n", status);
             return 0;
          }
         case PAL_PARAM_ID_HAPTICS_CNFG :
@@ -3060,14 +3178,12 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 goto exit;
             }
 
-            builder->payloadGainConfig(&paramData, &paramSize, miid, gdata);
+            PayloadArena::Scope arenaScope(payloadArena);
+            MultiParamPayload params(payloadArena);
 
-            if (paramSize) {
-                status = SessionAlsaUtils::setMixerParameter(mixer, device,
-                                               paramData, paramSize);
-                PAL_DBG(LOG_TAG, "GainLog - mixer set gain config status=%d\n", status);
-                freeCustomPayload(&paramData, &paramSize);
-            }
+            PayloadBuilder::payloadGainConfig(params, miid, gdata);
+            status = SessionAlsaUtils::setMixerParameter(mixer, device, params);
+            PAL_DBG(LOG_TAG, "GainLog - mixer set gain config status=%d\n", status);
             return 0;
         }
 
@@ -3129,7 +3245,7 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
 
             if (sendToRx) {
                 tagCntrlName<<streamPcm<<pcmDevRxIds.at(0)<<setParamTagControl;
-                ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+                ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
                 if (!ctl) {
                     PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                     status = -EINVAL;
@@ -3139,7 +3255,7 @@ int SessionAlsaPcm::setParameters(Stream *streamHandle, int tagId, uint32_t para
                 status = mixer_ctl_set_array(ctl, tagConfig, sizeof(struct agm_tag_config) + tkv_size);
             } else {
                 tagCntrlName<<streamPcm<<pcmDevTxIds.at(0)<<setParamTagControl;
-                ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+                ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
                 if (!ctl) {
                     PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                     status = -EINVAL;
@@ -3419,7 +3535,7 @@ int SessionAlsaPcm::getParameters(Stream *s __unused, int tagId, uint32_t param_
         status = -EINVAL;
         goto exit;
     }
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         status = -ENOENT;
@@ -3715,7 +3831,7 @@ int SessionAlsaPcm::createMmapBuffer(Stream *s, int32_t min_size_frames,
         PAL_DBG(LOG_TAG, "Opening PCM device card_id(%d) device_id(%d), channels %d",
                 rm->getVirtualSndCard(), pcmDevIds.at(0), config.channels);
 
-        pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+        pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0),
                              pcm_flags, &config);
 
         if ((!pcm || !pcm_is_ready(pcm)) && ecRefDevId != PAL_DEVICE_OUT_MIN) {
@@ -3751,7 +3867,7 @@ int SessionAlsaPcm::createMmapBuffer(Stream *s, int32_t min_size_frames,
 
 
         CntrlName << stream << pcmDevIds.at(0) << " " << control;
-        ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+        ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
         if (!ctl) {
             PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
             status = -ENOENT;
@@ -3836,7 +3952,7 @@ void SessionAlsaPcm::retryOpenWithoutEC(Stream *s, unsigned int pcm_flags, struc
         }
     }
     if (pcmDevIds.size() > 0) {
-        pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0),
+        pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0),
                        pcm_flags, config);
     } else {
         PAL_ERR(LOG_TAG, "frontendIDs is not available.");
@@ -3958,7 +4074,7 @@ int SessionAlsaPcm::openGraph(Stream *s) {
         config.silence_threshold = 0;
 
         if (pcmDevIds.size() > 0) {
-            pcm = pcm_open(rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_IN, &config);
+            pcm = openPcm(s, rm->getVirtualSndCard(), pcmDevIds.at(0), PCM_IN, &config);
         } else {
             PAL_ERR(LOG_TAG, "frontendIDs is not available.");
             status = -EINVAL;
@@ -65,6 +65,8 @@
 #define LOG_TAG "PAL: SessionAlsaUtils"
 
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
+#include "PalTrace.h"
 
 #include <sstream>
 #include <string>
@@ -86,6 +88,21 @@ static constexpr const char* const COMPRESS_SND_DEV_NAME_PREFIX = "COMPRESS";
 static constexpr const char* const PCM_SND_DEV_NAME_PREFIX = "PCM";
 static constexpr const char* const PCM_SND_VOICE_DEV_NAME_PREFIX = "VOICEMMODE";
 
+/* every metadata, connect and param write below counts as PAL_TRACE_MIXER_WRITE */
+static int mixerCtlSetArray(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    PalTraceScope trace(PAL_TRACE_MIXER_WRITE);
+
+    return mixer_ctl_set_array(ctl, array, count);
+}
+
+static int mixerCtlSetEnumByString(struct mixer_ctl *ctl, const char *string)
+{
+    PalTraceScope trace(PAL_TRACE_MIXER_WRITE);
+
+    return mixer_ctl_set_enum_by_string(ctl, string);
+}
+
 static const char *feCtrlNames[] = {
     " control",
     " metadata",
@@ -117,6 +134,22 @@ struct agmMetaData {
         :buf(b),size(s) {}
 };
 
+#define TAGGED_INFO_PAYLOAD_SIZE 1024
+
+/* drops cached MIIDs around a graph update, on entry and on every exit */
+class MiidCacheInvalidator
+{
+public:
+    MiidCacheInvalidator() { SessionAlsaUtils::invalidateMiidCache(); }
+    ~MiidCacheInvalidator() { SessionAlsaUtils::invalidateMiidCache(); }
+};
+
+std::map<std::pair<int, std::string>, std::map<int, uint32_t>> SessionAlsaUtils::miidCache;
+std::mutex SessionAlsaUtils::miidCacheMutex;
+uint32_t SessionAlsaUtils::miidCacheGeneration = 0;
+std::atomic<uint64_t> SessionAlsaUtils::miidCacheHits(0);
+std::atomic<uint64_t> SessionAlsaUtils::miidCacheMisses(0);
+
 SessionAlsaUtils::~SessionAlsaUtils()
 {
 
@@ -201,13 +234,13 @@ int SessionAlsaUtils::setMixerCtlData(struct mixer_ctl *ctl, MixerCtlType id, vo
 
     switch (id) {
         case MixerCtlType::MIXER_SET_ID_STRING:
-            mixer_ctl_set_enum_by_string(ctl, (const char *)data);
+            mixerCtlSetEnumByString(ctl, (const char *)data);
             break;
         case MixerCtlType::MIXER_SET_ID_VALUE:
             mixer_ctl_set_value(ctl, SNDRV_CTL_ELEM_TYPE_BYTES, *((int *)data));
             break;
         case MixerCtlType::MIXER_SET_ID_ARRAY:
-            mixer_ctl_set_array(ctl, data, size);
+            mixerCtlSetArray(ctl, data, size);
             break;
     }
 
@@ -224,6 +257,7 @@ void SessionAlsaUtils::getAgmMetaData(const std::vector <std::pair<int, int>> &k
     uint8_t *ptr = NULL;
     struct agm_key_value *kvPtr = NULL;
     uint32_t mdSize = 0;
+    PalTraceScope trace(PAL_TRACE_METADATA_BUILD);
 
     md.buf = nullptr;
     md.size = 0;
@@ -328,25 +362,20 @@ bool SessionAlsaUtils::isMmapUsecase(struct pal_stream_attributes &sAttr)
 
 struct mixer_ctl *SessionAlsaUtils::getStaticMixerControl(struct mixer *am, std::string name)
 {
-    std::ostringstream cntrlName;
-
-    cntrlName << name;
-    PAL_DBG(LOG_TAG, "mixer control name is %s", cntrlName.str().data());
+    PAL_DBG(LOG_TAG, "mixer control name is %s", name.c_str());
 
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+    return MixerCtlCache::getCtl(am, name.c_str());
 }
 
 struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, std::string feName,
         uint32_t idx)
 {
-    std::ostringstream cntrlName;
     struct mixer_ctl *ctl = NULL;
 
-    cntrlName << feName << feCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    ctl = mixer_get_ctl_by_name(am, cntrlName.str().data());
+    PAL_DBG(LOG_TAG, "mixer control %s%s", feName.c_str(), feCtrlNames[idx]);
+    ctl = MixerCtlCache::getCtl(am, feName.c_str(), feCtrlNames[idx]);
     if (!ctl)
-        PAL_FATAL(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
+        PAL_FATAL(LOG_TAG, "invalid mixer control: %s%s", feName.c_str(), feCtrlNames[idx]);
 
     return ctl;
 }
@@ -354,11 +383,8 @@ struct mixer_ctl *SessionAlsaUtils::getFeMixerControl(struct mixer *am, std::str
 struct mixer_ctl *SessionAlsaUtils::getBeMixerControl(struct mixer *am, std::string beName,
         uint32_t idx)
 {
-    std::ostringstream cntrlName;
-
-    cntrlName << beName << beCtrlNames[idx];
-    PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
-    return mixer_get_ctl_by_name(am, cntrlName.str().data());
+    PAL_DBG(LOG_TAG, "mixer control %s%s", beName.c_str(), beCtrlNames[idx]);
+    return MixerCtlCache::getCtl(am, beName.c_str(), beCtrlNames[idx]);
 }
 
 int SessionAlsaUtils::getScoDevCount(void)
@@ -380,6 +406,7 @@ int SessionAlsaUtils::getScoDevCount(void)
 int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManager> rmHandle,
     const std::vector<int> &DevIds, const std::vector<std::pair<int32_t, std::string>> &BackEnds)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::vector <std::pair<int, int>> streamKV;
     std::vector <std::pair<int, int>> streamCKV;
     std::vector <std::pair<int, int>> streamDeviceKV;
@@ -485,9 +512,9 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             goto freeStreamMetaData;
         }
     }
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL], "ZERO");
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamMetaData.buf,
                 streamMetaData.size);
 
     for (std::vector<std::pair<int32_t, std::string>>::const_iterator be = BackEnds.begin();
@@ -601,14 +628,14 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
 
         /** set mixer controls */
         if (deviceMetaData.size)
-            mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+            mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                     deviceMetaData.size);
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
+        mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL], be->second.data());
         if (streamDeviceMetaData.size) {
-            mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+            mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                     streamDeviceMetaData.size);
         }
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONNECT], (be->second).data());
+        mixerCtlSetEnumByString(feMixerCtrls[FE_CONNECT], (be->second).data());
 
         deviceKV.clear();
         streamDeviceKV.clear();
@@ -640,6 +667,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     const std::vector<int> &DevIds, const std::vector<std::pair<int32_t, std::string>> &BackEnds,
     std::vector<std::pair<std::string, int>> &freedevicemetadata)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     int status = 0;
     uint32_t i;
     std::vector <std::pair<int, int>> emptyKV;
@@ -709,21 +737,21 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
         }
 
         /** set mixer controls */
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_DISCONNECT], be->second.data());
+        mixerCtlSetEnumByString(feMixerCtrls[FE_DISCONNECT], be->second.data());
         for (auto freeDevmeta = freedevicemetadata.begin(); freeDevmeta != freedevicemetadata.end(); ++freeDevmeta) {
             PAL_DBG(LOG_TAG, "backend %s and freedevicemetadata %d", freeDevmeta->first.data(), freeDevmeta->second);
             if (!(freeDevmeta->first.compare(be->second))) {
                 if (freeDevmeta->second == 0) {
                     PAL_INFO(LOG_TAG, "No need to free device metadata as device is still active");
                 } else {
-                    mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+                    mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                                     deviceMetaData.size);
                 }
             }
         }
 
-        mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], be->second.data());
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
+        mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL], be->second.data());
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void *)streamDeviceMetaData.buf,
                 streamDeviceMetaData.size);
 
         free(streamDeviceMetaData.buf);
@@ -733,11 +761,11 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     }
 
     // clear stream metadata
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL], "ZERO");
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data *)streamPropId,
             streamMetaData);
     if (streamMetaData.size)
-        mixer_ctl_set_array(feMixerCtrls[FE_METADATA],
+        mixerCtlSetArray(feMixerCtrls[FE_METADATA],
             (void *)streamMetaData.buf, streamMetaData.size);
 
 
@@ -884,7 +912,7 @@ int SessionAlsaUtils::rwACDBTunnel(Stream * streamHandle, std::shared_ptr<Resour
 
     /* set mixer controls */
     if (payloadSize)
-        status = mixer_ctl_set_array(acdbMixerCtrl, payloadData,
+        status = mixerCtlSetArray(acdbMixerCtrl, payloadData,
                 payloadSize);
 
     if (!isParamWrite && !status) {
@@ -951,13 +979,14 @@ int SessionAlsaUtils::setDeviceCustomPayload(std::shared_ptr<ResourceManager> rm
         return -EINVAL;
     }
 
-    return mixer_ctl_set_array(ctl, payload, size);
+    return mixerCtlSetArray(ctl, payload, size);
 }
 
 int SessionAlsaUtils::setDeviceMetadata(std::shared_ptr<ResourceManager> rmHandle,
                                            std::string backEndName,
                                            std::vector <std::pair<int, int>> &deviceKV)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::vector <std::pair<int, int>> emptyKV;
     int status = 0;
     struct agmMetaData deviceMetaData(nullptr, 0);
@@ -989,7 +1018,7 @@ int SessionAlsaUtils::setDeviceMetadata(std::shared_ptr<ResourceManager> rmHandl
     }
 
     if (deviceMetaData.size)
-        status = mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        status = mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                         deviceMetaData.size);
 
     free(deviceMetaData.buf);
@@ -1001,6 +1030,7 @@ int SessionAlsaUtils::setDeviceMetadata(std::shared_ptr<ResourceManager> rmHandl
 int SessionAlsaUtils::setDeviceMediaConfig(std::shared_ptr<ResourceManager> rmHandle,
                                            std::string backEndName, struct pal_device *dAttr)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     struct mixer_ctl *ctl = NULL;
     long aif_media_config[4];
     long aif_group_atrr_config[5];
@@ -1055,7 +1085,7 @@ int SessionAlsaUtils::setDeviceMediaConfig(std::shared_ptr<ResourceManager> rmHa
         aif_group_atrr_config[3] = AGM_DATA_FORMAT_FIXED_POINT;
         aif_group_atrr_config[4] = rmHandle->activeGroupDevConfig->grp_dev_hwep_cfg.slot_mask;
 
-        mixer_ctl_set_array(ctl, &aif_group_atrr_config,
+        mixerCtlSetArray(ctl, &aif_group_atrr_config,
                                sizeof(aif_group_atrr_config)/sizeof(aif_group_atrr_config[0]));
         PAL_INFO(LOG_TAG, "%s rate ch fmt data_fmt slot_mask %ld %ld %ld %ld %ld\n", truncatedBeName.c_str(),
                 aif_group_atrr_config[0], aif_group_atrr_config[1], aif_group_atrr_config[2],
@@ -1073,7 +1103,7 @@ int SessionAlsaUtils::setDeviceMediaConfig(std::shared_ptr<ResourceManager> rmHa
                      aif_media_config[0], aif_media_config[1],
                      aif_media_config[2], aif_media_config[3]);
 
-    return mixer_ctl_set_array(ctl, &aif_media_config,
+    return mixerCtlSetArray(ctl, &aif_media_config,
                                sizeof(aif_media_config)/sizeof(aif_media_config[0]));
 }
 
@@ -1102,7 +1132,7 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
         return -EINVAL;
     }
     CntrlName<<pcmDeviceName<<" "<<getParamControl;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return -ENOENT;
@@ -1115,7 +1145,7 @@ int SessionAlsaUtils::getTimestamp(struct mixer *mixer, const std::vector<int> &
         status = -EINVAL;
         goto exit;
     }
-    status = mixer_ctl_set_array(ctl, payload->data(), payloadSize);
+    status = mixerCtlSetArray(ctl, payload->data(), payloadSize);
     if (0 != status) {
          PAL_ERR(LOG_TAG, "Set failed status = %d", status);
          goto exit;
@@ -1143,14 +1173,18 @@ exit:
     return status;
 }
 
-int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const char *intf_name,
-                       int tag_id, uint32_t *miid)
+/*
+ * Reads the whole tag -> module info table of the graph currently selected
+ * through the "control" of the FE, keeping the first module of each tag.
+ */
+int SessionAlsaUtils::fetchModuleInstanceIds(struct mixer *mixer, int device,
+                                             std::map<int, uint32_t> &miids)
 {
     char *pcmDeviceName = NULL;
     char const *control = "getTaggedInfo";
     char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,ret = 0, i;
+    int ctl_len = 0, ret = 0, i;
     void *payload;
     struct gsl_tag_module_info *tag_info;
     struct gsl_tag_module_info_entry *tag_entry;
@@ -1158,15 +1192,11 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
     pcmDeviceName = rm->getDeviceNameFromID(device);
-    if(!pcmDeviceName){
+    if (!pcmDeviceName) {
         PAL_ERR(LOG_TAG, "Device name from id %d not found", device);
         return -EINVAL;
     }
 
-    ret = setStreamMetadataType(mixer, device, intf_name);
-    if (ret)
-        return ret;
-
     ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
     mixer_str = (char *)calloc(1, ctl_len);
     if (!mixer_str)
@@ -1175,29 +1205,27 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    payload = calloc(1024, sizeof(char));
+    payload = calloc(TAGGED_INFO_PAYLOAD_SIZE, sizeof(char));
     if (!payload) {
         free(mixer_str);
         return -ENOMEM;
     }
 
-    ret = mixer_ctl_get_array(ctl, payload, 1024);
+    ret = mixer_ctl_get_array(ctl, payload, TAGGED_INFO_PAYLOAD_SIZE);
     if (ret < 0) {
         PAL_ERR(LOG_TAG, "Failed to mixer_ctl_get_array\n");
-        free(payload);
-        free(mixer_str);
-        return ret;
+        goto exit;
     }
+    ret = 0;
     tag_info = (struct gsl_tag_module_info *)payload;
     PAL_DBG(LOG_TAG, "num of tags associated with stream %d is %d\n", device, tag_info->num_tags);
-    ret = -1;
     tag_entry = (struct gsl_tag_module_info_entry *)(&tag_info->tag_module_entry[0]);
     offset = 0;
     for (i = 0; i < tag_info->num_tags; i++) {
@@ -1205,29 +1233,104 @@ int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const
 
         PAL_DBG(LOG_TAG, "tag id[%d] = 0x%x, num_modules = 0x%x\n", i, tag_entry->tag_id, tag_entry->num_modules);
         offset = sizeof(struct gsl_tag_module_info_entry) + (tag_entry->num_modules * sizeof(struct gsl_module_id_info_entry));
-        if (tag_entry->tag_id == tag_id) {
-            struct gsl_module_id_info_entry *mod_info_entry;
-
-            if (tag_entry->num_modules) {
-                 mod_info_entry = &tag_entry->module_entry[0];
-                 *miid = mod_info_entry->module_iid;
-                 PAL_DBG(LOG_TAG, "MIID is 0x%x\n", *miid);
-                 ret = 0;
-                 break;
-            }
+        if (tag_entry->num_modules)
+            miids.insert(std::make_pair((int)tag_entry->tag_id,
+                                        tag_entry->module_entry[0].module_iid));
+    }
+
+exit:
+    free(payload);
+    free(mixer_str);
+    return ret;
+}
+
+/*
+ * MIIDs only change when the graph behind the FE does, so the tag table is
+ * fetched once and served from the cache until invalidateMiidCache() is
+ * called on a graph open/close, device switch, metadata update or SSR. The
+ * stream metadata type is still selected on every call since later
+ * setParam/getParam calls on the FE rely on it.
+ */
+int SessionAlsaUtils::getModuleInstanceId(struct mixer *mixer, int device, const char *intf_name,
+                       int tag_id, uint32_t *miid)
+{
+    int ret = 0;
+    uint32_t generation;
+    bool found = false;
+    std::map<int, uint32_t> miids;
+    std::map<int, uint32_t>::iterator it;
+    std::pair<int, std::string> key;
+
+    if (!intf_name || !miid)
+        return -EINVAL;
+
+    ret = setStreamMetadataType(mixer, device, intf_name);
+    if (ret)
+        return ret;
+
+    key = std::make_pair(device, std::string(intf_name));
+    miidCacheMutex.lock();
+    auto entry = miidCache.find(key);
+    if (entry != miidCache.end()) {
+        it = entry->second.find(tag_id);
+        if (it != entry->second.end()) {
+            *miid = it->second;
+            found = true;
         }
+        miidCacheMutex.unlock();
+        miidCacheHits++;
+        goto done;
+    }
+    generation = miidCacheGeneration;
+    miidCacheMutex.unlock();
+
+    miidCacheMisses++;
+    ret = fetchModuleInstanceIds(mixer, device, miids);
+    if (ret)
+        return ret;
+
+    it = miids.find(tag_id);
+    if (it != miids.end()) {
+        *miid = it->second;
+        found = true;
     }
 
+    miidCacheMutex.lock();
+    /* drop the table if the graph changed while it was being read */
+    if (generation == miidCacheGeneration)
+        miidCache[key] = std::move(miids);
+    miidCacheMutex.unlock();
+
+done:
+    if (found)
+        PAL_DBG(LOG_TAG, "MIID is 0x%x\n", *miid);
+    ret = found ? 0 : -1;
     if (*miid == 0) {
          ret = -EINVAL;
          PAL_ERR(LOG_TAG, "No matching MIID found for tag: 0x%x, error:%d", tag_id, ret);
     }
-
-    free(payload);
-    free(mixer_str);
     return ret;
 }
 
+void SessionAlsaUtils::invalidateMiidCache()
+{
+    miidCacheMutex.lock();
+    miidCache.clear();
+    miidCacheGeneration++;
+    miidCacheMutex.unlock();
+}
+
+void SessionAlsaUtils::getMiidCacheStats(uint64_t *hits, uint64_t *misses)
+{
+    if (hits)
+        *hits = miidCacheHits.load();
+    if (misses)
+        *misses = miidCacheMisses.load();
+    PAL_VERBOSE(LOG_TAG, "MIID cache hits %llu misses %llu",
+                (unsigned long long)miidCacheHits.load(),
+                (unsigned long long)miidCacheMisses.load());
+}
+
 int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, const char *intf_name,
                                             uint8_t *payload)
 {
@@ -1259,7 +1362,7 @@ int SessionAlsaUtils::getTagsWithModuleInfo(struct mixer *mixer, int device, con
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -1290,10 +1393,8 @@ int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
                                         void *payload, int size)
 {
     char *pcmDeviceName = NULL;
-    char const *control = "setParam";
-    char *mixer_str;
     struct mixer_ctl *ctl;
-    int ctl_len = 0,ret = 0;
+    int ret = 0;
     std::shared_ptr<ResourceManager> rm = ResourceManager::getInstance();
 
     pcmDeviceName = rm->getDeviceNameFromID(device);
@@ -1302,28 +1403,28 @@ int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
         return -EINVAL;
     }
 
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", pcmDeviceName);
-    ctl_len = strlen(pcmDeviceName) + 1 + strlen(control) + 1;
-    mixer_str = (char *)calloc(1, ctl_len);
-    if (!mixer_str) {
-        return -ENOMEM;
-    }
-    snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
-
-    PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    PAL_DBG(LOG_TAG, "- mixer -%s setParam-\n", pcmDeviceName);
+    ctl = MixerCtlCache::getCtl(mixer, pcmDeviceName, " setParam");
     if (!ctl) {
-        PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
-        free(mixer_str);
+        PAL_ERR(LOG_TAG, "Invalid mixer control: %s setParam\n", pcmDeviceName);
         return ENOENT;
     }
-    ret = mixer_ctl_set_array(ctl, payload, size);
+    ret = mixerCtlSetArray(ctl, payload, size);
 
     PAL_DBG(LOG_TAG, "ret = %d, cnt = %d\n", ret, size);
-    free(mixer_str);
     return ret;
 }
 
+int SessionAlsaUtils::setMixerParameter(struct mixer *mixer, int device,
+                                        MultiParamPayload &params)
+{
+    if (!params.count())
+        return 0;
+
+    PAL_DBG(LOG_TAG, "%u params, %zu bytes", params.count(), params.size());
+    return setMixerParameter(mixer, device, params.data(), params.size());
+}
+
 int SessionAlsaUtils::setStreamMetadataType(struct mixer *mixer, int device, const char *val)
 {
     char *pcmDeviceName = NULL;
@@ -1347,14 +1448,14 @@ int SessionAlsaUtils::setStreamMetadataType(struct mixer *mixer, int device, con
     }
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, val);
+    ret = mixerCtlSetEnumByString(ctl, val);
     free(mixer_str);
     return ret;
 }
@@ -1401,14 +1502,14 @@ int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, void *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    status = mixer_ctl_set_array(ctl, (struct agm_event_reg_cfg *)payload,
+    status = mixerCtlSetArray(ctl, (struct agm_event_reg_cfg *)payload,
                         payload_size);
     free(mixer_str);
     return status;
@@ -1416,6 +1517,7 @@ int SessionAlsaUtils::registerMixerEvent(struct mixer *mixer, int device, void *
 
 int SessionAlsaUtils::setECRefPath(struct mixer *mixer, int device, const char *intf_name)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     char *pcmDeviceName = NULL;
     char const *control = "echoReference";
     char *mixer_str;
@@ -1440,14 +1542,14 @@ int SessionAlsaUtils::setECRefPath(struct mixer *mixer, int device, const char *
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     printf("%s mixer -%s-\n", __func__, mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         printf("Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
 
-    ret = mixer_ctl_set_enum_by_string(ctl, intf_name);
+    ret = mixerCtlSetEnumByString(ctl, intf_name);
     free(mixer_str);
     return ret;
 }
@@ -1477,14 +1579,14 @@ int SessionAlsaUtils::mixerWriteDatapathParams(struct mixer *mixer, int device,
     snprintf(mixer_str, ctl_len, "%s %s", pcmDeviceName, control);
 
     PAL_DBG(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
         return ENOENT;
     }
     PAL_DBG(LOG_TAG, "payload = %p\n", payload);
-    ret = mixer_ctl_set_array(ctl, payload, size);
+    ret = mixerCtlSetArray(ctl, payload, size);
 
     PAL_DBG(LOG_TAG, "ret = %d, cnt = %d\n", ret, size);
     free(mixer_str);
@@ -1496,6 +1598,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     const std::vector<std::pair<int32_t, std::string>> &rxBackEnds,
     const std::vector<std::pair<int32_t, std::string>> &txBackEnds)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::vector <std::pair<int, int>> streamRxKV, streamTxKV;
     std::vector <std::pair<int, int>> streamRxCKV, streamTxCKV;
     std::vector <std::pair<int, int>> streamDeviceRxKV, streamDeviceTxKV;
@@ -1757,34 +1860,34 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
     txDevNum = !rxDevNum;
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnumByString(txFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamTxMetaData.size)
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+        mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
                 streamTxMetaData.size);
     if (deviceTxMetaData.size)
-        mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+        mixerCtlSetArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
                 deviceTxMetaData.size);
     if (streamDeviceTxMetaData.size) {
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-        mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+        mixerCtlSetEnumByString(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+        mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
                 streamDeviceTxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
+    mixerCtlSetEnumByString(txFeMixerCtrls[FE_CONNECT], txBackEnds[0].second.data());
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnumByString(rxFeMixerCtrls[FE_CONTROL], "ZERO");
     if (streamRxMetaData.size)
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+        mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
                 streamRxMetaData.size);
     if (deviceRxMetaData.size)
-        mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+        mixerCtlSetArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
                 deviceRxMetaData.size);
     if (streamDeviceRxMetaData.size) {
-        mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-        mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+        mixerCtlSetEnumByString(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+        mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
                 streamDeviceRxMetaData.size);
     }
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
+    mixerCtlSetEnumByString(rxFeMixerCtrls[FE_CONNECT], rxBackEnds[0].second.data());
 
     if (sAttr.type != PAL_STREAM_VOICE_CALL) {
         txFeMixerCtrls[FE_LOOPBACK] = getFeMixerControl(mixerHandle, txFeName.str(), FE_LOOPBACK);
@@ -1794,7 +1897,7 @@ int SessionAlsaUtils::open(Stream * streamHandle, std::shared_ptr<ResourceManage
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
+        mixerCtlSetEnumByString(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
     }
 freeTxMetaData:
     free(streamDeviceTxMetaData.buf);
@@ -1815,6 +1918,7 @@ exit:
 int SessionAlsaUtils::openDev(std::shared_ptr<ResourceManager> rmHandle,
     const std::vector<int> &DevIds, int32_t backEndId, std::string backEndName)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::vector <std::pair<int, int>> deviceKV;
     std::vector <std::pair<int, int>> emptyKV;
     int status = 0;
@@ -1856,7 +1960,7 @@ int SessionAlsaUtils::openDev(std::shared_ptr<ResourceManager> rmHandle,
             goto freeMetaData;
         }
     }
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL], "ZERO");
 
     if ((status = builder->populateDeviceKV(NULL, backEndId, deviceKV)) != 0) {
         PAL_ERR(LOG_TAG, "get device KV failed %d", status);
@@ -1883,9 +1987,9 @@ int SessionAlsaUtils::openDev(std::shared_ptr<ResourceManager> rmHandle,
 
     /** set mixer controls */
     if (deviceMetaData.size)
-        mixer_ctl_set_array(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
+        mixerCtlSetArray(beMetaDataMixerCtrl, (void *)deviceMetaData.buf,
                 deviceMetaData.size);
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONNECT], backEndName.data());
+    mixerCtlSetEnumByString(feMixerCtrls[FE_CONNECT], backEndName.data());
     deviceKV.clear();
     free(deviceMetaData.buf);
     deviceMetaData.buf = nullptr;
@@ -1906,6 +2010,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
     const std::vector<std::pair<int32_t, std::string>> &txBackEnds,
     std::vector<std::pair<std::string, int>> &freeDeviceMetaData)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     int status = 0;
     std::vector <std::pair<int, int>> emptyKV;
     struct pal_stream_attributes sAttr = {};
@@ -2026,25 +2131,25 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             status = -EINVAL;
             goto freeTxMetaData;
         }
-        mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
+        mixerCtlSetEnumByString(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
     }
 
     /** set TX mixer controls */
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
+    mixerCtlSetEnumByString(txFeMixerCtrls[FE_DISCONNECT], txBackEnds[0].second.data());
+    mixerCtlSetEnumByString(txFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamTxMetaData.buf,
             streamTxMetaData.size);
-    mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
-    mixer_ctl_set_array(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
+    mixerCtlSetEnumByString(txFeMixerCtrls[FE_CONTROL], txBackEnds[0].second.data());
+    mixerCtlSetArray(txFeMixerCtrls[FE_METADATA], (void *)streamDeviceTxMetaData.buf,
             streamDeviceTxMetaData.size);
 
     /** set RX mixer controls */
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], "ZERO");
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
+    mixerCtlSetEnumByString(rxFeMixerCtrls[FE_DISCONNECT], rxBackEnds[0].second.data());
+    mixerCtlSetEnumByString(rxFeMixerCtrls[FE_CONTROL], "ZERO");
+    mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamRxMetaData.buf,
             streamRxMetaData.size);
-    mixer_ctl_set_enum_by_string(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
-    mixer_ctl_set_array(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
+    mixerCtlSetEnumByString(rxFeMixerCtrls[FE_CONTROL], rxBackEnds[0].second.data());
+    mixerCtlSetArray(rxFeMixerCtrls[FE_METADATA], (void *)streamDeviceRxMetaData.buf,
             streamDeviceRxMetaData.size);
 
     /* set Backend mixer control */
@@ -2054,7 +2159,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free TX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
+                mixerCtlSetArray(txBeMixerCtrl, (void *)deviceTxMetaData.buf,
                                     deviceTxMetaData.size);
             }
         }
@@ -2062,7 +2167,7 @@ int SessionAlsaUtils::close(Stream * streamHandle, std::shared_ptr<ResourceManag
             if (freeDevMeta->second == 0) {
                 PAL_INFO(LOG_TAG, "No need to free RX device metadata as device is still active");
             } else {
-                mixer_ctl_set_array(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
+                mixerCtlSetArray(rxBeMixerCtrl, (void *)deviceRxMetaData.buf,
                                     deviceRxMetaData.size);
             }
         }
@@ -2090,6 +2195,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
         const std::vector<int> &pcmDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToDisconnect)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::ostringstream disconnectCtrlName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
@@ -2145,7 +2251,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = MixerCtlCache::getCtl(mixerHandle, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
         return -EINVAL;
@@ -2162,7 +2268,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     }
 
     /** Disconnect FE to BE */
-    mixer_ctl_set_enum_by_string(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
+    mixerCtlSetEnumByString(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
 
     /** clear device metadata*/
     getAgmMetaData(emptyKV, emptyKV, (struct prop_data*)devicePropId,
@@ -2200,13 +2306,13 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
     if (devCount > 1) {
         PAL_INFO(LOG_TAG, "No need to free device metadata since active streams present on device");
     } else {
-        mixer_ctl_set_array(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
+        mixerCtlSetArray(beMetaDataMixerCtrl, (void*)deviceMetaData.buf,
             deviceMetaData.size);
     }
 
-    mixer_ctl_set_enum_by_string(feMixerCtrls[FE_CONTROL],
+    mixerCtlSetEnumByString(feMixerCtrls[FE_CONTROL],
         aifBackEndsToDisconnect[0].second.data());
-    mixer_ctl_set_array(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
+    mixerCtlSetArray(feMixerCtrls[FE_METADATA], (void*)streamDeviceMetaData.buf,
         streamDeviceMetaData.size);
 
 freeMetaData:
@@ -2223,6 +2329,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
         const std::vector<int> &pcmTxDevIds,const std::vector<int> &pcmRxDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToDisconnect)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::ostringstream disconnectCtrlName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
@@ -2242,7 +2349,7 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
                  status = -EINVAL;
                  return status;
              }
-             mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
+             mixerCtlSetEnumByString(txFeMixerCtrls[FE_LOOPBACK], "ZERO");
              if (dAttr.id > PAL_DEVICE_OUT_MIN && dAttr.id < PAL_DEVICE_OUT_MAX) {
                  disconnectCtrlName << PCM_SND_DEV_NAME_PREFIX << pcmRxDevIds.at(0) << " disconnect";
              } else if (dAttr.id > PAL_DEVICE_IN_MIN && dAttr.id < PAL_DEVICE_IN_MAX) {
@@ -2254,13 +2361,13 @@ int SessionAlsaUtils::disconnectSessionDevice(Stream* streamHandle, pal_stream_t
             break;
     }
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
-    disconnectCtrl = mixer_get_ctl_by_name(mixerHandle, disconnectCtrlName.str().data());
+    disconnectCtrl = MixerCtlCache::getCtl(mixerHandle, disconnectCtrlName.str().data());
     if (!disconnectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", disconnectCtrlName.str().data());
         return -EINVAL;
     }
     /** Disconnect FE to BE */
-    mixer_ctl_set_enum_by_string(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
+    mixerCtlSetEnumByString(disconnectCtrl, aifBackEndsToDisconnect[0].second.data());
 
     return status;
 }
@@ -2270,6 +2377,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         const std::vector<int> &pcmDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToConnect)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     struct mixer_ctl *connectCtrl;
     struct mixer *mixerHandle = nullptr;
     bool is_compress = false;
@@ -2439,13 +2547,13 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
     }
 
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(mixerHandle, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         status = -EINVAL;
         goto exit;
     }
-    status = mixer_ctl_set_enum_by_string(connectCtrl, aifBackEndsToConnect[0].second.data());
+    status = mixerCtlSetEnumByString(connectCtrl, aifBackEndsToConnect[0].second.data());
 
     if (PAL_STREAM_VOICE_CALL == streamType) {
         SessionAlsaVoice *voiceSession = dynamic_cast<SessionAlsaVoice *>(sess);
@@ -2471,6 +2579,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         const std::vector<int> &pcmTxDevIds,const std::vector<int> &pcmRxDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToConnect)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::ostringstream connectCtrlName;
     int status = 0;
     struct mixer *mixerHandle = nullptr;
@@ -2529,14 +2638,14 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
         }
     }
 
-    connectCtrl = mixer_get_ctl_by_name(mixerHandle, connectCtrlName.str().data());
+    connectCtrl = MixerCtlCache::getCtl(mixerHandle, connectCtrlName.str().data());
     if (!connectCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", connectCtrlName.str().data());
         status = -EINVAL;
         goto exit;
     }
     /** connect FE to BE */
-    mixer_ctl_set_enum_by_string(connectCtrl, aifBackEndsToConnect[0].second.data());
+    mixerCtlSetEnumByString(connectCtrl, aifBackEndsToConnect[0].second.data());
 
     switch (streamType) {
          case PAL_STREAM_ULTRASOUND:
@@ -2551,7 +2660,7 @@ int SessionAlsaUtils::connectSessionDevice(Session* sess, Stream* streamHandle,
                  status = -EINVAL;
                  goto exit;
              }
-             mixer_ctl_set_enum_by_string(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
+             mixerCtlSetEnumByString(txFeMixerCtrls[FE_LOOPBACK], rxFeName.str().data());
              break;
          default:
              PAL_ERR(LOG_TAG, "unknown stream type %d",streamType);
@@ -2567,6 +2676,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         const std::vector<int> &pcmDevIds,
         const std::vector<std::pair<int32_t, std::string>> &aifBackEndsToConnect)
 {
+    MiidCacheInvalidator miidCacheInvalidator;
     std::ostringstream cntrlName;
     std::ostringstream aifMdName;
     std::ostringstream aifMfCtrlName;
@@ -2755,7 +2865,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
 
     status = rmHandle->getVirtualAudioMixer(&mixerHandle);
 
-    aifMdCtrl = mixer_get_ctl_by_name(mixerHandle, aifMdName.str().data());
+    aifMdCtrl = MixerCtlCache::getCtl(mixerHandle, aifMdName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", aifMdName.str().data());
     if (!aifMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", aifMdName.str().data());
@@ -2763,18 +2873,18 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (deviceMetaData.size)
-        mixer_ctl_set_array(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
+        mixerCtlSetArray(aifMdCtrl, (void *)deviceMetaData.buf, deviceMetaData.size);
 
-    feCtrl = mixer_get_ctl_by_name(mixerHandle, cntrlName.str().data());
+    feCtrl = MixerCtlCache::getCtl(mixerHandle, cntrlName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", cntrlName.str().data());
     if (!feCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", cntrlName.str().data());
         status = -EINVAL;
         goto freeMetaData;
     }
-    mixer_ctl_set_enum_by_string(feCtrl, aifBackEndsToConnect[0].second.data());
+    mixerCtlSetEnumByString(feCtrl, aifBackEndsToConnect[0].second.data());
 
-    feMdCtrl = mixer_get_ctl_by_name(mixerHandle, feMdName.str().data());
+    feMdCtrl = MixerCtlCache::getCtl(mixerHandle, feMdName.str().data());
     PAL_DBG(LOG_TAG, "mixer control %s", feMdName.str().data());
     if (!feMdCtrl) {
         PAL_ERR(LOG_TAG, "invalid mixer control: %s", feMdName.str().data());
@@ -2782,7 +2892,7 @@ int SessionAlsaUtils::setupSessionDevice(Stream* streamHandle, pal_stream_type_t
         goto freeMetaData;
     }
     if (streamDeviceMetaData.size)
-        mixer_ctl_set_array(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
+        mixerCtlSetArray(feMdCtrl, (void *)streamDeviceMetaData.buf, streamDeviceMetaData.size);
 freeMetaData:
     free(streamDeviceMetaData.buf);
     free(deviceMetaData.buf);
@@ -68,6 +68,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "SessionAlsaVoice.h"
 #include "SessionAlsaUtils.h"
+#include "MixerCtlCache.h"
 #include "Stream.h"
 #include "ResourceManager.h"
 #include "apm_api.h"
@@ -151,7 +152,7 @@ struct mixer_ctl* SessionAlsaVoice::getFEMixerCtl(const char *controlName, int *
     }
 
     CntrlName << stream << " " << controlName;
-    ctl = mixer_get_ctl_by_name(mixer, CntrlName.str().data());
+    ctl = MixerCtlCache::getCtl(mixer, CntrlName.str().data());
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", CntrlName.str().data());
         return NULL;
@@ -1553,7 +1554,7 @@ int SessionAlsaVoice::payloadTaged(Stream * s, configType type, int tag,
                 goto exit;
             }
             tagCntrlName<<stream<<" "<<setParamTagControl;
-            ctl = mixer_get_ctl_by_name(mixer, tagCntrlName.str().data());
+            ctl = MixerCtlCache::getCtl(mixer, tagCntrlName.str().data());
             if (!ctl) {
                 PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", tagCntrlName.str().data());
                 if (tagConfig)
@@ -2086,7 +2087,7 @@ int SessionAlsaVoice::setVoiceMixerParameter(Stream * s, struct mixer *mixer,
     snprintf(mixer_str, ctl_len, "%s %s", stream, control);
 
     PAL_VERBOSE(LOG_TAG, "- mixer -%s-\n", mixer_str);
-    ctl = mixer_get_ctl_by_name(mixer, mixer_str);
+    ctl = MixerCtlCache::getCtl(mixer, mixer_str);
     if (!ctl) {
         PAL_ERR(LOG_TAG, "Invalid mixer control: %s\n", mixer_str);
         free(mixer_str);
@@ -128,6 +128,16 @@ uint32_t SoundTriggerEngine::UsToBytes(uint64_t input_us) {
     return bytes;
 }
 
+uint64_t SoundTriggerEngine::BytesToUs(uint64_t bytes) {
+    uint64_t bytes_per_sec = (uint64_t)sample_rate_ * bit_width_ * channels_ /
+        BITS_PER_BYTE;
+
+    if (!bytes_per_sec)
+        return 0;
+
+    return bytes * US_PER_SEC / bytes_per_sec;
+}
+
 uint32_t SoundTriggerEngine::FrameToBytes(uint32_t frames) {
     uint32_t total_bytes, bytes_per_frame = bit_width_ * channels_ / BITS_PER_BYTE;
     try {
@@ -46,6 +46,7 @@
 #include "Stream.h"
 #include "SoundTriggerPlatformInfo.h"
 #include "VoiceUIInterface.h"
+#include "PalTrace.h"
 
 #define CNN_BUFFER_LENGTH 10000
 #define CNN_FRAME_SIZE 320
@@ -106,6 +107,8 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
                         detection_state = KEYWORD_DETECTION_REJECT;
                     else
                         detection_state = capi_engine->detection_state_;
+                    PalTrace::record(PAL_TRACE_SSTAGE_KEYWORD, capi_engine->detected_ns_,
+                                     PalTrace::nowNs(), (uint64_t)s);
                     lck.unlock();
                     s->SetEngineDetectionState(detection_state);
                     lck.lock();
@@ -124,6 +127,8 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
                         detection_state = USER_VERIFICATION_REJECT;
                     else
                         detection_state = capi_engine->detection_state_;
+                    PalTrace::record(PAL_TRACE_SSTAGE_USER, capi_engine->detected_ns_,
+                                     PalTrace::nowNs(), (uint64_t)s);
                     lck.unlock();
                     s->SetEngineDetectionState(detection_state);
                     lck.lock();
@@ -137,18 +142,68 @@ void SoundTriggerEngineCapi::BufferThreadLoop(
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Returns up to size bytes of unread data. When the data does not wrap in the
+ * ring buffer it is handed out in place and must be released with commit()
+ * after processing, otherwise it is copied into *copy_buff, which is
+ * allocated with copy_buff_size bytes on first use. The CAPI data_ptr is
+ * writable, and the other engines and the client read the same bytes, so
+ * data is only handed out in place to the ring's sole reader or to a module
+ * whose config declares read_only_input.
+ */
+int32_t SoundTriggerEngineCapi::GetProcessInput(char **copy_buff, size_t copy_buff_size,
+                                                size_t size, char **data, bool *in_place)
+{
+    struct pal_ring_buffer_span spans[PAL_RING_BUFFER_MAX_SPANS];
+    int32_t avail = reader_->peek(spans);
+
+    if (avail <= 0)
+        return avail;
+
+    if (spans[0].size >= std::min((size_t)avail, size) &&
+        (ss_cfg_->IsInputReadOnly() || reader_->isSoleReader())) {
+        *data = (char *)spans[0].data;
+        *in_place = true;
+        return std::min((size_t)avail, size);
+    }
+
+    if (!*copy_buff) {
+        *copy_buff = (char *)malloc(copy_buff_size);
+        if (!*copy_buff) {
+            PAL_ERR(LOG_TAG, "failed to allocate process input buff");
+            return -ENOMEM;
+        }
+    }
+    *data = *copy_buff;
+    *in_place = false;
+    return reader_->read((void *)*copy_buff, std::min(size, copy_buff_size));
+}
+
+/*
+ * With early decision, a detection is rejected once decision_sz bytes are
+ * processed and the running score is more than the configured margin below
+ * the threshold, instead of after the whole processing size.
+ */
+bool SoundTriggerEngineCapi::IsRejectedEarly(uint32_t processed_sz, uint32_t decision_sz)
+{
+    if (!ss_cfg_->IsEarlyDecisionEnabled() || processed_sz < decision_sz)
+        return false;
+
+    return det_conf_score_ < confidence_threshold_ - ss_cfg_->GetEarlyRejectMargin();
+}
+
 int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 {
     int32_t status = 0;
     char *process_input_buff = nullptr;
+    char *input_data = nullptr;
+    bool in_place = false;
     capi_v2_err_t rc = CAPI_V2_EOK;
     capi_v2_stream_data_t *stream_input = nullptr;
     sva_result_t *result_cfg_ptr = nullptr;
     int32_t read_size = 0;
     capi_v2_buf_t capi_result;
-    bool buffer_advanced = false;
-    size_t lab_buffer_size = 0;
-    bool first_buffer_processed = false;
+    size_t chunk_sz = 0, copy_buff_size = 0;
     FILE *keyword_detection_fd = nullptr;
     ChronoSteadyClock_t process_start;
     ChronoSteadyClock_t process_end;
@@ -159,7 +214,7 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     uint64_t total_capi_get_param_duration = 0;
     uint32_t start_idx = 0, end_idx = 0;
     uint32_t ftrt_sz = 0, read_offset = 0;
-    uint32_t max_processing_sz = 0, processed_sz = 0;
+    uint32_t max_processing_sz = 0, processed_sz = 0, decision_sz = 0;
     vui_intf_param_t param;
 
     PAL_DBG(LOG_TAG, "Enter");
@@ -191,14 +246,20 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
             UsToBytes(kw_end_tolerance_ + data_after_kw_end_);
         ftrt_sz = end_idx;
     }
+    /* ftrt_sz is the data up to the keyword end here */
+    decision_sz = ftrt_sz + UsToBytes(ss_cfg_->GetEarlyRejectAfterKwEnd());
     /*
      * As per requirement in PDK, input buffer size for
      * second stage should be in multiple of 10 ms(10000us).
      */
     ftrt_sz -= ftrt_sz % (UsToBytes(10000));
 
-    lab_buffer_size = buffer_size_;
-    buffer_size_ = ftrt_sz;
+    /*
+     * The history goes in one call, the data after it in lab buffer chunks.
+     * With early decision the history is scored chunk by chunk as well.
+     */
+    chunk_sz = (ftrt_sz && !ss_cfg_->IsEarlyDecisionEnabled()) ? ftrt_sz : buffer_size_;
+    copy_buff_size = std::max((size_t)ftrt_sz, (size_t)buffer_size_);
 
     if (vui_ptfm_info_->GetEnableDebugDumps()) {
         ST_DBG_FILE_OPEN_WR(keyword_detection_fd, ST_DEBUG_DUMP_LOCATION,
@@ -209,14 +270,6 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
     }
 
     memset(&capi_result, 0, sizeof(capi_result));
-    process_input_buff = (char*)calloc(1, buffer_size_);
-    if (!process_input_buff) {
-        status = -ENOMEM;
-        PAL_ERR(LOG_TAG, "failed to allocate process input buff, status %d",
-                status);
-        goto exit;
-    }
-
     stream_input = (capi_v2_stream_data_t *)
                    calloc(1, sizeof(capi_v2_stream_data_t));
     if (!stream_input) {
@@ -240,28 +293,26 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
         goto exit;
     }
 
+    /* advance the offset to ensure we are reading at the right place */
+    if (read_offset > 0)
+        reader_->advanceReadOffset(read_offset);
+
     process_start = std::chrono::steady_clock::now();
     while (!exit_buffering_ && (processed_sz < max_processing_sz)) {
-        /* Original code had some time of wait will need to revisit*/
-        /* need to take into consideration the start and end buffer*/
         if (!reader_->isEnabled()) {
             status = -EINVAL;
             goto exit;
         }
 
-        /* advance the offset to ensure we are reading at the right place */
-        if (!buffer_advanced && read_offset > 0) {
-            if (reader_->advanceReadOffset(read_offset)) {
-                buffer_advanced = true;
-            } else {
-                continue;
-            }
-        }
-
-        if (!reader_->waitForBuffers(buffer_size_))
+        /*
+         * Sleeps until the chunk is buffered, the reader is reset or
+         * StopRecognition() cancels the wait, only a timeout waits again.
+         */
+        if (!reader_->waitForBuffers(chunk_sz))
             continue;
 
-        read_size = reader_->read((void*)process_input_buff, buffer_size_);
+        read_size = GetProcessInput(&process_input_buff, copy_buff_size, chunk_sz,
+                                    &input_data, &in_place);
         if (read_size == 0) {
             continue;
         } else if (read_size < 0) {
@@ -271,13 +322,13 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
         }
 
         stream_input->bufs_num = 1;
-        stream_input->buf_ptr->max_data_len = buffer_size_;
+        stream_input->buf_ptr->max_data_len = chunk_sz;
         stream_input->buf_ptr->actual_data_len = read_size;
-        stream_input->buf_ptr->data_ptr = (int8_t *)process_input_buff;
+        stream_input->buf_ptr->data_ptr = (int8_t *)input_data;
 
         if (vui_ptfm_info_->GetEnableDebugDumps()) {
             ST_DBG_FILE_WRITE(keyword_detection_fd,
-                process_input_buff, read_size);
+                input_data, read_size);
         }
 
         PAL_VERBOSE(LOG_TAG, "Calling Capi Process");
@@ -290,6 +341,8 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
 #ifndef ATRACE_UNSUPPORTED
         ATRACE_END();
 #endif
+        if (in_place)
+            reader_->commit(read_size);
         capi_call_end = std::chrono::steady_clock::now();
         total_capi_process_duration +=
             std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -332,21 +385,22 @@ int32_t SoundTriggerEngineCapi::StartKeywordDetection()
             vui_intf_->SetParameter(PARAM_SSTAGE_KW_DET_LEVEL, &param);
             PAL_INFO(LOG_TAG, "KWD Second Stage Detected, start index %u, end index %u",
                 start_idx, end_idx);
-        } else if (processed_sz >= max_processing_sz) {
+        } else if (processed_sz >= max_processing_sz ||
+                   IsRejectedEarly(processed_sz, decision_sz)) {
+            if (processed_sz < max_processing_sz)
+                exit_buffering_ = true;
             detection_state_ = KEYWORD_DETECTION_REJECT;
             param.stream = (void *)stream_handle_;
             param.data = (void *)&det_conf_score_;
             param.size = sizeof(int32_t);
             vui_intf_->SetParameter(PARAM_SSTAGE_KW_DET_LEVEL, &param);
-            PAL_INFO(LOG_TAG, "KWD Second Stage rejected");
+            PAL_INFO(LOG_TAG, "KWD Second Stage rejected after %u of %u bytes",
+                processed_sz, max_processing_sz);
         }
         PAL_INFO(LOG_TAG, "KWD second stage conf level %d, processed %u bytes",
             det_conf_score_, processed_sz);
 
-        if (!first_buffer_processed) {
-            buffer_size_ = lab_buffer_size;
-            first_buffer_processed = true;
-        }
+        chunk_sz = buffer_size_;
     }
 
 exit:
@@ -396,6 +450,8 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
 {
     int32_t status = 0;
     char *process_input_buff = nullptr;
+    char *input_data = nullptr;
+    bool in_place = false;
     capi_v2_err_t rc = CAPI_V2_EOK;
     capi_v2_stream_data_t *stream_input = nullptr;
     capi_v2_buf_t capi_uv_ptr;
@@ -403,7 +459,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     stage2_uv_wrapper_stage1_uv_score_t *uv_cfg_ptr = nullptr;
     int32_t read_size = 0;
     capi_v2_buf_t capi_result;
-    bool buffer_advanced = false;
+    size_t chunk_sz = 0, copy_buff_size = 0;
     StreamSoundTrigger *str = nullptr;
     FILE *user_verification_fd = nullptr;
     ChronoSteadyClock_t process_start;
@@ -415,7 +471,7 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     uint64_t total_capi_get_param_duration = 0;
     uint32_t start_idx = 0, end_idx = 0;
     uint32_t ftrt_sz = 0, read_offset = 0;
-    uint32_t max_processing_sz = 0, processed_sz = 0;
+    uint32_t max_processing_sz = 0, processed_sz = 0, decision_sz = 0;
     st_module_type_t fstage_module_type;
     vui_intf_param_t param;
 
@@ -446,6 +502,20 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
         max_processing_sz = end_idx + UsToBytes(kw_end_tolerance_);
     }
     PAL_INFO(LOG_TAG, "processing size %u", max_processing_sz);
+
+    /*
+     * Process the data up to the keyword end, already buffered at detection,
+     * in one call and the end tolerance in lab buffer chunks as it arrives,
+     * rather than waiting for all of it. A stop is seen between two chunks.
+     * With early decision the history is scored chunk by chunk as well.
+     */
+    decision_sz = max_processing_sz - UsToBytes(kw_end_tolerance_) +
+        UsToBytes(ss_cfg_->GetEarlyRejectAfterKwEnd());
+    chunk_sz = max_processing_sz - UsToBytes(kw_end_tolerance_);
+    chunk_sz -= chunk_sz % UsToBytes(10000);
+    if (!chunk_sz || ss_cfg_->IsEarlyDecisionEnabled())
+        chunk_sz = std::min(max_processing_sz, buffer_size_);
+    copy_buff_size = std::max(chunk_sz, (size_t)buffer_size_);
     if (vui_ptfm_info_->GetEnableDebugDumps()) {
         ST_DBG_FILE_OPEN_WR(user_verification_fd, ST_DEBUG_DUMP_LOCATION,
             "user_verification", "bin", user_verification_cnt);
@@ -457,13 +527,6 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
     memset(&capi_uv_ptr, 0, sizeof(capi_uv_ptr));
     memset(&capi_result, 0, sizeof(capi_result));
 
-    process_input_buff = (char*)calloc(1, max_processing_sz);
-    if (!process_input_buff) {
-        PAL_ERR(LOG_TAG, "failed to allocate process input buff");
-        status = -ENOMEM;
-        goto exit;
-    }
-
     stream_input = (capi_v2_stream_data_t *)
                    calloc(1, sizeof(capi_v2_stream_data_t));
     if (!stream_input) {
@@ -525,28 +588,23 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
         }
     }
 
+    /* advance the offset to ensure we are reading at the right place */
+    if (read_offset > 0)
+        reader_->advanceReadOffset(read_offset);
+
     process_start = std::chrono::steady_clock::now();
     while (!exit_buffering_ && (processed_sz < max_processing_sz)) {
-        /* Original code had some time of wait will need to revisit*/
-        /* need to take into consideration the start and end buffer*/
         if (!reader_->isEnabled()) {
             status = -EINVAL;
             goto exit;
         }
 
-        /* advance the offset to ensure we are reading at the right place */
-        if (!buffer_advanced && read_offset > 0) {
-            if (reader_->advanceReadOffset(read_offset)) {
-                buffer_advanced = true;
-            } else {
-                continue;
-            }
-        }
-
-        if (!reader_->waitForBuffers(max_processing_sz))
+        chunk_sz = std::min(chunk_sz, (size_t)(max_processing_sz - processed_sz));
+        if (!reader_->waitForBuffers(chunk_sz))
             continue;
 
-        read_size = reader_->read((void*)process_input_buff, max_processing_sz);
+        read_size = GetProcessInput(&process_input_buff, copy_buff_size, chunk_sz,
+                                    &input_data, &in_place);
         if (read_size == 0) {
             continue;
         } else if (read_size < 0) {
@@ -555,13 +613,13 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
             goto exit;
         }
         stream_input->bufs_num = 1;
-        stream_input->buf_ptr->max_data_len = max_processing_sz;
+        stream_input->buf_ptr->max_data_len = chunk_sz;
         stream_input->buf_ptr->actual_data_len = read_size;
-        stream_input->buf_ptr->data_ptr = (int8_t *)process_input_buff;
+        stream_input->buf_ptr->data_ptr = (int8_t *)input_data;
 
         if (vui_ptfm_info_->GetEnableDebugDumps()) {
             ST_DBG_FILE_WRITE(user_verification_fd,
-                process_input_buff, read_size);
+                input_data, read_size);
         }
 
         PAL_VERBOSE(LOG_TAG, "Calling Capi Process\n");
@@ -574,6 +632,8 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
 #ifndef ATRACE_UNSUPPORTED
         ATRACE_END();
 #endif
+        if (in_place)
+            reader_->commit(read_size);
         capi_call_end = std::chrono::steady_clock::now();
         total_capi_process_duration +=
             std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -619,16 +679,22 @@ int32_t SoundTriggerEngineCapi::StartUserVerification()
             param.size = sizeof(int32_t);
             vui_intf_->SetParameter(PARAM_SSTAGE_UV_DET_LEVEL ,&param);
             PAL_INFO(LOG_TAG, "UV Second Stage Detected");
-        } else if (processed_sz >= max_processing_sz) {
+        } else if (processed_sz >= max_processing_sz ||
+                   IsRejectedEarly(processed_sz, decision_sz)) {
+            if (processed_sz < max_processing_sz)
+                exit_buffering_ = true;
             detection_state_ = USER_VERIFICATION_REJECT;
             param.stream = (void *)stream_handle_;
             param.data = (void *)&det_conf_score_;
             param.size = sizeof(int32_t);
             vui_intf_->SetParameter(PARAM_SSTAGE_UV_DET_LEVEL ,&param);
-            PAL_INFO(LOG_TAG, "UV Second Stage Rejected");
+            PAL_INFO(LOG_TAG, "UV Second Stage Rejected after %u of %u bytes",
+                processed_sz, max_processing_sz);
         }
         PAL_INFO(LOG_TAG, "UV second stage conf level %d, processing %u bytes",
             det_conf_score_, processed_sz);
+
+        chunk_sz = buffer_size_;
     }
 
 exit:
@@ -696,6 +762,7 @@ SoundTriggerEngineCapi::SoundTriggerEngineCapi(
     stream_handle_ = s;
     confidence_threshold_ = 0;
     detection_state_ = ENGINE_IDLE;
+    detected_ns_ = 0;
     capi_handle_ = nullptr;
     capi_lib_handle_ = nullptr;
     capi_init_ = nullptr;
@@ -1151,7 +1218,10 @@ int32_t SoundTriggerEngineCapi::RestartRecognition(Stream *s __unused)
     std::lock_guard<std::mutex> lck(mutex_);
     processing_started_ = false;
     {
+        /* wake the processing thread so that it leaves after its current chunk */
         exit_buffering_ = true;
+        if (reader_)
+            reader_->cancelWait();
         std::lock_guard<std::mutex> event_lck(event_mutex_);
     }
     if (reader_) {
@@ -1175,7 +1245,10 @@ int32_t SoundTriggerEngineCapi::StopRecognition(Stream *s __unused)
     std::lock_guard<std::mutex> lck(mutex_);
     processing_started_ = false;
     {
+        /* wake the processing thread so that it leaves after its current chunk */
         exit_buffering_ = true;
+        if (reader_)
+            reader_->cancelWait();
         std::lock_guard<std::mutex> event_lck(event_mutex_);
     }
     if (reader_) {
@@ -1196,8 +1269,10 @@ void SoundTriggerEngineCapi::SetDetected(bool detected)
     PAL_DBG(LOG_TAG, "SetDetected %d", detected);
     std::lock_guard<std::mutex> lck(event_mutex_);
     if (detected != processing_started_) {
-        if (detected)
+        if (detected) {
+            detected_ns_ = PalTrace::nowNs();
             reader_->updateState(READER_ENABLED);
+        }
         processing_started_ = detected;
         exit_buffering_ = !processing_started_;
         PAL_INFO(LOG_TAG, "setting processing started %d", detected);
@@ -55,6 +55,7 @@
 
 #define TIMEOUT_FOR_EOS 100000
 #define MAX_MMAP_POSITION_QUERY_RETRY_CNT 5
+#define MIN_MMAP_POSITION_WAIT_US 1000
 
 ST_DBG_DECLARE(static int dsp_output_cnt = 0);
 
@@ -65,6 +66,8 @@ std::map<Stream*, std::shared_ptr<SoundTriggerEngineGsl>>
 std::mutex SoundTriggerEngineGsl::eng_create_mutex_;
 int32_t SoundTriggerEngineGsl::engine_count_ = 0;
 std::condition_variable cvEOS;
+LatencyHistogram SoundTriggerEngineGsl::kw_first_byte_hist_("kw_first_byte");
+LatencyHistogram SoundTriggerEngineGsl::kw_ftrt_hist_("kw_ftrt_transfer");
 
 void SoundTriggerEngineGsl::EventProcessingThread(
     SoundTriggerEngineGsl *gsl_engine) {
@@ -141,6 +144,74 @@ void SoundTriggerEngineGsl::ProcessEventTask() {
     PAL_DBG(LOG_TAG, "Exit");
 }
 
+/*
+ * Called by the event processing thread with mutex_ held. mutex_ is given
+ * up while waiting so that stop/restart can get in; StopBuffering() and
+ * consecutive detections cut the wait short. A notification racing with
+ * the exit_buffering_ check is only lost for one wait period.
+ */
+void SoundTriggerEngineGsl::WaitForBufferingEvent(uint64_t wait_us) {
+    std::unique_lock<std::mutex> lck(mutex_, std::adopt_lock);
+
+    if (!exit_buffering_)
+        buffering_cv_.wait_for(lck, std::chrono::microseconds(wait_us));
+    lck.release();
+}
+
+void SoundTriggerEngineGsl::StopBuffering() {
+    exit_buffering_ = true;
+    buffering_cv_.notify_all();
+}
+
+/*
+ * Passes one contiguous block of LAB data to the VUI interface while it
+ * is still part of FTRT and copies it into the ring buffer, skipping the
+ * first bytes_to_drop bytes. Returns bytes written to the ring buffer.
+ */
+size_t SoundTriggerEngineGsl::WriteLabData(Stream *s, uint8_t *data, size_t size,
+    bool is_ftrt, uint32_t *bytes_to_drop, FILE *dump_fd) {
+    vui_intf_param_t param {};
+    size_t ret = 0;
+
+    if (!size)
+        return 0;
+
+    if (is_ftrt) {
+        param.stream = (void *)s;
+        param.data = data;
+        param.size = size;
+        vui_intf_->SetParameter(PARAM_FTRT_DATA, &param);
+    }
+
+    if (*bytes_to_drop) {
+        if (size < *bytes_to_drop) {
+            *bytes_to_drop -= size;
+            return 0;
+        }
+        data += *bytes_to_drop;
+        size -= *bytes_to_drop;
+        *bytes_to_drop = 0;
+    }
+
+    ret = buffer_->write((void *)data, size);
+    if (vui_ptfm_info_->GetEnableDebugDumps()) {
+        ST_DBG_FILE_WRITE(dump_fd, data, size);
+    }
+
+    if (ret && !kw_first_byte_written_) {
+        auto iter = detection_time_map_.find(s);
+
+        if (iter != detection_time_map_.end())
+            kw_first_byte_hist_.record(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - iter->second).count());
+        kw_first_byte_written_ = true;
+    }
+    PAL_VERBOSE(LOG_TAG, "%zu written to ring buffer", ret);
+
+    return ret;
+}
+
 int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     int32_t status = 0;
     int32_t size = 0;
@@ -155,7 +226,11 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     size_t size_to_read = 0;
     size_t read_offset = 0;
     size_t bytes_written = 0;
-    uint32_t sleep_ms = 0;
+    size_t wrap_size = 0;
+    uint64_t buffer_us = 0;
+    uint64_t period_us = 0;
+    uint64_t wait_us = 0;
+    uint64_t stall_us = 0;
     bool event_notified = false;
     StreamSoundTrigger *st = (StreamSoundTrigger *)s;
     struct pal_mmap_position mmap_pos;
@@ -164,23 +239,36 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     ChronoSteadyClock_t kw_transfer_end;
     vui_intf_param_t param {};
     struct buffer_config buf_config;
-    size_t retry_cnt = 0;
 
     PAL_DBG(LOG_TAG, "Enter");
+    std::memset(&buf, 0, sizeof(struct pal_buffer));
     UpdateState(ENG_BUFFERING);
     s->getBufInfo(&input_buf_size, &input_buf_num, nullptr, nullptr);
-    sleep_ms = (input_buf_size * input_buf_num) *
-        BITS_PER_BYTE * MS_PER_SEC / (sample_rate_ * bit_width_ * channels_);
-
-    std::memset(&buf, 0, sizeof(struct pal_buffer));
-    buf.size = input_buf_size * input_buf_num;
-    buf.buffer = (uint8_t *)calloc(1, buf.size);
-    if (!buf.buffer) {
-        PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-        status = -ENOMEM;
+    /*
+     * Wake-ups are derived from the real time data rate: one period for
+     * mmap, where the DSP position tells exactly what is pending, and the
+     * whole read size for shared memory reads as before.
+     */
+    period_us = BytesToUs(input_buf_size);
+    buffer_us = period_us * input_buf_num;
+    if (!period_us) {
+        PAL_ERR(LOG_TAG, "Invalid buffer config, size %zu rate %u",
+            input_buf_size, sample_rate_);
+        status = -EINVAL;
         goto exit;
     }
 
+    /* mmap data goes straight from the shared buffer to the ring buffer */
+    if (mmap_buffer_size_ == 0) {
+        buf.size = input_buf_size * input_buf_num;
+        buf.buffer = (uint8_t *)calloc(1, buf.size);
+        if (!buf.buffer) {
+            PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
+            status = -ENOMEM;
+            goto exit;
+        }
+    }
+
     // for PDK models, pre roll is adjusted inside ADSP, no need to drop data
     if (module_type_ == ST_MODULE_TYPE_GMM) {
         param.stream = (void *)s;
@@ -209,6 +297,7 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
     ATRACE_ASYNC_BEGIN("stEngine: read FTRT data", (int32_t)module_type_);
 #endif
     kw_transfer_begin = std::chrono::steady_clock::now();
+    kw_first_byte_written_ = false;
     while (!exit_buffering_) {
         /*
          * When RestartRecognition is called during buffering thread
@@ -230,9 +319,9 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
             event_notified = false;
             PAL_DBG(LOG_TAG, "new detected stream added, size %d", det_streams_q_.size());
             kw_transfer_begin = std::chrono::steady_clock::now();
+            kw_first_byte_written_ = false;
         }
 
-        PAL_VERBOSE(LOG_TAG, "request read %zu from gsl", buf.size);
         // read data from session
 #ifndef ATRACE_UNSUPPORTED
         ATRACE_ASYNC_BEGIN("stEngine: lab read", (int32_t)module_type_);
@@ -264,16 +353,26 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 }
                 if (bytes_written > total_read_size) {
                     size_to_read = bytes_written - total_read_size;
-                    retry_cnt = 0;
+                    stall_us = 0;
                 } else {
-                    retry_cnt++;
-                    if (retry_cnt > MAX_MMAP_POSITION_QUERY_RETRY_CNT) {
+                    /*
+                     * Nothing new yet: sleep until the next period is due,
+                     * or only until the rest of the keyword is due if that
+                     * comes first.
+                     */
+                    wait_us = period_us;
+                    if (total_read_size < ftrt_size)
+                        wait_us = std::min(wait_us,
+                            BytesToUs(ftrt_size - total_read_size));
+                    wait_us = std::max(wait_us, (uint64_t)MIN_MMAP_POSITION_WAIT_US);
+                    stall_us += wait_us;
+                    if (stall_us > MAX_MMAP_POSITION_QUERY_RETRY_CNT * buffer_us) {
+                        PAL_ERR(LOG_TAG, "mmap position stalled for %llu us",
+                            (unsigned long long)stall_us);
                         status = -EIO;
                         goto exit;
                     }
-                    mutex_.unlock();
-                    std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
-                    mutex_.lock();
+                    WaitForBufferingEvent(wait_us);
                     continue;
                 }
                 if (size_to_read > (2 * mmap_buffer_size_) - read_offset) {
@@ -289,36 +388,26 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 goto exit;
             }
 
-            if (size_to_read != buf.size) {
-                buf.buffer = (uint8_t *)realloc(buf.buffer, size_to_read);
-                if (!buf.buffer) {
-                    PAL_ERR(LOG_TAG, "buf.buffer allocation failed");
-                    status = -ENOMEM;
-                    goto exit;
-                }
-                buf.size = size_to_read;
-            }
-
-            // TODO: directly write to PalRingBuffer with shared buffer pointer
+            // copy from the shared buffer, in two parts if the data wraps
             if (read_offset + size_to_read <= mmap_buffer_size_) {
-                ar_mem_cpy(buf.buffer, size_to_read,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    size_to_read);
+                WriteLabData(s, (uint8_t *)mmap_buffer_.buffer + read_offset,
+                    size_to_read, total_read_size + size_to_read < ftrt_size,
+                    &bytes_to_drop, dsp_output_fd);
                 read_offset += size_to_read;
             } else {
-                ar_mem_cpy(buf.buffer, mmap_buffer_size_ - read_offset,
-                    (uint8_t *)mmap_buffer_.buffer + read_offset,
-                    mmap_buffer_size_ - read_offset);
-                ar_mem_cpy(buf.buffer + mmap_buffer_size_ - read_offset,
-                    size_to_read + read_offset - mmap_buffer_size_,
-                    (uint8_t *)mmap_buffer_.buffer,
-                    size_to_read + read_offset - mmap_buffer_size_);
-                read_offset = size_to_read + read_offset - mmap_buffer_size_;
+                wrap_size = mmap_buffer_size_ - read_offset;
+                WriteLabData(s, (uint8_t *)mmap_buffer_.buffer + read_offset,
+                    wrap_size, total_read_size + size_to_read < ftrt_size,
+                    &bytes_to_drop, dsp_output_fd);
+                WriteLabData(s, (uint8_t *)mmap_buffer_.buffer,
+                    size_to_read - wrap_size, total_read_size + size_to_read < ftrt_size,
+                    &bytes_to_drop, dsp_output_fd);
+                read_offset = size_to_read - wrap_size;
             }
-            size = size_to_read;
-            PAL_VERBOSE(LOG_TAG, "read %d bytes from shared buffer", size);
-            total_read_size += size;
+            PAL_VERBOSE(LOG_TAG, "read %zu bytes from shared buffer", size_to_read);
+            total_read_size += size_to_read;
         } else if (buffer_->getFreeSize() >= buf.size) {
+            PAL_VERBOSE(LOG_TAG, "request read %zu from gsl", buf.size);
             if (total_read_size < ftrt_size &&
                 ftrt_size - total_read_size < buf.size) {
                 buf.size = ftrt_size - total_read_size;
@@ -332,38 +421,12 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
             }
             PAL_VERBOSE(LOG_TAG, "requested %zu, read %d", buf.size, size);
             total_read_size += size;
+            WriteLabData(s, buf.buffer, size, total_read_size < ftrt_size,
+                &bytes_to_drop, dsp_output_fd);
         }
 #ifndef ATRACE_UNSUPPORTED
         ATRACE_ASYNC_END("stEngine: lab read", (int32_t)module_type_);
 #endif
-        // write data to ring buffer
-        if (size) {
-            if (total_read_size < ftrt_size) {
-                param.data = buf.buffer;
-                param.size = size;
-                vui_intf_->SetParameter(PARAM_FTRT_DATA, &param);
-            }
-            size_t ret = 0;
-            if (bytes_to_drop) {
-                if (size < bytes_to_drop) {
-                    bytes_to_drop -= size;
-                } else {
-                    ret = buffer_->write((void*)(buf.buffer + bytes_to_drop),
-                        size - bytes_to_drop);
-                    if (vui_ptfm_info_->GetEnableDebugDumps()) {
-                        ST_DBG_FILE_WRITE(dsp_output_fd,
-                            buf.buffer + bytes_to_drop, size - bytes_to_drop);
-                    }
-                    bytes_to_drop = 0;
-                }
-            } else {
-                ret = buffer_->write(buf.buffer, size);
-                if (vui_ptfm_info_->GetEnableDebugDumps()) {
-                    ST_DBG_FILE_WRITE(dsp_output_fd, buf.buffer, size);
-                }
-            }
-            PAL_VERBOSE(LOG_TAG, "%zu written to ring buffer", ret);
-        }
 
         // notify client until ftrt data read
         if (total_read_size >= ftrt_size) {
@@ -372,10 +435,14 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
 #ifndef ATRACE_UNSUPPORTED
                 ATRACE_ASYNC_END("stEngine: read FTRT data", (int32_t)module_type_);
 #endif
+                kw_ftrt_hist_.record(std::chrono::duration_cast<std::chrono::microseconds>(
+                    kw_transfer_end - kw_transfer_begin).count());
                 kw_transfer_latency_ = std::chrono::duration_cast<std::chrono::milliseconds>(
                     kw_transfer_end - kw_transfer_begin).count();
                 PAL_INFO(LOG_TAG, "FTRT data read done! total_read_size %zu, ftrt_size %zu, read latency %llums",
                         total_read_size, ftrt_size, (long long)kw_transfer_latency_);
+                kw_first_byte_hist_.dump();
+                kw_ftrt_hist_.dump();
                 st = dynamic_cast<StreamSoundTrigger *>(s);
                 if (st) {
                     mutex_.unlock();
@@ -395,9 +462,7 @@ int32_t SoundTriggerEngineGsl::StartBuffering(Stream *s) {
                 event_notified = true;
             }
             // From now on, capture the real time data.
-            mutex_.unlock();
-            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
-            mutex_.lock();
+            WaitForBufferingEvent(mmap_buffer_size_ != 0 ? period_us : buffer_us);
         }
     }
 
@@ -458,6 +523,7 @@ SoundTriggerEngineGsl::SoundTriggerEngineGsl(
     rx_ec_dev_ = nullptr;
     mmap_write_position_ = 0;
     kw_transfer_latency_ = 0;
+    kw_first_byte_written_ = false;
     std::shared_ptr<VUIFirstStageConfig> sm_module_info = nullptr;
     builder_ = new PayloadBuilder();
     dev_disconnect_count_ = 0;
@@ -546,7 +612,7 @@ SoundTriggerEngineGsl::SoundTriggerEngineGsl(
 SoundTriggerEngineGsl::~SoundTriggerEngineGsl() {
     PAL_INFO(LOG_TAG, "Enter");
     {
-        exit_buffering_ = true;
+        StopBuffering();
         std::unique_lock<std::mutex> lck(mutex_);
         exit_thread_ = true;
         cv_.notify_one();
@@ -747,7 +813,7 @@ int32_t SoundTriggerEngineGsl::LoadSoundModel(Stream *s, uint8_t *data,
         return status;
     }
 
-    exit_buffering_ = true;
+    StopBuffering();
     std::unique_lock<std::mutex> lck(mutex_);
     /* Check whether any stream is already attached to this engine */
     if (CheckIfOtherStreamsAttached(s)) {
@@ -799,7 +865,7 @@ int32_t SoundTriggerEngineGsl::UnloadSoundModel(Stream *s) {
 
     PAL_DBG(LOG_TAG, "Enter");
 
-    exit_buffering_ = true;
+    StopBuffering();
     std::unique_lock<std::mutex> lck(mutex_);
 
     /* Check whether any stream is already attached to this engine */
@@ -849,7 +915,7 @@ int32_t SoundTriggerEngineGsl::CreateBuffer(uint32_t buffer_size,
 
     PAL_DBG(LOG_TAG, "Enter, buf size %u", buffer_size);
     if (!buffer_) {
-        buffer_ = new PalRingBuffer(buffer_size);
+        buffer_ = new PalRingBuffer(buffer_size, true);
         if (!buffer_) {
             PAL_ERR(LOG_TAG, "Failed to allocate memory for ring buffer");
             status = -ENOMEM;
@@ -993,7 +1059,7 @@ int32_t SoundTriggerEngineGsl::StartRecognition(Stream *s) {
 
     PAL_DBG(LOG_TAG, "Enter");
 
-    exit_buffering_ = true;
+    StopBuffering();
 
     std::unique_lock<std::mutex> lck(mutex_);
 
@@ -1065,7 +1131,7 @@ int32_t SoundTriggerEngineGsl::RestartRecognition_l(Stream *s) {
         PAL_INFO(LOG_TAG, "Engine buffering with other active streams");
         return status;
     }
-    exit_buffering_ = true;
+    StopBuffering();
     if (buffer_) {
         buffer_->reset();
     }
@@ -1114,7 +1180,7 @@ int32_t SoundTriggerEngineGsl::ReconfigureDetectionGraph(Stream *s) {
 
     PAL_DBG(LOG_TAG, "Enter");
 
-    exit_buffering_ = true;
+    StopBuffering();
     std::unique_lock<std::mutex> lck(mutex_);
     DetachStream(s, false);
 
@@ -1191,7 +1257,7 @@ int32_t SoundTriggerEngineGsl::StopRecognition(Stream *s) {
 
     PAL_DBG(LOG_TAG, "Enter");
 
-    exit_buffering_ = true;
+    StopBuffering();
     std::lock_guard<std::mutex> lck(mutex_);
 
     param.stream = (void *)s;
@@ -1540,6 +1606,8 @@ void SoundTriggerEngineGsl::HandleSessionEvent(uint32_t event_id __unused,
         param.data = (void *)&kw_index;
         param.size = sizeof(struct keyword_index);
         vui_intf_->SetParameter(PARAM_KEYWORD_INDEX, &param);
+        // let the buffering loop pick it up without waiting out its period
+        buffering_cv_.notify_one();
     }
 
     if (vui_ptfm_info_->GetEnableDebugDumps()) {
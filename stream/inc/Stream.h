@@ -72,6 +72,7 @@
 #include <math.h>
 #include <memory>
 #include <mutex>
+#include <functional>
 #include <exception>
 #include <semaphore.h>
 #include <errno.h>
@@ -79,6 +80,8 @@
 #include <condition_variable>
 #endif
 #include "PalCommon.h"
+#include "NullClock.h"
+#include "DataPathStats.h"
 
 typedef enum {
     DATA_MODE_SHMEM = 0,
@@ -167,11 +170,20 @@ typedef enum {
 #define VOLUME_RAMP_PERIOD (200*1000)
 
 /*
- * The sleep is required for mute to ramp down.
+ * The wait is required for mute to ramp down, counted in rendered audio.
  */
 #define MUTE_RAMP_PERIOD (40*1000)
 #define DEFAULT_RAMP_PERIOD 0x28 //40ms
 
+/*
+ * Render position based waits, see Stream::waitForRenderPosition. Polls
+ * are spaced between the two bounds, and a position that has not moved
+ * for RENDER_STALL_PERIOD means nothing is being rendered any more.
+ */
+#define RENDER_POLL_MIN_PERIOD (2*1000)
+#define RENDER_POLL_MAX_PERIOD (10*1000)
+#define RENDER_STALL_PERIOD (50*1000)
+
 class Device;
 class ResourceManager;
 class Session;
@@ -188,6 +200,8 @@ protected:
     int mOrientation = 0;
     std::mutex mStreamMutex;
     std::mutex mGetParamMutex;
+    NullClock mNullClock; // paces read/write while data is dropped
+    DataPathStats mDataPathStats;
     static std::mutex mBaseStreamMutex; //TBD change this. as having a single static mutex for all instances of Stream is incorrect. Replace
     static std::shared_ptr<ResourceManager> rm;
     struct modifier_kv *mModifiers;
@@ -249,6 +263,8 @@ public:
     virtual int32_t addRemoveEffect(pal_audio_effect_t effect, bool enable) = 0; //TBD: make this non virtual and prrovide implementation as StreamPCM and StreamCompressed are doing the same things
     virtual int32_t setParameters(uint32_t param_id, void *payload) = 0;
     virtual int32_t write(struct pal_buffer *buf) = 0; //TBD: make this non virtual and prrovide implementation as StreamPCM and StreamCompressed are doing the same things
+    virtual int32_t readBatch(struct pal_buffer *bufs, uint32_t count);
+    virtual int32_t writeBatch(struct pal_buffer *bufs, uint32_t count);
     virtual int32_t registerCallBack(pal_stream_callback cb, uint64_t cookie) = 0;
     virtual int32_t getCallBack(pal_stream_callback *cb) = 0;
     virtual int32_t getParameters(uint32_t param_id, void **payload) = 0;
@@ -270,6 +286,8 @@ public:
     uint32_t getRenderLatency();
     uint32_t getLatency();
     int32_t getAssociatedDevices(std::vector <std::shared_ptr<Device>> &adevices);
+    bool isDeviceAssociated(const std::shared_ptr<Device> &dev);
+    bool hasAssociatedDevices() { return !mDevices.empty(); }
     int32_t getPalDevices(std::vector <std::shared_ptr<Device>> &PalDevices);
     void removePalDevice(Stream *streamHandle, int palDevId);
     void clearOutPalDevices(Stream *streamHandle);
@@ -293,12 +311,34 @@ public:
          uint32_t no_of_devices, struct modifier_kv *modifiers, uint32_t no_of_modifiers);
     bool isStreamAudioOutFmtSupported(pal_audio_fmt_t format);
     int32_t getTimestamp(struct pal_session_time *stime);
+    /* SPR session time in us, -ENOTSUP if the session does not report one */
+    int32_t getRenderPosition(uint64_t *posUs);
+    /*
+     * Waits until the position returned by getPos reaches targetUs or
+     * stops advancing, bounded by timeoutUs (-ETIMEDOUT). A getPos failure
+     * ends the wait with its status, callers without a position to start
+     * from keep their fixed sleep.
+     */
+    static int32_t waitForRenderPosition(std::function<int32_t(uint64_t *)> getPos,
+                                         uint64_t targetUs, uint64_t timeoutUs);
+    /* ramp-then-act helper: waits for durationUs more audio to be rendered */
+    int32_t waitForRender(uint64_t durationUs, uint64_t timeoutUs);
     int32_t handleBTDeviceNotReadyToDummy(bool& a2dpSuspend);
     int32_t handleBTDeviceNotReady(bool& a2dpSuspend);
     int disconnectStreamDevice(Stream* streamHandle,  pal_device_id_t dev_id);
     int disconnectStreamDevice_l(Stream* streamHandle,  pal_device_id_t dev_id);
     int connectStreamDevice(Stream* streamHandle, struct pal_device *dattr);
     int connectStreamDevice_l(Stream* streamHandle, struct pal_device *dattr);
+    /* connectStreamDevice_l split in three, see ResourceManager::streamDevSwitch */
+    int32_t resolveStreamDevice_l(struct pal_device *dattr, std::shared_ptr<Device> &dev);
+    int32_t prepareStreamDevice_l(Stream* streamHandle, struct pal_device *dattr,
+                                  std::shared_ptr<Device> dev,
+                                  std::shared_ptr<Device> &devToCommit);
+    bool isBackendConnected_l(std::shared_ptr<Device> dev);
+    int32_t commitStreamDevice_l(Stream* streamHandle, struct pal_device *dattr,
+                                 std::shared_ptr<Device> dev);
+    int32_t checkUsbConnectStatus(std::shared_ptr<Device> dev,
+                                  struct pal_device *dattr, int32_t status);
     int switchDevice(Stream* streamHandle, uint32_t no_of_devices, struct pal_device *deviceArray);
     bool isGKVMatch(pal_key_vector_t* gkv);
     int32_t getEffectParameters(void *effect_query, size_t *payload_size);
@@ -338,6 +378,7 @@ public:
         mStreamMutex.unlock();
     };
     bool isMutexLockedbyRm() { return mutexLockedbyRm; }
+    DataPathStats *getDataPathStats() { return &mDataPathStats; }
     void lockGetParamMutex() { mGetParamMutex.lock(); };
     void unlockGetParamMutex() { mGetParamMutex.unlock(); };
     /* GetPalDevice only applies to Sound Trigger streams */
@@ -42,6 +42,7 @@
 #include "ACDPlatformInfo.h"
 #include "SoundTriggerUtils.h"
 #include "ContextDetectionEngine.h"
+#include "Reactor.h"
 
 class ContextDetectionEngine;
 
@@ -437,7 +438,7 @@ class StreamACD : public Stream {
 
     int32_t GenerateCallbackEvent(struct pal_acd_recognition_event **event,
                                   uint32_t *event_size);
-    static void EventNotificationThread(StreamACD *stream);
+    void OnNotificationEvent();
 
     std::shared_ptr<ACDStreamConfig> sm_cfg_;
     std::shared_ptr<ACDPlatformInfo> acd_info_;
@@ -467,9 +468,10 @@ class StreamACD : public Stream {
 
     std::map<uint32_t, ACDState*> acd_states_;
  protected:
-    std::thread notification_thread_handler_;
+    std::shared_ptr<Reactor> reactor_;
+    /* Reactor event handle, signaled to send cached events to the client */
+    int notification_event_;
     std::mutex mutex_;
-    std::condition_variable cv_;
-    bool exit_thread_;
+    bool exit_notification_;
 };
 #endif // STREAMACD_H_
@@ -61,6 +61,8 @@ public:
    int32_t addRemoveEffect(pal_audio_effect_t effect, bool enable) override;
    int32_t read(struct pal_buffer *buf) override;
    int32_t write(struct pal_buffer *buf) override;
+   int32_t readBatch(struct pal_buffer *bufs, uint32_t count) override;
+   int32_t writeBatch(struct pal_buffer *bufs, uint32_t count) override;
    int32_t registerCallBack(pal_stream_callback cb, uint64_t cookie) override;
    int32_t getCallBack(pal_stream_callback *cb) override;
    int32_t getParameters(uint32_t param_id, void **payload) override;
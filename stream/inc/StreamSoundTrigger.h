@@ -42,6 +42,7 @@
 #include "PalRingBuffer.h"
 #include "SoundTriggerEngine.h"
 #include "VoiceUIPlatformInfo.h"
+#include "Reactor.h"
 
 enum {
     ENGINE_IDLE  = 0x0,
@@ -516,20 +517,21 @@ private:
        struct pal_st_recognition_config *new_config);
 
     int32_t notifyClient(uint32_t detection);
+    bool LockStreamInState(int32_t state_a, int32_t state_b);
+    void NotifyStreamLockWaiters();
 
-    static void TimerThread(StreamSoundTrigger& st_stream);
+    void OnDelayedStopTimer();
     void PostDelayedStop();
     void CancelDelayedStop();
     void InternalStopRecognition();
     int32_t DisconnectEvent(std::shared_ptr<StEventConfig> ev_cfg,
           bool device_switch_event = false);
     int32_t ConnectEvent(std::shared_ptr<StEventConfig> ev_cfg);
-    std::thread timer_thread_;
+    std::shared_ptr<Reactor> reactor_;
+    int stop_timer_;
     std::mutex timer_mutex_;
-    std::condition_variable timer_start_cond_;
-    std::condition_variable timer_wait_cond_;
     bool timer_stop_waiting_;
-    bool exit_timer_thread_;
+    bool exit_timer_;
     bool pending_stop_;
     bool paused_;
     bool device_opened_;
@@ -588,6 +590,9 @@ private:
     ChronoSteadyClock_t transit_end_time_;
     // set to true only when mutex is not locked after callback
     bool mutex_unlocked_after_cb_;
+    // signalled when the detection path drops mStreamMutex or state changes
+    std::mutex lock_wait_mutex_;
+    std::condition_variable lock_wait_cv_;
     // flag to indicate whether we should update common capture profile in RM
     bool common_cp_update_disable_;
     bool second_stage_processing_;
@@ -34,6 +34,8 @@
 
 #define LOG_TAG "PAL: Stream"
 #include <semaphore.h>
+#include <unistd.h>
+#include <chrono>
 #include "Stream.h"
 #include "StreamPCM.h"
 #include "StreamInCall.h"
@@ -457,6 +459,38 @@ int32_t Stream::getStreamDirection(pal_stream_direction_t *dir)
     return status;
 }
 
+/*
+ * Default batch transfers, one read/write per buffer. Returns the bytes
+ * transferred, or the error if the first buffer failed.
+ */
+int32_t Stream::readBatch(struct pal_buffer *bufs, uint32_t count)
+{
+    int32_t status = 0;
+    int32_t size = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        status = read(&bufs[i]);
+        if (status < 0)
+            return size ? size : status;
+        size += status;
+    }
+    return size;
+}
+
+int32_t Stream::writeBatch(struct pal_buffer *bufs, uint32_t count)
+{
+    int32_t status = 0;
+    int32_t size = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        status = write(&bufs[i]);
+        if (status < 0)
+            return size ? size : status;
+        size += status;
+    }
+    return size;
+}
+
 uint32_t Stream::getRenderLatency()
 {
     uint32_t delayMs = 0;
@@ -555,6 +589,12 @@ int32_t Stream::getAssociatedDevices(std::vector <std::shared_ptr<Device>> &aDev
     return status;
 }
 
+/* same as searching getAssociatedDevices(), without copying the list */
+bool Stream::isDeviceAssociated(const std::shared_ptr<Device> &dev)
+{
+    return std::find(mDevices.begin(), mDevices.end(), dev) != mDevices.end();
+}
+
 int32_t Stream::getPalDevices(std::vector <std::shared_ptr<Device>> &PalDevices)
 {
     int32_t status = 0;
@@ -876,6 +916,89 @@ exit:
     return status;
 }
 
+int32_t Stream::getRenderPosition(uint64_t *posUs)
+{
+    struct pal_session_time stime = {};
+    int32_t status = 0;
+
+    if (!posUs)
+        return -EINVAL;
+
+    status = getTimestamp(&stime);
+    if (status)
+        return status;
+
+    /* sessions without an SPR module leave the time untouched */
+    if (!stime.absolute_time.value_lsw && !stime.absolute_time.value_msw)
+        return -ENOTSUP;
+
+    *posUs = ((uint64_t)stime.session_time.value_msw << 32) |
+             stime.session_time.value_lsw;
+    return 0;
+}
+
+int32_t Stream::waitForRenderPosition(std::function<int32_t(uint64_t *)> getPos,
+                                      uint64_t targetUs, uint64_t timeoutUs)
+{
+    auto begin = std::chrono::steady_clock::now();
+    auto deadline = begin + std::chrono::microseconds(timeoutUs);
+    auto lastMove = begin;
+    uint64_t posUs = 0, lastUs = 0, sleepUs = 0;
+    uint64_t stallUs = RENDER_STALL_PERIOD;
+    int32_t status = 0;
+
+    status = getPos(&lastUs);
+    if (status)
+        return status;
+    /* a stall is not waited out for longer than the wait it replaces */
+    if (lastUs < targetUs)
+        stallUs = std::min<uint64_t>(stallUs, targetUs - lastUs);
+
+    while (lastUs < targetUs) {
+        auto now = std::chrono::steady_clock::now();
+
+        if (now >= deadline) {
+            status = -ETIMEDOUT;
+            break;
+        }
+        if (now - lastMove >= std::chrono::microseconds(stallUs))
+            break;
+
+        sleepUs = std::min<uint64_t>(std::max<uint64_t>(targetUs - lastUs,
+                RENDER_POLL_MIN_PERIOD), RENDER_POLL_MAX_PERIOD);
+        sleepUs = std::min<uint64_t>(sleepUs,
+                std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+        usleep(sleepUs);
+
+        /* the stream stopped or went away, nothing is left to drain */
+        status = getPos(&posUs);
+        if (status)
+            break;
+        if (posUs != lastUs)
+            lastMove = std::chrono::steady_clock::now();
+        lastUs = posUs;
+    }
+
+    PAL_VERBOSE(LOG_TAG, "waited %lldus, position %llu target %llu status %d",
+                (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - begin).count(),
+                (unsigned long long)lastUs, (unsigned long long)targetUs, status);
+    return status;
+}
+
+int32_t Stream::waitForRender(uint64_t durationUs, uint64_t timeoutUs)
+{
+    uint64_t startUs = 0;
+
+    if (getRenderPosition(&startUs)) {
+        usleep(std::min(durationUs, timeoutUs));
+        return 0;
+    }
+    return waitForRenderPosition([this](uint64_t *posUs) {
+                                     return getRenderPosition(posUs);
+                                 }, startUs + durationUs, timeoutUs);
+}
+
 int32_t Stream::handleBTDeviceNotReadyToDummy(bool& a2dpSuspend)
 {
     int32_t status = 0;
@@ -1392,23 +1515,120 @@ int32_t Stream::connectStreamDevice_l(Stream* streamHandle, struct pal_device *d
 {
     int32_t status = 0;
     std::shared_ptr<Device> dev = nullptr;
-    std::string newBackEndName;
-    std::string curBackEndName;
+    std::shared_ptr<Device> devToCommit = nullptr;
+
+    status = resolveStreamDevice_l(dattr, dev);
+    if (!status && dev)
+        status = prepareStreamDevice_l(streamHandle, dattr, dev, devToCommit);
+    if (!status && devToCommit)
+        status = commitStreamDevice_l(streamHandle, dattr, devToCommit);
+
+    return status;
+}
 
+int32_t Stream::checkUsbConnectStatus(std::shared_ptr<Device> dev,
+                                      struct pal_device *dattr, int32_t status)
+{
+    /* check if USB is not available restore to default device */
+    if (dev && status && (dev->getSndDeviceId() == PAL_DEVICE_OUT_USB_HEADSET ||
+                   dev->getSndDeviceId() == PAL_DEVICE_IN_USB_HEADSET)) {
+       if (USB::isUsbConnected(dattr->address)) {
+           PAL_ERR(LOG_TAG, "USB still connected, connect failed");
+       } else {
+           status = -ENOSYS;
+           PAL_ERR(LOG_TAG, "failed to connect to USB device");
+       }
+
+    }
+    return status;
+}
+
+/*
+ * First step of connectStreamDevice_l: looks up the device object for
+ * dattr and applies the attributes to it. Device switches run it for all
+ * streams on the switching thread, before the prepares fan out, so they
+ * do not race on the attributes of a device that several streams share.
+ * Leaves dev null, without an error, when no device can be created.
+ */
+int32_t Stream::resolveStreamDevice_l(struct pal_device *dattr, std::shared_ptr<Device> &dev)
+{
+    dev = nullptr;
     if (!dattr) {
         PAL_ERR(LOG_TAG, "invalid params");
-        status = -EINVAL;
-        goto exit;
+        return -EINVAL;
     }
 
     dev = Device::getInstance(dattr, rm);
     if (!dev) {
         PAL_ERR(LOG_TAG, "Device creation failed");
-        goto exit;
+        return 0;
     }
 
     dev->setDeviceAttributes(*dattr);
 
+    /* For UC2: USB insertion on playback, after disabling PA, notify PMIC
+     * assuming that current Concurrent Boost status is false and Limiter
+     * is not configured for speaker.Audio will continue to playback irrespective
+     * of success/failure after notifying PMIC about enabling concurrency.
+     * Done here, before prepareStreamDevice_l opens the device and so enables
+     * the PA, and on the switching thread, the boost state has no lock.
+     */
+    if (ResourceManager::isChargeConcurrencyEnabled &&
+        dev->getSndDeviceId() == PAL_DEVICE_OUT_SPEAKER &&
+        currentState != STREAM_IDLE && !PAL_CARD_STATUS_DOWN(rm->cardState) &&
+        !isBackendConnected_l(dev) &&
+        !rm->getConcurrentBoostState() && !rm->getInputCurrentLimitorConfigStatus())
+        rm->chargerListenerSetBoostState(true, PB_ON_CHARGER_INSERT);
+    return 0;
+}
+
+/*
+ * Avoid stream connecting to devices sharing the same backend.
+ * - For A2DP streams may play on combo devices like Speaker and A2DP.
+ *   However, if a2dp suspend is called, all streams on a2dp will temporarily
+ *   move to speaker. If the stream is already connected to speaker, speaker
+ *   will be connected twice.
+ * - For multi-recording stream connecting to bt-sco-mic and handset-mic,
+ *   if a2dp suspend arrives, stream will switch from bt-sco-mic to speaker-mic.
+ *   Hence, both speaker-mic and handset-mic will be enabled.
+ */
+bool Stream::isBackendConnected_l(std::shared_ptr<Device> dev)
+{
+    std::string newBackEndName;
+    std::string curBackEndName;
+
+    rm->getBackendName(dev->getSndDeviceId(), newBackEndName);
+    for (auto iter = mDevices.begin(); iter != mDevices.end(); iter++) {
+        rm->getBackendName((*iter)->getSndDeviceId(), curBackEndName);
+        if (newBackEndName == curBackEndName)
+            return true;
+    }
+    return false;
+}
+
+/*
+ * Second step of connectStreamDevice_l: opens dev, as resolved by
+ * resolveStreamDevice_l, and sets up this stream's session for it.
+ * Device switches run it for several streams at once. It changes only
+ * this stream and its session, apart from Device::open, which counts
+ * the users of the shared device under the device's own mutex. Device
+ * lookups in the session setup go through Device::getInstance, which
+ * serializes singleton creation. Leaves devToCommit null when there is
+ * nothing left to connect.
+ */
+int32_t Stream::prepareStreamDevice_l(Stream* streamHandle, struct pal_device *dattr,
+                                      std::shared_ptr<Device> dev,
+                                      std::shared_ptr<Device> &devToCommit)
+{
+    int32_t status = 0;
+
+    devToCommit = nullptr;
+    if (!dattr || !dev) {
+        PAL_ERR(LOG_TAG, "invalid params");
+        status = -EINVAL;
+        goto exit;
+    }
+
     if (currentState == STREAM_IDLE || PAL_CARD_STATUS_DOWN(rm->cardState)) {
         PAL_DBG(LOG_TAG, "stream is in IDLE state or SSR coming, insert %d to mDevices", dev->getSndDeviceId());
         mDevices.push_back(dev);
@@ -1416,37 +1636,14 @@ int32_t Stream::connectStreamDevice_l(Stream* streamHandle, struct pal_device *d
         goto exit;
     }
 
-    /* Avoid stream connecting to devices sharing the same backend.
-     * - For A2DP streams may play on combo devices like Speaker and A2DP.
-     *   However, if a2dp suspend is called, all streams on a2dp will temporarily
-     *   move to speaker. If the stream is already connected to speaker, speaker
-     *   will be connected twice.
-     * - For multi-recording stream connecting to bt-sco-mic and handset-mic,
-     *   if a2dp suspend arrives, stream will switch from bt-sco-mic to speaker-mic.
-     *   Hence, both speaker-mic and handset-mic will be enabled.
-     */
-    rm->getBackendName(dev->getSndDeviceId(), newBackEndName);
-    for (auto iter = mDevices.begin(); iter != mDevices.end(); iter++) {
-        rm->getBackendName((*iter)->getSndDeviceId(), curBackEndName);
-        if (newBackEndName == curBackEndName) {
-            PAL_INFO(LOG_TAG,
-                "stream is already connected to device %d name %s - return",
-                dev->getSndDeviceId(), dev->getPALDeviceName().c_str());
-            status = 0;
-            goto exit;
-        }
+    if (isBackendConnected_l(dev)) {
+        PAL_INFO(LOG_TAG,
+            "stream is already connected to device %d name %s - return",
+            dev->getSndDeviceId(), dev->getPALDeviceName().c_str());
+        status = 0;
+        goto exit;
     }
 
-    /* For UC2: USB insertion on playback, after disabling PA, notify PMIC
-     * assuming that current Concurrent Boost status is false and Limiter
-     * is not configured for speaker.Audio will continue to playback irrespective
-     * of success/failure after notifying PMIC about enabling concurrency
-     */
-    if (ResourceManager::isChargeConcurrencyEnabled && dev
-        && dev->getSndDeviceId() == PAL_DEVICE_OUT_SPEAKER &&
-        !rm->getConcurrentBoostState() && !rm->getInputCurrentLimitorConfigStatus())
-        status = rm->chargerListenerSetBoostState(true, PB_ON_CHARGER_INSERT);
-
     PAL_DBG(LOG_TAG, "device %d name %s, going to start",
         dev->getSndDeviceId(), dev->getPALDeviceName().c_str());
 
@@ -1462,8 +1659,30 @@ int32_t Stream::connectStreamDevice_l(Stream* streamHandle, struct pal_device *d
     if (0 != status) {
         PAL_ERR(LOG_TAG, "setupSessionDevice for %d failed with status %d",
                 dev->getSndDeviceId(), status);
-        goto dev_close;
+        if (status != -ENETRESET) {
+            mDevices.pop_back();
+            dev->close();
+        }
+        goto exit;
     }
+    devToCommit = dev;
+
+exit:
+    return checkUsbConnectStatus(dev, dattr, status);
+}
+
+/*
+ * Last step of connectStreamDevice_l: starts the device and connects the
+ * session to it under the graph lock, then registers the device. Device
+ * switches run it for one stream at a time, in order.
+ */
+int32_t Stream::commitStreamDevice_l(Stream* streamHandle, struct pal_device *dattr,
+                                     std::shared_ptr<Device> dev)
+{
+    int32_t status = 0;
+
+    if (!dev)
+        return 0;
 
     /* Special handling for aaudio usecase on A2DP/BLE/Speaker.
      * For mmap usecase, if device switch happens to A2DP/BLE/Speaker device
@@ -1513,7 +1732,7 @@ int32_t Stream::connectStreamDevice_l(Stream* streamHandle, struct pal_device *d
      * As enabling PA is done assuming that current Concurrent Boost state
      * is True and Audio will config Limiter for speaker.
      */
-    if (ResourceManager::isChargeConcurrencyEnabled && dev &&
+    if (ResourceManager::isChargeConcurrencyEnabled &&
         (dev->getSndDeviceId() == PAL_DEVICE_OUT_SPEAKER) && rm->getConcurrentBoostState()
         && !rm->getInputCurrentLimitorConfigStatus() && rm->getChargerOnlineState())
         status = rm->setSessionParamConfig(PAL_PARAM_ID_CHARGER_STATE, streamHandle,
@@ -1535,18 +1754,7 @@ dev_close:
     }
 
 exit:
-    /* check if USB is not available restore to default device */
-    if (dev && status && (dev->getSndDeviceId() == PAL_DEVICE_OUT_USB_HEADSET ||
-                   dev->getSndDeviceId() == PAL_DEVICE_IN_USB_HEADSET)) {
-       if (USB::isUsbConnected(dattr->address)) {
-           PAL_ERR(LOG_TAG, "USB still connected, connect failed");
-       } else {
-           status = -ENOSYS;
-           PAL_ERR(LOG_TAG, "failed to connect to USB device");
-       }
-
-    }
-    return status;
+    return checkUsbConnectStatus(dev, dattr, status);
 }
 
 /*
@@ -2074,7 +2282,7 @@ bool Stream::checkStreamMatch(pal_device_id_t pal_device_id,
 
 int Stream::initStreamSmph()
 {
-    return sem_init(&mInUse, 0, 1);
+    return sem_init(&mInUse, 0, 0);
 }
 
 int Stream::deinitStreamSmph()
@@ -55,7 +55,9 @@ StreamACD::StreamACD(struct pal_stream_attributes *sattr,
     paused_ = false;
     device_opened_ = false;
     currentState = STREAM_IDLE;
-    exit_thread_ = false;
+    exit_notification_ = false;
+    reactor_ = nullptr;
+    notification_event_ = -1;
     acd_idle_ = nullptr;
     acd_loaded_ = nullptr;
     acd_active = nullptr;
@@ -115,11 +117,19 @@ StreamACD::StreamACD(struct pal_stream_attributes *sattr,
         throw std::runtime_error("ACD not enabled, exiting");
     }
 
-    notification_thread_handler_ = std::thread(EventNotificationThread, this);
-    if (!notification_thread_handler_.joinable()) {
-        PAL_ERR(LOG_TAG, "Error:%d failed to create notification thread",
-                -EINVAL);
-        throw std::runtime_error("failed to create notification thread");
+    reactor_ = Reactor::getInstance();
+    if (!reactor_) {
+        PAL_ERR(LOG_TAG, "Error:%d failed to get reactor", -EINVAL);
+        throw std::runtime_error("failed to get reactor");
+    }
+    /* notifications take mStreamMutex and call the client back */
+    notification_event_ = reactor_->addEvent([this](uint32_t events __unused) {
+        OnNotificationEvent();
+    }, true);
+    if (notification_event_ < 0) {
+        PAL_ERR(LOG_TAG, "Error:%d failed to create notification event",
+                notification_event_);
+        throw std::runtime_error("failed to create notification event");
     }
     rm->registerStream(this);
 
@@ -164,13 +174,13 @@ exit:
 StreamACD::~StreamACD()
 {
     acd_states_.clear();
-    exit_thread_ = true;
-    if (notification_thread_handler_.joinable()) {
-        std::unique_lock<std::mutex> lck(mutex_);
-        cv_.notify_one();
-        lck.unlock();
-        notification_thread_handler_.join();
-        PAL_INFO(LOG_TAG, "Thread joined");
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        exit_notification_ = true;
+    }
+    if (notification_event_ > 0) {
+        reactor_->remove(notification_event_);
+        PAL_INFO(LOG_TAG, "Notification event removed");
     }
 
     rm->deregisterStream(this);
@@ -545,7 +555,7 @@ notify:
         mutex_.lock();
         notificationInProgress = false;
         /* If mutex_ lock is acquired by other thread handling detection event before
-         * this thread, then cv_.notify_one will not be handled. Handle it here and
+         * this thread, then the notification signal will not be handled. Handle it here and
          * notify client if there is pending notification to be sent to client.
          */
         if (deferredNotification == true && cached_event_data_ != NULL) {
@@ -978,24 +988,15 @@ exit:
     return status;
 }
 
-void StreamACD::EventNotificationThread(StreamACD *stream)
+void StreamACD::OnNotificationEvent()
 {
-    PAL_DBG(LOG_TAG, "Enter. start thread loop");
+    std::unique_lock<std::mutex> lck(mutex_);
 
-    std::unique_lock<std::mutex> lck(stream->mutex_);
-    while (!stream->exit_thread_) {
-        PAL_DBG(LOG_TAG, "waiting on cond");
-        stream->cv_.wait(lck);
-        PAL_INFO(LOG_TAG, "Received start recognition");
-
-        if (stream->exit_thread_) {
-            PAL_DBG(LOG_TAG, "Exit thread");
-            break;
-        }
+    if (exit_notification_ || !cached_event_data_)
+        return;
 
-        stream->SendCachedEventData();
-    }
-    PAL_DBG(LOG_TAG, "Exit");
+    PAL_INFO(LOG_TAG, "Received start recognition");
+    SendCachedEventData();
 }
 
 int32_t StreamACD::ACDIdle::ProcessEvent(
@@ -1208,7 +1209,7 @@ int32_t StreamACD::ACDLoaded::ProcessEvent(
                 acd_stream_.state_for_restore_ = ACD_STATE_NONE;
             } else if (acd_stream_.cached_event_data_) {
                 std::unique_lock<std::mutex> lck(acd_stream_.mutex_);
-                acd_stream_.cv_.notify_one();
+                acd_stream_.reactor_->signal(acd_stream_.notification_event_);
                 TransitTo(ACD_STATE_DETECTED);
             }
             break;
@@ -1436,7 +1437,7 @@ int32_t StreamACD::ACDActive::ProcessEvent(
                 if (acd_stream_.notificationInProgress == true)
                     acd_stream_.deferredNotification = true;
                 else
-                    acd_stream_.cv_.notify_one();
+                    acd_stream_.reactor_->signal(acd_stream_.notification_event_);
                 TransitTo(ACD_STATE_DETECTED);
             }
             break;
@@ -1719,7 +1720,7 @@ int32_t StreamACD::ACDDetected::ProcessEvent(
                 if (acd_stream_.notificationInProgress == true)
                     acd_stream_.deferredNotification = true;
                 else
-                    acd_stream_.cv_.notify_one();
+                    acd_stream_.reactor_->signal(acd_stream_.notification_event_);
             } else {
                 TransitTo(ACD_STATE_ACTIVE);
             }
@@ -1889,7 +1890,7 @@ int32_t StreamACD::ACDSSR::ProcessEvent(std::shared_ptr<ACDEventConfig> ev_cfg)
                 if ((acd_stream_.state_for_restore_ == ACD_STATE_DETECTED) &&
                     (acd_stream_.cached_event_data_ != NULL)) {
                     std::unique_lock<std::mutex> lck(acd_stream_.mutex_);
-                    acd_stream_.cv_.notify_one();
+                    acd_stream_.reactor_->signal(acd_stream_.notification_event_);
                 } else {
                     acd_stream_.state_for_restore_ = ACD_STATE_ACTIVE;
                 }
@@ -34,6 +34,7 @@
 
 #define LOG_TAG "PAL: StreamCompress"
 #include "StreamCompress.h"
+#include "PalTrace.h"
 #include "Session.h"
 #include "SessionAlsaPcm.h"
 #include "SessionAlsaCompress.h"
@@ -674,10 +675,13 @@ int32_t StreamCompress::write(struct pal_buffer *buf)
 {
     int32_t status = 0;
     int32_t size;
+    uint64_t startNs = 0;
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %p state %d", session,
             currentState);
 
+    startNs = PalTrace::nowNs();
     mStreamMutex.lock();
+    mDataPathStats.recordLockWait(startNs, PalTrace::nowNs());
     if (PAL_CARD_STATUS_DOWN(rm->cardState)) {
         status = -ENETRESET;
         PAL_ERR(LOG_TAG, "Sound Card offline/standby, can not write, status %d",
@@ -690,6 +694,7 @@ int32_t StreamCompress::write(struct pal_buffer *buf)
     if ((currentState == STREAM_OPENED) ||
         (currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED)) {
+        startNs = PalTrace::nowNs();
         status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write failed with status %d", status);
@@ -707,6 +712,7 @@ int32_t StreamCompress::write(struct pal_buffer *buf)
                 return status;
             }
         }
+        mDataPathStats.recordTransfer(size, startNs, PalTrace::nowNs());
         if ((currentState != STREAM_STARTED) &&
             !(currentState == STREAM_PAUSED && isPaused)) {
             currentState = STREAM_STARTED;
@@ -776,11 +782,11 @@ int32_t StreamCompress::setParameters(uint32_t param_id, void *payload)
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Mute failed");
                 }
-                usleep(MUTE_RAMP_PERIOD); // Wait for mute to ramp down
+                waitForRender(MUTE_RAMP_PERIOD, 2 * MUTE_RAMP_PERIOD); // Wait for mute to ramp down
                 status = session->setParameters(this, 0,
                                                 PAL_PARAM_ID_DEVICE_ROTATION,
                                                 payload);
-                usleep(MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
+                waitForRender(MUTE_RAMP_PERIOD, 2 * MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
                 setConfigStatus = session->setConfig(this, MODULE, DEVICEPP_UNMUTE);
                 if (setConfigStatus) {
                     PAL_INFO(LOG_TAG, "DevicePP Unmute failed");
@@ -966,9 +972,10 @@ int32_t StreamCompress::pause_l()
             PAL_DBG(LOG_TAG, "Waiting for Pause to complete from ADSP");
             cvPause.wait_for(pauseLock, std::chrono::microseconds(VOLUME_RAMP_PERIOD));
         } else {
-            PAL_DBG(LOG_TAG, "Pause event registration not done, sleeping for %d",
+            /* soft pause stops the render position once the ramp is done */
+            PAL_DBG(LOG_TAG, "Pause event registration not done, waiting up to %d for the ramp",
                     VOLUME_RAMP_PERIOD);
-            usleep(VOLUME_RAMP_PERIOD);
+            waitForRender(VOLUME_RAMP_PERIOD, VOLUME_RAMP_PERIOD);
         }
         PAL_VERBOSE(LOG_TAG,"session pause successful, state %d", currentState);
 
@@ -501,6 +501,7 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
         uint32_t byteWidth = mStreamAttr->in_media_config.bit_width / 8;
         uint32_t sampleRate = mStreamAttr->in_media_config.sample_rate;
         struct pal_channel_info chInfo = mStreamAttr->in_media_config.ch_info;
+        struct timespec deadline;
 
         streamSize = byteWidth * chInfo.channels;
         if ((streamSize == 0) || (sampleRate == 0)) {
@@ -510,12 +511,15 @@ int32_t  StreamInCall::read(struct pal_buffer* buf)
             goto exit;
         }
         size = buf->size;
+        deadline = mNullClock.advance((uint64_t)size * 1000000 / streamSize / sampleRate);
+        mStreamMutex.unlock();
+        /* setParam and close must not wait for the paced silence */
         memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        NullClock::sleepUntil(deadline);
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
-        status = size;
-        goto exit;
+        return size;
     }
+    mNullClock.reset();
 
     if (currentState == STREAM_STARTED) {
         status = session->read(this, SHMEM_ENDPOINT, buf, &size);
@@ -561,6 +565,7 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
     uint32_t byteWidth = 0;
     uint32_t sampleRate = 0;
     uint32_t channelCount = 0;
+    struct timespec deadline;
 
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
@@ -580,12 +585,15 @@ int32_t  StreamInCall::write(struct pal_buffer* buf)
             return -EINVAL;
         }
         size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
-        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
+        deadline = mNullClock.advance((uint64_t)size * 1000000 / frameSize / sampleRate);
         mStreamMutex.unlock();
+        /* setParam and close must not wait for the paced silence */
+        NullClock::sleepUntil(deadline);
+        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
+    mNullClock.reset();
 
     if (currentState == STREAM_STARTED) {
         status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
@@ -35,6 +35,7 @@
 #define LOG_TAG "PAL: StreamPCM"
 
 #include "StreamPCM.h"
+#include "PalTrace.h"
 #include "Session.h"
 #include "kvh2xml.h"
 #include "SessionAlsaPcm.h"
@@ -966,24 +967,43 @@ exit:
 }
 
 int32_t  StreamPCM::read(struct pal_buffer* buf)
+{
+    return readBatch(buf, 1);
+}
+
+/*
+ * Reads count buffers under a single mStreamMutex hold. A batch of one is
+ * the plain read path.
+ */
+int32_t  StreamPCM::readBatch(struct pal_buffer *bufs, uint32_t count)
 {
     int32_t status = 0;
     int32_t size;
+    uint32_t totalSize = 0;
+    uint64_t startNs = 0;
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
 
+    if (!bufs || !count)
+        return -EINVAL;
+    for (uint32_t i = 0; i < count; i++)
+        totalSize += bufs[i].size;
+
+    startNs = PalTrace::nowNs();
 #ifdef LINUX_ENABLED
     std::unique_lock<std::mutex> stream_lock(mStreamMutex);
 #else
     mStreamMutex.lock();
 #endif
+    mDataPathStats.recordLockWait(startNs, PalTrace::nowNs());
     if ((PAL_CARD_STATUS_DOWN(rm->cardState))
             || cachedState != STREAM_IDLE) {
-       /* calculate sleep time based on buf->size, sleep and return buf->size */
+       /* calculate sleep time based on the total size, sleep and return it */
         uint32_t streamSize;
         uint32_t byteWidth = mStreamAttr->in_media_config.bit_width / 8;
         uint32_t sampleRate = mStreamAttr->in_media_config.sample_rate;
         struct pal_channel_info chInfo = mStreamAttr->in_media_config.ch_info;
+        struct timespec deadline;
 
         streamSize = byteWidth * chInfo.channels;
         if ((streamSize == 0) || (sampleRate == 0)) {
@@ -992,13 +1012,22 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
             status =  -EINVAL;
             goto exit;
         }
-        size = buf->size;
-        memset(buf->buffer, 0, size);
-        usleep((uint64_t)size * 1000000 / streamSize / sampleRate);
+        size = totalSize;
+        deadline = mNullClock.advance((uint64_t)size * 1000000 / streamSize / sampleRate);
+        mDataPathStats.recordDropped(size);
+#ifdef LINUX_ENABLED
+        stream_lock.unlock();
+#else
+        mStreamMutex.unlock();
+#endif
+        /* setParam and close must not wait for the paced silence */
+        for (uint32_t i = 0; i < count; i++)
+            memset(bufs[i].buffer, 0, bufs[i].size);
+        NullClock::sleepUntil(deadline);
         PAL_DBG(LOG_TAG, "Sound card offline, dropped buffer size - %d", size);
-        status = size;
-        goto exit;
+        return size;
     }
+    mNullClock.reset();
 
     if (currentState == STREAM_STARTED) {
 #ifdef LINUX_ENABLED
@@ -1006,20 +1035,26 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
             ecref_cv.wait(stream_lock);
         }
 #endif
-        status = session->read(this, SHMEM_ENDPOINT, buf, &size);
+        startNs = PalTrace::nowNs();
+        if (count == 1)
+            status = session->read(this, SHMEM_ENDPOINT, bufs, &size);
+        else
+            status = session->readBatch(this, SHMEM_ENDPOINT, bufs, count, &size);
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session read is failed with status %d", status);
             if (errno == -ENETRESET &&
                 (PAL_CARD_STATUS_UP(rm->cardState))) {
                 PAL_ERR(LOG_TAG, "Sound card offline/standby, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
-                size = buf->size;
+                size = totalSize;
                 status = size;
+                mDataPathStats.recordDropped(size);
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (PAL_CARD_STATUS_DOWN(rm->cardState)) {
-                size = buf->size;
+                size = totalSize;
                 status = size;
+                mDataPathStats.recordDropped(size);
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else {
@@ -1031,6 +1066,7 @@ int32_t  StreamPCM::read(struct pal_buffer* buf)
         status = -EINVAL;
         goto exit;
     }
+    mDataPathStats.recordTransfer(size, startNs, PalTrace::nowNs());
     mStreamMutex.unlock();
     PAL_VERBOSE(LOG_TAG, "Exit. session read successful size - %d", size);
     return size;
@@ -1041,18 +1077,37 @@ exit :
 }
 
 int32_t StreamPCM::write(struct pal_buffer* buf)
+{
+    return writeBatch(buf, 1);
+}
+
+/*
+ * Writes count buffers under a single mStreamMutex hold. A batch of one is
+ * the plain write path.
+ */
+int32_t StreamPCM::writeBatch(struct pal_buffer *bufs, uint32_t count)
 {
     int32_t status = 0;
     int32_t size = 0;
+    uint32_t totalSize = 0;
     uint32_t frameSize = 0;
     uint32_t byteWidth = 0;
     uint32_t sampleRate = 0;
     uint32_t channelCount = 0;
+    struct timespec deadline;
+    uint64_t startNs = 0;
 
     PAL_VERBOSE(LOG_TAG, "Enter. session handle - %pK, state %d",
             session, currentState);
 
+    if (!bufs || !count)
+        return -EINVAL;
+    for (uint32_t i = 0; i < count; i++)
+        totalSize += bufs[i].size;
+
+    startNs = PalTrace::nowNs();
     mStreamMutex.lock();
+    mDataPathStats.recordLockWait(startNs, PalTrace::nowNs());
     // If cached state is not STREAM_IDLE, we are still processing SSR up.
     // or when a softpause happens during a2dpsuspend, stream does not write data.
     if (PAL_CARD_STATUS_DOWN(rm->cardState) ||
@@ -1068,18 +1123,31 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
             status = -EINVAL;
             goto exit;
         }
-        size = buf->size;
-        usleep((uint64_t)size * 1000000 / frameSize / sampleRate);
-        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
+        size = totalSize;
+        deadline = mNullClock.advance((uint64_t)size * 1000000 / frameSize / sampleRate);
+        mDataPathStats.recordDropped(size);
         mStreamMutex.unlock();
+        /* setParam and close must not wait for the paced silence */
+        NullClock::sleepUntil(deadline);
+        PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
         PAL_VERBOSE(LOG_TAG, "Exit size: %d", size);
         return size;
     }
+    mNullClock.reset();
 
     // we should allow writes to go through in Start/Pause state as well.
     if ((currentState == STREAM_STARTED) ||
         (currentState == STREAM_PAUSED) ) {
-        status = session->write(this, SHMEM_ENDPOINT, buf, &size, 0);
+        startNs = PalTrace::nowNs();
+        if (count == 1)
+            status = session->write(this, SHMEM_ENDPOINT, bufs, &size, 0);
+        else
+            status = session->writeBatch(this, SHMEM_ENDPOINT, bufs, count, &size);
+        /* the stats are members too, record them before close can go ahead */
+        if (!status)
+            mDataPathStats.recordTransfer(size, startNs, PalTrace::nowNs());
+        else if (errno == -ENETRESET || PAL_CARD_STATUS_DOWN(rm->cardState))
+            mDataPathStats.recordDropped(totalSize);
         mStreamMutex.unlock();
         if (0 != status) {
             PAL_ERR(LOG_TAG, "session write is failed with status %d", status);
@@ -1089,12 +1157,12 @@ int32_t StreamPCM::write(struct pal_buffer* buf)
                 (PAL_CARD_STATUS_UP(rm->cardState))) {
                 PAL_ERR(LOG_TAG, "Sound card offline/standby, informing RM");
                 rm->ssrHandler(CARD_STATUS_OFFLINE);
-                size = buf->size;
+                size = totalSize;
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
             } else if (PAL_CARD_STATUS_DOWN(rm->cardState)) {
-                size = buf->size;
+                size = totalSize;
                 status = size;
                 PAL_DBG(LOG_TAG, "dropped buffer size - %d", size);
                 goto exit;
@@ -1200,13 +1268,13 @@ int32_t  StreamPCM::setParameters(uint32_t param_id, void *payload)
                     PAL_INFO(LOG_TAG, "DevicePP Mute failed");
                 }
                 mStreamMutex.unlock();
-                usleep(MUTE_RAMP_PERIOD); // Wait for Mute ramp down to happen
+                waitForRender(MUTE_RAMP_PERIOD, 2 * MUTE_RAMP_PERIOD); // Wait for Mute ramp down to happen
                 mStreamMutex.lock();
                 status = session->setParameters(this, 0,
                                                 PAL_PARAM_ID_DEVICE_ROTATION,
                                                 payload);
                 mStreamMutex.unlock();
-                usleep(MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
+                waitForRender(MUTE_RAMP_PERIOD, 2 * MUTE_RAMP_PERIOD); // Wait for channel swap to take affect
                 mStreamMutex.lock();
                 if (mStreamAttr->type == PAL_STREAM_LOW_LATENCY ||
                     mStreamAttr->type == PAL_STREAM_ULTRA_LOW_LATENCY) {
@@ -1333,9 +1401,10 @@ int32_t StreamPCM::pause_l()
             PAL_DBG(LOG_TAG, "Waiting for Pause to complete from ADSP");
             pauseCV.wait_for(pauseLock, std::chrono::microseconds(VOLUME_RAMP_PERIOD));
         } else {
-            PAL_DBG(LOG_TAG, "Pause event registration not done, sleeping for %d",
+            /* soft pause stops the render position once the ramp is done */
+            PAL_DBG(LOG_TAG, "Pause event registration not done, waiting up to %d for the ramp",
                     VOLUME_RAMP_PERIOD);
-            usleep(VOLUME_RAMP_PERIOD);
+            waitForRender(VOLUME_RAMP_PERIOD, VOLUME_RAMP_PERIOD);
         }
         palStateEnqueue(this, PAL_STATE_PAUSED, status);
         PAL_DBG(LOG_TAG, "session setConfig successful");
@@ -86,6 +86,7 @@
 #define ST_LAB_DEFERRED_STOP_DELAY_MS (10000)
 #define ST_MODEL_TYPE_SHIFT           (16)
 #define ST_MAX_FSTAGE_CONF_LEVEL      (100)
+#define ST_LOCK_WAIT_RETRY_MS         (10)
 
 ST_DBG_DECLARE(static int lab_cnt = 0);
 
@@ -226,26 +227,40 @@ StreamSoundTrigger::StreamSoundTrigger(struct pal_stream_attributes *sattr,
         paused_ = true;
     }
 
-    timer_thread_ = std::thread(TimerThread, std::ref(*this));
     timer_stop_waiting_ = false;
-    exit_timer_thread_ = false;
+    exit_timer_ = false;
+    reactor_ = Reactor::getInstance();
+    if (!reactor_) {
+        PAL_ERR(LOG_TAG, "Failed to get reactor");
+        throw std::runtime_error("Failed to get reactor");
+    }
+    /* the delayed stop takes mStreamMutex and stops the graph */
+    stop_timer_ = reactor_->addTimer([this](uint32_t events __unused) {
+        OnDelayedStopTimer();
+    }, true);
+    if (stop_timer_ < 0) {
+        PAL_ERR(LOG_TAG, "Failed to create delayed stop timer, status %d",
+            stop_timer_);
+        throw std::runtime_error("Failed to create delayed stop timer");
+    }
 
     PAL_DBG(LOG_TAG, "Exit");
 }
 
 StreamSoundTrigger::~StreamSoundTrigger() {
-    mStreamMutex.lock();
     {
         std::lock_guard<std::mutex> lck(timer_mutex_);
-        exit_timer_thread_ = true;
+        exit_timer_ = true;
         timer_stop_waiting_ = true;
-        timer_wait_cond_.notify_one();
-        timer_start_cond_.notify_one();
-    }
-    if (timer_thread_.joinable()) {
-        PAL_DBG(LOG_TAG, "Join timer thread");
-        timer_thread_.join();
     }
+    /*
+     * Waits for a delayed stop that is already running, which takes
+     * mStreamMutex, so this has to happen before locking it.
+     */
+    PAL_DBG(LOG_TAG, "Remove delayed stop timer");
+    reactor_->remove(stop_timer_);
+
+    mStreamMutex.lock();
 
     // clean up properly in case stream is deconstructed without close
     if (cur_state_ != st_idle_)
@@ -856,19 +871,18 @@ int32_t StreamSoundTrigger::SetEngineDetectionState(int32_t det_type) {
     /*
      * setEngineDetectionState should only be called when stream
      * is in ACTIVE state(for first stage) or in BUFFERING state
-     * (for second stage)
+     * (for second stage).
      */
-    do {
-        lock_status = mStreamMutex.try_lock();
-    } while (!lock_status && (GetCurrentStateId() == ST_STATE_ACTIVE ||
-        GetCurrentStateId() == ST_STATE_BUFFERING));
+    lock_status = LockStreamInState(ST_STATE_ACTIVE, ST_STATE_BUFFERING);
 
     if ((det_type == GMM_DETECTED &&
          GetCurrentStateId() != ST_STATE_ACTIVE) ||
         ((det_type & DETECTION_TYPE_SS) &&
          GetCurrentStateId() != ST_STATE_BUFFERING)) {
-        if (lock_status)
+        if (lock_status) {
             mStreamMutex.unlock();
+            NotifyStreamLockWaiters();
+        }
         PAL_DBG(LOG_TAG, "Exit as stream not in proper state");
         return -EINVAL;
     }
@@ -887,10 +901,12 @@ int32_t StreamSoundTrigger::SetEngineDetectionState(int32_t det_type) {
      * true, so check mutex_unlocked_after_cb_ here to avoid
      * double unlock.
      */
-    if (!mutex_unlocked_after_cb_)
+    if (!mutex_unlocked_after_cb_) {
         mStreamMutex.unlock();
-    else
+        NotifyStreamLockWaiters();
+    } else {
         mutex_unlocked_after_cb_ = false;
+    }
 
     if (det_type == USER_VERIFICATION_REJECT ||
         det_type == KEYWORD_DETECTION_REJECT)
@@ -900,6 +916,30 @@ int32_t StreamSoundTrigger::SetEngineDetectionState(int32_t det_type) {
     return status;
 }
 
+/*
+ * Lock mStreamMutex unless the stream leaves both states first, as the lock
+ * holder may then wait for the calling engine thread. Waiters sleep on
+ * lock_wait_cv_, which the detection path signals when it drops the lock
+ * and TransitTo signals on state change. Other holders do not signal, the
+ * lock is retried every ST_LOCK_WAIT_RETRY_MS for them.
+ */
+bool StreamSoundTrigger::LockStreamInState(int32_t state_a, int32_t state_b) {
+    std::unique_lock<std::mutex> lck(lock_wait_mutex_);
+
+    while (!mStreamMutex.try_lock()) {
+        if (GetCurrentStateId() != state_a && GetCurrentStateId() != state_b)
+            return false;
+        lock_wait_cv_.wait_for(lck,
+            std::chrono::milliseconds(ST_LOCK_WAIT_RETRY_MS));
+    }
+    return true;
+}
+
+void StreamSoundTrigger::NotifyStreamLockWaiters() {
+    std::lock_guard<std::mutex> lck(lock_wait_mutex_);
+    lock_wait_cv_.notify_all();
+}
+
 void StreamSoundTrigger::InternalStopRecognition() {
     int32_t status = 0;
 
@@ -913,39 +953,28 @@ void StreamSoundTrigger::InternalStopRecognition() {
     PAL_DBG(LOG_TAG, "Exit, status %d", status);
 }
 
-void StreamSoundTrigger::TimerThread(StreamSoundTrigger& st_stream) {
-    PAL_DBG(LOG_TAG, "Enter");
-
-    std::unique_lock<std::mutex> lck(st_stream.timer_mutex_);
-    while (!st_stream.exit_timer_thread_) {
-        st_stream.timer_start_cond_.wait(lck);
-        if (st_stream.exit_timer_thread_)
-            break;
+void StreamSoundTrigger::OnDelayedStopTimer() {
+    std::unique_lock<std::mutex> lck(timer_mutex_);
 
-        if (st_stream.GetCurrentStateId() == ST_STATE_BUFFERING &&
-            !st_stream.second_stage_processing_) {
-            st_stream.timer_wait_cond_.wait_for(lck,
-                std::chrono::milliseconds(ST_LAB_DEFERRED_STOP_DELAY_MS));
-        } else {
-            st_stream.timer_wait_cond_.wait_for(lck,
-                std::chrono::milliseconds(ST_DEFERRED_STOP_DELAY_MS));
-        }
+    // cancelled after the timer expired but before we got to run
+    if (timer_stop_waiting_ || exit_timer_)
+        return;
+    lck.unlock();
 
-        if (!st_stream.timer_stop_waiting_ && !st_stream.exit_timer_thread_) {
-            st_stream.timer_mutex_.unlock();
-            st_stream.InternalStopRecognition();
-            st_stream.timer_mutex_.lock();
-        }
-    }
-    PAL_DBG(LOG_TAG, "Exit");
+    InternalStopRecognition();
 }
 
 void StreamSoundTrigger::PostDelayedStop() {
+    uint32_t delay_ms = ST_DEFERRED_STOP_DELAY_MS;
+
     PAL_VERBOSE(LOG_TAG, "Post Delayed Stop for %p", this);
     pending_stop_ = true;
+    if (GetCurrentStateId() == ST_STATE_BUFFERING && !second_stage_processing_)
+        delay_ms = ST_LAB_DEFERRED_STOP_DELAY_MS;
+
     std::lock_guard<std::mutex> lck(timer_mutex_);
     timer_stop_waiting_ = false;
-    timer_start_cond_.notify_one();
+    reactor_->armTimer(stop_timer_, delay_ms);
 }
 
 void StreamSoundTrigger::CancelDelayedStop() {
@@ -953,7 +982,7 @@ void StreamSoundTrigger::CancelDelayedStop() {
     pending_stop_ = false;
     std::lock_guard<std::mutex> lck(timer_mutex_);
     timer_stop_waiting_ = true;
-    timer_wait_cond_.notify_one();
+    reactor_->disarmTimer(stop_timer_);
 }
 
 std::shared_ptr<SoundTriggerEngine> StreamSoundTrigger::HandleEngineLoad(
@@ -1632,6 +1661,7 @@ int32_t StreamSoundTrigger::notifyClient(uint32_t detection) {
             " total processing time: %llums",
             (long long)total_process_duration);
         mStreamMutex.unlock();
+        NotifyStreamLockWaiters();
         callback_((pal_stream_handle_t *)this, 0, (uint32_t *)rec_event,
                   event_size, cookie_);
 
@@ -1642,10 +1672,7 @@ int32_t StreamSoundTrigger::notifyClient(uint32_t detection) {
          * stream states when try lock fails so that we can skip lock
          * when stream is already stopped by client.
          */
-        do {
-            lock_status = mStreamMutex.try_lock();
-        } while (!lock_status && (GetCurrentStateId() == ST_STATE_DETECTED ||
-            GetCurrentStateId() == ST_STATE_BUFFERING));
+        lock_status = LockStreamInState(ST_STATE_DETECTED, ST_STATE_BUFFERING);
 
         /*
          * NOTE: Not unlock stream mutex here if mutex is locked successfully
@@ -1781,6 +1808,7 @@ void StreamSoundTrigger::TransitTo(int32_t state_id) {
     auto newState = stStateNameMap.at(it->first);
     PAL_DBG(LOG_TAG, "Stream instance %u: state transitioned from %s to %s",
             mInstanceID, oldState.c_str(), newState.c_str());
+    NotifyStreamLockWaiters();
 }
 
 int32_t StreamSoundTrigger::ProcessInternalEvent(
@@ -0,0 +1,999 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include "PalBenchmark.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#ifdef PAL_SIM_CARD
+#include "pal_sim.h"
+#endif
+
+struct bench_stream {
+    const char *name;
+    pal_stream_type_t type;
+    pal_stream_direction_t direction;
+    uint32_t flags;
+    uint16_t channels;
+    uint32_t sample_rate;
+    pal_device_id_t device;
+};
+
+static const struct bench_stream bench_deep_buffer = {
+    "deep_buffer", PAL_STREAM_DEEP_BUFFER, PAL_AUDIO_OUTPUT, 0, 2,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_OUT_SPEAKER };
+static const struct bench_stream bench_low_latency = {
+    "low_latency", PAL_STREAM_LOW_LATENCY, PAL_AUDIO_OUTPUT, 0, 2,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_OUT_SPEAKER };
+/* compress playback is only supported non blocking */
+static const struct bench_stream bench_compress = {
+    "compress", PAL_STREAM_COMPRESSED, PAL_AUDIO_OUTPUT, PAL_STREAM_FLAG_NON_BLOCKING, 2,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_OUT_SPEAKER };
+static const struct bench_stream bench_voip_rx = {
+    "voip_rx", PAL_STREAM_VOIP_RX, PAL_AUDIO_OUTPUT, 0, 1,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_OUT_HANDSET };
+static const struct bench_stream bench_voip_tx = {
+    "voip_tx", PAL_STREAM_VOIP_TX, PAL_AUDIO_INPUT, 0, 1,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_IN_HANDSET_MIC };
+static const struct bench_stream bench_deep_buffer_in = {
+    "deep_buffer_in", PAL_STREAM_DEEP_BUFFER, PAL_AUDIO_INPUT, 0, 2,
+    BENCH_SAMPLE_RATE, PAL_DEVICE_IN_HANDSET_MIC };
+static const struct bench_stream bench_voice_ui = {
+    "voice_ui", PAL_STREAM_VOICE_UI, PAL_AUDIO_INPUT, 0, 1,
+    BENCH_VA_SAMPLE_RATE, PAL_DEVICE_IN_HANDSET_VA_MIC };
+
+static const pal_device_id_t bench_switch_targets[] = {
+    PAL_DEVICE_OUT_SPEAKER,
+    PAL_DEVICE_OUT_WIRED_HEADSET,
+    PAL_DEVICE_OUT_BLUETOOTH_A2DP,
+};
+#define BENCH_NUM_SWITCH_TARGETS \
+    (sizeof(bench_switch_targets) / sizeof(bench_switch_targets[0]))
+
+/* share a backend, a mono handset config differs from the stereo speaker one */
+static const pal_device_id_t bench_shared_be_targets[] = {
+    PAL_DEVICE_OUT_HANDSET,
+    PAL_DEVICE_OUT_SPEAKER,
+};
+#define BENCH_NUM_SHARED_BE_TARGETS \
+    (sizeof(bench_shared_be_targets) / sizeof(bench_shared_be_targets[0]))
+
+/* vendor uuid the SVA engine of the VoiceUI platform XML is registered with */
+static const struct st_uuid bench_sva_uuid = {
+    0x68ab2d40, 0xe860, 0x11e3, 0x95ef, { 0x00, 0x02, 0xa5, 0xd5, 0xc5, 0x1b } };
+
+static const char *bench_op_names[BENCH_OP_MAX] = {
+    "open",
+    "start",
+    "stop",
+    "close",
+    "set_device",
+    "detection",
+};
+
+#ifdef PAL_SIM_CARD
+static const char *bench_sim_calls[] = {
+    "pcm_open", "pcm_prepare", "pcm_start", "pcm_stop", "pcm_close",
+    "mixer_get_ctl", "mixer_ctl_set", "mixer_ctl_get",
+    "compress_open", "compress_start", "compress_stop", "compress_close",
+    "agm_session_open", "agm_session_set", "agm_session_close",
+    "audio_route_apply", "audio_route_reset",
+};
+
+/* calls pal_stream_write/read spend their time in on the card side */
+static const char *bench_sim_transfer_calls[] = {
+    "pcm_write", "pcm_read", "compress_write", "compress_read",
+};
+#endif
+
+const char *bench_scenarios[] = {
+    "playback_mix",
+    "voip",
+    "sound_trigger",
+    "device_switch",
+    "device_switch_mix",
+    "data_path",
+    "stream_churn",
+    NULL,
+};
+
+/*
+ * Allocations made by the calling thread. malloc is interposed where the
+ * C library allows it, so the count covers libpal and libstdc++ too.
+ * Elsewhere, e.g. against libpalclient on Android, it stays 0 and the
+ * report says allocations were not counted.
+ */
+static __thread uint64_t bench_thread_allocs;
+
+#ifdef __GLIBC__
+#define BENCH_COUNTS_ALLOCS 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size)
+{
+    bench_thread_allocs++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    bench_thread_allocs++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    bench_thread_allocs++;
+    return __libc_realloc(ptr, size);
+}
+#else
+#define BENCH_COUNTS_ALLOCS 0
+#endif
+
+struct bench_samples {
+    uint64_t *us;
+    size_t count;
+    size_t capacity;
+    uint32_t errors;
+};
+
+struct bench_result {
+    pthread_mutex_t lock;
+    struct bench_samples ops[BENCH_OP_MAX];
+    uint32_t streams;
+    uint64_t buffers;
+    uint64_t transfer_ns;  /* spent inside pal_stream_write/read */
+    uint64_t allocs;
+    uint32_t transfer_errors;
+    double audio_s;
+    uint64_t xruns;
+    uint64_t dropped_buffers;
+    /* data path wait for the stream mutex, merged over all streams */
+    uint64_t lock_waits;
+    double lock_wait_total_us;
+    uint64_t lock_wait_p99_us;
+    uint64_t lock_wait_max_us;
+};
+
+struct bench_worker {
+    const struct bench_stream *spec;
+    const struct bench_options *opts;
+    struct bench_result *result;
+    pal_stream_handle_t *handle;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool write_ready;
+    uint64_t detected_us;
+    int stop;
+};
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static uint64_t bench_now_us(void)
+{
+    return bench_now_ns() / 1000;
+}
+
+static uint64_t bench_cpu_us(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void bench_record(struct bench_result *result, bench_op_t op, uint64_t elapsed,
+                         int32_t status)
+{
+    struct bench_samples *samples = &result->ops[op];
+    uint64_t *us;
+
+    pthread_mutex_lock(&result->lock);
+    if (status) {
+        samples->errors++;
+        goto exit;
+    }
+    if (samples->count == samples->capacity) {
+        us = (uint64_t *)realloc(samples->us,
+                                 (samples->capacity * 2 + 64) * sizeof(uint64_t));
+        if (!us)
+            goto exit;
+        samples->us = us;
+        samples->capacity = samples->capacity * 2 + 64;
+    }
+    samples->us[samples->count++] = elapsed;
+exit:
+    pthread_mutex_unlock(&result->lock);
+}
+
+static int32_t bench_stream_callback(pal_stream_handle_t *stream_handle,
+                                     uint32_t event_id, uint32_t *event_data,
+                                     uint32_t event_size, uint64_t cookie)
+{
+    struct bench_worker *worker = (struct bench_worker *)cookie;
+
+    pthread_mutex_lock(&worker->lock);
+    if (worker->spec->type == PAL_STREAM_VOICE_UI) {
+        if (!worker->detected_us)
+            worker->detected_us = bench_now_us();
+    } else if (event_id == PAL_STREAM_CBK_EVENT_WRITE_READY) {
+        worker->write_ready = true;
+    }
+    pthread_cond_signal(&worker->cond);
+    pthread_mutex_unlock(&worker->lock);
+    return 0;
+}
+
+/* waits until ready() holds, returns false if it still does not after timeout_ms */
+static bool bench_wait(struct bench_worker *worker, bool (*ready)(struct bench_worker *),
+                       uint32_t timeout_ms)
+{
+    struct timespec deadline;
+    bool done;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&worker->lock);
+    while (!ready(worker))
+        if (pthread_cond_timedwait(&worker->cond, &worker->lock, &deadline) == ETIMEDOUT)
+            break;
+    done = ready(worker);
+    pthread_mutex_unlock(&worker->lock);
+    return done;
+}
+
+static bool bench_write_ready(struct bench_worker *worker)
+{
+    return worker->write_ready;
+}
+
+static bool bench_detected(struct bench_worker *worker)
+{
+    return worker->detected_us != 0;
+}
+
+static bool bench_stopping(struct bench_worker *worker)
+{
+    return __atomic_load_n(&worker->stop, __ATOMIC_ACQUIRE);
+}
+
+static uint32_t bench_frame_size(const struct bench_stream *spec)
+{
+    return spec->channels * BENCH_BIT_WIDTH / 8;
+}
+
+static void bench_worker_init(struct bench_worker *worker, const struct bench_stream *spec,
+                              const struct bench_options *opts, struct bench_result *result)
+{
+    memset(worker, 0, sizeof(*worker));
+    worker->spec = spec;
+    worker->opts = opts;
+    worker->result = result;
+    pthread_mutex_init(&worker->lock, NULL);
+    pthread_cond_init(&worker->cond, NULL);
+}
+
+static void bench_worker_deinit(struct bench_worker *worker)
+{
+    pthread_mutex_destroy(&worker->lock);
+    pthread_cond_destroy(&worker->cond);
+}
+
+static void bench_fill_device(pal_device_id_t id, const struct bench_stream *spec,
+                              struct pal_device *device)
+{
+    memset(device, 0, sizeof(*device));
+    device->id = id;
+    device->config.sample_rate = spec->sample_rate;
+    device->config.bit_width = BENCH_BIT_WIDTH;
+    device->config.aud_fmt_id = PAL_AUDIO_FMT_PCM_S16_LE;
+    device->config.ch_info.channels = spec->channels;
+    device->config.ch_info.ch_map[0] = PAL_CHMAP_CHANNEL_FL;
+    device->config.ch_info.ch_map[1] = PAL_CHMAP_CHANNEL_FR;
+}
+
+static int32_t bench_open(struct bench_worker *worker)
+{
+    const struct bench_stream *spec = worker->spec;
+    struct pal_stream_attributes attributes;
+    struct pal_device device;
+    struct pal_media_config *config;
+    uint64_t start;
+    int32_t status;
+
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = spec->type;
+    attributes.flags = (pal_stream_flags_t)spec->flags;
+    attributes.direction = spec->direction;
+    bench_fill_device(spec->device, spec, &device);
+    config = spec->direction == PAL_AUDIO_OUTPUT ? &attributes.out_media_config :
+                                                   &attributes.in_media_config;
+    *config = device.config;
+
+    worker->write_ready = false;
+    worker->detected_us = 0;
+    start = bench_now_us();
+    status = pal_stream_open(&attributes, 1, &device, 0, NULL,
+                             (pal_stream_callback)&bench_stream_callback,
+                             (uint64_t)worker, &worker->handle);
+    bench_record(worker->result, BENCH_OP_OPEN, bench_now_us() - start, status);
+    if (status) {
+        fprintf(stderr, "%s: pal_stream_open failed %d\n", spec->name, status);
+        worker->handle = NULL;
+    }
+    return status;
+}
+
+static int32_t bench_start(struct bench_worker *worker)
+{
+    uint64_t start = bench_now_us();
+    int32_t status = pal_stream_start(worker->handle);
+
+    bench_record(worker->result, BENCH_OP_START, bench_now_us() - start, status);
+    if (status)
+        fprintf(stderr, "%s: pal_stream_start failed %d\n", worker->spec->name, status);
+    return status;
+}
+
+/* reads the data path counters of a started stream into the result */
+static void bench_collect_data_path_stats(struct bench_worker *worker)
+{
+    struct bench_result *result = worker->result;
+    pal_param_payload *payload = NULL;
+    pal_stream_data_path_stats_t *stats;
+
+    if (pal_stream_get_param(worker->handle, PAL_PARAM_ID_STREAM_DATA_PATH_STATS, &payload) ||
+        !payload)
+        return;
+
+    stats = (pal_stream_data_path_stats_t *)payload->payload;
+    pthread_mutex_lock(&result->lock);
+    result->xruns += stats->xruns;
+    result->dropped_buffers += stats->dropped_buffers;
+    result->lock_waits += stats->lock_wait.count;
+    result->lock_wait_total_us += (double)stats->lock_wait.mean_us * stats->lock_wait.count;
+    if (stats->lock_wait.p99_us > result->lock_wait_p99_us)
+        result->lock_wait_p99_us = stats->lock_wait.p99_us;
+    if (stats->lock_wait.max_us > result->lock_wait_max_us)
+        result->lock_wait_max_us = stats->lock_wait.max_us;
+    pthread_mutex_unlock(&result->lock);
+    free(payload);
+}
+
+static void bench_stop_and_close(struct bench_worker *worker, bool started)
+{
+    uint64_t start;
+    int32_t status;
+
+    if (started) {
+        bench_collect_data_path_stats(worker);
+        start = bench_now_us();
+        status = pal_stream_stop(worker->handle);
+        bench_record(worker->result, BENCH_OP_STOP, bench_now_us() - start, status);
+    }
+    start = bench_now_us();
+    status = pal_stream_close(worker->handle);
+    bench_record(worker->result, BENCH_OP_CLOSE, bench_now_us() - start, status);
+    worker->handle = NULL;
+}
+
+/*
+ * Moves duration_ms of audio through the stream, or audio until the
+ * worker is stopped if duration_ms is 0. Allocations are counted inside
+ * pal_stream_write/read only, on the calling thread.
+ */
+static void bench_transfer(struct bench_worker *worker, uint32_t duration_ms)
+{
+    const struct bench_stream *spec = worker->spec;
+    struct bench_result *result = worker->result;
+    uint64_t target = (uint64_t)spec->sample_rate * duration_ms / 1000 * bench_frame_size(spec);
+    uint64_t done = 0, buffers = 0, allocs = 0, transfer_ns = 0, before, start;
+    uint32_t errors = 0;
+    size_t in_size = 0, out_size = 0, size;
+    struct pal_buffer buf;
+    uint8_t *data;
+    ssize_t ret;
+
+    pal_stream_get_buffer_size(worker->handle, &in_size, &out_size);
+    size = spec->direction == PAL_AUDIO_OUTPUT ? out_size : in_size;
+    if (!size)
+        size = spec->sample_rate * BENCH_DEFAULT_BUFFER_MS / 1000 * bench_frame_size(spec);
+    data = (uint8_t *)calloc(1, size);
+    if (!data)
+        return;
+
+    while (!bench_stopping(worker) && (!duration_ms || done < target)) {
+        memset(&buf, 0, sizeof(buf));
+        buf.buffer = data;
+        buf.size = size;
+        pthread_mutex_lock(&worker->lock);
+        worker->write_ready = false;
+        pthread_mutex_unlock(&worker->lock);
+        before = bench_thread_allocs;
+        start = bench_now_ns();
+        if (spec->direction == PAL_AUDIO_OUTPUT)
+            ret = pal_stream_write(worker->handle, &buf);
+        else
+            ret = pal_stream_read(worker->handle, &buf);
+        transfer_ns += bench_now_ns() - start;
+        allocs += bench_thread_allocs - before;
+        if (ret < 0) {
+            fprintf(stderr, "%s: transfer failed %zd\n", spec->name, ret);
+            errors++;
+            break;
+        }
+        done += ret;
+        buffers++;
+        /* a non blocking write that was not taken whole calls back once there is room */
+        if ((spec->flags & PAL_STREAM_FLAG_NON_BLOCKING) && (size_t)ret < size &&
+            !bench_wait(worker, bench_write_ready, 1000)) {
+            fprintf(stderr, "%s: no write ready event\n", spec->name);
+            errors++;
+            break;
+        }
+    }
+    free(data);
+
+    pthread_mutex_lock(&result->lock);
+    result->buffers += buffers;
+    result->transfer_ns += transfer_ns;
+    result->allocs += allocs;
+    result->transfer_errors += errors;
+    result->audio_s += (double)done / ((double)spec->sample_rate * bench_frame_size(spec));
+    pthread_mutex_unlock(&result->lock);
+}
+
+static void *bench_stream_cycles(void *arg)
+{
+    struct bench_worker *worker = (struct bench_worker *)arg;
+    uint32_t i;
+    bool started;
+
+    for (i = 0; i < worker->opts->iterations; i++) {
+        if (bench_open(worker))
+            continue;
+        started = !bench_start(worker);
+        if (started)
+            bench_transfer(worker, worker->opts->duration_ms);
+        bench_stop_and_close(worker, started);
+    }
+    return NULL;
+}
+
+/* runs each worker's open/start/transfer/stop/close cycles on its own thread */
+static void bench_run_workers(struct bench_worker *workers, uint32_t count)
+{
+    uint32_t i;
+
+    for (i = 0; i < count; i++)
+        pthread_create(&workers[i].thread, NULL, bench_stream_cycles, &workers[i]);
+    for (i = 0; i < count; i++)
+        pthread_join(workers[i].thread, NULL);
+}
+
+static int32_t bench_playback_mix(const struct bench_options *opts, struct bench_result *result)
+{
+    const struct bench_stream *specs[] = { &bench_deep_buffer, &bench_low_latency,
+                                           &bench_compress };
+    uint32_t num_specs = sizeof(specs) / sizeof(specs[0]);
+    uint32_t count = num_specs * opts->instances;
+    struct bench_worker *workers;
+    uint32_t i;
+
+    workers = (struct bench_worker *)calloc(count, sizeof(*workers));
+    if (!workers)
+        return -ENOMEM;
+    for (i = 0; i < count; i++)
+        bench_worker_init(&workers[i], specs[i % num_specs], opts, result);
+    result->streams = count;
+    bench_run_workers(workers, count);
+    for (i = 0; i < count; i++)
+        bench_worker_deinit(&workers[i]);
+    free(workers);
+    return 0;
+}
+
+static int32_t bench_voip(const struct bench_options *opts, struct bench_result *result)
+{
+    struct bench_worker workers[2];
+
+    bench_worker_init(&workers[0], &bench_voip_rx, opts, result);
+    bench_worker_init(&workers[1], &bench_voip_tx, opts, result);
+    result->streams = 2;
+    bench_run_workers(workers, 2);
+    bench_worker_deinit(&workers[0]);
+    bench_worker_deinit(&workers[1]);
+    return 0;
+}
+
+static int32_t bench_set_sound_model(struct bench_worker *worker, const char *path)
+{
+    struct pal_st_phrase_sound_model *model;
+    struct pal_st_recognition_config *config;
+    pal_param_payload *payload = NULL;
+    size_t size, model_size;
+    FILE *file;
+    long length;
+    int32_t status = -EINVAL;
+
+    file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "cannot open sound model %s\n", path);
+        return -ENOENT;
+    }
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length <= 0)
+        goto exit;
+
+    model_size = sizeof(*model) + length;
+    payload = (pal_param_payload *)calloc(1, sizeof(*payload) + model_size);
+    if (!payload) {
+        status = -ENOMEM;
+        goto exit;
+    }
+    model = (struct pal_st_phrase_sound_model *)payload->payload;
+    model->common.type = PAL_SOUND_MODEL_TYPE_KEYPHRASE;
+    model->common.vendor_uuid = bench_sva_uuid;
+    model->common.data_size = (uint32_t)length;
+    model->common.data_offset = sizeof(*model);
+    model->num_phrases = 1;
+    model->phrases[0].id = 1;
+    model->phrases[0].recognition_mode = PAL_RECOGNITION_MODE_VOICE_TRIGGER;
+    strcpy(model->phrases[0].locale, "en_US");
+    if (fread((uint8_t *)model + sizeof(*model), 1, length, file) != (size_t)length)
+        goto exit;
+    payload->payload_size = model_size;
+    status = pal_stream_set_param(worker->handle, PAL_PARAM_ID_LOAD_SOUND_MODEL, payload);
+    if (status) {
+        fprintf(stderr, "loading sound model failed %d\n", status);
+        goto exit;
+    }
+    free(payload);
+
+    size = sizeof(*payload) + sizeof(*config);
+    payload = (pal_param_payload *)calloc(1, size);
+    if (!payload) {
+        status = -ENOMEM;
+        goto exit;
+    }
+    config = (struct pal_st_recognition_config *)payload->payload;
+    config->num_phrases = 1;
+    config->phrases[0].id = 1;
+    config->phrases[0].recognition_modes = PAL_RECOGNITION_MODE_VOICE_TRIGGER;
+    config->phrases[0].confidence_level = 60;
+    config->data_offset = sizeof(*config);
+    payload->payload_size = sizeof(*config);
+    status = pal_stream_set_param(worker->handle, PAL_PARAM_ID_RECOGNITION_CONFIG, payload);
+    if (status)
+        fprintf(stderr, "recognition config failed %d\n", status);
+exit:
+    free(payload);
+    fclose(file);
+    return status;
+}
+
+/*
+ * Open, load, start and wait for a detection. A timed out wait counts as
+ * a detection error, there is no keyword spoken into a simulated card.
+ */
+static int32_t bench_sound_trigger(const struct bench_options *opts, struct bench_result *result)
+{
+    struct bench_worker worker;
+    uint64_t start;
+    uint32_t i;
+    bool started, detected;
+
+    bench_worker_init(&worker, &bench_voice_ui, opts, result);
+    result->streams = 1;
+    for (i = 0; i < opts->iterations; i++) {
+        if (bench_open(&worker))
+            continue;
+        started = false;
+        if (!bench_set_sound_model(&worker, opts->sound_model) && !bench_start(&worker)) {
+            started = true;
+            start = bench_now_us();
+            detected = bench_wait(&worker, bench_detected, opts->detection_timeout_ms);
+            bench_record(result, BENCH_OP_DETECTION, worker.detected_us - start,
+                         detected ? 0 : -ETIME);
+        }
+        bench_stop_and_close(&worker, started);
+    }
+    bench_worker_deinit(&worker);
+    return 0;
+}
+
+static int32_t bench_set_connection(pal_device_id_t id, bool connected)
+{
+    pal_param_device_connection_t connection;
+
+    memset(&connection, 0, sizeof(connection));
+    connection.id = id;
+    connection.connection_state = connected;
+    return pal_set_param(PAL_PARAM_ID_DEVICE_CONNECTION, &connection, sizeof(connection));
+}
+
+static void *bench_stream_transfer(void *arg)
+{
+    struct bench_worker *worker = (struct bench_worker *)arg;
+
+    bench_transfer(worker, 0);
+    return NULL;
+}
+
+/*
+ * A deep buffer stream keeps playing while it is moved around the switch
+ * targets, switch_gap_ms apart. Targets that cannot connect on this
+ * target, e.g. a2dp without a BT stack, show up as set_device errors.
+ */
+static int32_t bench_device_switch(const struct bench_options *opts, struct bench_result *result)
+{
+    struct bench_worker worker;
+    struct pal_device device;
+    uint64_t start;
+    uint32_t i;
+    int32_t status;
+
+    for (i = 1; i < BENCH_NUM_SWITCH_TARGETS; i++)
+        if (bench_set_connection(bench_switch_targets[i], true))
+            fprintf(stderr, "connecting device %d failed\n", bench_switch_targets[i]);
+
+    bench_worker_init(&worker, &bench_deep_buffer, opts, result);
+    result->streams = 1;
+    if (bench_open(&worker))
+        goto exit;
+    if (bench_start(&worker)) {
+        bench_stop_and_close(&worker, false);
+        goto exit;
+    }
+    pthread_create(&worker.thread, NULL, bench_stream_transfer, &worker);
+    for (i = 0; i < opts->switches; i++) {
+        usleep(opts->switch_gap_ms * 1000);
+        bench_fill_device(bench_switch_targets[(i + 1) % BENCH_NUM_SWITCH_TARGETS],
+                          worker.spec, &device);
+        start = bench_now_us();
+        status = pal_stream_set_device(worker.handle, 1, &device);
+        bench_record(result, BENCH_OP_SET_DEVICE, bench_now_us() - start, status);
+        if (status)
+            fprintf(stderr, "set_device %d failed %d\n", device.id, status);
+    }
+    __atomic_store_n(&worker.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(worker.thread, NULL);
+    bench_stop_and_close(&worker, true);
+exit:
+    bench_worker_deinit(&worker);
+    for (i = 1; i < BENCH_NUM_SWITCH_TARGETS; i++)
+        bench_set_connection(bench_switch_targets[i], false);
+    return 0;
+}
+
+/* open, start, stop and close without moving audio, as fast as PAL allows */
+static void *bench_stream_churn(void *arg)
+{
+    struct bench_worker *worker = (struct bench_worker *)arg;
+    uint32_t i;
+
+    for (i = 0; i < worker->opts->iterations; i++) {
+        if (bench_open(worker))
+            continue;
+        bench_stop_and_close(worker, !bench_start(worker));
+    }
+    return NULL;
+}
+
+/*
+ * instances threads of each playback type cycle their streams at once, so
+ * the handle table, stream registration and the resource manager locks
+ * see concurrent opens and closes of streams sharing devices.
+ */
+static int32_t bench_stream_churn_mix(const struct bench_options *opts,
+                                      struct bench_result *result)
+{
+    const struct bench_stream *specs[] = { &bench_deep_buffer, &bench_low_latency };
+    uint32_t num_specs = sizeof(specs) / sizeof(specs[0]);
+    uint32_t count = num_specs * opts->instances;
+    struct bench_worker *workers;
+    uint32_t i;
+
+    workers = (struct bench_worker *)calloc(count, sizeof(*workers));
+    if (!workers)
+        return -ENOMEM;
+    for (i = 0; i < count; i++)
+        bench_worker_init(&workers[i], specs[i % num_specs], opts, result);
+    result->streams = count;
+    for (i = 0; i < count; i++)
+        pthread_create(&workers[i].thread, NULL, bench_stream_churn, &workers[i]);
+    for (i = 0; i < count; i++) {
+        pthread_join(workers[i].thread, NULL);
+        bench_worker_deinit(&workers[i]);
+    }
+    free(workers);
+    return 0;
+}
+
+/*
+ * One playback and one capture stream moving audio back to back, to
+ * weigh what PAL adds to every pal_stream_write/read. With the sim card
+ * the report gives the time per buffer spent outside the card calls.
+ */
+static int32_t bench_data_path(const struct bench_options *opts, struct bench_result *result)
+{
+    struct bench_worker workers[2];
+
+    bench_worker_init(&workers[0], &bench_low_latency, opts, result);
+    bench_worker_init(&workers[1], &bench_deep_buffer_in, opts, result);
+    result->streams = 2;
+    bench_run_workers(workers, 2);
+    bench_worker_deinit(&workers[0]);
+    bench_worker_deinit(&workers[1]);
+    return 0;
+}
+
+/*
+ * instances deep buffer and low latency streams play on the speaker while
+ * one of them at a time is moved between handset and speaker. The two
+ * share a backend, so when the device config changes PAL moves every
+ * stream on it in one switch, connecting them in parallel. set_device
+ * times are those of the whole multi stream switch.
+ */
+static int32_t bench_device_switch_mix(const struct bench_options *opts,
+                                       struct bench_result *result)
+{
+    const struct bench_stream *specs[] = { &bench_deep_buffer, &bench_low_latency };
+    uint32_t num_specs = sizeof(specs) / sizeof(specs[0]);
+    uint32_t count = num_specs * opts->instances;
+    struct bench_worker *workers;
+    struct bench_worker *worker;
+    struct pal_device device;
+    uint64_t start;
+    uint32_t i, started = 0;
+    int32_t status;
+
+    workers = (struct bench_worker *)calloc(count, sizeof(*workers));
+    if (!workers)
+        return -ENOMEM;
+    for (i = 0; i < count; i++)
+        bench_worker_init(&workers[i], specs[i % num_specs], opts, result);
+    result->streams = count;
+    for (i = 0; i < count; i++) {
+        if (bench_open(&workers[i]))
+            break;
+        if (bench_start(&workers[i])) {
+            bench_stop_and_close(&workers[i], false);
+            break;
+        }
+        pthread_create(&workers[i].thread, NULL, bench_stream_transfer, &workers[i]);
+        started++;
+    }
+
+    for (i = 0; started && i < opts->switches; i++) {
+        worker = &workers[i % started];
+        usleep(opts->switch_gap_ms * 1000);
+        bench_fill_device(bench_shared_be_targets[i % BENCH_NUM_SHARED_BE_TARGETS],
+                          worker->spec, &device);
+        if (device.id == PAL_DEVICE_OUT_HANDSET)
+            device.config.ch_info.channels = 1;
+        start = bench_now_us();
+        status = pal_stream_set_device(worker->handle, 1, &device);
+        bench_record(result, BENCH_OP_SET_DEVICE, bench_now_us() - start, status);
+        if (status)
+            fprintf(stderr, "set_device %d failed %d\n", device.id, status);
+    }
+
+    for (i = 0; i < started; i++) {
+        __atomic_store_n(&workers[i].stop, 1, __ATOMIC_RELEASE);
+        pthread_join(workers[i].thread, NULL);
+        bench_stop_and_close(&workers[i], true);
+    }
+    for (i = 0; i < count; i++)
+        bench_worker_deinit(&workers[i]);
+    free(workers);
+    return 0;
+}
+
+static int bench_compare_us(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* nearest rank percentile of sorted samples */
+static uint64_t bench_percentile(const struct bench_samples *samples, uint32_t p)
+{
+    size_t rank = (samples->count * p + 99) / 100;
+
+    return rank ? samples->us[rank - 1] : 0;
+}
+
+static void bench_report(const char *name, struct bench_result *result, uint64_t wall_us,
+                         uint64_t cpu_us, FILE *out)
+{
+    struct bench_samples *samples;
+#ifdef PAL_SIM_CARD
+    uint64_t card_us = 0;
+#endif
+    uint32_t op;
+    bool first = true;
+
+    fprintf(out, "{\"name\":\"%s\",\"streams\":%u,\"wall_ms\":%.1f,\"audio_s\":%.3f,"
+            "\"cpu_ms\":%.1f,\"cpu_ms_per_audio_s\":%.2f,\"buffers\":%llu,"
+            "\"transfer_errors\":%u,\"xruns\":%llu,\"dropped_buffers\":%llu,",
+            name, result->streams, wall_us / 1000.0, result->audio_s, cpu_us / 1000.0,
+            result->audio_s > 0 ? cpu_us / 1000.0 / result->audio_s : 0.0,
+            (unsigned long long)result->buffers, result->transfer_errors,
+            (unsigned long long)result->xruns, (unsigned long long)result->dropped_buffers);
+    if (BENCH_COUNTS_ALLOCS && result->buffers)
+        fprintf(out, "\"allocs_per_buffer\":%.2f,",
+                (double)result->allocs / result->buffers);
+    else
+        fprintf(out, "\"allocs_per_buffer\":null,");
+    fprintf(out, "\"lock_wait\":{\"count\":%llu,\"mean_us\":%.1f,\"p99_us\":%llu,"
+            "\"max_us\":%llu},",
+            (unsigned long long)result->lock_waits,
+            result->lock_waits ? result->lock_wait_total_us / result->lock_waits : 0.0,
+            (unsigned long long)result->lock_wait_p99_us,
+            (unsigned long long)result->lock_wait_max_us);
+
+    fprintf(out, "\"ops\":{");
+    for (op = 0; op < BENCH_OP_MAX; op++) {
+        samples = &result->ops[op];
+        if (!samples->count && !samples->errors)
+            continue;
+        qsort(samples->us, samples->count, sizeof(uint64_t), bench_compare_us);
+        fprintf(out, "%s\"%s\":{\"count\":%zu,\"errors\":%u,\"p50_us\":%llu,\"p95_us\":%llu,"
+                "\"p99_us\":%llu,\"max_us\":%llu}",
+                first ? "" : ",", bench_op_names[op], samples->count, samples->errors,
+                (unsigned long long)bench_percentile(samples, 50),
+                (unsigned long long)bench_percentile(samples, 95),
+                (unsigned long long)bench_percentile(samples, 99),
+                (unsigned long long)(samples->count ? samples->us[samples->count - 1] : 0));
+        first = false;
+    }
+    fprintf(out, "}");
+
+#ifdef PAL_SIM_CARD
+    fprintf(out, ",\"sim_calls\":{");
+    first = true;
+    for (op = 0; op < sizeof(bench_sim_calls) / sizeof(bench_sim_calls[0]); op++) {
+        if (!pal_sim_get_call_count(bench_sim_calls[op]))
+            continue;
+        fprintf(out, "%s\"%s\":{\"count\":%llu,\"time_us\":%llu}", first ? "" : ",",
+                bench_sim_calls[op],
+                (unsigned long long)pal_sim_get_call_count(bench_sim_calls[op]),
+                (unsigned long long)pal_sim_get_call_time_us(bench_sim_calls[op]));
+        first = false;
+    }
+    fprintf(out, "}");
+
+    for (op = 0; op < sizeof(bench_sim_transfer_calls) / sizeof(bench_sim_transfer_calls[0]);
+         op++)
+        card_us += pal_sim_get_call_time_us(bench_sim_transfer_calls[op]);
+    if (result->buffers && result->transfer_ns / 1000 > card_us)
+        fprintf(out, ",\"pal_us_per_buffer\":%.2f",
+                (result->transfer_ns / 1000.0 - card_us) / result->buffers);
+    else
+        fprintf(out, ",\"pal_us_per_buffer\":null");
+#endif
+    fprintf(out, "}");
+}
+
+int32_t bench_run_scenario(const char *name, const struct bench_options *opts, FILE *out)
+{
+    int32_t (*run)(const struct bench_options *, struct bench_result *) = NULL;
+    struct bench_result result;
+    uint64_t wall, cpu;
+    uint32_t op;
+    int32_t status;
+
+    if (!strcmp(name, "playback_mix"))
+        run = bench_playback_mix;
+    else if (!strcmp(name, "voip"))
+        run = bench_voip;
+    else if (!strcmp(name, "sound_trigger"))
+        run = bench_sound_trigger;
+    else if (!strcmp(name, "device_switch"))
+        run = bench_device_switch;
+    else if (!strcmp(name, "device_switch_mix"))
+        run = bench_device_switch_mix;
+    else if (!strcmp(name, "data_path"))
+        run = bench_data_path;
+    else if (!strcmp(name, "stream_churn"))
+        run = bench_stream_churn_mix;
+    if (!run)
+        return -EINVAL;
+
+    if (run == bench_sound_trigger && !opts->sound_model) {
+        fprintf(out, "{\"name\":\"%s\",\"skipped\":\"no sound model\"}", name);
+        return 0;
+    }
+
+    fprintf(stderr, "running %s\n", name);
+    memset(&result, 0, sizeof(result));
+    pthread_mutex_init(&result.lock, NULL);
+#ifdef PAL_SIM_CARD
+    pal_sim_reset_counters();
+#endif
+    wall = bench_now_us();
+    cpu = bench_cpu_us();
+    status = run(opts, &result);
+    cpu = bench_cpu_us() - cpu;
+    wall = bench_now_us() - wall;
+    if (!status)
+        bench_report(name, &result, wall, cpu, out);
+
+    for (op = 0; op < BENCH_OP_MAX; op++)
+        free(result.ops[op].us);
+    pthread_mutex_destroy(&result.lock);
+    return status;
+}
+
+void bench_report_phases(FILE *out)
+{
+    pal_param_latency_stats_t *stats = NULL;
+    size_t size = 0;
+    uint32_t i;
+    bool first = true;
+
+    fprintf(out, "[");
+    if (!pal_get_param(PAL_PARAM_ID_LATENCY_STATS, (void **)&stats, &size, NULL) && stats) {
+        for (i = 0; i < stats->num_stats && i < PAL_MAX_LATENCY_STATS; i++) {
+            if (!stats->stats[i].count)
+                continue;
+            fprintf(out, "%s{\"name\":\"%s\",\"count\":%llu,\"mean_us\":%llu,\"p50_us\":%llu,"
+                    "\"p90_us\":%llu,\"p99_us\":%llu,\"max_us\":%llu}",
+                    first ? "" : ",", stats->stats[i].name,
+                    (unsigned long long)stats->stats[i].count,
+                    (unsigned long long)stats->stats[i].mean_us,
+                    (unsigned long long)stats->stats[i].p50_us,
+                    (unsigned long long)stats->stats[i].p90_us,
+                    (unsigned long long)stats->stats[i].p99_us,
+                    (unsigned long long)stats->stats[i].max_us);
+            first = false;
+        }
+        free(stats);
+    }
+    fprintf(out, "]");
+}
+
+void bench_report_caches(FILE *out)
+{
+    pal_param_latency_stats_t *stats = NULL;
+    size_t size = 0;
+    uint32_t i;
+
+    fprintf(out, "[");
+    if (!pal_get_param(PAL_PARAM_ID_LATENCY_STATS, (void **)&stats, &size, NULL) && stats) {
+        for (i = 0; i < stats->num_caches && i < PAL_MAX_CACHE_STATS; i++) {
+            fprintf(out, "%s{\"name\":\"%s\",\"hits\":%llu,\"misses\":%llu}",
+                    i ? "," : "", stats->caches[i].name,
+                    (unsigned long long)stats->caches[i].hits,
+                    (unsigned long long)stats->caches[i].misses);
+        }
+        free(stats);
+    }
+    fprintf(out, "]");
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAL_BENCHMARK_H
+#define PAL_BENCHMARK_H
+
+#include <stdio.h>
+#include <PalApi.h>
+#include <PalDefs.h>
+
+#define BENCH_SAMPLE_RATE 48000
+#define BENCH_VA_SAMPLE_RATE 16000
+#define BENCH_BIT_WIDTH 16
+/* used when PAL reports no buffer size for a stream */
+#define BENCH_DEFAULT_BUFFER_MS 20
+
+typedef enum {
+    BENCH_OP_OPEN,
+    BENCH_OP_START,
+    BENCH_OP_STOP,
+    BENCH_OP_CLOSE,
+    BENCH_OP_SET_DEVICE,
+    BENCH_OP_DETECTION,
+    BENCH_OP_MAX,
+} bench_op_t;
+
+struct bench_options {
+    uint32_t instances;            /* streams of each type in playback_mix, stream_churn and
+                                      device_switch_mix */
+    uint32_t iterations;           /* open to close cycles of each stream */
+    uint32_t duration_ms;          /* audio transferred per cycle */
+    uint32_t switches;             /* pal_stream_set_device calls of device_switch(_mix) */
+    uint32_t switch_gap_ms;        /* audio played between two switches */
+    const char *sound_model;       /* keyphrase model, sound_trigger is skipped without it */
+    uint32_t detection_timeout_ms; /* wait for a detection after start */
+};
+
+/* names accepted by bench_run_scenario, in the order they run by default */
+extern const char *bench_scenarios[];
+
+/*
+ * Runs one scenario and appends its report to out as a JSON object.
+ * Returns -EINVAL for an unknown name, failed PAL calls are counted in
+ * the report and do not fail the scenario.
+ */
+int32_t bench_run_scenario(const char *name, const struct bench_options *opts, FILE *out);
+
+/* appends the PAL_PARAM_ID_LATENCY_STATS phases as a JSON array */
+void bench_report_phases(FILE *out);
+
+/* appends the PAL_PARAM_ID_LATENCY_STATS cache counters as a JSON array */
+void bench_report_caches(FILE *out);
+
+#endif /* PAL_BENCHMARK_H */
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "PalBenchmark.h"
+
+static void usage(void)
+{
+    fprintf(stdout, "Usage: PalBenchmark [options] [scenario...]\n"
+            "  -n <count>  concurrent streams of each type in playback_mix,\n"
+            "              stream_churn and device_switch_mix (2)\n"
+            "  -i <count>  open to close cycles per stream (5)\n"
+            "  -d <ms>     audio per cycle (200)\n"
+            "  -s <count>  device switches in device_switch and device_switch_mix (30)\n"
+            "  -g <ms>     audio between two switches (20)\n"
+            "  -m <file>   keyphrase sound model, sound_trigger is skipped without it\n"
+            "  -t <ms>     wait for a detection after start (2000)\n"
+            "  -o <file>   write the JSON report to file instead of stdout\n"
+            "Scenarios, all by default:");
+    for (const char **name = bench_scenarios; *name; name++)
+        fprintf(stdout, " %s", *name);
+    fprintf(stdout, "\n");
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_options opts = {
+        .instances = 2,
+        .iterations = 5,
+        .duration_ms = 200,
+        .switches = 30,
+        .switch_gap_ms = 20,
+        .sound_model = NULL,
+        .detection_timeout_ms = 2000,
+    };
+    const char *output = NULL;
+    FILE *out = stdout;
+    int status = 0;
+    int opt, i;
+    bool first = true;
+
+    while ((opt = getopt(argc, argv, "n:i:d:s:g:m:t:o:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            opts.instances = atoi(optarg);
+            break;
+        case 'i':
+            opts.iterations = atoi(optarg);
+            break;
+        case 'd':
+            opts.duration_ms = atoi(optarg);
+            break;
+        case 's':
+            opts.switches = atoi(optarg);
+            break;
+        case 'g':
+            opts.switch_gap_ms = atoi(optarg);
+            break;
+        case 'm':
+            opts.sound_model = optarg;
+            break;
+        case 't':
+            opts.detection_timeout_ms = atoi(optarg);
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            usage();
+            return opt == 'h' ? 0 : -EINVAL;
+        }
+    }
+
+    if (output) {
+        out = fopen(output, "w");
+        if (!out) {
+            fprintf(stderr, "cannot open %s\n", output);
+            return -EINVAL;
+        }
+    }
+
+    status = pal_init();
+    if (status) {
+        fprintf(stderr, "pal_init failed %d\n", status);
+        goto exit;
+    }
+
+    fprintf(out, "{\"options\":{\"instances\":%u,\"iterations\":%u,\"duration_ms\":%u,"
+            "\"switches\":%u,\"switch_gap_ms\":%u},\"scenarios\":[",
+            opts.instances, opts.iterations, opts.duration_ms, opts.switches,
+            opts.switch_gap_ms);
+    if (optind == argc) {
+        for (const char **name = bench_scenarios; *name; name++) {
+            fprintf(out, "%s", first ? "" : ",");
+            bench_run_scenario(*name, &opts, out);
+            first = false;
+        }
+    }
+    for (i = optind; i < argc; i++) {
+        fprintf(out, "%s", first ? "" : ",");
+        if (bench_run_scenario(argv[i], &opts, out)) {
+            fprintf(out, "{\"name\":\"%s\",\"skipped\":\"unknown scenario\"}", argv[i]);
+            status = -EINVAL;
+        }
+        first = false;
+    }
+    fprintf(out, "],\"phases\":");
+    bench_report_phases(out);
+    fprintf(out, ",\"caches\":");
+    bench_report_caches(out);
+    fprintf(out, "}\n");
+
+    pal_deinit();
+exit:
+    if (output)
+        fclose(out);
+    return status;
+}
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Stress test and throughput benchmark of PalRingBuffer with one writer and
+ * N readers, in locked and lock free mode. Every byte a reader gets is
+ * checked against the position it was written at. Half of the readers use
+ * read(), the other half peek()/commit(). In lock free mode another thread
+ * keeps adding and removing readers while the writer runs, unless -n.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "PalRingBuffer.h"
+
+/* waits this long are reported as stalls, the ring buffer gives up at 3 s */
+#define RB_TEST_STALL_MS 500
+
+struct rb_test_options {
+    uint32_t readers;
+    size_t total;       /* bytes written per run */
+    size_t chunk;       /* bytes per write and per wait */
+    size_t bufferSize;
+    bool churn;         /* add and remove readers during the lock free run */
+};
+
+struct rb_test_result {
+    double seconds;
+    uint64_t mismatches;
+    uint64_t stalls;
+    double maxWaitMs;
+    uint64_t churned;   /* readers added and removed during the run */
+};
+
+static inline uint8_t patternAt(uint64_t pos)
+{
+    return (uint8_t)(pos ^ (pos >> 8) ^ (pos >> 16) ^ (pos >> 24));
+}
+
+static uint64_t checkData(const char *data, size_t size, uint64_t pos)
+{
+    uint64_t mismatches = 0;
+
+    for (size_t i = 0; i < size; i++) {
+        if ((uint8_t)data[i] != patternAt(pos + i))
+            mismatches++;
+    }
+    return mismatches;
+}
+
+static void readerLoop(PalRingBufferReader *reader, const struct rb_test_options *opts,
+    bool usePeek, std::atomic<uint64_t> *mismatches, std::atomic<uint64_t> *stalls,
+    std::atomic<uint64_t> *maxWaitUs)
+{
+    std::vector<char> buf(opts->chunk);
+    struct pal_ring_buffer_span spans[PAL_RING_BUFFER_MAX_SPANS];
+    uint64_t pos = 0;
+
+    while (pos < opts->total) {
+        size_t want = std::min(opts->chunk, (size_t)(opts->total - pos));
+        auto start = std::chrono::steady_clock::now();
+        bool ready = reader->waitForBuffers(want);
+        uint64_t waitUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        uint64_t prev = maxWaitUs->load();
+
+        while (waitUs > prev && !maxWaitUs->compare_exchange_weak(prev, waitUs));
+        if (waitUs >= RB_TEST_STALL_MS * 1000)
+            (*stalls)++;
+        if (!ready)
+            continue;
+
+        if (usePeek) {
+            int32_t avail = reader->peek(spans);
+            size_t size;
+
+            if (avail <= 0)
+                continue;
+            size = std::min((size_t)avail, want);
+            for (int i = 0; i < PAL_RING_BUFFER_MAX_SPANS && size; i++) {
+                size_t part = std::min(size, spans[i].size);
+
+                *mismatches += checkData(spans[i].data, part, pos);
+                reader->commit(part);
+                pos += part;
+                size -= part;
+            }
+        } else {
+            int32_t size = reader->read(buf.data(), want);
+
+            if (size <= 0)
+                continue;
+            *mismatches += checkData(buf.data(), size, pos);
+            pos += size;
+        }
+    }
+}
+
+static void writerLoop(PalRingBuffer *ring, const struct rb_test_options *opts)
+{
+    std::vector<char> buf(opts->chunk);
+    uint64_t pos = 0;
+
+    while (pos < opts->total) {
+        size_t size = std::min(opts->chunk, (size_t)(opts->total - pos));
+        size_t written;
+
+        for (size_t i = 0; i < size; i++)
+            buf[i] = patternAt(pos + i);
+        written = ring->write(buf.data(), size);
+        pos += written;
+        /* full, let the slowest reader catch up */
+        if (written < size)
+            std::this_thread::yield();
+    }
+}
+
+/* readers that never get enabled, so they are notified but hold nothing back */
+static void churnLoop(PalRingBuffer *ring, std::atomic<bool> *done, uint64_t *churned)
+{
+    while (!*done) {
+        PalRingBufferReader *reader = ring->newReader();
+
+        ring->removeReader(reader);
+        delete reader;
+        (*churned)++;
+    }
+}
+
+static int runTest(bool lockFree, const struct rb_test_options *opts,
+    struct rb_test_result *result)
+{
+    PalRingBuffer ring(opts->bufferSize, lockFree);
+    std::vector<PalRingBufferReader *> readers;
+    std::vector<std::thread> threads;
+    std::atomic<uint64_t> mismatches(0), stalls(0), maxWaitUs(0);
+    std::atomic<bool> done(false);
+    std::thread churn;
+
+    *result = {};
+    for (uint32_t i = 0; i < opts->readers; i++) {
+        PalRingBufferReader *reader = ring.newReader();
+
+        if (!reader)
+            return -ENOMEM;
+        reader->updateState(READER_ENABLED);
+        readers.push_back(reader);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < opts->readers; i++)
+        threads.emplace_back(readerLoop, readers[i], opts, i % 2 == 1, &mismatches,
+            &stalls, &maxWaitUs);
+    if (lockFree && opts->churn)
+        churn = std::thread(churnLoop, &ring, &done, &result->churned);
+    writerLoop(&ring, opts);
+    for (auto &t : threads)
+        t.join();
+    result->seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    done = true;
+    if (churn.joinable())
+        churn.join();
+
+    result->mismatches = mismatches;
+    result->stalls = stalls;
+    result->maxWaitMs = maxWaitUs / 1000.0;
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stdout, "Usage: PalRingBufferTest [options]\n"
+            "  -r <count>  readers (4)\n"
+            "  -m <MB>     data written per mode (64)\n"
+            "  -c <bytes>  bytes per write and per reader wait (3840)\n"
+            "  -b <bytes>  ring buffer size (65536)\n"
+            "  -n          no readers added and removed during the lock free run\n");
+}
+
+int main(int argc, char *argv[])
+{
+    struct rb_test_options opts = {
+        .readers = 4,
+        .total = (size_t)64 << 20,
+        .chunk = 3840,
+        .bufferSize = 65536,
+        .churn = true,
+    };
+    struct rb_test_result result;
+    int status = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "r:m:c:b:nh")) != -1) {
+        switch (opt) {
+        case 'r':
+            opts.readers = atoi(optarg);
+            break;
+        case 'm':
+            opts.total = (size_t)atoi(optarg) << 20;
+            break;
+        case 'c':
+            opts.chunk = atoi(optarg);
+            break;
+        case 'b':
+            opts.bufferSize = atoi(optarg);
+            break;
+        case 'n':
+            opts.churn = false;
+            break;
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (!opts.readers || !opts.total || !opts.chunk || opts.chunk > opts.bufferSize) {
+        usage();
+        return 1;
+    }
+
+    for (int lockFree = 0; lockFree <= 1; lockFree++) {
+        if (runTest(lockFree, &opts, &result)) {
+            fprintf(stderr, "%s: setup failed\n", lockFree ? "lock free" : "locked");
+            return 1;
+        }
+        fprintf(stdout, "%-9s 1 writer, %u readers: %.1f MB/s, max wait %.2f ms, "
+                "%llu stalls, %llu mismatches, %llu readers churned\n",
+                lockFree ? "lock free" : "locked", opts.readers,
+                opts.total / result.seconds / (1 << 20), result.maxWaitMs,
+                (unsigned long long)result.stalls, (unsigned long long)result.mismatches,
+                (unsigned long long)result.churned);
+        if (result.mismatches || result.stalls)
+            status = 1;
+    }
+    return status;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+/*
+ * Compares the linear string lookup of usecaseKvManager.xml with the
+ * compiled KV index of PayloadBuilder. Every query is run on both paths
+ * and must give the same result, then both paths are timed, and the index
+ * is timed again from several threads at once.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PayloadBuilder.h"
+
+#ifndef KV_BENCH_CONFIG_DIR
+#define KV_BENCH_CONFIG_DIR "configs"
+#endif
+
+#define KV_BENCH_NO_SUCH_VALUE "KV_BENCH_NO_SUCH_VALUE"
+
+struct kvQuery {
+    std::vector<allKVs> *table;
+    int32_t type;
+    std::vector<std::pair<selector_type_t, std::string>> pairs;
+};
+
+/* reaches the parsed tables and the switch between the two lookup paths */
+class KvBench : public PayloadBuilder {
+public:
+    static void useIndex(bool enable) { kvIndexReady = enable; }
+    static void buildQueries(std::vector<kvQuery> &queries);
+};
+
+void KvBench::buildQueries(std::vector<kvQuery> &queries)
+{
+    std::vector<allKVs> *tables[] = {&all_streams, &all_streampps,
+        &all_devices, &all_devicepps};
+
+    for (auto table : tables) {
+        for (auto &block : *table) {
+            for (int32_t type : block.id_type) {
+                kvQuery query = {table, type, {}};
+
+                /* empty tuple */
+                queries.push_back(query);
+                for (auto &info : block.keys_values) {
+                    if (info.selector_pairs.empty())
+                        continue;
+                    /* exact tuple */
+                    query.pairs = info.selector_pairs;
+                    queries.push_back(query);
+                    /* subset */
+                    if (query.pairs.size() > 1) {
+                        query.pairs.erase(query.pairs.begin());
+                        queries.push_back(query);
+                    }
+                    /* value the xml never uses */
+                    query.pairs = info.selector_pairs;
+                    query.pairs.back().second = KV_BENCH_NO_SUCH_VALUE;
+                    queries.push_back(query);
+                }
+            }
+        }
+    }
+}
+
+static double runQueries(std::vector<kvQuery> &queries, uint32_t iterations)
+{
+    std::vector<std::pair<int, int>> keyVector;
+    auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        for (auto &query : queries) {
+            keyVector.clear();
+            PayloadBuilder::findKVs(query.pairs, query.type, *query.table, keyVector);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() / (iterations * queries.size());
+}
+
+static int checkQueries(std::vector<kvQuery> &queries)
+{
+    std::vector<std::pair<int, int>> linear, indexed;
+    bool linearFound, indexedFound;
+    int mismatches = 0;
+
+    for (auto &query : queries) {
+        linear.clear();
+        indexed.clear();
+        KvBench::useIndex(false);
+        linearFound = PayloadBuilder::findKVs(query.pairs, query.type, *query.table, linear);
+        KvBench::useIndex(true);
+        indexedFound = PayloadBuilder::findKVs(query.pairs, query.type, *query.table, indexed);
+        if (linearFound != indexedFound || linear != indexed) {
+            fprintf(stderr, "mismatch: type 0x%x, %zu selectors, found %d/%d, %zu/%zu kvs\n",
+                query.type, query.pairs.size(), linearFound, indexedFound,
+                linear.size(), indexed.size());
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static int benchFile(const char *xml, uint32_t iterations, uint32_t threads)
+{
+    std::vector<kvQuery> queries;
+    std::vector<std::thread> workers;
+    double linearNs, indexNs, parallelNs;
+    int mismatches;
+
+    if (PayloadBuilder::init(xml)) {
+        fprintf(stderr, "failed to load %s\n", xml);
+        return -EINVAL;
+    }
+    KvBench::buildQueries(queries);
+    mismatches = checkQueries(queries);
+
+    KvBench::useIndex(false);
+    linearNs = runQueries(queries, iterations);
+    KvBench::useIndex(true);
+    indexNs = runQueries(queries, iterations);
+
+    /* wall time of all threads over all of their lookups */
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t t = 0; t < threads; t++)
+        workers.emplace_back([&queries, iterations]() { runQueries(queries, iterations); });
+    for (auto &worker : workers)
+        worker.join();
+    parallelNs = std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - start).count() /
+        ((double)threads * iterations * queries.size());
+
+    fprintf(stdout, "%s\n", xml);
+    fprintf(stdout, "  queries %zu, mismatches %d\n", queries.size(), mismatches);
+    fprintf(stdout, "  linear  %8.1f ns/lookup\n", linearNs);
+    fprintf(stdout, "  index   %8.1f ns/lookup\n", indexNs);
+    fprintf(stdout, "  index   %8.1f ns/lookup, %u threads at once\n", parallelNs, threads);
+    return mismatches ? -EINVAL : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stdout, "Usage: PayloadBuilderKvBench [-i iterations] [-t threads] [xml...]\n"
+            "  -i <count>  passes over all queries per timing (200)\n"
+            "  -t <count>  threads looking up at once (4)\n"
+            "Without xml, the kalama and pineapple usecaseKvManager.xml are used\n");
+}
+
+int main(int argc, char *argv[])
+{
+    const char *defaults[] = {KV_BENCH_CONFIG_DIR "/kalama/usecaseKvManager.xml",
+        KV_BENCH_CONFIG_DIR "/pineapple/usecaseKvManager.xml"};
+    uint32_t iterations = 200;
+    uint32_t threads = 4;
+    int status = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:t:h")) != -1) {
+        switch (opt) {
+        case 'i':
+            iterations = atoi(optarg);
+            break;
+        case 't':
+            threads = atoi(optarg);
+            break;
+        default:
+            usage();
+            return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (iterations == 0 || threads == 0) {
+        usage();
+        return 1;
+    }
+
+    if (optind < argc) {
+        for (int i = optind; i < argc; i++)
+            status |= benchFile(argv[i], iterations, threads);
+    } else {
+        for (auto xml : defaults)
+            status |= benchFile(xml, iterations, threads);
+    }
+    return status ? 1 : 0;
+}
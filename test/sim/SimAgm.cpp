@@ -0,0 +1,342 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SimAgm"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <agm/agm_api.h>
+#include "SimCard.h"
+#include "PalCommon.h"
+
+/*
+ * Non tunnel AGM sessions. Buffers are taken whole, their done events
+ * and EOS are delivered from a dispatch thread as the AGM service would,
+ * never from inside the call that queued them.
+ */
+struct sim_agm_session {
+    uint32_t sessionId;
+    bool opened;
+    agm_event_cb dataCb;
+    void *dataCookie;
+    agm_event_cb moduleCb;
+    void *moduleCookie;
+};
+
+struct sim_agm_event {
+    uint32_t sessionId;
+    uint32_t eventId;
+    struct agm_buff buff;
+};
+
+class SimAgm
+{
+public:
+    static SimAgm *getInstance();
+
+    int open(uint32_t sessionId, uint64_t *handle);
+    int close(uint64_t handle);
+    bool isOpen(uint64_t handle);
+    int registerCb(uint32_t sessionId, agm_event_cb cb, enum event_type type, void *cookie);
+    void queueEvent(uint64_t handle, uint32_t eventId, const struct agm_buff *buff);
+
+private:
+    SimAgm() : mDispatching(0) {}
+    struct sim_agm_session *getSession(uint32_t sessionId);
+    void dispatchLoop();
+
+    std::mutex mLock;
+    std::condition_variable mCv;
+    std::map<uint32_t, struct sim_agm_session> mSessions;
+    std::deque<struct sim_agm_event> mEvents;
+    /* session whose callback runs right now, 0 if none */
+    uint32_t mDispatching;
+    std::thread mDispatcher;
+};
+
+/* set on the dispatcher while it runs a callback, which may close its own session */
+static thread_local bool inCallback = false;
+
+SimAgm *SimAgm::getInstance()
+{
+    /* never freed, the dispatcher runs until the process exits */
+    static SimAgm *instance = [] {
+        SimAgm *agm = new SimAgm();
+
+        agm->mDispatcher = std::thread(&SimAgm::dispatchLoop, agm);
+        agm->mDispatcher.detach();
+        return agm;
+    }();
+
+    return instance;
+}
+
+struct sim_agm_session *SimAgm::getSession(uint32_t sessionId)
+{
+    struct sim_agm_session &session = mSessions[sessionId];
+
+    session.sessionId = sessionId;
+    return &session;
+}
+
+int SimAgm::open(uint32_t sessionId, uint64_t *handle)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    struct sim_agm_session *session = getSession(sessionId);
+
+    if (session->opened)
+        return -EALREADY;
+    session->opened = true;
+    *handle = sessionId;
+    return 0;
+}
+
+int SimAgm::close(uint64_t handle)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    uint32_t sessionId = (uint32_t)handle;
+    auto iter = mSessions.find(sessionId);
+
+    if (iter == mSessions.end() || !iter->second.opened)
+        return -EINVAL;
+
+    /* callers free their cookie once this returns */
+    if (!inCallback)
+        mCv.wait(lock, [this, sessionId] { return mDispatching != sessionId; });
+    mSessions.erase(iter);
+    return 0;
+}
+
+bool SimAgm::isOpen(uint64_t handle)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    auto iter = mSessions.find((uint32_t)handle);
+
+    return iter != mSessions.end() && iter->second.opened;
+}
+
+int SimAgm::registerCb(uint32_t sessionId, agm_event_cb cb, enum event_type type,
+                       void *cookie)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    struct sim_agm_session *session = getSession(sessionId);
+
+    if (type == AGM_EVENT_DATA_PATH) {
+        session->dataCb = cb;
+        session->dataCookie = cookie;
+    } else {
+        session->moduleCb = cb;
+        session->moduleCookie = cookie;
+    }
+    /* no callback may run against a cookie once it is unregistered */
+    if (!cb && !inCallback)
+        mCv.wait(lock, [this, sessionId] { return mDispatching != sessionId; });
+    return 0;
+}
+
+void SimAgm::queueEvent(uint64_t handle, uint32_t eventId, const struct agm_buff *buff)
+{
+    struct sim_agm_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.sessionId = (uint32_t)handle;
+    ev.eventId = eventId;
+    if (buff)
+        ev.buff = *buff;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mEvents.push_back(ev);
+    mCv.notify_all();
+}
+
+void SimAgm::dispatchLoop()
+{
+    size_t size = sizeof(struct agm_event_cb_params) +
+                  sizeof(struct agm_event_read_write_done_payload);
+    struct agm_event_cb_params *params = (struct agm_event_cb_params *)calloc(1, size);
+    struct agm_event_read_write_done_payload done;
+    struct sim_agm_event ev;
+    agm_event_cb cb;
+    void *cookie;
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (1) {
+        mCv.wait(lock, [this] { return !mEvents.empty(); });
+        ev = mEvents.front();
+        mEvents.pop_front();
+
+        auto iter = mSessions.find(ev.sessionId);
+        if (iter == mSessions.end() || !iter->second.dataCb)
+            continue;
+        cb = iter->second.dataCb;
+        cookie = iter->second.dataCookie;
+
+        memset(params, 0, size);
+        params->event_id = ev.eventId;
+        if (ev.eventId == AGM_EVENT_READ_DONE || ev.eventId == AGM_EVENT_WRITE_DONE) {
+            /* the payload follows three words and is not 8 byte aligned */
+            memset(&done, 0, sizeof(done));
+            done.buff = ev.buff;
+            params->event_payload_size = sizeof(done);
+            memcpy(params->event_payload, &done, sizeof(done));
+        }
+
+        mDispatching = ev.sessionId;
+        lock.unlock();
+        inCallback = true;
+        cb(ev.sessionId, params, cookie);
+        inCallback = false;
+        lock.lock();
+        mDispatching = 0;
+        mCv.notify_all();
+    }
+}
+
+int agm_session_open(uint32_t session_id, enum agm_session_mode sess_mode __unused,
+                     uint64_t *handle)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_OPEN);
+
+    if (!handle)
+        return -EINVAL;
+    return SimAgm::getInstance()->open(session_id, handle);
+}
+
+int agm_session_close(uint64_t handle)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_CLOSE);
+
+    return SimAgm::getInstance()->close(handle);
+}
+
+int agm_session_prepare(uint64_t handle)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_PREPARE);
+
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_start(uint64_t handle)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_START);
+
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_stop(uint64_t handle)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_STOP);
+
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_suspend(uint64_t handle)
+{
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_flush(uint64_t handle)
+{
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_eos(uint64_t handle)
+{
+    if (!SimAgm::getInstance()->isOpen(handle))
+        return -EINVAL;
+    SimAgm::getInstance()->queueEvent(handle, AGM_EVENT_EOS_RENDERED, NULL);
+    return 0;
+}
+
+int agm_session_set_metadata(uint32_t session_id __unused, uint32_t size, uint8_t *metadata)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_SET);
+
+    return (size && !metadata) ? -EINVAL : 0;
+}
+
+int agm_session_set_params(uint32_t session_id __unused, void *payload, size_t size)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_SET);
+
+    return (!payload || !size) ? -EINVAL : 0;
+}
+
+int agm_session_set_non_tunnel_mode_config(uint64_t handle,
+                                           struct agm_session_config *session_config __unused,
+                                           struct agm_media_config *in_media_config __unused,
+                                           struct agm_media_config *out_media_config __unused,
+                                           struct agm_buffer_config *in_buffer_config __unused,
+                                           struct agm_buffer_config *out_buffer_config __unused)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_SET);
+
+    return SimAgm::getInstance()->isOpen(handle) ? 0 : -EINVAL;
+}
+
+int agm_session_write_with_metadata(uint64_t handle, struct agm_buff *buff,
+                                    size_t *consumed_size)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_WRITE);
+
+    if (!buff || !consumed_size || !SimAgm::getInstance()->isOpen(handle))
+        return -EINVAL;
+    *consumed_size = buff->size;
+    SimAgm::getInstance()->queueEvent(handle, AGM_EVENT_WRITE_DONE, buff);
+    return 0;
+}
+
+int agm_session_read_with_metadata(uint64_t handle, struct agm_buff *buff,
+                                   uint32_t *captured_size)
+{
+    SimCallScope call(SIM_CALL_AGM_SESSION_READ);
+
+    if (!buff || !captured_size || !SimAgm::getInstance()->isOpen(handle))
+        return -EINVAL;
+    if (buff->addr)
+        memset(buff->addr, 0, buff->size);
+    *captured_size = buff->size;
+    SimAgm::getInstance()->queueEvent(handle, AGM_EVENT_READ_DONE, buff);
+    return 0;
+}
+
+int agm_session_register_cb(uint32_t session_id, agm_event_cb cb, enum event_type evt_type,
+                            void *client_data)
+{
+    return SimAgm::getInstance()->registerCb(session_id, cb, evt_type, client_data);
+}
+
+int agm_session_aif_get_tag_module_info(uint32_t session_id __unused, uint32_t aif_id __unused,
+                                        void *payload, size_t *size)
+{
+    std::vector<uint8_t> info;
+
+    if (!size)
+        return -EINVAL;
+
+    SimCard::getInstance()->getTaggedInfo(info);
+    if (!payload) {
+        *size = info.size();
+        return 0;
+    }
+    if (*size < info.size())
+        return -ENOMEM;
+    memcpy(payload, info.data(), info.size());
+    *size = info.size();
+    return 0;
+}
+
+int agm_register_service_crash_callback(agm_service_crash_cb cb __unused,
+                                        uint64_t cookie __unused)
+{
+    return 0;
+}
+
+int agm_dump(struct agm_dump_info *dump_info __unused)
+{
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SimAudioRoute"
+
+#include <errno.h>
+#include <audio_route/audio_route.h>
+#include "SimCard.h"
+#include "PalCommon.h"
+
+/*
+ * Paths of the mixer_paths XML only program codec controls of the hw
+ * card, which nothing reads back on a simulated card. Enabling and
+ * disabling a device costs its modelled latency and nothing else.
+ */
+struct audio_route {
+    unsigned int card;
+};
+
+struct audio_route *audio_route_init(unsigned int card, const char *xml_path)
+{
+    struct audio_route *ar = NULL;
+
+    PAL_INFO(LOG_TAG, "card %u, ignoring %s", card, xml_path ? xml_path : "(null)");
+    ar = new struct audio_route;
+    ar->card = card;
+    return ar;
+}
+
+void audio_route_free(struct audio_route *ar)
+{
+    delete ar;
+}
+
+int audio_route_apply_and_update_path(struct audio_route *ar, const char *name)
+{
+    SimCallScope call(SIM_CALL_AUDIO_ROUTE_APPLY);
+
+    if (!ar || !name)
+        return -EINVAL;
+    PAL_DBG(LOG_TAG, "apply %s", name);
+    return 0;
+}
+
+int audio_route_reset_and_update_path(struct audio_route *ar, const char *name)
+{
+    SimCallScope call(SIM_CALL_AUDIO_ROUTE_RESET);
+
+    if (!ar || !name)
+        return -EINVAL;
+    PAL_DBG(LOG_TAG, "reset %s", name);
+    return 0;
+}
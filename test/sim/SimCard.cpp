@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SimCard"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <expat.h>
+#include "SimCard.h"
+#include "PalCommon.h"
+
+#define SIM_CONFIG_LINE_MAX 512
+
+static const char *callNames[SIM_CALL_MAX] = {
+    "pcm_open",
+    "pcm_close",
+    "pcm_prepare",
+    "pcm_start",
+    "pcm_stop",
+    "pcm_write",
+    "pcm_read",
+    "mixer_open",
+    "mixer_get_ctl",
+    "mixer_ctl_set",
+    "mixer_ctl_get",
+    "compress_open",
+    "compress_close",
+    "compress_start",
+    "compress_stop",
+    "compress_write",
+    "compress_read",
+    "agm_session_open",
+    "agm_session_close",
+    "agm_session_prepare",
+    "agm_session_start",
+    "agm_session_stop",
+    "agm_session_set",
+    "agm_session_write",
+    "agm_session_read",
+    "audio_route_apply",
+    "audio_route_reset",
+};
+
+/* same suffixes SessionAlsaUtils builds FE and BE control names from */
+static const char *feCtlNames[] = {
+    " control",
+    " metadata",
+    " connect",
+    " disconnect",
+    " setParam",
+    " getTaggedInfo",
+    " setParamTag",
+    " getParam",
+    " echoReference",
+    " Sidetone",
+    " loopback",
+    " event",
+    " setcal",
+    " flush",
+};
+
+/* BE names live in the platform XML, their controls are made on first use */
+static const char *beCtlNames[] = {
+    " metadata",
+    " rate ch fmt",
+    " setParam",
+    " grp config",
+};
+
+/* layout of gsl_tag_module_info with one module per tag */
+struct sim_tag_entry {
+    uint32_t tagId;
+    uint32_t numModules;
+    uint32_t moduleId;
+    uint32_t moduleIid;
+};
+
+struct card_defs_parser {
+    std::string text;
+    bool inCard;
+    bool cardDone;
+    bool inDevice;
+    struct sim_device dev;
+    struct sim_mixer_card *virtCard;
+    std::vector<struct sim_device> *devices;
+};
+
+static void cardDefsStart(void *userdata, const XML_Char *tag, const XML_Char **attr __unused)
+{
+    struct card_defs_parser *p = (struct card_defs_parser *)userdata;
+
+    p->text.clear();
+    if (p->cardDone)
+        return;
+    if (!strcmp(tag, "card")) {
+        p->inCard = true;
+    } else if (p->inCard && (!strcmp(tag, "pcm-device") || !strcmp(tag, "compress-device"))) {
+        p->inDevice = true;
+        p->dev.id = 0;
+        p->dev.name.clear();
+        p->dev.compress = !strcmp(tag, "compress-device");
+    }
+}
+
+static void cardDefsEnd(void *userdata, const XML_Char *tag)
+{
+    struct card_defs_parser *p = (struct card_defs_parser *)userdata;
+
+    if (!p->inCard)
+        goto done;
+
+    if (!strcmp(tag, "card")) {
+        p->inCard = false;
+        p->cardDone = true;
+    } else if (!strcmp(tag, "pcm-device") || !strcmp(tag, "compress-device")) {
+        p->inDevice = false;
+        p->devices->push_back(p->dev);
+    } else if (!strcmp(tag, "id")) {
+        if (p->inDevice)
+            p->dev.id = atoi(p->text.c_str());
+        else
+            p->virtCard->card = atoi(p->text.c_str());
+    } else if (!strcmp(tag, "name")) {
+        if (p->inDevice)
+            p->dev.name = p->text;
+        else
+            p->virtCard->name = p->text;
+    }
+done:
+    p->text.clear();
+}
+
+static void cardDefsData(void *userdata, const XML_Char *s, int len)
+{
+    struct card_defs_parser *p = (struct card_defs_parser *)userdata;
+
+    p->text.append(s, len);
+}
+
+static bool endsWith(const std::string &name, const char *suffix)
+{
+    size_t len = strlen(suffix);
+
+    return name.size() > len && !name.compare(name.size() - len, len, suffix);
+}
+
+SimCard *SimCard::getInstance()
+{
+    /* never freed, PAL threads may still call in while the process exits */
+    static SimCard *instance = new SimCard();
+
+    return instance;
+}
+
+uint64_t SimCard::nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+const char *SimCard::getCallName(sim_call_t call)
+{
+    if ((uint32_t)call >= SIM_CALL_MAX)
+        return "unknown";
+    return callNames[call];
+}
+
+SimCard::SimCard()
+    : mCompressRate(SIM_COMPRESS_RATE), mCardDefs(SIM_CARD_DEFS_PATH)
+{
+    const char *path = getenv("PAL_SIM_CONFIG");
+
+    for (int i = 0; i < SIM_CALL_MAX; i++) {
+        mLatency[i].meanUs = 0;
+        mLatency[i].jitterUs = 0;
+        mLatency[i].count = 0;
+        mLatency[i].timeNs = 0;
+    }
+
+    mHwCard.card = SIM_HW_CARD;
+    mHwCard.name = SIM_HW_CARD_NAME;
+    mHwCard.isVirtual = false;
+    mVirtCard.card = 0;
+    mVirtCard.isVirtual = true;
+
+    loadConfig(path ? path : SIM_CONFIG_PATH);
+    path = getenv("PAL_SIM_CARD_DEFS");
+    if (path)
+        mCardDefs = path;
+    loadCardDefs(mCardDefs.c_str());
+
+    for (auto &dev : mDevices) {
+        for (auto suffix : feCtlNames) {
+            struct mixer_ctl *ctl = addCtl(&mVirtCard, dev.name + suffix);
+
+            if (!strcmp(suffix, " getTaggedInfo"))
+                ctl->type = SIM_CTL_TAGGED_INFO;
+        }
+    }
+    for (auto &name : mHwCtls)
+        addCtl(&mHwCard, name);
+
+    PAL_INFO(LOG_TAG, "hw card %u %s, virtual card %u %s with %zu devices, %zu controls",
+             mHwCard.card, mHwCard.name.c_str(), mVirtCard.card, mVirtCard.name.c_str(),
+             mDevices.size(), mVirtCard.ctls.size());
+}
+
+void SimCard::loadConfig(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[SIM_CONFIG_LINE_MAX];
+    char key[64];
+    char arg[SIM_CONFIG_LINE_MAX];
+    unsigned int num;
+    uint32_t a, b;
+    int n = 0;
+
+    if (!fp) {
+        PAL_INFO(LOG_TAG, "no config at %s, calls take no time", path);
+        return;
+    }
+
+    while (fgets(line, sizeof(line), fp)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#' || sscanf(line, "%63s", key) != 1)
+            continue;
+
+        if (!strcmp(key, "latency")) {
+            a = b = 0;
+            if (sscanf(line, "%*s %511s %u %u", arg, &a, &b) < 2 ||
+                setLatency(arg, a, b))
+                PAL_ERR(LOG_TAG, "bad latency line: %s", line);
+        } else if (!strcmp(key, "hw_card")) {
+            if (sscanf(line, "%*s %u %n", &num, &n) != 1 || !line[n]) {
+                PAL_ERR(LOG_TAG, "bad hw_card line: %s", line);
+                continue;
+            }
+            mHwCard.card = num;
+            mHwCard.name = line + n;
+        } else if (!strcmp(key, "hw_ctl")) {
+            if (sscanf(line, "%*s %n", &n) != 0 || !line[n]) {
+                PAL_ERR(LOG_TAG, "bad hw_ctl line: %s", line);
+                continue;
+            }
+            mHwCtls.push_back(line + n);
+        } else if (!strcmp(key, "tag")) {
+            if (sscanf(line, "%*s %63s %511s", key, arg) != 2) {
+                PAL_ERR(LOG_TAG, "bad tag line: %s", line);
+                continue;
+            }
+            mTags.push_back(std::make_pair((uint32_t)strtoul(key, NULL, 0),
+                                           (uint32_t)strtoul(arg, NULL, 0)));
+        } else if (!strcmp(key, "compress_rate")) {
+            if (sscanf(line, "%*s %u", &a) != 1 || !a) {
+                PAL_ERR(LOG_TAG, "bad compress_rate line: %s", line);
+                continue;
+            }
+            mCompressRate = a;
+        } else if (!strcmp(key, "card_defs")) {
+            if (sscanf(line, "%*s %511s", arg) == 1)
+                mCardDefs = arg;
+        } else {
+            PAL_ERR(LOG_TAG, "unknown config line: %s", line);
+        }
+    }
+    fclose(fp);
+}
+
+void SimCard::loadCardDefs(const char *path)
+{
+    struct card_defs_parser p;
+    XML_Parser parser = NULL;
+    FILE *fp = NULL;
+    char buf[4096];
+    size_t len;
+
+    p.inCard = false;
+    p.cardDone = false;
+    p.inDevice = false;
+    p.virtCard = &mVirtCard;
+    p.devices = &mDevices;
+
+    fp = fopen(path, "r");
+    if (!fp) {
+        PAL_ERR(LOG_TAG, "failed to open %s, virtual card has no devices", path);
+        return;
+    }
+
+    parser = XML_ParserCreate(NULL);
+    if (!parser) {
+        PAL_ERR(LOG_TAG, "failed to create XML parser");
+        goto exit;
+    }
+    XML_SetUserData(parser, &p);
+    XML_SetElementHandler(parser, cardDefsStart, cardDefsEnd);
+    XML_SetCharacterDataHandler(parser, cardDefsData);
+
+    do {
+        len = fread(buf, 1, sizeof(buf), fp);
+        if (XML_Parse(parser, buf, (int)len, len < sizeof(buf)) == XML_STATUS_ERROR) {
+            PAL_ERR(LOG_TAG, "%s at line %lu of %s",
+                    XML_ErrorString(XML_GetErrorCode(parser)),
+                    (unsigned long)XML_GetCurrentLineNumber(parser), path);
+            break;
+        }
+    } while (len == sizeof(buf));
+
+    XML_ParserFree(parser);
+exit:
+    fclose(fp);
+}
+
+int SimCard::lookupCall(const char *call)
+{
+    for (int i = 0; i < SIM_CALL_MAX; i++) {
+        if (!strcmp(callNames[i], call))
+            return i;
+    }
+    return -1;
+}
+
+void SimCard::applyLatency(sim_call_t call)
+{
+    static thread_local std::minstd_rand rng(
+        (uint32_t)std::hash<std::thread::id>()(std::this_thread::get_id()));
+    uint32_t meanUs = mLatency[call].meanUs.load(std::memory_order_relaxed);
+    uint32_t jitterUs = mLatency[call].jitterUs.load(std::memory_order_relaxed);
+    int64_t delayUs = meanUs;
+    struct timespec ts;
+
+    if (jitterUs)
+        delayUs += (int64_t)(rng() % (2 * (uint64_t)jitterUs + 1)) - jitterUs;
+    if (delayUs <= 0)
+        return;
+
+    ts.tv_sec = delayUs / 1000000;
+    ts.tv_nsec = (delayUs % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, 0, &ts, &ts) == EINTR)
+        ;
+}
+
+void SimCard::recordCall(sim_call_t call, uint64_t durNs)
+{
+    mLatency[call].count.fetch_add(1, std::memory_order_relaxed);
+    mLatency[call].timeNs.fetch_add(durNs, std::memory_order_relaxed);
+}
+
+int SimCard::setLatency(const char *call, uint32_t meanUs, uint32_t jitterUs)
+{
+    int i = call ? lookupCall(call) : -1;
+
+    if (i < 0)
+        return -EINVAL;
+    mLatency[i].meanUs = meanUs;
+    mLatency[i].jitterUs = jitterUs;
+    return 0;
+}
+
+uint64_t SimCard::getCallCount(const char *call)
+{
+    int i = call ? lookupCall(call) : -1;
+
+    return i < 0 ? 0 : mLatency[i].count.load(std::memory_order_relaxed);
+}
+
+uint64_t SimCard::getCallTimeUs(const char *call)
+{
+    int i = call ? lookupCall(call) : -1;
+
+    return i < 0 ? 0 : mLatency[i].timeNs.load(std::memory_order_relaxed) / 1000;
+}
+
+void SimCard::resetCounters()
+{
+    for (int i = 0; i < SIM_CALL_MAX; i++) {
+        mLatency[i].count = 0;
+        mLatency[i].timeNs = 0;
+    }
+}
+
+bool SimCard::hasDevice(unsigned int card, unsigned int device, bool compress)
+{
+    if (card != mVirtCard.card)
+        return false;
+    for (auto &dev : mDevices) {
+        if (dev.id == device && dev.compress == compress)
+            return true;
+    }
+    return false;
+}
+
+struct sim_mixer_card *SimCard::findCard(unsigned int card)
+{
+    if (card == mHwCard.card)
+        return &mHwCard;
+    if (card == mVirtCard.card)
+        return &mVirtCard;
+    return NULL;
+}
+
+struct mixer_ctl *SimCard::addCtl(struct sim_mixer_card *card, const std::string &name)
+{
+    std::unique_ptr<struct mixer_ctl> ctl(new struct mixer_ctl);
+    struct mixer_ctl *ret = ctl.get();
+
+    ctl->id = (unsigned int)card->ctls.size();
+    ctl->name = name;
+    ctl->type = SIM_CTL_BYTES;
+    card->ctls.push_back(std::move(ctl));
+    card->ctlsByName.insert(std::make_pair(name, ret));
+    return ret;
+}
+
+struct mixer_ctl *SimCard::findCtl(struct sim_mixer_card *card, const std::string &name)
+{
+    auto iter = card->ctlsByName.find(name);
+
+    return iter == card->ctlsByName.end() ? NULL : iter->second;
+}
+
+struct mixer *SimCard::openMixer(unsigned int card)
+{
+    struct sim_mixer_card *c = findCard(card);
+    struct mixer *mixer = NULL;
+
+    if (!c)
+        return NULL;
+
+    mixer = new struct mixer;
+    mixer->card = c;
+    mixer->subscribed = false;
+    mixer->closed = false;
+    mixer->waiters = 0;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    c->handles.push_back(mixer);
+    return mixer;
+}
+
+void SimCard::closeMixer(struct mixer *mixer)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    auto &handles = mixer->card->handles;
+
+    for (auto iter = handles.begin(); iter != handles.end(); iter++) {
+        if (*iter == mixer) {
+            handles.erase(iter);
+            break;
+        }
+    }
+    /* a thread blocked in mixer_wait_event() frees it on its way out */
+    mixer->closed = true;
+    if (mixer->waiters) {
+        mixer->card->eventCv.notify_all();
+        return;
+    }
+    delete mixer;
+}
+
+const char *SimCard::getMixerName(struct mixer *mixer)
+{
+    return mixer->card->name.c_str();
+}
+
+unsigned int SimCard::getNumCtls(struct mixer *mixer)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return (unsigned int)mixer->card->ctls.size();
+}
+
+struct mixer_ctl *SimCard::getCtl(struct mixer *mixer, unsigned int id)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (id >= mixer->card->ctls.size())
+        return NULL;
+    return mixer->card->ctls[id].get();
+}
+
+struct mixer_ctl *SimCard::getCtlByName(struct mixer *mixer, const char *name)
+{
+    struct mixer_ctl *ctl = NULL;
+    std::string str(name);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    ctl = findCtl(mixer->card, str);
+    if (ctl || !mixer->card->isVirtual)
+        return ctl;
+
+    for (auto suffix : beCtlNames) {
+        if (endsWith(str, suffix)) {
+            PAL_DBG(LOG_TAG, "creating %s", name);
+            return addCtl(mixer->card, str);
+        }
+    }
+    return NULL;
+}
+
+void SimCard::getTaggedInfo(std::vector<uint8_t> &info)
+{
+    uint32_t numTags = (uint32_t)mTags.size();
+    struct sim_tag_entry *entry;
+
+    info.assign(sizeof(numTags) + numTags * sizeof(*entry), 0);
+    memcpy(info.data(), &numTags, sizeof(numTags));
+    entry = (struct sim_tag_entry *)(info.data() + sizeof(numTags));
+    for (auto &tag : mTags) {
+        entry->tagId = tag.first;
+        entry->numModules = 1;
+        entry->moduleId = 0;
+        entry->moduleIid = tag.second;
+        entry++;
+    }
+}
+
+unsigned int SimCard::getNumValues(struct mixer_ctl *ctl)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (ctl->type == SIM_CTL_TAGGED_INFO)
+        getTaggedInfo(ctl->bytes);
+    if (!ctl->bytes.empty())
+        return (unsigned int)ctl->bytes.size();
+    if (!ctl->values.empty())
+        return (unsigned int)ctl->values.size();
+    return SIM_CTL_DEFAULT_SIZE;
+}
+
+int SimCard::getValue(struct mixer_ctl *ctl, unsigned int id)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    return id < ctl->values.size() ? ctl->values[id] : 0;
+}
+
+int SimCard::setValue(struct mixer_ctl *ctl, unsigned int id, int value)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (id >= ctl->values.size())
+        ctl->values.resize(id + 1, 0);
+    ctl->values[id] = value;
+    return 0;
+}
+
+int SimCard::getArray(struct mixer_ctl *ctl, void *array, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!array || !count)
+        return -EINVAL;
+
+    if (ctl->type == SIM_CTL_TAGGED_INFO)
+        getTaggedInfo(ctl->bytes);
+    memset(array, 0, count);
+    memcpy(array, ctl->bytes.data(), std::min(count, ctl->bytes.size()));
+    return 0;
+}
+
+int SimCard::setArray(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!array || !count)
+        return -EINVAL;
+
+    /* the tag table is owned by the config, writes only select the type */
+    if (ctl->type == SIM_CTL_TAGGED_INFO)
+        return 0;
+    ctl->bytes.assign((const uint8_t *)array, (const uint8_t *)array + count);
+    return 0;
+}
+
+int SimCard::setEnum(struct mixer_ctl *ctl, const char *string)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!string)
+        return -EINVAL;
+    ctl->enumValue = string;
+    return 0;
+}
+
+int SimCard::subscribeEvents(struct mixer *mixer, int subscribe)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mixer->subscribed = !!subscribe;
+    if (!subscribe)
+        mixer->events.clear();
+    return 0;
+}
+
+int SimCard::waitEvent(struct mixer *mixer, int timeoutMs)
+{
+    std::unique_lock<std::mutex> lock(mLock);
+    auto ready = [mixer] { return mixer->closed || !mixer->events.empty(); };
+    int ret;
+
+    mixer->waiters++;
+    if (timeoutMs < 0)
+        mixer->card->eventCv.wait(lock, ready);
+    else
+        mixer->card->eventCv.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+    mixer->waiters--;
+
+    if (mixer->closed) {
+        if (!mixer->waiters)
+            delete mixer;
+        return -EBADF;
+    }
+    ret = mixer->events.empty() ? 0 : 1;
+    return ret;
+}
+
+int SimCard::readEvent(struct mixer *mixer, std::string &name, unsigned int &id)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    struct mixer_ctl *ctl = NULL;
+
+    if (mixer->events.empty())
+        return -EAGAIN;
+    ctl = mixer->events.front();
+    mixer->events.pop_front();
+    name = ctl->name;
+    id = ctl->id;
+    return 0;
+}
+
+int SimCard::postEvent(const char *name, const void *payload, size_t size)
+{
+    struct mixer_ctl *ctl = NULL;
+
+    if (!name || (!payload && size))
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    ctl = findCtl(&mVirtCard, name);
+    if (!ctl)
+        ctl = addCtl(&mVirtCard, name);
+    ctl->bytes.assign((const uint8_t *)payload, (const uint8_t *)payload + size);
+
+    for (auto mixer : mVirtCard.handles) {
+        if (mixer->subscribed)
+            mixer->events.push_back(ctl);
+    }
+    mVirtCard.eventCv.notify_all();
+    return 0;
+}
+
+SimCallScope::SimCallScope(sim_call_t call)
+    : mCall(call), mStartNs(SimCard::nowNs())
+{
+    SimCard::getInstance()->applyLatency(call);
+}
+
+SimCallScope::~SimCallScope()
+{
+    SimCard::getInstance()->recordCall(mCall, SimCard::nowNs() - mStartNs);
+}
+
+int pal_sim_set_latency(const char *call, uint32_t mean_us, uint32_t jitter_us)
+{
+    return SimCard::getInstance()->setLatency(call, mean_us, jitter_us);
+}
+
+uint64_t pal_sim_get_call_count(const char *call)
+{
+    return SimCard::getInstance()->getCallCount(call);
+}
+
+uint64_t pal_sim_get_call_time_us(const char *call)
+{
+    return SimCard::getInstance()->getCallTimeUs(call);
+}
+
+void pal_sim_reset_counters(void)
+{
+    SimCard::getInstance()->resetCounters();
+}
+
+int pal_sim_post_mixer_event(const char *ctl_name, const void *payload, size_t size)
+{
+    return SimCard::getInstance()->postEvent(ctl_name, payload, size);
+}
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef SIM_CARD_H
+#define SIM_CARD_H
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "pal_sim.h"
+
+/* both can be overridden with PAL_SIM_CONFIG and PAL_SIM_CARD_DEFS */
+#define SIM_CONFIG_PATH "/etc/pal_sim.conf"
+#define SIM_CARD_DEFS_PATH "/etc/card-defs.xml"
+
+/* ResourceManager picks the first card whose name has a known target in it */
+#define SIM_HW_CARD 0
+#define SIM_HW_CARD_NAME "pineapple-sim-snd-card"
+/* byte rate compress devices drain at, a 256 kbps stream */
+#define SIM_COMPRESS_RATE 32000
+/* size reported for a byte control nothing was written to yet */
+#define SIM_CTL_DEFAULT_SIZE 1024
+
+/* order is the index of the call in the latency and counter tables */
+typedef enum {
+    SIM_CALL_PCM_OPEN,
+    SIM_CALL_PCM_CLOSE,
+    SIM_CALL_PCM_PREPARE,
+    SIM_CALL_PCM_START,
+    SIM_CALL_PCM_STOP,
+    SIM_CALL_PCM_WRITE,
+    SIM_CALL_PCM_READ,
+    SIM_CALL_MIXER_OPEN,
+    SIM_CALL_MIXER_GET_CTL,
+    SIM_CALL_MIXER_CTL_SET,
+    SIM_CALL_MIXER_CTL_GET,
+    SIM_CALL_COMPRESS_OPEN,
+    SIM_CALL_COMPRESS_CLOSE,
+    SIM_CALL_COMPRESS_START,
+    SIM_CALL_COMPRESS_STOP,
+    SIM_CALL_COMPRESS_WRITE,
+    SIM_CALL_COMPRESS_READ,
+    SIM_CALL_AGM_SESSION_OPEN,
+    SIM_CALL_AGM_SESSION_CLOSE,
+    SIM_CALL_AGM_SESSION_PREPARE,
+    SIM_CALL_AGM_SESSION_START,
+    SIM_CALL_AGM_SESSION_STOP,
+    SIM_CALL_AGM_SESSION_SET,
+    SIM_CALL_AGM_SESSION_WRITE,
+    SIM_CALL_AGM_SESSION_READ,
+    SIM_CALL_AUDIO_ROUTE_APPLY,
+    SIM_CALL_AUDIO_ROUTE_RESET,
+    SIM_CALL_MAX,
+} sim_call_t;
+
+typedef enum {
+    SIM_CTL_BYTES,
+    /* answers reads with the tag to MIID table of pal_sim.conf */
+    SIM_CTL_TAGGED_INFO,
+} sim_ctl_type_t;
+
+struct mixer_ctl {
+    unsigned int id;
+    std::string name;
+    sim_ctl_type_t type;
+    std::vector<uint8_t> bytes;
+    std::vector<int> values;
+    std::string enumValue;
+};
+
+struct sim_mixer_card;
+
+/* one mixer_open(), controls are shared by all handles of a card */
+struct mixer {
+    struct sim_mixer_card *card;
+    bool subscribed;
+    bool closed;
+    int waiters;
+    std::deque<struct mixer_ctl *> events;
+};
+
+struct sim_mixer_card {
+    unsigned int card;
+    std::string name;
+    bool isVirtual;
+    /* controls never move once created, MixerCtlCache keeps pointers */
+    std::vector<std::unique_ptr<struct mixer_ctl>> ctls;
+    std::map<std::string, struct mixer_ctl *> ctlsByName;
+    std::vector<struct mixer *> handles;
+    std::condition_variable eventCv;
+};
+
+struct sim_device {
+    unsigned int id;
+    std::string name;
+    bool compress;
+};
+
+/*
+ * Position of a device running at a fixed rate, in frames for PCM and
+ * bytes for compress. Not thread safe, callers hold their device lock.
+ */
+class SimClock
+{
+public:
+    SimClock() : mRate(0), mRunning(false), mBasePos(0), mBaseNs(0) {}
+
+    void setRate(uint64_t rate) { mRate = rate; }
+    bool isRunning() const { return mRunning; }
+
+    void reset()
+    {
+        mBasePos = 0;
+        mRunning = false;
+    }
+
+    void start(uint64_t pos, uint64_t nowNs)
+    {
+        mBasePos = pos;
+        mBaseNs = nowNs;
+        mRunning = true;
+    }
+
+    void stop(uint64_t nowNs)
+    {
+        mBasePos = position(nowNs);
+        mRunning = false;
+    }
+
+    uint64_t position(uint64_t nowNs) const
+    {
+        if (!mRunning || nowNs <= mBaseNs)
+            return mBasePos;
+        return mBasePos + (nowNs - mBaseNs) * mRate / 1000000000ULL;
+    }
+
+    /* time the position reaches pos, 0 if it never will */
+    uint64_t timeOf(uint64_t pos) const
+    {
+        if (!mRunning || !mRate)
+            return 0;
+        if (pos <= mBasePos)
+            return mBaseNs;
+        return mBaseNs + ((pos - mBasePos) * 1000000000ULL + mRate - 1) / mRate;
+    }
+
+private:
+    uint64_t mRate;
+    bool mRunning;
+    uint64_t mBasePos;
+    uint64_t mBaseNs;
+};
+
+/*
+ * In process stand-in for the sound card PAL drives through tinyalsa,
+ * tinycompress and AGM. The virtual card and its PCM and compress
+ * devices come from card-defs.xml, every call goes through a latency
+ * model read from pal_sim.conf:
+ *
+ *   latency <call> <mean_us> [jitter_us]
+ *   hw_card <number> <name>
+ *   hw_ctl <name>
+ *   tag <tag_id> <module_iid>
+ *   compress_rate <bytes per second>
+ *   card_defs <path>
+ */
+class SimCard
+{
+public:
+    static SimCard *getInstance();
+    static uint64_t nowNs();
+    static const char *getCallName(sim_call_t call);
+
+    /* sleeps for the modelled cost of a call */
+    void applyLatency(sim_call_t call);
+    void recordCall(sim_call_t call, uint64_t durNs);
+    int setLatency(const char *call, uint32_t meanUs, uint32_t jitterUs);
+    uint64_t getCallCount(const char *call);
+    uint64_t getCallTimeUs(const char *call);
+    void resetCounters();
+
+    bool hasDevice(unsigned int card, unsigned int device, bool compress);
+    /* tag to MIID table in the layout of gsl_tag_module_info */
+    void getTaggedInfo(std::vector<uint8_t> &info);
+    uint64_t getCompressRate() const { return mCompressRate; }
+
+    struct mixer *openMixer(unsigned int card);
+    void closeMixer(struct mixer *mixer);
+    const char *getMixerName(struct mixer *mixer);
+    unsigned int getNumCtls(struct mixer *mixer);
+    struct mixer_ctl *getCtl(struct mixer *mixer, unsigned int id);
+    struct mixer_ctl *getCtlByName(struct mixer *mixer, const char *name);
+
+    unsigned int getNumValues(struct mixer_ctl *ctl);
+    int getValue(struct mixer_ctl *ctl, unsigned int id);
+    int setValue(struct mixer_ctl *ctl, unsigned int id, int value);
+    int getArray(struct mixer_ctl *ctl, void *array, size_t count);
+    int setArray(struct mixer_ctl *ctl, const void *array, size_t count);
+    int setEnum(struct mixer_ctl *ctl, const char *string);
+
+    int subscribeEvents(struct mixer *mixer, int subscribe);
+    int waitEvent(struct mixer *mixer, int timeoutMs);
+    /* name and index of the oldest pending event, -EAGAIN if none */
+    int readEvent(struct mixer *mixer, std::string &name, unsigned int &id);
+    int postEvent(const char *name, const void *payload, size_t size);
+
+private:
+    struct latency_model {
+        std::atomic<uint32_t> meanUs;
+        std::atomic<uint32_t> jitterUs;
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> timeNs;
+    };
+
+    SimCard();
+    void loadConfig(const char *path);
+    void loadCardDefs(const char *path);
+    int lookupCall(const char *call);
+    struct mixer_ctl *addCtl(struct sim_mixer_card *card, const std::string &name);
+    struct mixer_ctl *findCtl(struct sim_mixer_card *card, const std::string &name);
+    struct sim_mixer_card *findCard(unsigned int card);
+
+    std::mutex mLock;
+    struct latency_model mLatency[SIM_CALL_MAX];
+    struct sim_mixer_card mHwCard;
+    struct sim_mixer_card mVirtCard;
+    std::vector<struct sim_device> mDevices;
+    std::vector<std::string> mHwCtls;
+    std::vector<std::pair<uint32_t, uint32_t>> mTags;
+    uint64_t mCompressRate;
+    std::string mCardDefs;
+};
+
+/* applies the latency model of a call and accounts its full duration */
+class SimCallScope
+{
+public:
+    explicit SimCallScope(sim_call_t call);
+    ~SimCallScope();
+
+private:
+    sim_call_t mCall;
+    uint64_t mStartNs;
+};
+
+#endif /* SIM_CARD_H */
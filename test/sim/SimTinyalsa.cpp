@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SimTinyalsa"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <algorithm>
+#include <chrono>
+#include <sound/asound.h>
+#include <tinyalsa/asoundlib.h>
+#include "SimCard.h"
+#include "PalCommon.h"
+
+#define SIM_PCM_ERROR_MAX 128
+
+#define SIM_PCM_DEFAULT_CHANNELS 2
+#define SIM_PCM_DEFAULT_RATE 48000
+#define SIM_PCM_DEFAULT_PERIOD_SIZE 1024
+#define SIM_PCM_DEFAULT_PERIOD_COUNT 2
+
+/*
+ * A PCM device moves one period at a time on its own clock. Playback
+ * starts consuming with the first write and underruns when the writer
+ * falls behind, capture starts producing silence with the first read
+ * and overruns when the reader does; both count as xruns.
+ */
+struct pcm {
+    unsigned int card;
+    unsigned int device;
+    unsigned int flags;
+    struct pcm_config config;
+    bool ready;
+    bool prepared;
+    bool running;
+    char error[SIM_PCM_ERROR_MAX];
+    int pollFd;
+    int xruns;
+    /* frames written or read since prepare */
+    uint64_t applPtr;
+    SimClock clock;
+    std::vector<uint8_t> mmapBuf;
+    /* bumped on stop and prepare to release blocked transfers */
+    uint32_t generation;
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+static int oops(struct pcm *pcm, int e, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(pcm->error, sizeof(pcm->error), fmt, ap);
+    va_end(ap);
+    PAL_ERR(LOG_TAG, "pcm %u,%u: %s", pcm->card, pcm->device, pcm->error);
+    errno = e;
+    return -e;
+}
+
+static uint64_t bufferFrames(const struct pcm *pcm)
+{
+    return (uint64_t)pcm->config.period_size * pcm->config.period_count;
+}
+
+static uint64_t roundUpToPeriod(const struct pcm *pcm, uint64_t frames)
+{
+    uint64_t period = pcm->config.period_size;
+
+    return (frames + period - 1) / period * period;
+}
+
+/* waits for the device clock to reach pos, fails if the PCM is stopped meanwhile */
+static int waitForPosition(struct pcm *pcm, std::unique_lock<std::mutex> &lock, uint64_t pos)
+{
+    uint32_t generation = pcm->generation;
+    std::chrono::steady_clock::time_point deadline(
+        std::chrono::nanoseconds(pcm->clock.timeOf(pos)));
+
+    pcm->cv.wait_until(lock, deadline, [pcm, generation] {
+        return pcm->generation != generation;
+    });
+    if (pcm->generation != generation)
+        return oops(pcm, EBADFD, "stopped while waiting for the device");
+    return 0;
+}
+
+static int doPrepare(struct pcm *pcm)
+{
+    pcm->applPtr = 0;
+    pcm->clock.reset();
+    pcm->running = false;
+    pcm->prepared = true;
+    pcm->generation++;
+    pcm->cv.notify_all();
+    return 0;
+}
+
+static int doWrite(struct pcm *pcm, unsigned int frames)
+{
+    std::unique_lock<std::mutex> lock(pcm->lock);
+    uint64_t remaining = frames;
+    uint64_t chunk, hwPtr, now;
+    int ret;
+
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    if (!pcm->prepared)
+        doPrepare(pcm);
+    pcm->running = true;
+
+    while (remaining) {
+        now = SimCard::nowNs();
+        if (!pcm->clock.isRunning()) {
+            pcm->clock.start(pcm->applPtr, now);
+        } else {
+            hwPtr = pcm->clock.position(now);
+            if (hwPtr > pcm->applPtr) {
+                pcm->xruns++;
+                PAL_DBG(LOG_TAG, "pcm %u,%u underrun by %llu frames", pcm->card,
+                        pcm->device, (unsigned long long)(hwPtr - pcm->applPtr));
+                pcm->clock.start(pcm->applPtr, now);
+            }
+        }
+
+        chunk = std::min(remaining, bufferFrames(pcm));
+        if (pcm->applPtr + chunk > bufferFrames(pcm)) {
+            ret = waitForPosition(pcm, lock,
+                                  roundUpToPeriod(pcm, pcm->applPtr + chunk - bufferFrames(pcm)));
+            if (ret)
+                return ret;
+        }
+        pcm->applPtr += chunk;
+        remaining -= chunk;
+    }
+    return 0;
+}
+
+static int doRead(struct pcm *pcm, void *data, unsigned int frames)
+{
+    std::unique_lock<std::mutex> lock(pcm->lock);
+    uint64_t remaining = frames;
+    uint64_t chunk, hwPtr, now;
+    int ret;
+
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    if (!pcm->prepared)
+        doPrepare(pcm);
+    pcm->running = true;
+
+    now = SimCard::nowNs();
+    if (!pcm->clock.isRunning()) {
+        pcm->clock.start(pcm->applPtr, now);
+    } else {
+        hwPtr = pcm->clock.position(now);
+        if (hwPtr > pcm->applPtr + bufferFrames(pcm)) {
+            pcm->xruns++;
+            PAL_DBG(LOG_TAG, "pcm %u,%u overrun by %llu frames", pcm->card, pcm->device,
+                    (unsigned long long)(hwPtr - pcm->applPtr - bufferFrames(pcm)));
+            pcm->applPtr = hwPtr - hwPtr % pcm->config.period_size;
+        }
+    }
+
+    while (remaining) {
+        chunk = std::min(remaining, bufferFrames(pcm));
+        ret = waitForPosition(pcm, lock, roundUpToPeriod(pcm, pcm->applPtr + chunk));
+        if (ret)
+            return ret;
+        pcm->applPtr += chunk;
+        remaining -= chunk;
+    }
+    memset(data, 0, pcm_frames_to_bytes(pcm, frames));
+    return 0;
+}
+
+struct pcm *pcm_open(unsigned int card, unsigned int device, unsigned int flags,
+                     const struct pcm_config *config)
+{
+    SimCallScope call(SIM_CALL_PCM_OPEN);
+    struct pcm *pcm = new struct pcm();
+
+    pcm->card = card;
+    pcm->device = device;
+    pcm->flags = flags;
+    pcm->pollFd = -1;
+    if (config) {
+        pcm->config = *config;
+    } else {
+        pcm->config.channels = SIM_PCM_DEFAULT_CHANNELS;
+        pcm->config.rate = SIM_PCM_DEFAULT_RATE;
+        pcm->config.period_size = SIM_PCM_DEFAULT_PERIOD_SIZE;
+        pcm->config.period_count = SIM_PCM_DEFAULT_PERIOD_COUNT;
+        pcm->config.format = PCM_FORMAT_S16_LE;
+    }
+
+    /* like tinyalsa, a failed open still returns an object to read the error from */
+    if (!SimCard::getInstance()->hasDevice(card, device, false)) {
+        oops(pcm, ENODEV, "no pcm device %u on card %u", device, card);
+        return pcm;
+    }
+    if (!pcm->config.rate || !pcm->config.channels || !pcm->config.period_size ||
+        !pcm->config.period_count) {
+        oops(pcm, EINVAL, "invalid config %u ch %u Hz %u x %u", pcm->config.channels,
+             pcm->config.rate, pcm->config.period_count, pcm->config.period_size);
+        return pcm;
+    }
+
+    pcm->pollFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    pcm->clock.setRate(pcm->config.rate);
+    pcm->ready = true;
+    PAL_DBG(LOG_TAG, "pcm %u,%u %s opened, %u ch %u Hz %u x %u", card, device,
+            (flags & PCM_IN) ? "capture" : "playback", pcm->config.channels,
+            pcm->config.rate, pcm->config.period_count, pcm->config.period_size);
+    return pcm;
+}
+
+int pcm_close(struct pcm *pcm)
+{
+    SimCallScope call(SIM_CALL_PCM_CLOSE);
+
+    if (!pcm)
+        return 0;
+    if (pcm->pollFd >= 0)
+        close(pcm->pollFd);
+    delete pcm;
+    return 0;
+}
+
+int pcm_is_ready(const struct pcm *pcm)
+{
+    return pcm && pcm->ready;
+}
+
+int pcm_prepare(struct pcm *pcm)
+{
+    SimCallScope call(SIM_CALL_PCM_PREPARE);
+
+    if (!pcm)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    if (pcm->prepared && !pcm->running)
+        return 0;
+    return doPrepare(pcm);
+}
+
+int pcm_start(struct pcm *pcm)
+{
+    SimCallScope call(SIM_CALL_PCM_START);
+
+    if (!pcm)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    if (!pcm->prepared)
+        doPrepare(pcm);
+    pcm->running = true;
+    /* playback clock starts with the first write, the buffer is empty until then */
+    if ((pcm->flags & PCM_IN) || pcm->applPtr)
+        pcm->clock.start(pcm->applPtr, SimCard::nowNs());
+    return 0;
+}
+
+int pcm_stop(struct pcm *pcm)
+{
+    SimCallScope call(SIM_CALL_PCM_STOP);
+
+    if (!pcm)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    pcm->clock.stop(SimCard::nowNs());
+    pcm->running = false;
+    pcm->prepared = false;
+    pcm->generation++;
+    pcm->cv.notify_all();
+    return 0;
+}
+
+int pcm_write(struct pcm *pcm, const void *data, unsigned int count)
+{
+    SimCallScope call(SIM_CALL_PCM_WRITE);
+
+    if (!pcm || !data)
+        return -EINVAL;
+    if (pcm->flags & PCM_IN)
+        return -EINVAL;
+    return doWrite(pcm, count / pcm_frames_to_bytes(pcm, 1));
+}
+
+int pcm_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    SimCallScope call(SIM_CALL_PCM_READ);
+
+    if (!pcm || !data)
+        return -EINVAL;
+    if (!(pcm->flags & PCM_IN))
+        return -EINVAL;
+    return doRead(pcm, data, count / pcm_frames_to_bytes(pcm, 1));
+}
+
+int pcm_mmap_write(struct pcm *pcm, const void *data, unsigned int count)
+{
+    return pcm_write(pcm, data, count);
+}
+
+int pcm_mmap_read(struct pcm *pcm, void *data, unsigned int count)
+{
+    return pcm_read(pcm, data, count);
+}
+
+int pcm_mmap_begin(struct pcm *pcm, void **areas, unsigned int *offset, unsigned int *frames)
+{
+    uint64_t off;
+
+    if (!pcm || !areas || !offset || !frames)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    if (pcm->mmapBuf.empty())
+        pcm->mmapBuf.assign(pcm_frames_to_bytes(pcm, (unsigned int)bufferFrames(pcm)), 0);
+
+    off = pcm->applPtr % bufferFrames(pcm);
+    *areas = pcm->mmapBuf.data();
+    *offset = (unsigned int)off;
+    *frames = (unsigned int)std::min((uint64_t)*frames, bufferFrames(pcm) - off);
+    return 0;
+}
+
+int pcm_mmap_commit(struct pcm *pcm, unsigned int offset __unused, unsigned int frames)
+{
+    if (!pcm)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    pcm->applPtr += frames;
+    return (int)frames;
+}
+
+int pcm_mmap_get_hw_ptr(struct pcm *pcm, unsigned int *hw_ptr, struct timespec *tstamp)
+{
+    uint64_t now = SimCard::nowNs();
+
+    if (!pcm || !hw_ptr || !tstamp)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    *hw_ptr = (unsigned int)pcm->clock.position(now);
+    tstamp->tv_sec = now / 1000000000ULL;
+    tstamp->tv_nsec = now % 1000000000ULL;
+    return 0;
+}
+
+int pcm_ioctl(struct pcm *pcm, int request, ...)
+{
+    if (!pcm)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(pcm->lock);
+    if (!pcm->ready)
+        return oops(pcm, EBADFD, "pcm not ready");
+    /* a reset drops whatever is queued, the device continues from the writer */
+    if ((unsigned int)request == SNDRV_PCM_IOCTL_RESET && pcm->clock.isRunning())
+        pcm->clock.start(pcm->applPtr, SimCard::nowNs());
+    return 0;
+}
+
+int pcm_get_poll_fd(struct pcm *pcm)
+{
+    return pcm ? pcm->pollFd : -1;
+}
+
+unsigned int pcm_get_buffer_size(const struct pcm *pcm)
+{
+    return pcm ? (unsigned int)bufferFrames(pcm) : 0;
+}
+
+unsigned int pcm_format_to_bits(enum pcm_format format)
+{
+    switch (format) {
+    case PCM_FORMAT_S8:
+        return 8;
+    case PCM_FORMAT_S24_3LE:
+        return 24;
+    case PCM_FORMAT_S24_LE:
+    case PCM_FORMAT_S32_LE:
+        return 32;
+    case PCM_FORMAT_S16_LE:
+    default:
+        return 16;
+    }
+}
+
+unsigned int pcm_frames_to_bytes(const struct pcm *pcm, unsigned int frames)
+{
+    if (!pcm)
+        return 0;
+    return frames * pcm->config.channels * (pcm_format_to_bits(pcm->config.format) >> 3);
+}
+
+int pcm_get_xruns(const struct pcm *pcm)
+{
+    return pcm ? pcm->xruns : 0;
+}
+
+const char *pcm_get_error(const struct pcm *pcm)
+{
+    return pcm ? pcm->error : "no pcm";
+}
+
+struct mixer *mixer_open(unsigned int card)
+{
+    SimCallScope call(SIM_CALL_MIXER_OPEN);
+
+    return SimCard::getInstance()->openMixer(card);
+}
+
+void mixer_close(struct mixer *mixer)
+{
+    if (mixer)
+        SimCard::getInstance()->closeMixer(mixer);
+}
+
+const char *mixer_get_name(const struct mixer *mixer)
+{
+    return mixer ? SimCard::getInstance()->getMixerName(const_cast<struct mixer *>(mixer)) : NULL;
+}
+
+unsigned int mixer_get_num_ctls(const struct mixer *mixer)
+{
+    return mixer ? SimCard::getInstance()->getNumCtls(const_cast<struct mixer *>(mixer)) : 0;
+}
+
+struct mixer_ctl *mixer_get_ctl(struct mixer *mixer, unsigned int id)
+{
+    return mixer ? SimCard::getInstance()->getCtl(mixer, id) : NULL;
+}
+
+struct mixer_ctl *mixer_get_ctl_by_name(struct mixer *mixer, const char *name)
+{
+    SimCallScope call(SIM_CALL_MIXER_GET_CTL);
+
+    if (!mixer || !name)
+        return NULL;
+    return SimCard::getInstance()->getCtlByName(mixer, name);
+}
+
+const char *mixer_ctl_get_name(const struct mixer_ctl *ctl)
+{
+    return ctl ? ctl->name.c_str() : NULL;
+}
+
+unsigned int mixer_ctl_get_num_values(const struct mixer_ctl *ctl)
+{
+    if (!ctl)
+        return 0;
+    return SimCard::getInstance()->getNumValues(const_cast<struct mixer_ctl *>(ctl));
+}
+
+int mixer_ctl_get_value(const struct mixer_ctl *ctl, unsigned int id)
+{
+    SimCallScope call(SIM_CALL_MIXER_CTL_GET);
+
+    if (!ctl)
+        return -EINVAL;
+    return SimCard::getInstance()->getValue(const_cast<struct mixer_ctl *>(ctl), id);
+}
+
+int mixer_ctl_set_value(struct mixer_ctl *ctl, unsigned int id, int value)
+{
+    SimCallScope call(SIM_CALL_MIXER_CTL_SET);
+
+    if (!ctl)
+        return -EINVAL;
+    return SimCard::getInstance()->setValue(ctl, id, value);
+}
+
+int mixer_ctl_get_array(const struct mixer_ctl *ctl, void *array, size_t count)
+{
+    SimCallScope call(SIM_CALL_MIXER_CTL_GET);
+
+    if (!ctl)
+        return -EINVAL;
+    return SimCard::getInstance()->getArray(const_cast<struct mixer_ctl *>(ctl), array, count);
+}
+
+int mixer_ctl_set_array(struct mixer_ctl *ctl, const void *array, size_t count)
+{
+    SimCallScope call(SIM_CALL_MIXER_CTL_SET);
+
+    if (!ctl)
+        return -EINVAL;
+    return SimCard::getInstance()->setArray(ctl, array, count);
+}
+
+int mixer_ctl_set_enum_by_string(struct mixer_ctl *ctl, const char *string)
+{
+    SimCallScope call(SIM_CALL_MIXER_CTL_SET);
+
+    if (!ctl)
+        return -EINVAL;
+    return SimCard::getInstance()->setEnum(ctl, string);
+}
+
+void mixer_ctl_update(struct mixer_ctl *ctl __unused)
+{
+}
+
+int mixer_subscribe_events(struct mixer *mixer, int subscribe)
+{
+    if (!mixer)
+        return -EINVAL;
+    return SimCard::getInstance()->subscribeEvents(mixer, subscribe);
+}
+
+int mixer_wait_event(struct mixer *mixer, int timeout)
+{
+    if (!mixer)
+        return -EINVAL;
+    return SimCard::getInstance()->waitEvent(mixer, timeout);
+}
+
+int mixer_read_event(struct mixer *mixer, struct ctl_event *ev)
+{
+    std::string name;
+    unsigned int id = 0;
+    int ret;
+
+    if (!mixer || !ev)
+        return -EINVAL;
+
+    ret = SimCard::getInstance()->readEvent(mixer, name, id);
+    if (ret)
+        return ret;
+
+    memset(ev, 0, sizeof(*ev));
+    ev->type = SNDRV_CTL_EVENT_ELEM;
+    ev->data.elem.mask = SNDRV_CTL_EVENT_MASK_VALUE;
+    ev->data.elem.id.numid = id + 1;
+    snprintf((char *)ev->data.elem.id.name, sizeof(ev->data.elem.id.name), "%s", name.c_str());
+    return 0;
+}
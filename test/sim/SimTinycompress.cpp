@@ -0,0 +1,391 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: SimTinycompress"
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <sound/compress_params.h>
+#include <tinycompress/tinycompress.h>
+#include "SimCard.h"
+#include "PalCommon.h"
+
+#define SIM_COMPRESS_ERROR_MAX 128
+
+/*
+ * A compress device drains its buffer at the byte rate of pal_sim.conf
+ * while started, capture fills it at the same rate. A starved playback
+ * device stalls instead of counting an xrun, as the DSP does.
+ */
+struct compress {
+    unsigned int card;
+    unsigned int device;
+    unsigned int flags;
+    struct compr_config config;
+    struct snd_codec codec;
+    bool ready;
+    bool nonblock;
+    bool running;
+    char error[SIM_COMPRESS_ERROR_MAX];
+    /* bytes queued by the client, written for playback and read for capture */
+    uint64_t appPos;
+    /* bytes the device consumed or produced */
+    SimClock clock;
+    uint32_t generation;
+    std::mutex lock;
+    std::condition_variable cv;
+};
+
+typedef std::chrono::steady_clock::time_point sim_time_t;
+
+static int oops(struct compress *compress, int e, const char *fmt, ...)
+{
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(compress->error, sizeof(compress->error), fmt, ap);
+    va_end(ap);
+    PAL_ERR(LOG_TAG, "compress %u,%u: %s", compress->card, compress->device, compress->error);
+    errno = e;
+    return -e;
+}
+
+static bool isPlayback(const struct compress *compress)
+{
+    return compress->flags & COMPRESS_IN;
+}
+
+static uint64_t bufferBytes(const struct compress *compress)
+{
+    return (uint64_t)compress->config.fragment_size * compress->config.fragments;
+}
+
+static sim_time_t toTime(uint64_t ns)
+{
+    return sim_time_t(std::chrono::nanoseconds(ns));
+}
+
+/* a playback device that ran out of data stalls at the last byte written */
+static uint64_t devicePos(struct compress *compress, uint64_t now)
+{
+    uint64_t pos = compress->clock.position(now);
+
+    if (isPlayback(compress) && pos > compress->appPos) {
+        compress->clock.start(compress->appPos, now);
+        pos = compress->appPos;
+    }
+    return pos;
+}
+
+/* bytes the client can transfer without blocking */
+static uint64_t available(struct compress *compress, uint64_t now)
+{
+    uint64_t pos = devicePos(compress, now);
+
+    if (isPlayback(compress))
+        return bufferBytes(compress) - (compress->appPos - pos);
+
+    if (pos - compress->appPos > bufferBytes(compress)) {
+        PAL_DBG(LOG_TAG, "compress %u,%u overrun", compress->card, compress->device);
+        compress->appPos = pos - bufferBytes(compress);
+    }
+    return pos - compress->appPos;
+}
+
+/*
+ * Waits until at least want bytes are available, the stream is stopped
+ * or timeoutMs passes. A stream that is not running wakes on start.
+ */
+static int waitAvailable(struct compress *compress, std::unique_lock<std::mutex> &lock,
+                         uint64_t want, int timeoutMs)
+{
+    uint32_t generation = compress->generation;
+    sim_time_t end = sim_time_t::max();
+    sim_time_t deadline;
+    uint64_t now = SimCard::nowNs();
+    uint64_t avail;
+
+    if (timeoutMs >= 0)
+        end = toTime(now + timeoutMs * 1000000ULL);
+
+    while (1) {
+        now = SimCard::nowNs();
+        if (compress->generation != generation)
+            return oops(compress, EBADFD, "stopped while waiting for the device");
+
+        avail = available(compress, now);
+        if (avail >= want)
+            return 0;
+        if (toTime(now) >= end)
+            return -ETIME;
+
+        deadline = end;
+        if (compress->clock.isRunning()) {
+            if (isPlayback(compress))
+                deadline = std::min(deadline, toTime(compress->clock.timeOf(
+                                    compress->clock.position(now) + want - avail)));
+            else
+                deadline = std::min(deadline, toTime(compress->clock.timeOf(
+                                    compress->appPos + want)));
+        }
+        compress->cv.wait_until(lock, deadline);
+    }
+}
+
+struct compress *compress_open(unsigned int card, unsigned int device, unsigned int flags,
+                               struct compr_config *config)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_OPEN);
+    struct compress *compress = new struct compress();
+
+    compress->card = card;
+    compress->device = device;
+    compress->flags = flags;
+    compress->clock.setRate(SimCard::getInstance()->getCompressRate());
+
+    if (!config || !config->fragment_size || !config->fragments) {
+        oops(compress, EINVAL, "invalid config");
+        return compress;
+    }
+    compress->config = *config;
+    if (config->codec)
+        compress->codec = *config->codec;
+    compress->config.codec = &compress->codec;
+
+    if (!SimCard::getInstance()->hasDevice(card, device, true)) {
+        oops(compress, ENODEV, "no compress device %u on card %u", device, card);
+        return compress;
+    }
+
+    compress->ready = true;
+    PAL_DBG(LOG_TAG, "compress %u,%u %s opened, %u x %u", card, device,
+            isPlayback(compress) ? "playback" : "capture", config->fragments,
+            config->fragment_size);
+    return compress;
+}
+
+void compress_close(struct compress *compress)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_CLOSE);
+
+    delete compress;
+}
+
+int is_compress_ready(struct compress *compress)
+{
+    return compress && compress->ready;
+}
+
+const char *compress_get_error(struct compress *compress)
+{
+    return compress ? compress->error : "no compress";
+}
+
+void compress_nonblock(struct compress *compress, int nonblock)
+{
+    if (!compress)
+        return;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    compress->nonblock = !!nonblock;
+}
+
+int compress_set_codec_params(struct compress *compress, struct snd_codec *codec)
+{
+    if (!compress || !codec)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    compress->codec = *codec;
+    return 0;
+}
+
+int compress_set_gapless_metadata(struct compress *compress,
+                                  struct compr_gapless_mdata *mdata)
+{
+    if (!compress || !mdata)
+        return -EINVAL;
+    return 0;
+}
+
+int compress_write(struct compress *compress, const void *buf, unsigned int size)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_WRITE);
+    uint64_t written = 0;
+    uint64_t chunk;
+    int ret;
+
+    if (!compress || !buf)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    if (!compress->ready || !isPlayback(compress))
+        return oops(compress, EBADFD, "not a ready playback stream");
+
+    while (written < size) {
+        chunk = std::min((uint64_t)size - written, available(compress, SimCard::nowNs()));
+        if (!chunk) {
+            /* a stream that is not started would never make room */
+            if (compress->nonblock || !compress->running)
+                break;
+            ret = waitAvailable(compress, lock,
+                                std::min((uint64_t)size - written,
+                                         (uint64_t)compress->config.fragment_size), -1);
+            if (ret)
+                return written ? (int)written : ret;
+            continue;
+        }
+        compress->appPos += chunk;
+        written += chunk;
+    }
+    return (int)written;
+}
+
+int compress_read(struct compress *compress, void *buf, unsigned int size)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_READ);
+    uint64_t chunk;
+    int ret;
+
+    if (!compress || !buf)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    if (!compress->ready || isPlayback(compress))
+        return oops(compress, EBADFD, "not a ready capture stream");
+
+    if (!compress->nonblock) {
+        ret = waitAvailable(compress, lock, size, -1);
+        if (ret)
+            return ret;
+    }
+    chunk = std::min((uint64_t)size, available(compress, SimCard::nowNs()));
+    compress->appPos += chunk;
+    memset(buf, 0, chunk);
+    return (int)chunk;
+}
+
+int compress_start(struct compress *compress)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_START);
+    uint64_t now = SimCard::nowNs();
+
+    if (!compress)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!compress->ready)
+        return oops(compress, EBADFD, "compress not ready");
+    compress->running = true;
+    compress->clock.start(compress->clock.position(now), now);
+    compress->cv.notify_all();
+    return 0;
+}
+
+int compress_stop(struct compress *compress)
+{
+    SimCallScope call(SIM_CALL_COMPRESS_STOP);
+
+    if (!compress)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!compress->ready)
+        return oops(compress, EBADFD, "compress not ready");
+    compress->running = false;
+    compress->clock.reset();
+    compress->appPos = 0;
+    compress->generation++;
+    compress->cv.notify_all();
+    return 0;
+}
+
+int compress_pause(struct compress *compress)
+{
+    uint64_t now = SimCard::nowNs();
+
+    if (!compress)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!compress->ready || !compress->running)
+        return oops(compress, EBADFD, "compress not running");
+    devicePos(compress, now);
+    compress->clock.stop(now);
+    return 0;
+}
+
+int compress_resume(struct compress *compress)
+{
+    uint64_t now = SimCard::nowNs();
+
+    if (!compress)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!compress->ready || !compress->running)
+        return oops(compress, EBADFD, "compress not running");
+    compress->clock.start(compress->clock.position(now), now);
+    compress->cv.notify_all();
+    return 0;
+}
+
+int compress_drain(struct compress *compress)
+{
+    if (!compress)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    if (!compress->ready || !compress->running)
+        return oops(compress, EBADFD, "compress not running");
+    return waitAvailable(compress, lock, bufferBytes(compress), -1);
+}
+
+int compress_partial_drain(struct compress *compress)
+{
+    return compress_drain(compress);
+}
+
+int compress_next_track(struct compress *compress)
+{
+    if (!compress)
+        return -EINVAL;
+    return 0;
+}
+
+int compress_wait(struct compress *compress, int timeout_ms)
+{
+    if (!compress)
+        return -EINVAL;
+
+    std::unique_lock<std::mutex> lock(compress->lock);
+    if (!compress->ready)
+        return oops(compress, EBADFD, "compress not ready");
+    return waitAvailable(compress, lock, compress->config.fragment_size, timeout_ms);
+}
+
+int compress_get_hpointer(struct compress *compress, unsigned int *avail,
+                          struct timespec *tstamp)
+{
+    uint64_t now = SimCard::nowNs();
+    uint64_t rate = SimCard::getInstance()->getCompressRate();
+    uint64_t pos;
+
+    if (!compress || !avail || !tstamp)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(compress->lock);
+    if (!compress->ready)
+        return oops(compress, EBADFD, "compress not ready");
+    *avail = (unsigned int)available(compress, now);
+    pos = devicePos(compress, now);
+    tstamp->tv_sec = pos / rate;
+    tstamp->tv_nsec = (pos % rate) * 1000000000ULL / rate;
+    return 0;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAL_SIM_H
+#define PAL_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Control interface of the simulated sound card that libpalsim provides
+ * in place of tinyalsa, tinycompress, audioroute and AGM. Call names are
+ * the ones of the latency lines in pal_sim.conf, e.g. "pcm_open".
+ */
+
+/* overrides the latency model of one call, mean and uniform jitter in us */
+int pal_sim_set_latency(const char *call, uint32_t mean_us, uint32_t jitter_us);
+
+/* number of times a call was made and time spent in it since the last reset */
+uint64_t pal_sim_get_call_count(const char *call);
+uint64_t pal_sim_get_call_time_us(const char *call);
+void pal_sim_reset_counters(void);
+
+/*
+ * Stores payload in the named control of the virtual card and wakes
+ * every mixer subscribed to events, as a DSP module event would.
+ */
+int pal_sim_post_mixer_event(const char *ctl_name, const void *payload, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PAL_SIM_H */
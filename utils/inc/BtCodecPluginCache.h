@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef BT_CODEC_PLUGIN_CACHE_H
+#define BT_CODEC_PLUGIN_CACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <bt_intf.h>
+
+/*
+ * Process wide registry of the BT codec plugins of btCodecMap. Each
+ * library is dlopened once, ahead of time by prewarm() or on first use,
+ * and stays loaded with plugin_open resolved.
+ *
+ * getCodec() hands out an opened codec together with the payload it
+ * populated for codecInfo. A released codec is kept with its payload, one
+ * per library, format and direction, and is handed out again as long as
+ * the BT stack reports the same config, so an unchanged reconnect or a2dp
+ * resume neither reopens the plugin nor repacks the payload. Configs
+ * without a known layout are repacked every time.
+ */
+class BtCodecPluginCache
+{
+public:
+    static void prewarm(const std::vector<std::string> &libs);
+    static int getCodec(const std::string &lib, uint32_t codecFormat, codec_type type,
+                        void *codecInfo, bt_codec_t **codec, bt_enc_payload_t **payload);
+    static void putCodec(bt_codec_t *codec);
+    /* hits: payload reused, misses: payload populated by the plugin */
+    static void getStats(uint64_t *hits, uint64_t *misses);
+
+private:
+    struct entry {
+        std::string lib;
+        uint32_t codecFormat;
+        codec_type type;
+        bool cacheable;
+        std::vector<uint8_t> config;
+        bt_codec_t *codec;
+        bt_enc_payload_t *payload;
+        uint32_t users;
+    };
+
+    static open_fn_t getOpenFn_l(const std::string &lib);
+    static bool serializeConfig(uint32_t codecFormat, codec_type type, void *codecInfo,
+                                std::vector<uint8_t> &config);
+    static void dropIdle_l(const struct entry &keep);
+
+    static std::mutex mLock;
+    static std::map<std::string, open_fn_t> mLibs;
+    static std::list<struct entry> mEntries;
+    static std::atomic<uint64_t> mHits;
+    static std::atomic<uint64_t> mMisses;
+};
+
+#endif /* BT_CODEC_PLUGIN_CACHE_H */
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef DATA_PATH_STATS_H
+#define DATA_PATH_STATS_H
+
+#include <stdint.h>
+#include <atomic>
+#include "LatencyHistogram.h"
+#include "PalDefs.h"
+
+/* a longer gap between transfers is a pause or standby, not jitter */
+#define DATA_PATH_MAX_INTERVAL_US (1000 * 1000)
+
+/*
+ * Steady state counters of one stream's read or write path. Updates are
+ * relaxed atomics so they can sit on the data path without a lock; a
+ * reader gets counters that may be one transfer apart from each other.
+ */
+class DataPathStats
+{
+public:
+    DataPathStats();
+    void recordLockWait(uint64_t startNs, uint64_t endNs);
+    /* one successful read or write spanning [startNs, endNs) */
+    void recordTransfer(uint64_t bytes, uint64_t startNs, uint64_t endNs);
+    void recordXruns(uint32_t xruns);
+    void recordDropped(uint64_t bytes);
+    void getStats(pal_stream_data_path_stats_t *stats) const;
+    void reset();
+
+private:
+    std::atomic<uint64_t> mTransfers;
+    std::atomic<uint64_t> mBytes;
+    std::atomic<uint64_t> mXruns;
+    std::atomic<uint64_t> mDroppedBuffers;
+    std::atomic<uint64_t> mDroppedBytes;
+    std::atomic<uint64_t> mLastStartNs;
+    LatencyHistogram mTransferHist;
+    LatencyHistogram mIntervalHist;
+    LatencyHistogram mLockWaitHist;
+};
+
+#endif /* DATA_PATH_STATS_H */
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <atomic>
+
+#define LATENCY_HISTOGRAM_BUCKETS 32
+
+struct latency_histogram_summary {
+    uint64_t count;
+    uint64_t minUs;
+    uint64_t maxUs;
+    uint64_t meanUs;
+    /* upper bound of the bucket holding the percentile */
+    uint64_t p50Us;
+    uint64_t p90Us;
+    uint64_t p99Us;
+};
+
+/*
+ * Lock free latency histogram with power of two microsecond buckets:
+ * bucket 0 holds samples below 1us, bucket n holds [2^(n-1), 2^n) us and
+ * the last bucket everything above. Recording is a few relaxed atomics so
+ * it can sit on real time paths; readers get a consistent enough view for
+ * reporting, not an exact snapshot.
+ */
+class LatencyHistogram
+{
+public:
+    explicit LatencyHistogram(const char *name);
+    void record(uint64_t us);
+    void getSummary(struct latency_histogram_summary *summary) const;
+    void reset();
+    /* prints the summary and non empty buckets at info level */
+    void dump() const;
+    const char *getName() const { return mName; }
+
+private:
+    uint64_t getPercentile(uint64_t count, uint32_t percent) const;
+    static uint32_t getBucket(uint64_t us);
+
+    const char *mName;
+    std::atomic<uint64_t> mBuckets[LATENCY_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> mCount;
+    std::atomic<uint64_t> mSumUs;
+    std::atomic<uint64_t> mMinUs;
+    std::atomic<uint64_t> mMaxUs;
+};
+
+#endif /* LATENCY_HISTOGRAM_H */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef MIXER_CTL_CACHE_H
+#define MIXER_CTL_CACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include <tinyalsa/asoundlib.h>
+
+/*
+ * Name -> mixer_ctl directory, built once per mixer on first use so that
+ * control lookups no longer strcmp through every control of the card.
+ * Names may be passed split as prefix + suffix ("PCM100" + " setParam"),
+ * they are hashed as one string and never concatenated.
+ *
+ * A name missing from the directory is resolved with
+ * mixer_get_ctl_by_name; if the card gained controls since the directory
+ * was built it is rebuilt, otherwise the name is remembered as missing.
+ * Directories are dropped with invalidate() whenever the mixer or its
+ * controls may have changed (SSR, mixer close).
+ */
+class MixerCtlCache
+{
+public:
+    static struct mixer_ctl *getCtl(struct mixer *am, const char *name);
+    static struct mixer_ctl *getCtl(struct mixer *am, const char *prefix,
+                                    const char *suffix);
+    static void invalidate();
+    /* hits: served by a directory, misses: needed a linear lookup */
+    static void getStats(uint64_t *hits, uint64_t *misses);
+
+private:
+    struct entry {
+        uint64_t hash;
+        std::string name;
+        struct mixer_ctl *ctl;
+    };
+
+    struct directory {
+        struct mixer *am;
+        uint32_t numCtls;
+        uint32_t mask;
+        std::vector<struct entry> slots;
+        std::unordered_set<std::string> missing;
+    };
+
+    static uint64_t hash(const char *prefix, const char *suffix);
+    static bool matches(const struct entry &e, uint64_t h, const char *prefix,
+                        const char *suffix);
+    static void build(struct mixer *am, struct directory &dir);
+    static struct directory &getDirectory(struct mixer *am);
+
+    static std::mutex mLock;
+    static std::vector<struct directory> mDirs;
+    static std::atomic<uint64_t> mHits;
+    static std::atomic<uint64_t> mMisses;
+};
+
+#endif /* MIXER_CTL_CACHE_H */
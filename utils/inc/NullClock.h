@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef NULL_CLOCK_H
+#define NULL_CLOCK_H
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <mutex>
+
+/* a longer gap between two paced buffers restarts the timeline */
+#define NULL_CLOCK_RESYNC_US (100 * 1000)
+
+/*
+ * Stands in for the DSP clock while a stream drops its data, i.e. the sound
+ * card is offline, SSR is being recovered or a2dp is suspended. advance()
+ * returns the absolute time at which the dropped buffer would have been
+ * rendered or captured, and sleepUntil() blocks until then, so clients keep
+ * their cadence without the drift of back to back relative sleeps. Call
+ * advance() under the stream lock and sleepUntil() after releasing it: the
+ * sleep only uses the returned deadline, so a close that goes ahead meanwhile
+ * may delete the stream and its clock.
+ *
+ * reset() is called on the normal data path and is a single relaxed load
+ * unless the clock was running, so the next offline period starts from
+ * "now" rather than catching up on the time spent online.
+ */
+class NullClock
+{
+public:
+    NullClock();
+    struct timespec advance(uint64_t durationUs);
+    void reset();
+    static void sleepUntil(const struct timespec &deadline);
+
+private:
+    std::mutex mLock;
+    struct timespec mDeadline;
+    std::atomic<bool> mRunning;
+};
+
+#endif /* NULL_CLOCK_H */
@@ -34,6 +34,10 @@
 
 
 #include <stdlib.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <atomic>
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -65,21 +69,38 @@ struct kwdConfig {
     uint32_t ftrtSize;
 };
 
+/* contiguous read-only region of the ring returned by PalRingBufferReader::peek */
+struct pal_ring_buffer_span {
+    const char *data;
+    size_t size;
+};
+
+#define PAL_RING_BUFFER_MAX_SPANS 2
+
 class PalRingBuffer;
 
 class PalRingBufferReader {
  public:
-     PalRingBufferReader(PalRingBuffer *buffer)
-         : ringBuffer_(buffer),
-           unreadSize_(0),
-           readOffset_(0),
-           requestedSize_(0),
-           state_(READER_DISABLED) {}
+     PalRingBufferReader(PalRingBuffer *buffer);
 
-    ~PalRingBufferReader() {};
+    ~PalRingBufferReader();
 
     size_t advanceReadOffset(size_t advanceSize);
     int32_t read(void* readBuffer, size_t readSize);
+    /*
+     * Zero copy read: fill up to two spans covering the unread data (the
+     * second one is used when the data wraps) and return the total size.
+     * The data stays valid, and is not overwritten by the writer, until it
+     * is released with commit().
+     */
+    int32_t peek(struct pal_ring_buffer_span spans[PAL_RING_BUFFER_MAX_SPANS]);
+    int32_t commit(size_t size);
+    /*
+     * True when this is the only reader of the ring, so that nobody else
+     * sees the data peek() hands out. Readers are added when the buffer is
+     * set up, before any of them reads.
+     */
+    bool isSoleReader();
     void updateState(pal_ring_buffer_reader_state state);
     void getIndices(Stream *s,
         uint32_t *startIdx, uint32_t *endIdx, uint32_t *ftrtSize);
@@ -89,6 +110,8 @@ class PalRingBufferReader {
     bool isEnabled() { return state_ == READER_ENABLED; }
     bool isPrepared() { return state_ == READER_PREPARED; }
     bool waitForBuffers(uint32_t buffer_size);
+    /* makes a pending and any later waitForBuffers() return, until reset() */
+    void cancelWait();
 
     friend class PalRingBuffer;
 
@@ -96,25 +119,60 @@ class PalRingBufferReader {
     PalRingBuffer *ringBuffer_;
     size_t unreadSize_;
     size_t readOffset_;
-    pal_ring_buffer_reader_state state_;
+    std::atomic<pal_ring_buffer_reader_state> state_;
     std::mutex mutex_;
     std::condition_variable cv_;
-    uint32_t requestedSize_;
+    std::atomic<uint32_t> requestedSize_;
+    std::atomic<bool> waitCancelled_;
+    /* lock free mode only: absolute read cursor and writer->reader wakeup */
+    std::atomic<uint64_t> readPos_;
+    int eventFd_;
+    size_t getAvailable(uint64_t writePos, uint64_t readPos);
+    int32_t readLockFree(void* readBuffer, size_t bufferSize);
+    bool waitForBuffersLockFree(uint32_t buffer_size);
+    void notify();
 };
 
+/*
+ * In lock free mode the buffer supports one writer thread and any number of
+ * reader threads without taking mutex_ on the data path. The writer and each
+ * reader own a monotonically increasing byte cursor: the writer publishes
+ * writePos_ with release ordering after copying, readers publish readPos_
+ * the same way after consuming, and waiting readers are woken through a
+ * per reader eventfd. A waiting reader stores requestedSize_ and then reads
+ * writePos_ while the writer stores writePos_ and then reads requestedSize_,
+ * so both sides put a seq_cst fence between the two or the wakeup can be lost.
+ *
+ * newReader/removeReader may run while the writer is active. They update
+ * readers_ under mutex_ and publish a copy in readerList_, which is what the
+ * lock free writer walks. removeReader returns only once no writer is still
+ * walking the old copy, after that the reader can be deleted. Each publish
+ * starts a new list generation and the writer counts itself in the user
+ * count of the generation it runs in, so the publisher only waits for the
+ * write in progress, on a condition variable and without holding mutex_.
+ * Other control operations (reset, updateKwdConfig) serialize on mutex_ and
+ * must not race with data transfer on the same reader.
+ */
 class PalRingBuffer {
  public:
-    explicit PalRingBuffer(size_t bufferSize)
+    explicit PalRingBuffer(size_t bufferSize, bool lockFree = false)
         : buffer_((char*)(new char[bufferSize])),
           writeOffset_(0),
-          bufferEnd_(bufferSize) {}
+          bufferEnd_(bufferSize),
+          lockFree_(lockFree),
+          writePos_(0),
+          readerList_(new std::vector<PalRingBufferReader*>()),
+          readerListGen_(0),
+          readerListUsers_(),
+          readerListWaiters_(0) {}
 
     ~PalRingBuffer() {
         if (buffer_)
-            delete buffer_;
+            delete[] buffer_;
 
         for (int i = 0; i < readers_.size(); i++)
             delete readers_[i];
+        delete readerList_.load();
     }
 
     PalRingBufferReader* newReader();
@@ -131,6 +189,7 @@ class PalRingBuffer {
     void reset();
     size_t getBufferSize() { return bufferEnd_; };
     void resizeRingBuffer(size_t bufferSize);
+    bool isLockFree() { return lockFree_; }
 
  protected:
     std::mutex mutex_;
@@ -138,8 +197,28 @@ class PalRingBuffer {
     std::unordered_map<Stream*, struct kwdConfig> kwCfg_;
     size_t writeOffset_;
     size_t bufferEnd_;
+    bool lockFree_;
+    std::atomic<uint64_t> writePos_;
     std::vector<PalRingBufferReader*> readers_;
+    /*
+     * copy of readers_ for the lock free writer, replaced under mutex_.
+     * Publishers are serialized by publishMutex_, which they keep while
+     * they wait for the users of the previous generation to leave.
+     */
+    std::mutex publishMutex_;
+    std::atomic<std::vector<PalRingBufferReader*> *> readerList_;
+    std::atomic<uint32_t> readerListGen_;
+    std::atomic<uint32_t> readerListUsers_[2]; /* indexed by generation & 1 */
+    std::atomic<uint32_t> readerListWaiters_;
+    std::mutex readerListWaitMutex_;
+    std::condition_variable readerListWaitCv_;
     void updateUnReadSize(size_t writtenSize);
+    size_t getFreeSize(const std::vector<PalRingBufferReader*> &readers);
+    size_t writeLockFree(void* writeBuffer, size_t writeSize);
+    /* returns the user slot to hand back to releaseReaderList */
+    uint32_t acquireReaderList(const std::vector<PalRingBufferReader*> **readers);
+    void releaseReaderList(uint32_t slot);
+    void publishReaderList(std::unique_lock<std::mutex> &lock);
     friend class PalRingBufferReader;
 };
 #endif
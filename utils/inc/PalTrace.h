@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef PAL_TRACE_H
+#define PAL_TRACE_H
+
+#include <stdint.h>
+#include "PalDefs.h"
+
+/* events kept per thread, a power of two */
+#define PAL_TRACE_RING_SIZE 256
+
+/* order is the index of the phase in PAL_PARAM_ID_LATENCY_STATS */
+typedef enum {
+    PAL_TRACE_STREAM_OPEN,
+    PAL_TRACE_STREAM_START,
+    PAL_TRACE_STREAM_SET_DEVICE,
+    PAL_TRACE_KV_LOOKUP,
+    PAL_TRACE_METADATA_BUILD,
+    PAL_TRACE_MIXER_WRITE,
+    PAL_TRACE_PCM_OPEN,
+    PAL_TRACE_PCM_PREPARE,
+    PAL_TRACE_PCM_START,
+    PAL_TRACE_DEVSWITCH_PLAN,
+    PAL_TRACE_DEVSWITCH_DISCONNECT,
+    PAL_TRACE_DEVSWITCH_CONNECT,
+    PAL_TRACE_DEVSWITCH_TOTAL,
+    PAL_TRACE_SSTAGE_KEYWORD,      /* first stage detection to keyword verdict */
+    PAL_TRACE_SSTAGE_USER,         /* first stage detection to user verdict */
+    PAL_TRACE_PHASE_MAX,
+} pal_trace_phase_t;
+
+/*
+ * Always on phase tracing. Every recorded phase goes into a lock free
+ * ring of the calling thread, with CLOCK_MONOTONIC ns timestamps, and
+ * into a latency histogram of the phase. Recording takes no lock and
+ * makes no system call besides reading the clock.
+ *
+ * Rings of exited threads are kept and handed to new threads, so the
+ * events of short lived workers stay readable until reused.
+ */
+class PalTrace
+{
+public:
+    static uint64_t nowNs();
+    static void record(pal_trace_phase_t phase, uint64_t startNs, uint64_t endNs,
+                       uint64_t tag = 0);
+    static const char *getPhaseName(pal_trace_phase_t phase);
+    static void getLatencyStats(pal_param_latency_stats_t *stats);
+    static void getEvents(pal_param_latency_trace_t *trace);
+};
+
+/*
+ * Records its own lifetime as one phase. Only the outermost scope of a
+ * phase on a thread records, nested lookups are not counted twice.
+ */
+class PalTraceScope
+{
+public:
+    explicit PalTraceScope(pal_trace_phase_t phase, uint64_t tag = 0);
+    ~PalTraceScope();
+    void setTag(uint64_t tag) { mTag = tag; }
+
+private:
+    pal_trace_phase_t mPhase;
+    uint64_t mTag;
+    uint64_t mStartNs;
+    bool mOutermost;
+};
+
+#endif /* PAL_TRACE_H */
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define REACTOR_NUM_WORKERS 2
+#define REACTOR_MAX_BLOCKING_WORKERS 4
+/* a blocking lane worker idle this long exits */
+#define REACTOR_BLOCKING_IDLE_MS 5000
+
+/*
+ * Process wide epoll loop with a small worker pool, for components that
+ * used to keep a thread of their own just to wait on a file descriptor,
+ * a timeout or a condition.
+ *
+ * Three kinds of handles can be registered:
+ *  - addFd: a caller owned fd, the callback gets the epoll events.
+ *  - addTimer: a one shot timerfd, (re)started with armTimer.
+ *  - addEvent: an eventfd, signal() runs the callback once; signals
+ *    raised before the callback gets to run are coalesced.
+ *
+ * Callbacks of one handle never run concurrently and run on one of
+ * REACTOR_NUM_WORKERS threads, so they must not block for long. Handles
+ * added with blocking set, e.g. ones that take a stream mutex, stop graphs
+ * or call back into clients, run on a separate lane instead. That lane
+ * starts a worker whenever all of its workers are busy, up to
+ * REACTOR_MAX_BLOCKING_WORKERS, and queues callbacks beyond that. Its
+ * workers exit after REACTOR_BLOCKING_IDLE_MS without work, so the lane
+ * only holds threads while blocking callbacks actually run.
+ * A callback that is already queued when its timer is disarmed or its
+ * handle removed is dropped. remove() waits for a running callback to
+ * return, unless it is called from that callback.
+ */
+class Reactor
+{
+public:
+    typedef std::function<void(uint32_t events)> callback_t;
+
+    static std::shared_ptr<Reactor> getInstance();
+    ~Reactor();
+
+    /* all add* return a handle > 0 or a negative errno */
+    int addFd(int fd, uint32_t events, callback_t cb, bool blocking = false);
+    int addTimer(callback_t cb, bool blocking = false);
+    int addEvent(callback_t cb, bool blocking = false);
+    int armTimer(int handle, uint32_t delayMs);
+    int disarmTimer(int handle);
+    int signal(int handle);
+    int remove(int handle);
+
+private:
+    enum reg_type {
+        REG_FD,
+        REG_TIMER,
+        REG_EVENT,
+    };
+
+    struct registration {
+        int handle;
+        int fd;
+        reg_type type;
+        uint32_t events;
+        callback_t cb;
+        bool blocking;
+        bool running;
+        bool removed;
+    };
+
+    Reactor();
+    int init();
+    int add(int fd, reg_type type, uint32_t events, callback_t cb, bool blocking);
+    std::shared_ptr<struct registration> find(int handle);
+    void dispatchLoop();
+    void workerLoop(bool blocking);
+    void retireBlockingWorker_l();
+    void joinRetiredWorkers_l();
+    void run(int handle, uint32_t events);
+
+    static std::mutex mInstanceLock;
+    static std::shared_ptr<Reactor> mInstance;
+
+    int mEpollFd;
+    int mWakeFd;
+    int mNextHandle;
+    bool mExit;
+    std::mutex mLock;
+    std::condition_variable mWorkCv;
+    std::condition_variable mRemoveCv;
+    std::map<int, std::shared_ptr<struct registration>> mRegs;
+    std::deque<std::pair<int, uint32_t>> mWork;
+    std::thread mDispatcher;
+    std::vector<std::thread> mWorkers;
+    /*
+     * blocking lane, grown by the dispatcher while all of its workers are
+     * busy. Workers that time out move themselves to mRetiredWorkers and
+     * wake the dispatcher, which joins them.
+     */
+    std::condition_variable mBlockingCv;
+    std::deque<std::pair<int, uint32_t>> mBlockingWork;
+    std::list<std::thread> mBlockingWorkers;
+    std::vector<std::thread> mRetiredWorkers;
+    size_t mBlockingIdle;
+};
+
+#endif /* REACTOR_H */
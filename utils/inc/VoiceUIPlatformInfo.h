@@ -80,6 +80,10 @@ public:
     uint32_t GetSampleRate() const { return sample_rate_; }
     uint32_t GetBitWidth() const { return bit_width_; }
     uint32_t GetChannels() const { return channels_; }
+    bool IsEarlyDecisionEnabled() const { return early_decision_; }
+    int32_t GetEarlyRejectMargin() const { return early_reject_margin_; }
+    uint32_t GetEarlyRejectAfterKwEnd() const { return early_reject_after_kw_end_; }
+    bool IsInputReadOnly() const { return read_only_input_; }
 
 private:
     st_sound_model_type_t detection_type_;
@@ -88,6 +92,10 @@ private:
     uint32_t sample_rate_;
     uint32_t bit_width_;
     uint32_t channels_;
+    bool early_decision_;
+    int32_t early_reject_margin_;
+    uint32_t early_reject_after_kw_end_;
+    bool read_only_input_;
 };
 
 class VUIFirstStageConfig : public SoundTriggerXml
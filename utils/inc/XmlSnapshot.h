@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#ifndef XML_SNAPSHOT_H
+#define XML_SNAPSHOT_H
+
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include <expat.h>
+
+#ifndef PAL_XML_SNAPSHOT_DIR
+#define PAL_XML_SNAPSHOT_DIR "/data/vendor/audio"
+#endif
+
+#define XML_SNAPSHOT_MAGIC   0x4e535850 /* "PXSN" */
+#define XML_SNAPSHOT_VERSION 1
+#define XML_SNAPSHOT_EXT     ".palsnap"
+
+typedef enum {
+    XML_SNAPSHOT_EVT_START = 0,
+    XML_SNAPSHOT_EVT_END,
+    XML_SNAPSHOT_EVT_DATA,
+} xml_snapshot_event_type_t;
+
+/*
+ * On-disk layout, all offsets relative to the start of the file:
+ *   xml_snapshot_header_t
+ *   xml_snapshot_event_t   events[num_events]
+ *   uint32_t               attrs[num_attrs]   (string offsets, name/value pairs)
+ *   char                   strings[strings_size] (NUL terminated)
+ * The file is mmap'ed on load and tag/attribute pointers handed to the
+ * expat handlers point straight into the mapping.
+ */
+struct xml_snapshot_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t xml_size;
+    int64_t  xml_mtime_sec;
+    int64_t  xml_mtime_nsec;
+    uint64_t xml_hash;
+    uint64_t body_hash;
+    uint32_t num_events;
+    uint32_t num_attrs;
+    uint32_t strings_size;
+    uint32_t reserved;
+};
+
+struct xml_snapshot_event_t {
+    uint32_t type;
+    uint32_t str_off;   /* tag name, or character data */
+    uint32_t len;       /* attribute count for START, data length for DATA */
+    uint32_t attr_idx;  /* first entry in attrs[] for START */
+};
+
+class XmlSnapshot
+{
+public:
+    /*
+     * Parse xmlFile through the given expat handlers. A snapshot of the
+     * handler calls is replayed when it matches the xml size, mtime and
+     * content hash, otherwise the xml is parsed with expat and a new
+     * snapshot is written on success. Returns -ENOENT if xmlFile is missing.
+     */
+    static int parse(const std::string &xmlFile, void *userdata,
+                     XML_StartElementHandler startTag,
+                     XML_EndElementHandler endTag,
+                     XML_CharacterDataHandler dataHandler);
+    static uint64_t hash(const uint8_t *buf, size_t size, uint64_t seed);
+
+private:
+    struct recorder {
+        void *userdata;
+        XML_StartElementHandler startTag;
+        XML_EndElementHandler endTag;
+        XML_CharacterDataHandler dataHandler;
+        std::vector<xml_snapshot_event_t> events;
+        std::vector<uint32_t> attrs;
+        std::vector<char> strings;
+    };
+
+    static std::string getSnapshotPath(const std::string &xmlFile);
+    static int replay(const std::string &snapFile, const struct stat &xmlStat,
+                      uint64_t xmlHash, void *userdata,
+                      XML_StartElementHandler startTag,
+                      XML_EndElementHandler endTag,
+                      XML_CharacterDataHandler dataHandler);
+    static int parseXml(const uint8_t *xml, size_t size, struct recorder *rec);
+    static int write(const std::string &snapFile, const struct stat &xmlStat,
+                     uint64_t xmlHash, struct recorder *rec);
+    static uint32_t addString(struct recorder *rec, const char *s, size_t len);
+    static void recordStart(void *userdata, const XML_Char *tag_name, const XML_Char **attr);
+    static void recordEnd(void *userdata, const XML_Char *tag_name);
+    static void recordData(void *userdata, const XML_Char *s, int len);
+};
+
+#endif /* XML_SNAPSHOT_H */
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: BtCodecPluginCache"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <string.h>
+#include "BtCodecPluginCache.h"
+#include "PalCommon.h"
+/* every plugin header has its own NUM_CODEC, only the config types are used here */
+#include <bt_bundle.h>
+#undef NUM_CODEC
+#include <bt_aptx.h>
+#undef NUM_CODEC
+#include <bt_ble.h>
+
+std::mutex BtCodecPluginCache::mLock;
+std::map<std::string, open_fn_t> BtCodecPluginCache::mLibs;
+std::list<struct BtCodecPluginCache::entry> BtCodecPluginCache::mEntries;
+std::atomic<uint64_t> BtCodecPluginCache::mHits(0);
+std::atomic<uint64_t> BtCodecPluginCache::mMisses(0);
+
+static void appendBytes(std::vector<uint8_t> &config, const void *data, size_t size)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+
+    config.insert(config.end(), bytes, bytes + size);
+}
+
+template <typename T>
+static void appendConfig(std::vector<uint8_t> &config, const T *value)
+{
+    appendBytes(config, value, sizeof(T));
+}
+
+open_fn_t BtCodecPluginCache::getOpenFn_l(const std::string &lib)
+{
+    auto iter = mLibs.find(lib);
+    open_fn_t openFn = NULL;
+    void *handle = NULL;
+
+    if (iter != mLibs.end())
+        return iter->second;
+
+    handle = dlopen(lib.c_str(), RTLD_NOW);
+    if (!handle) {
+        PAL_ERR(LOG_TAG, "failed to dlopen lib %s. Error: %s", lib.c_str(), dlerror());
+        return NULL;
+    }
+    openFn = (open_fn_t)dlsym(handle, "plugin_open");
+    if (!openFn) {
+        PAL_ERR(LOG_TAG, "dlsym to open fn failed, err = '%s'", dlerror());
+        dlclose(handle);
+        return NULL;
+    }
+    /* never closed, codecs of the library may be cached for the process lifetime */
+    mLibs[lib] = openFn;
+    PAL_DBG(LOG_TAG, "loaded %s", lib.c_str());
+    return openFn;
+}
+
+/*
+ * Flattens codecInfo into bytes that compare equal for equal configs.
+ * Pointers are replaced by the data they point to. Returns false for a
+ * format and direction without a known config layout.
+ */
+bool BtCodecPluginCache::serializeConfig(uint32_t codecFormat, codec_type type,
+                                         void *codecInfo, std::vector<uint8_t> &config)
+{
+    config.clear();
+    if (!codecInfo)
+        return false;
+
+    switch (codecFormat) {
+    case CODEC_TYPE_SBC:
+        if (type == ENC)
+            appendConfig(config, (audio_sbc_encoder_config_t *)codecInfo);
+        else
+            appendConfig(config, (audio_sbc_decoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_AAC:
+        if (type == ENC) {
+            audio_aac_encoder_config_t aac;
+            const audio_aac_encoder_config_t *src = (audio_aac_encoder_config_t *)codecInfo;
+
+            memcpy(&aac, codecInfo, sizeof(aac));
+            aac.frame_ctl_ptr = NULL;
+            aac.abr_ctl_ptr = NULL;
+            appendConfig(config, &aac);
+            if (src->frame_ctl_ptr)
+                appendConfig(config, src->frame_ctl_ptr);
+            if (src->abr_ctl_ptr)
+                appendConfig(config, src->abr_ctl_ptr);
+        } else {
+            appendConfig(config, (audio_aac_decoder_config_t *)codecInfo);
+        }
+        return true;
+    case CODEC_TYPE_CELT:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_celt_encoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_LDAC:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_ldac_encoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_APTX:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_aptx_encoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_APTX_HD:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_aptx_hd_encoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_APTX_DUAL_MONO:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_aptx_dual_mono_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_APTX_AD:
+        if (type != ENC)
+            return false;
+        appendConfig(config, (audio_aptx_ad_encoder_config_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_APTX_AD_SPEECH:
+        /* the swb speech mode */
+        appendConfig(config, (uint32_t *)codecInfo);
+        return true;
+    case CODEC_TYPE_LC3:
+    case CODEC_TYPE_APTX_AD_QLEA:
+    case CODEC_TYPE_APTX_AD_R4: {
+        audio_lc3_codec_cfg_t lc3;
+        const audio_lc3_codec_cfg_t *src = (audio_lc3_codec_cfg_t *)codecInfo;
+
+        memcpy(&lc3, codecInfo, sizeof(lc3));
+        lc3.enc_cfg.streamMapOut = NULL;
+        lc3.dec_cfg.streamMapIn = NULL;
+        appendConfig(config, &lc3);
+        if (src->enc_cfg.streamMapOut)
+            appendBytes(config, src->enc_cfg.streamMapOut,
+                        src->enc_cfg.stream_map_size * sizeof(lc3_stream_map_t));
+        if (src->dec_cfg.streamMapIn)
+            appendBytes(config, src->dec_cfg.streamMapIn,
+                        src->dec_cfg.stream_map_size * sizeof(lc3_stream_map_t));
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+/* closes idle codecs of keep's library, format and direction other than keep */
+void BtCodecPluginCache::dropIdle_l(const struct entry &keep)
+{
+    for (auto iter = mEntries.begin(); iter != mEntries.end();) {
+        if (&*iter != &keep && !iter->users && iter->lib == keep.lib &&
+            iter->codecFormat == keep.codecFormat && iter->type == keep.type) {
+            iter->codec->close_plugin(iter->codec);
+            iter = mEntries.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+}
+
+void BtCodecPluginCache::prewarm(const std::vector<std::string> &libs)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    for (auto &lib : libs) {
+        if (!getOpenFn_l(lib))
+            PAL_INFO(LOG_TAG, "BT codec lib %s not available", lib.c_str());
+    }
+}
+
+int BtCodecPluginCache::getCodec(const std::string &lib, uint32_t codecFormat,
+                                 codec_type type, void *codecInfo, bt_codec_t **codec,
+                                 bt_enc_payload_t **payload)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+    struct entry e;
+    open_fn_t openFn = NULL;
+    int status = 0;
+
+    e.lib = lib;
+    e.codecFormat = codecFormat;
+    e.type = type;
+    e.cacheable = serializeConfig(codecFormat, type, codecInfo, e.config);
+    e.codec = NULL;
+    e.payload = NULL;
+    e.users = 1;
+
+    if (e.cacheable) {
+        for (auto &cached : mEntries) {
+            if (cached.cacheable && cached.lib == lib && cached.codecFormat == codecFormat &&
+                cached.type == type && cached.config == e.config) {
+                cached.users++;
+                *codec = cached.codec;
+                *payload = cached.payload;
+                mHits++;
+                PAL_DBG(LOG_TAG, "reusing payload of codec 0x%x, %u users", codecFormat,
+                        cached.users);
+                return 0;
+            }
+        }
+    }
+    mMisses++;
+
+    openFn = getOpenFn_l(lib);
+    if (!openFn)
+        return -EINVAL;
+
+    status = openFn(&e.codec, codecFormat, type);
+    if (status) {
+        PAL_ERR(LOG_TAG, "failed to open plugin %d", status);
+        return status;
+    }
+
+    status = e.codec->plugin_populate_payload(e.codec, codecInfo, (void **)&e.payload);
+    if (status != 0) {
+        PAL_ERR(LOG_TAG, "fail to pack the encoder config %d", status);
+        e.codec->close_plugin(e.codec);
+        return status;
+    }
+
+    mEntries.push_front(std::move(e));
+    *codec = mEntries.front().codec;
+    *payload = mEntries.front().payload;
+    return 0;
+}
+
+void BtCodecPluginCache::putCodec(bt_codec_t *codec)
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (!codec)
+        return;
+
+    for (auto iter = mEntries.begin(); iter != mEntries.end(); iter++) {
+        if (iter->codec != codec)
+            continue;
+        if (--iter->users)
+            return;
+        if (!iter->cacheable) {
+            codec->close_plugin(codec);
+            mEntries.erase(iter);
+            return;
+        }
+        /* the most recently released config is the one a reconnect asks for */
+        dropIdle_l(*iter);
+        return;
+    }
+    PAL_ERR(LOG_TAG, "codec %pK not from the cache", codec);
+}
+
+void BtCodecPluginCache::getStats(uint64_t *hits, uint64_t *misses)
+{
+    if (hits)
+        *hits = mHits.load();
+    if (misses)
+        *misses = mMisses.load();
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: DataPathStats"
+
+#include <stdio.h>
+#include <string.h>
+#include "DataPathStats.h"
+#include "PalCommon.h"
+
+static void fillLatencyStat(const LatencyHistogram &hist, pal_latency_stat_t *stat)
+{
+    struct latency_histogram_summary s;
+
+    hist.getSummary(&s);
+    snprintf(stat->name, sizeof(stat->name), "%s", hist.getName());
+    stat->count = s.count;
+    stat->min_us = s.minUs;
+    stat->mean_us = s.meanUs;
+    stat->p50_us = s.p50Us;
+    stat->p90_us = s.p90Us;
+    stat->p99_us = s.p99Us;
+    stat->max_us = s.maxUs;
+}
+
+DataPathStats::DataPathStats()
+    : mTransferHist("transfer_time"),
+      mIntervalHist("transfer_interval"),
+      mLockWaitHist("lock_wait")
+{
+    reset();
+}
+
+void DataPathStats::recordLockWait(uint64_t startNs, uint64_t endNs)
+{
+    mLockWaitHist.record(endNs > startNs ? (endNs - startNs) / 1000 : 0);
+}
+
+void DataPathStats::recordTransfer(uint64_t bytes, uint64_t startNs, uint64_t endNs)
+{
+    uint64_t lastNs = mLastStartNs.exchange(startNs, std::memory_order_relaxed);
+
+    if (lastNs && startNs > lastNs &&
+        (startNs - lastNs) / 1000 <= DATA_PATH_MAX_INTERVAL_US)
+        mIntervalHist.record((startNs - lastNs) / 1000);
+    mTransferHist.record(endNs > startNs ? (endNs - startNs) / 1000 : 0);
+    mTransfers.fetch_add(1, std::memory_order_relaxed);
+    mBytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void DataPathStats::recordXruns(uint32_t xruns)
+{
+    mXruns.fetch_add(xruns, std::memory_order_relaxed);
+}
+
+void DataPathStats::recordDropped(uint64_t bytes)
+{
+    mDroppedBuffers.fetch_add(1, std::memory_order_relaxed);
+    mDroppedBytes.fetch_add(bytes, std::memory_order_relaxed);
+    /* the paced silence is not a transfer, do not count it as jitter */
+    mLastStartNs.store(0, std::memory_order_relaxed);
+}
+
+void DataPathStats::getStats(pal_stream_data_path_stats_t *stats) const
+{
+    if (!stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->transfers = mTransfers.load(std::memory_order_relaxed);
+    stats->bytes = mBytes.load(std::memory_order_relaxed);
+    stats->xruns = mXruns.load(std::memory_order_relaxed);
+    stats->dropped_buffers = mDroppedBuffers.load(std::memory_order_relaxed);
+    stats->dropped_bytes = mDroppedBytes.load(std::memory_order_relaxed);
+    fillLatencyStat(mTransferHist, &stats->transfer_time);
+    fillLatencyStat(mIntervalHist, &stats->transfer_interval);
+    fillLatencyStat(mLockWaitHist, &stats->lock_wait);
+}
+
+void DataPathStats::reset()
+{
+    mTransfers.store(0, std::memory_order_relaxed);
+    mBytes.store(0, std::memory_order_relaxed);
+    mXruns.store(0, std::memory_order_relaxed);
+    mDroppedBuffers.store(0, std::memory_order_relaxed);
+    mDroppedBytes.store(0, std::memory_order_relaxed);
+    mLastStartNs.store(0, std::memory_order_relaxed);
+    mTransferHist.reset();
+    mIntervalHist.reset();
+    mLockWaitHist.reset();
+}
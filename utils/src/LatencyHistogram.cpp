@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: LatencyHistogram"
+
+#include <string.h>
+#include <algorithm>
+#include "LatencyHistogram.h"
+#include "PalCommon.h"
+
+LatencyHistogram::LatencyHistogram(const char *name)
+    : mName(name)
+{
+    reset();
+}
+
+uint32_t LatencyHistogram::getBucket(uint64_t us)
+{
+    uint32_t bucket = 0;
+
+    while (us && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void LatencyHistogram::record(uint64_t us)
+{
+    uint64_t cur;
+
+    mBuckets[getBucket(us)].fetch_add(1, std::memory_order_relaxed);
+    mSumUs.fetch_add(us, std::memory_order_relaxed);
+
+    cur = mMinUs.load(std::memory_order_relaxed);
+    while (us < cur && !mMinUs.compare_exchange_weak(cur, us, std::memory_order_relaxed))
+        ;
+    cur = mMaxUs.load(std::memory_order_relaxed);
+    while (us > cur && !mMaxUs.compare_exchange_weak(cur, us, std::memory_order_relaxed))
+        ;
+    /* count last, a reader seeing it also sees a populated bucket */
+    mCount.fetch_add(1, std::memory_order_release);
+}
+
+uint64_t LatencyHistogram::getPercentile(uint64_t count, uint32_t percent) const
+{
+    uint64_t target = (count * percent + 99) / 100;
+    uint64_t seen = 0;
+
+    for (uint32_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        seen += mBuckets[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return i ? (1ULL << i) - 1 : 0;
+    }
+    return mMaxUs.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::getSummary(struct latency_histogram_summary *summary) const
+{
+    uint64_t maxUs;
+
+    if (!summary)
+        return;
+
+    memset(summary, 0, sizeof(*summary));
+    summary->count = mCount.load(std::memory_order_acquire);
+    if (!summary->count)
+        return;
+
+    maxUs = mMaxUs.load(std::memory_order_relaxed);
+    summary->minUs = mMinUs.load(std::memory_order_relaxed);
+    summary->maxUs = maxUs;
+    summary->meanUs = mSumUs.load(std::memory_order_relaxed) / summary->count;
+    /* a bucket bound past the largest sample says less than the sample */
+    summary->p50Us = std::min(getPercentile(summary->count, 50), maxUs);
+    summary->p90Us = std::min(getPercentile(summary->count, 90), maxUs);
+    summary->p99Us = std::min(getPercentile(summary->count, 99), maxUs);
+}
+
+void LatencyHistogram::reset()
+{
+    for (uint32_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+        mBuckets[i].store(0, std::memory_order_relaxed);
+    mSumUs.store(0, std::memory_order_relaxed);
+    mMinUs.store(UINT64_MAX, std::memory_order_relaxed);
+    mMaxUs.store(0, std::memory_order_relaxed);
+    mCount.store(0, std::memory_order_release);
+}
+
+void LatencyHistogram::dump() const
+{
+    struct latency_histogram_summary s;
+
+    getSummary(&s);
+    PAL_INFO(LOG_TAG, "%s: count %llu min %lluus mean %lluus p50 %lluus p90 %lluus p99 %lluus max %lluus",
+             mName, (unsigned long long)s.count, (unsigned long long)s.minUs,
+             (unsigned long long)s.meanUs, (unsigned long long)s.p50Us,
+             (unsigned long long)s.p90Us, (unsigned long long)s.p99Us,
+             (unsigned long long)s.maxUs);
+
+    for (uint32_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++) {
+        uint64_t n = mBuckets[i].load(std::memory_order_relaxed);
+
+        if (n)
+            PAL_VERBOSE(LOG_TAG, "%s: < %lluus: %llu", mName,
+                        (unsigned long long)(1ULL << i), (unsigned long long)n);
+    }
+}
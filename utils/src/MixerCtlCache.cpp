@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: MixerCtlCache"
+
+#include <string.h>
+#include "MixerCtlCache.h"
+#include "PalCommon.h"
+
+#define FNV_OFFSET_BASIS_64 0xcbf29ce484222325ULL
+#define FNV_PRIME_64        0x100000001b3ULL
+
+std::mutex MixerCtlCache::mLock;
+std::vector<struct MixerCtlCache::directory> MixerCtlCache::mDirs;
+std::atomic<uint64_t> MixerCtlCache::mHits(0);
+std::atomic<uint64_t> MixerCtlCache::mMisses(0);
+
+uint64_t MixerCtlCache::hash(const char *prefix, const char *suffix)
+{
+    uint64_t h = FNV_OFFSET_BASIS_64;
+
+    for (const char *p = prefix; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= FNV_PRIME_64;
+    }
+    for (const char *p = suffix; *p; p++) {
+        h ^= (uint8_t)*p;
+        h *= FNV_PRIME_64;
+    }
+    return h;
+}
+
+bool MixerCtlCache::matches(const struct entry &e, uint64_t h, const char *prefix,
+                            const char *suffix)
+{
+    size_t len = strlen(prefix);
+
+    return e.hash == h && !e.name.compare(0, len, prefix) &&
+           !strcmp(e.name.c_str() + len, suffix);
+}
+
+void MixerCtlCache::build(struct mixer *am, struct directory &dir)
+{
+    unsigned int num = mixer_get_num_ctls(am);
+    uint32_t size = 16;
+
+    while (size < num * 2)
+        size <<= 1;
+
+    dir.am = am;
+    dir.numCtls = num;
+    dir.mask = size - 1;
+    dir.slots.assign(size, {0, "", nullptr});
+    dir.missing.clear();
+
+    for (unsigned int i = 0; i < num; i++) {
+        struct mixer_ctl *ctl = mixer_get_ctl(am, i);
+        const char *name = ctl ? mixer_ctl_get_name(ctl) : NULL;
+        uint64_t h;
+        uint32_t idx;
+
+        if (!name)
+            continue;
+
+        h = hash(name, "");
+        for (idx = h & dir.mask; dir.slots[idx].ctl; idx = (idx + 1) & dir.mask) {
+            /* duplicate names resolve to the first control, as tinyalsa does */
+            if (matches(dir.slots[idx], h, name, ""))
+                break;
+        }
+        if (dir.slots[idx].ctl)
+            continue;
+        dir.slots[idx].hash = h;
+        dir.slots[idx].name = name;
+        dir.slots[idx].ctl = ctl;
+    }
+    PAL_DBG(LOG_TAG, "mixer %pK: %u controls in %u slots", am, num, size);
+}
+
+struct MixerCtlCache::directory &MixerCtlCache::getDirectory(struct mixer *am)
+{
+    for (auto &dir : mDirs) {
+        if (dir.am == am)
+            return dir;
+    }
+
+    mDirs.emplace_back();
+    build(am, mDirs.back());
+    return mDirs.back();
+}
+
+struct mixer_ctl *MixerCtlCache::getCtl(struct mixer *am, const char *name)
+{
+    return getCtl(am, name, "");
+}
+
+struct mixer_ctl *MixerCtlCache::getCtl(struct mixer *am, const char *prefix,
+                                        const char *suffix)
+{
+    uint64_t h;
+    uint32_t idx;
+    std::string name;
+    struct mixer_ctl *ctl = NULL;
+
+    if (!am || !prefix || !suffix)
+        return NULL;
+
+    h = hash(prefix, suffix);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    struct directory &dir = getDirectory(am);
+
+    for (idx = h & dir.mask; dir.slots[idx].ctl; idx = (idx + 1) & dir.mask) {
+        if (matches(dir.slots[idx], h, prefix, suffix)) {
+            mHits.fetch_add(1, std::memory_order_relaxed);
+            return dir.slots[idx].ctl;
+        }
+    }
+
+    name = std::string(prefix) + suffix;
+    if (dir.missing.count(name)) {
+        mHits.fetch_add(1, std::memory_order_relaxed);
+        return NULL;
+    }
+
+    mMisses.fetch_add(1, std::memory_order_relaxed);
+    ctl = mixer_get_ctl_by_name(am, name.c_str());
+    if (!ctl) {
+        dir.missing.insert(name);
+    } else {
+        /*
+         * The card grew controls after the directory was built, control
+         * pointers may have moved with it, start over.
+         */
+        PAL_INFO(LOG_TAG, "%s not in directory, rebuilding", name.c_str());
+        build(am, dir);
+    }
+
+    return ctl;
+}
+
+void MixerCtlCache::invalidate()
+{
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mDirs.clear();
+}
+
+void MixerCtlCache::getStats(uint64_t *hits, uint64_t *misses)
+{
+    if (hits)
+        *hits = mHits.load(std::memory_order_relaxed);
+    if (misses)
+        *misses = mMisses.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: NullClock"
+
+#include <errno.h>
+#include "NullClock.h"
+#include "PalCommon.h"
+
+#define NSEC_PER_SEC 1000000000LL
+#define NSEC_PER_USEC 1000LL
+
+static int64_t toNs(const struct timespec &ts)
+{
+    return (int64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+NullClock::NullClock()
+    : mDeadline(), mRunning(false)
+{
+}
+
+struct timespec NullClock::advance(uint64_t durationUs)
+{
+    struct timespec now;
+    int64_t deadlineNs;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    std::lock_guard<std::mutex> lock(mLock);
+    deadlineNs = toNs(mDeadline);
+    if (!mRunning.load(std::memory_order_relaxed) ||
+        deadlineNs + NULL_CLOCK_RESYNC_US * NSEC_PER_USEC < toNs(now)) {
+        PAL_DBG(LOG_TAG, "%s null clock", mRunning ? "resyncing" : "starting");
+        deadlineNs = toNs(now);
+        mRunning.store(true, std::memory_order_relaxed);
+    }
+    deadlineNs += (int64_t)durationUs * NSEC_PER_USEC;
+    mDeadline.tv_sec = deadlineNs / NSEC_PER_SEC;
+    mDeadline.tv_nsec = deadlineNs % NSEC_PER_SEC;
+    return mDeadline;
+}
+
+void NullClock::sleepUntil(const struct timespec &deadline)
+{
+    int ret;
+
+    do {
+        ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+    } while (ret == EINTR);
+}
+
+void NullClock::reset()
+{
+    if (!mRunning.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    mRunning.store(false, std::memory_order_relaxed);
+}
@@ -37,19 +37,107 @@
 #ifdef LINUX_ENABLED
 #include <algorithm>
 #endif
+#include <poll.h>
+#include <chrono>
+#include <thread>
 #include "PalRingBuffer.h"
 #include "PalCommon.h"
 #include "StreamSoundTrigger.h"
 
+#define RING_BUFFER_WAIT_TIMEOUT_MS 3000
+
+PalRingBufferReader::PalRingBufferReader(PalRingBuffer *buffer)
+    : ringBuffer_(buffer),
+      unreadSize_(0),
+      readOffset_(0),
+      state_(READER_DISABLED),
+      requestedSize_(0),
+      waitCancelled_(false),
+      readPos_(0),
+      eventFd_(-1)
+{
+    if (ringBuffer_->lockFree_) {
+        eventFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (eventFd_ < 0)
+            PAL_ERR(LOG_TAG, "eventfd failed %s", strerror(errno));
+    }
+}
+
+PalRingBufferReader::~PalRingBufferReader()
+{
+    if (eventFd_ >= 0)
+        close(eventFd_);
+}
+
 int32_t PalRingBuffer::removeReader(PalRingBufferReader *reader)
 {
+    std::lock_guard<std::mutex> publishLock(publishMutex_);
+    std::unique_lock<std::mutex> lck(mutex_);
     auto iter = std::find(readers_.begin(), readers_.end(), reader);
-    if (iter != readers_.end())
+    if (iter != readers_.end()) {
         readers_.erase(iter);
+        publishReaderList(lck);
+    }
 
     return 0;
 }
 
+/*
+ * Called with publishMutex_ and mutex_ held, after readers_ changed. Drops
+ * mutex_ once the new copy is published and returns when no writer can be
+ * walking the old one anymore.
+ */
+void PalRingBuffer::publishReaderList(std::unique_lock<std::mutex> &lock)
+{
+    std::vector<PalRingBufferReader*> *old =
+        readerList_.exchange(new std::vector<PalRingBufferReader*>(readers_),
+                             std::memory_order_seq_cst);
+    uint32_t slot = readerListGen_.fetch_add(1, std::memory_order_seq_cst) & 1;
+
+    lock.unlock();
+    /*
+     * Writers that may hold the old copy are counted in the slot of the
+     * previous generation, later ones count in the other slot, so this
+     * waits for at most the write in progress.
+     */
+    readerListWaiters_.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> waitLock(readerListWaitMutex_);
+        readerListWaitCv_.wait(waitLock, [this, slot] {
+            return readerListUsers_[slot].load(std::memory_order_seq_cst) == 0;
+        });
+    }
+    readerListWaiters_.fetch_sub(1, std::memory_order_seq_cst);
+    delete old;
+}
+
+uint32_t PalRingBuffer::acquireReaderList(const std::vector<PalRingBufferReader*> **readers)
+{
+    uint32_t gen;
+    uint32_t slot;
+
+    while (1) {
+        gen = readerListGen_.load(std::memory_order_seq_cst);
+        slot = gen & 1;
+        readerListUsers_[slot].fetch_add(1, std::memory_order_seq_cst);
+        /* a publish in between may already have stopped waiting on this slot */
+        if (readerListGen_.load(std::memory_order_seq_cst) == gen)
+            break;
+        releaseReaderList(slot);
+    }
+    *readers = readerList_.load(std::memory_order_seq_cst);
+    return slot;
+}
+
+void PalRingBuffer::releaseReaderList(uint32_t slot)
+{
+    if (readerListUsers_[slot].fetch_sub(1, std::memory_order_seq_cst) == 1 &&
+        readerListWaiters_.load(std::memory_order_seq_cst)) {
+        std::lock_guard<std::mutex> lock(readerListWaitMutex_);
+        readerListWaitCv_.notify_all();
+    }
+}
+
 size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
                            void* readBuffer __unused, size_t readSize __unused)
 {
@@ -58,11 +146,41 @@ size_t PalRingBuffer::read(std::shared_ptr<PalRingBufferReader>reader __unused,
 
 size_t PalRingBuffer::getFreeSize()
 {
+    size_t freeSize = 0;
+
+    if (lockFree_) {
+        const std::vector<PalRingBufferReader*> *readers;
+        uint32_t slot = acquireReaderList(&readers);
+
+        freeSize = getFreeSize(*readers);
+        releaseReaderList(slot);
+        return freeSize;
+    }
+
+    std::lock_guard<std::mutex> lck(mutex_);
+    return getFreeSize(readers_);
+}
 
+size_t PalRingBuffer::getFreeSize(const std::vector<PalRingBufferReader*> &readers)
+{
     size_t freeSize = bufferEnd_;
-    std::vector<PalRingBufferReader*>::iterator it;
+    std::vector<PalRingBufferReader*>::const_iterator it;
+
+    if (lockFree_) {
+        uint64_t writePos = writePos_.load(std::memory_order_relaxed);
+
+        for (it = readers.begin(); it != readers.end(); it++) {
+            if ((*(it))->state_ == READER_ENABLED) {
+                uint64_t readPos = (*(it))->readPos_.load(std::memory_order_acquire);
+                size_t used = writePos > readPos ?
+                    std::min((size_t)(writePos - readPos), bufferEnd_) : 0;
+                freeSize = std::min(freeSize, bufferEnd_ - used);
+            }
+        }
+        return freeSize;
+    }
 
-    for (it = readers_.begin(); it != readers_.end(); it++) {
+    for (it = readers.begin(); it != readers.end(); it++) {
         if ((*(it))->state_ == READER_ENABLED)
             freeSize = std::min(freeSize, bufferEnd_ - (*(it))->unreadSize_);
     }
@@ -75,6 +193,9 @@ void PalRingBuffer::updateUnReadSize(size_t writtenSize)
     std::vector<PalRingBufferReader*>::iterator it;
 
     for (it = readers_.begin(); it != readers_.end(); it++, i++) {
+        /* under the reader mutex, a waiter cannot miss the update between check and wait */
+        std::lock_guard<std::mutex> lck((*(it))->mutex_);
+
         (*(it))->unreadSize_ += writtenSize;
         PAL_VERBOSE(LOG_TAG, "Reader (%d), unreadSize(%zu)", i, (*(it))->unreadSize_);
 
@@ -104,6 +225,12 @@ void PalRingBuffer::updateKwdConfig(Stream *s, uint32_t startIdx, uint32_t endId
      */
     sz = startIdx >= preRoll ? startIdx - preRoll : 0;
     for (auto reader : readers) {
+        if (lockFree_) {
+            /* cursors count from the last reset, i.e. the buffering start */
+            reader->readPos_.store(sz, std::memory_order_release);
+            PAL_DBG(LOG_TAG, "adjusted unread size %zu", reader->getUnreadSize());
+            continue;
+        }
         if (reader->unreadSize_ > sz) {
             reader->unreadSize_ -= sz;
             PAL_DBG(LOG_TAG, "adjusted unread size %zu", reader->unreadSize_);
@@ -126,15 +253,47 @@ void PalRingBuffer::getIndices(Stream *s,
     *ftrtSize = kwCfg_[s].ftrtSize;
 }
 
+size_t PalRingBuffer::writeLockFree(void* writeBuffer, size_t writeSize)
+{
+    const std::vector<PalRingBufferReader*> *readers;
+    uint32_t slot = acquireReaderList(&readers);
+    size_t freeSize = getFreeSize(*readers);
+    uint64_t writePos = writePos_.load(std::memory_order_relaxed);
+    size_t offset = writePos % bufferEnd_;
+    size_t sizeToCopy = std::min(writeSize, freeSize);
+    size_t i = std::min(sizeToCopy, bufferEnd_ - offset);
+
+    if (sizeToCopy) {
+        ar_mem_cpy(buffer_ + offset, i, writeBuffer, i);
+        if (sizeToCopy > i)
+            ar_mem_cpy(buffer_, sizeToCopy - i, (char*)writeBuffer + i,
+                       sizeToCopy - i);
+        writePos_.store(writePos + sizeToCopy, std::memory_order_release);
+        /* pairs with the fence in waitForBuffersLockFree */
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    for (auto reader : *readers)
+        reader->notify();
+    releaseReaderList(slot);
+
+    PAL_VERBOSE(LOG_TAG, "written %zu, writePos %llu", sizeToCopy,
+                (unsigned long long)(writePos + sizeToCopy));
+    return sizeToCopy;
+}
+
 size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
 {
-    /* update the unread size for each reader*/
-    size_t freeSize = getFreeSize();
+    if (lockFree_)
+        return writeLockFree(writeBuffer, writeSize);
+
+    size_t freeSize = 0;
     size_t writtenSize = 0;
     size_t i = 0;
     size_t sizeToCopy = 0;
 
     std::lock_guard<std::mutex> lck(mutex_);
+    freeSize = getFreeSize(readers_);
     PAL_DBG(LOG_TAG, "Enter. freeSize(%zu), writeOffset(%zu)", freeSize, writeOffset_);
 
     if (writeSize <= freeSize)
@@ -169,16 +328,18 @@ size_t PalRingBuffer::write(void* writeBuffer, size_t writeSize)
 
 void PalRingBuffer::reset()
 {
-    std::vector<PalRingBufferReader*>::iterator it;
+    std::vector<PalRingBufferReader*> readers;
 
     mutex_.lock();
     kwCfg_.clear();
     writeOffset_ = 0;
+    writePos_.store(0, std::memory_order_release);
+    readers = readers_;
     mutex_.unlock();
 
     /* Reset all the associated readers */
-    for (it = readers_.begin(); it != readers_.end(); it++)
-        (*(it))->reset();
+    for (auto reader : readers)
+        reader->reset();
 }
 
 void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
@@ -191,21 +352,120 @@ void PalRingBuffer::resizeRingBuffer(size_t bufferSize)
     bufferEnd_ = bufferSize;
 }
 
+size_t PalRingBufferReader::getAvailable(uint64_t writePos, uint64_t readPos)
+{
+    size_t avail;
+
+    /* read cursor may be advanced past the writer, e.g. to a keyword start */
+    if (writePos <= readPos)
+        return 0;
+
+    avail = writePos - readPos;
+    /*
+     * A reader that was not enabled does not hold the writer back and may
+     * have been lapped; like the offset based mode, keep reading from the
+     * same position within the ring.
+     */
+    if (avail > ringBuffer_->bufferEnd_)
+        avail = (avail - 1) % ringBuffer_->bufferEnd_ + 1;
+    return avail;
+}
+
+void PalRingBufferReader::notify()
+{
+    uint32_t requested = requestedSize_.load(std::memory_order_acquire);
+    uint64_t val = 1;
+
+    if (eventFd_ < 0 || requested == 0)
+        return;
+
+    if (getUnreadSize() >= requested) {
+        if (::write(eventFd_, &val, sizeof(val)) < 0 && errno != EAGAIN)
+            PAL_ERR(LOG_TAG, "eventfd write failed %s", strerror(errno));
+    }
+}
+
+bool PalRingBufferReader::waitForBuffersLockFree(uint32_t buffer_size)
+{
+    struct pollfd pfd = {};
+    uint64_t val = 0;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::milliseconds(RING_BUFFER_WAIT_TIMEOUT_MS);
+
+    if (state_ != READER_ENABLED)
+        return getUnreadSize() >= buffer_size;
+
+    pfd.fd = eventFd_;
+    pfd.events = POLLIN;
+    requestedSize_.store(buffer_size, std::memory_order_release);
+    /* pairs with the fence in writeLockFree, see PalRingBuffer */
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (getUnreadSize() < buffer_size && state_ == READER_ENABLED && !waitCancelled_) {
+        int timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          deadline - std::chrono::steady_clock::now()).count();
+
+        if (timeout <= 0 || eventFd_ < 0)
+            break;
+        if (poll(&pfd, 1, timeout) > 0)
+            (void)::read(eventFd_, &val, sizeof(val));
+    }
+    requestedSize_.store(0, std::memory_order_release);
+
+    return getUnreadSize() >= buffer_size;
+}
+
 bool PalRingBufferReader::waitForBuffers(uint32_t buffer_size)
 {
+    if (ringBuffer_->lockFree_)
+        return waitForBuffersLockFree(buffer_size);
+
     std::unique_lock<std::mutex> lck(mutex_);
     if (state_ == READER_ENABLED) {
-        if (unreadSize_ >= buffer_size)
-            goto exit;
         requestedSize_ = buffer_size;
-        cv_.wait_for(lck, std::chrono::milliseconds(3000));
+        cv_.wait_for(lck, std::chrono::milliseconds(RING_BUFFER_WAIT_TIMEOUT_MS), [&] {
+            return unreadSize_ >= buffer_size || state_ != READER_ENABLED || waitCancelled_;
+        });
     }
-
-exit:
     requestedSize_ = 0;
     return unreadSize_ >= buffer_size;
 }
 
+void PalRingBufferReader::cancelWait()
+{
+    uint64_t val = 1;
+
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        waitCancelled_ = true;
+        cv_.notify_all();
+    }
+    if (eventFd_ >= 0)
+        (void)::write(eventFd_, &val, sizeof(val));
+}
+
+int32_t PalRingBufferReader::readLockFree(void* readBuffer, size_t bufferSize)
+{
+    uint64_t writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+    uint64_t readPos = readPos_.load(std::memory_order_relaxed);
+    size_t avail = getAvailable(writePos, readPos);
+    size_t readSize = std::min(avail, bufferSize);
+    size_t offset, i;
+
+    if (readSize == 0)
+        return 0;
+
+    readPos = writePos - avail;
+    offset = readPos % ringBuffer_->bufferEnd_;
+    i = std::min(readSize, ringBuffer_->bufferEnd_ - offset);
+    ar_mem_cpy(readBuffer, i, ringBuffer_->buffer_ + offset, i);
+    if (readSize > i)
+        ar_mem_cpy((char *)readBuffer + i, readSize - i, ringBuffer_->buffer_,
+                   readSize - i);
+
+    readPos_.store(readPos + readSize, std::memory_order_release);
+    return readSize;
+}
+
 int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
 {
     int32_t readSize = 0;
@@ -216,12 +476,15 @@ int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
         state_ = READER_ENABLED;
     }
 
+    if (ringBuffer_->lockFree_)
+        return readLockFree(readBuffer, bufferSize);
+
+    std::lock_guard<std::mutex> lck(ringBuffer_->mutex_);
+
     // Return 0 when no data can be read for current reader
     if (unreadSize_ == 0)
         return 0;
 
-    std::lock_guard<std::mutex> lck(ringBuffer_->mutex_);
-
     // when writeOffset leads readOffset
     if (ringBuffer_->writeOffset_ > readOffset_) {
         unreadSize_ = ringBuffer_->writeOffset_ - readOffset_;
@@ -279,10 +542,85 @@ int32_t PalRingBufferReader::read(void* readBuffer, size_t bufferSize)
     return readSize;
 }
 
+int32_t PalRingBufferReader::peek(struct pal_ring_buffer_span spans[PAL_RING_BUFFER_MAX_SPANS])
+{
+    size_t avail, offset, bufferEnd = ringBuffer_->bufferEnd_;
+
+    spans[0] = {nullptr, 0};
+    spans[1] = {nullptr, 0};
+
+    if (state_ == READER_DISABLED) {
+        return -EINVAL;
+    } else if (state_ == READER_PREPARED) {
+        state_ = READER_ENABLED;
+    }
+
+    if (ringBuffer_->lockFree_) {
+        uint64_t writePos = ringBuffer_->writePos_.load(std::memory_order_acquire);
+
+        avail = getAvailable(writePos, readPos_.load(std::memory_order_relaxed));
+        if (avail == 0)
+            return 0;
+        /* pin the cursor to the oldest valid byte if the reader was lapped */
+        readPos_.store(writePos - avail, std::memory_order_release);
+        offset = (writePos - avail) % bufferEnd;
+    } else {
+        std::lock_guard<std::mutex> lck(ringBuffer_->mutex_);
+        if (unreadSize_ == 0)
+            return 0;
+        offset = readOffset_;
+        if (ringBuffer_->writeOffset_ > readOffset_)
+            avail = ringBuffer_->writeOffset_ - readOffset_;
+        else
+            avail = bufferEnd - readOffset_ + ringBuffer_->writeOffset_;
+    }
+
+    spans[0].data = ringBuffer_->buffer_ + offset;
+    spans[0].size = std::min(avail, bufferEnd - offset);
+    if (avail > spans[0].size) {
+        spans[1].data = ringBuffer_->buffer_;
+        spans[1].size = avail - spans[0].size;
+    }
+    return avail;
+}
+
+int32_t PalRingBufferReader::commit(size_t size)
+{
+    size_t avail;
+
+    if (state_ == READER_DISABLED)
+        return -EINVAL;
+
+    if (ringBuffer_->lockFree_) {
+        avail = getUnreadSize();
+        size = std::min(size, avail);
+        readPos_.fetch_add(size, std::memory_order_acq_rel);
+        return size;
+    }
+
+    std::lock_guard<std::mutex> lck(ringBuffer_->mutex_);
+    if (unreadSize_ == 0)
+        return 0;
+    if (ringBuffer_->writeOffset_ > readOffset_)
+        avail = ringBuffer_->writeOffset_ - readOffset_;
+    else
+        avail = ringBuffer_->bufferEnd_ - readOffset_ + ringBuffer_->writeOffset_;
+    size = std::min(size, avail);
+    readOffset_ = (readOffset_ + size) % ringBuffer_->bufferEnd_;
+    unreadSize_ = avail - size;
+    return size;
+}
+
 size_t PalRingBufferReader::advanceReadOffset(size_t advanceSize)
 {
     std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
 
+    if (ringBuffer_->lockFree_) {
+        readPos_.fetch_add(advanceSize, std::memory_order_acq_rel);
+        PAL_INFO(LOG_TAG, "advanced %zu, unread %zu", advanceSize, getUnreadSize());
+        return advanceSize;
+    }
+
     readOffset_ = (readOffset_ + advanceSize) % ringBuffer_->bufferEnd_;
 
     /*
@@ -307,6 +645,12 @@ void PalRingBufferReader::updateState(pal_ring_buffer_reader_state state)
     state_ = state;
 }
 
+bool PalRingBufferReader::isSoleReader()
+{
+    std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
+    return ringBuffer_->readers_.size() == 1;
+}
+
 void PalRingBufferReader::getIndices(Stream *s,
     uint32_t *startIdx, uint32_t *endIdx, uint32_t *ftrtSize)
 {
@@ -315,6 +659,10 @@ void PalRingBufferReader::getIndices(Stream *s,
 
 size_t PalRingBufferReader::getUnreadSize()
 {
+    if (ringBuffer_->lockFree_)
+        return getAvailable(ringBuffer_->writePos_.load(std::memory_order_acquire),
+                            readPos_.load(std::memory_order_acquire));
+
     PAL_VERBOSE(LOG_TAG, "unread size %zu", unreadSize_);
     return unreadSize_;
 }
@@ -329,15 +677,27 @@ void PalRingBufferReader::reset()
     std::lock_guard<std::mutex> lock(ringBuffer_->mutex_);
     readOffset_ = 0;
     unreadSize_ = 0;
+    readPos_.store(0, std::memory_order_release);
     state_ = READER_DISABLED;
     requestedSize_ = 0;
-    cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> lck(mutex_);
+        waitCancelled_ = false;
+        cv_.notify_all();
+    }
+    if (eventFd_ >= 0) {
+        uint64_t val = 1;
+        (void)::write(eventFd_, &val, sizeof(val));
+    }
 }
 
 PalRingBufferReader* PalRingBuffer::newReader()
 {
     PalRingBufferReader* reader =
                   new PalRingBufferReader(this);
+    std::lock_guard<std::mutex> publishLock(publishMutex_);
+    std::unique_lock<std::mutex> lck(mutex_);
     readers_.push_back(reader);
+    publishReaderList(lck);
     return reader;
 }
@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: PalTrace"
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include "PalTrace.h"
+#include "LatencyHistogram.h"
+#include "PalCommon.h"
+
+#define PAL_TRACE_RING_MASK (PAL_TRACE_RING_SIZE - 1)
+
+static const char *phaseNames[PAL_TRACE_PHASE_MAX] = {
+    "stream_open",
+    "stream_start",
+    "stream_set_device",
+    "kv_lookup",
+    "metadata_build",
+    "mixer_write",
+    "pcm_open",
+    "pcm_prepare",
+    "pcm_start",
+    "devswitch_plan",
+    "devswitch_disconnect",
+    "devswitch_connect",
+    "devswitch_total",
+    "sstage_keyword",
+    "sstage_user",
+};
+
+/*
+ * A slot is a seqlock with a single writer, the owner of the ring:
+ * seq is odd while the slot is written and 2 * (event index + 1) once
+ * the event is complete.
+ */
+struct trace_slot {
+    std::atomic<uint64_t> seq;
+    std::atomic<uint64_t> startNs;
+    std::atomic<uint64_t> durNs;
+    std::atomic<uint64_t> tag;
+    std::atomic<uint64_t> tidPhase;
+};
+
+struct trace_ring {
+    std::atomic<uint64_t> head;
+    bool inUse;
+    struct trace_slot slots[PAL_TRACE_RING_SIZE];
+};
+
+struct trace_state {
+    LatencyHistogram *hist[PAL_TRACE_PHASE_MAX];
+    std::mutex lock;
+    std::vector<struct trace_ring *> rings;
+};
+
+/* never freed, threads may record while the process exits */
+static struct trace_state *getState()
+{
+    static struct trace_state *state = [] {
+        struct trace_state *s = new struct trace_state;
+
+        for (int i = 0; i < PAL_TRACE_PHASE_MAX; i++)
+            s->hist[i] = new LatencyHistogram(phaseNames[i]);
+        return s;
+    }();
+
+    return state;
+}
+
+/* attaches a ring to the thread on first use, releases it on thread exit */
+class TraceRingHolder
+{
+public:
+    TraceRingHolder() : mRing(nullptr), mTid(0) {}
+    ~TraceRingHolder()
+    {
+        if (mRing) {
+            std::lock_guard<std::mutex> lock(getState()->lock);
+            mRing->inUse = false;
+        }
+    }
+
+    struct trace_ring *get()
+    {
+        if (!mRing)
+            attach();
+        return mRing;
+    }
+
+    uint32_t getTid() const { return mTid; }
+
+private:
+    void attach()
+    {
+        struct trace_state *state = getState();
+        std::lock_guard<std::mutex> lock(state->lock);
+
+        mTid = (uint32_t)syscall(SYS_gettid);
+        for (auto ring : state->rings) {
+            if (!ring->inUse) {
+                ring->inUse = true;
+                mRing = ring;
+                return;
+            }
+        }
+        mRing = new struct trace_ring();
+        mRing->inUse = true;
+        state->rings.push_back(mRing);
+    }
+
+    struct trace_ring *mRing;
+    uint32_t mTid;
+};
+
+static thread_local TraceRingHolder ringHolder;
+/* phases with an open PalTraceScope on this thread */
+static thread_local uint32_t activePhases = 0;
+
+uint64_t PalTrace::nowNs()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void PalTrace::record(pal_trace_phase_t phase, uint64_t startNs, uint64_t endNs,
+                      uint64_t tag)
+{
+    struct trace_ring *ring = nullptr;
+    struct trace_slot *slot = nullptr;
+    uint64_t durNs = endNs > startNs ? endNs - startNs : 0;
+    uint64_t n;
+
+    if ((uint32_t)phase >= PAL_TRACE_PHASE_MAX)
+        return;
+
+    getState()->hist[phase]->record(durNs / 1000);
+
+    ring = ringHolder.get();
+    n = ring->head.load(std::memory_order_relaxed);
+    slot = &ring->slots[n & PAL_TRACE_RING_MASK];
+
+    slot->seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->startNs.store(startNs, std::memory_order_relaxed);
+    slot->durNs.store(durNs, std::memory_order_relaxed);
+    slot->tag.store(tag, std::memory_order_relaxed);
+    slot->tidPhase.store(((uint64_t)ringHolder.getTid() << 32) | phase,
+                         std::memory_order_relaxed);
+    slot->seq.store(2 * n + 2, std::memory_order_release);
+    ring->head.store(n + 1, std::memory_order_release);
+}
+
+const char *PalTrace::getPhaseName(pal_trace_phase_t phase)
+{
+    if ((uint32_t)phase >= PAL_TRACE_PHASE_MAX)
+        return "unknown";
+    return phaseNames[phase];
+}
+
+void PalTrace::getLatencyStats(pal_param_latency_stats_t *stats)
+{
+    struct trace_state *state = getState();
+    struct latency_histogram_summary s;
+
+    if (!stats)
+        return;
+
+    memset(stats, 0, sizeof(*stats));
+    for (int i = 0; i < PAL_TRACE_PHASE_MAX && i < PAL_MAX_LATENCY_STATS; i++) {
+        pal_latency_stat_t *stat = &stats->stats[i];
+
+        state->hist[i]->getSummary(&s);
+        snprintf(stat->name, sizeof(stat->name), "%s", phaseNames[i]);
+        stat->count = s.count;
+        stat->min_us = s.minUs;
+        stat->mean_us = s.meanUs;
+        stat->p50_us = s.p50Us;
+        stat->p90_us = s.p90Us;
+        stat->p99_us = s.p99Us;
+        stat->max_us = s.maxUs;
+        stats->num_stats++;
+    }
+}
+
+void PalTrace::getEvents(pal_param_latency_trace_t *trace)
+{
+    struct trace_state *state = getState();
+    std::vector<pal_trace_event_t> events;
+    size_t first;
+
+    if (!trace)
+        return;
+
+    memset(trace, 0, sizeof(*trace));
+    {
+        std::lock_guard<std::mutex> lock(state->lock);
+
+        for (auto ring : state->rings) {
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t i = head > PAL_TRACE_RING_SIZE ? head - PAL_TRACE_RING_SIZE : 0;
+
+            for (; i < head; i++) {
+                struct trace_slot *slot = &ring->slots[i & PAL_TRACE_RING_MASK];
+                uint64_t seq = slot->seq.load(std::memory_order_acquire);
+                uint64_t tidPhase;
+                pal_trace_event_t ev;
+
+                /* overwritten since head was read, or being written */
+                if (seq != 2 * i + 2)
+                    continue;
+                ev.start_ns = slot->startNs.load(std::memory_order_relaxed);
+                ev.duration_ns = slot->durNs.load(std::memory_order_relaxed);
+                ev.tag = slot->tag.load(std::memory_order_relaxed);
+                tidPhase = slot->tidPhase.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot->seq.load(std::memory_order_relaxed) != seq)
+                    continue;
+                ev.phase = (uint32_t)tidPhase;
+                ev.tid = (uint32_t)(tidPhase >> 32);
+                events.push_back(ev);
+            }
+        }
+    }
+
+    std::sort(events.begin(), events.end(),
+              [](const pal_trace_event_t &a, const pal_trace_event_t &b) {
+                  return a.start_ns < b.start_ns;
+              });
+    first = events.size() > PAL_MAX_TRACE_EVENTS ? events.size() - PAL_MAX_TRACE_EVENTS : 0;
+    for (size_t i = first; i < events.size(); i++)
+        trace->events[trace->num_events++] = events[i];
+}
+
+PalTraceScope::PalTraceScope(pal_trace_phase_t phase, uint64_t tag)
+    : mPhase(phase), mTag(tag), mStartNs(0), mOutermost(false)
+{
+    if (!(activePhases & (1U << phase))) {
+        activePhases |= 1U << phase;
+        mOutermost = true;
+        mStartNs = PalTrace::nowNs();
+    }
+}
+
+PalTraceScope::~PalTraceScope()
+{
+    /* callers read errno of the traced call after the scope ends */
+    int err = errno;
+
+    if (!mOutermost)
+        return;
+    PalTrace::record(mPhase, mStartNs, PalTrace::nowNs(), mTag);
+    activePhases &= ~(1U << mPhase);
+    errno = err;
+}
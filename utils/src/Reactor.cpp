@@ -0,0 +1,428 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: Reactor"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include "Reactor.h"
+#include "PalCommon.h"
+
+#define REACTOR_MAX_EVENTS 16
+/* epoll data of the internal wake eventfd, handles start at 1 */
+#define REACTOR_WAKE_HANDLE 0
+
+std::mutex Reactor::mInstanceLock;
+std::shared_ptr<Reactor> Reactor::mInstance = nullptr;
+
+/* handle whose callback the current worker is running, 0 if none */
+static thread_local int currentHandle = 0;
+
+std::shared_ptr<Reactor> Reactor::getInstance()
+{
+    std::lock_guard<std::mutex> lock(mInstanceLock);
+
+    if (!mInstance) {
+        std::shared_ptr<Reactor> reactor(new Reactor());
+
+        if (reactor->init()) {
+            PAL_ERR(LOG_TAG, "failed to start reactor");
+            return nullptr;
+        }
+        mInstance = reactor;
+    }
+    return mInstance;
+}
+
+Reactor::Reactor()
+    : mEpollFd(-1), mWakeFd(-1), mNextHandle(1), mExit(false), mBlockingIdle(0)
+{
+}
+
+int Reactor::init()
+{
+    struct epoll_event ev = {};
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpollFd < 0) {
+        PAL_ERR(LOG_TAG, "epoll_create1 failed, %s", strerror(errno));
+        return -errno;
+    }
+
+    mWakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mWakeFd < 0) {
+        PAL_ERR(LOG_TAG, "eventfd failed, %s", strerror(errno));
+        return -errno;
+    }
+
+    ev.events = EPOLLIN;
+    ev.data.u64 = REACTOR_WAKE_HANDLE;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev)) {
+        PAL_ERR(LOG_TAG, "failed to add wake fd, %s", strerror(errno));
+        return -errno;
+    }
+
+    mDispatcher = std::thread(&Reactor::dispatchLoop, this);
+    for (int i = 0; i < REACTOR_NUM_WORKERS; i++)
+        mWorkers.emplace_back(&Reactor::workerLoop, this, false);
+
+    PAL_INFO(LOG_TAG, "reactor started with %d workers", REACTOR_NUM_WORKERS);
+    return 0;
+}
+
+Reactor::~Reactor()
+{
+    uint64_t val = 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWorkCv.notify_all();
+    mBlockingCv.notify_all();
+    if (mWakeFd >= 0 && write(mWakeFd, &val, sizeof(val)) < 0)
+        PAL_ERR(LOG_TAG, "failed to wake dispatcher, %s", strerror(errno));
+
+    if (mDispatcher.joinable())
+        mDispatcher.join();
+    for (auto &worker : mWorkers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    /* no worker retires once mExit is set */
+    for (auto &worker : mBlockingWorkers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    for (auto &worker : mRetiredWorkers) {
+        if (worker.joinable())
+            worker.join();
+    }
+
+    for (auto &iter : mRegs) {
+        if (iter.second->type != REG_FD)
+            close(iter.second->fd);
+    }
+    if (mWakeFd >= 0)
+        close(mWakeFd);
+    if (mEpollFd >= 0)
+        close(mEpollFd);
+}
+
+int Reactor::add(int fd, reg_type type, uint32_t events, callback_t cb, bool blocking)
+{
+    std::shared_ptr<struct registration> reg(new struct registration);
+    struct epoll_event ev = {};
+
+    if (fd < 0 || !cb)
+        return -EINVAL;
+
+    std::lock_guard<std::mutex> lock(mLock);
+
+    reg->handle = mNextHandle++;
+    reg->fd = fd;
+    reg->type = type;
+    reg->events = events;
+    reg->cb = cb;
+    reg->blocking = blocking;
+    reg->running = false;
+    reg->removed = false;
+
+    /* one shot, re-armed once the callback returns, see run() */
+    ev.events = events | EPOLLONESHOT;
+    ev.data.u64 = reg->handle;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev)) {
+        PAL_ERR(LOG_TAG, "failed to add fd %d, %s", fd, strerror(errno));
+        return -errno;
+    }
+    mRegs[reg->handle] = reg;
+
+    PAL_DBG(LOG_TAG, "fd %d type %d blocking %d registered as %d", fd, type, blocking,
+            reg->handle);
+    return reg->handle;
+}
+
+int Reactor::addFd(int fd, uint32_t events, callback_t cb, bool blocking)
+{
+    return add(fd, REG_FD, events, cb, blocking);
+}
+
+int Reactor::addTimer(callback_t cb, bool blocking)
+{
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    int handle;
+
+    if (fd < 0) {
+        PAL_ERR(LOG_TAG, "timerfd_create failed, %s", strerror(errno));
+        return -errno;
+    }
+
+    handle = add(fd, REG_TIMER, EPOLLIN, cb, blocking);
+    if (handle < 0)
+        close(fd);
+    return handle;
+}
+
+int Reactor::addEvent(callback_t cb, bool blocking)
+{
+    int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    int handle;
+
+    if (fd < 0) {
+        PAL_ERR(LOG_TAG, "eventfd failed, %s", strerror(errno));
+        return -errno;
+    }
+
+    handle = add(fd, REG_EVENT, EPOLLIN, cb, blocking);
+    if (handle < 0)
+        close(fd);
+    return handle;
+}
+
+std::shared_ptr<struct Reactor::registration> Reactor::find(int handle)
+{
+    auto iter = mRegs.find(handle);
+
+    if (iter == mRegs.end())
+        return nullptr;
+    return iter->second;
+}
+
+int Reactor::armTimer(int handle, uint32_t delayMs)
+{
+    struct itimerspec spec = {};
+    std::shared_ptr<struct registration> reg = nullptr;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    reg = find(handle);
+    if (!reg || reg->type != REG_TIMER)
+        return -EINVAL;
+
+    spec.it_value.tv_sec = delayMs / 1000;
+    spec.it_value.tv_nsec = (delayMs % 1000) * 1000000L;
+    /* an all zero it_value would disarm the timer instead */
+    if (!delayMs)
+        spec.it_value.tv_nsec = 1;
+
+    if (timerfd_settime(reg->fd, 0, &spec, NULL)) {
+        PAL_ERR(LOG_TAG, "failed to arm timer %d, %s", handle, strerror(errno));
+        return -errno;
+    }
+    return 0;
+}
+
+int Reactor::disarmTimer(int handle)
+{
+    struct itimerspec spec = {};
+    std::shared_ptr<struct registration> reg = nullptr;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    reg = find(handle);
+    if (!reg || reg->type != REG_TIMER)
+        return -EINVAL;
+
+    /* also drops an expiry that is queued but not yet handled */
+    if (timerfd_settime(reg->fd, 0, &spec, NULL)) {
+        PAL_ERR(LOG_TAG, "failed to disarm timer %d, %s", handle, strerror(errno));
+        return -errno;
+    }
+    return 0;
+}
+
+int Reactor::signal(int handle)
+{
+    uint64_t val = 1;
+    std::shared_ptr<struct registration> reg = nullptr;
+
+    std::lock_guard<std::mutex> lock(mLock);
+    reg = find(handle);
+    if (!reg || reg->type != REG_EVENT)
+        return -EINVAL;
+
+    if (write(reg->fd, &val, sizeof(val)) < 0) {
+        PAL_ERR(LOG_TAG, "failed to signal %d, %s", handle, strerror(errno));
+        return -errno;
+    }
+    return 0;
+}
+
+int Reactor::remove(int handle)
+{
+    std::shared_ptr<struct registration> reg = nullptr;
+
+    std::unique_lock<std::mutex> lock(mLock);
+    reg = find(handle);
+    if (!reg)
+        return -EINVAL;
+
+    reg->removed = true;
+    mRegs.erase(handle);
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, reg->fd, NULL);
+    if (currentHandle != handle)
+        mRemoveCv.wait(lock, [&reg] { return !reg->running; });
+    /* a callback removing itself does not touch its fd once it returns */
+    if (reg->type != REG_FD)
+        close(reg->fd);
+
+    PAL_DBG(LOG_TAG, "handle %d removed", handle);
+    return 0;
+}
+
+void Reactor::dispatchLoop()
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    std::shared_ptr<struct registration> reg = nullptr;
+    uint64_t val;
+    int num;
+
+    PAL_DBG(LOG_TAG, "Enter");
+    while (1) {
+        num = epoll_wait(mEpollFd, events, REACTOR_MAX_EVENTS, -1);
+        if (num < 0) {
+            if (errno == EINTR)
+                continue;
+            PAL_ERR(LOG_TAG, "epoll_wait failed, %s", strerror(errno));
+            break;
+        }
+
+        std::lock_guard<std::mutex> lock(mLock);
+        if (mExit)
+            break;
+        for (int i = 0; i < num; i++) {
+            if (events[i].data.u64 == REACTOR_WAKE_HANDLE) {
+                if (read(mWakeFd, &val, sizeof(val)) < 0 && errno != EAGAIN)
+                    PAL_ERR(LOG_TAG, "failed to read wake fd, %s", strerror(errno));
+                continue;
+            }
+            reg = find((int)events[i].data.u64);
+            if (!reg)
+                continue;
+            if (reg->blocking)
+                mBlockingWork.emplace_back(reg->handle, (uint32_t)events[i].events);
+            else
+                mWork.emplace_back(reg->handle, (uint32_t)events[i].events);
+        }
+        reg = nullptr;
+        if (!mRetiredWorkers.empty())
+            joinRetiredWorkers_l();
+        if (!mWork.empty())
+            mWorkCv.notify_all();
+        if (!mBlockingWork.empty()) {
+            /* queued blocking callbacks get a worker each, up to the cap */
+            while (mBlockingIdle < mBlockingWork.size() &&
+                   mBlockingWorkers.size() < REACTOR_MAX_BLOCKING_WORKERS) {
+                mBlockingWorkers.emplace_back(&Reactor::workerLoop, this, true);
+                mBlockingIdle++;
+                PAL_INFO(LOG_TAG, "blocking lane grown to %zu workers",
+                         mBlockingWorkers.size());
+            }
+            mBlockingCv.notify_all();
+        }
+    }
+    PAL_DBG(LOG_TAG, "Exit");
+}
+
+void Reactor::run(int handle, uint32_t events)
+{
+    std::shared_ptr<struct registration> reg = nullptr;
+    struct epoll_event ev = {};
+    uint64_t val;
+    bool fire = true;
+
+    std::unique_lock<std::mutex> lock(mLock);
+    reg = find(handle);
+    if (!reg)
+        return;
+    reg->running = true;
+    lock.unlock();
+
+    /* nothing to read means the timer was disarmed after it expired */
+    if (reg->type != REG_FD && read(reg->fd, &val, sizeof(val)) < 0)
+        fire = false;
+
+    if (fire) {
+        currentHandle = handle;
+        reg->cb(events);
+        currentHandle = 0;
+    }
+
+    lock.lock();
+    reg->running = false;
+    if (reg->removed) {
+        mRemoveCv.notify_all();
+        return;
+    }
+    ev.events = reg->events | EPOLLONESHOT;
+    ev.data.u64 = handle;
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_MOD, reg->fd, &ev))
+        PAL_ERR(LOG_TAG, "failed to re-arm %d, %s", handle, strerror(errno));
+}
+
+void Reactor::workerLoop(bool blocking)
+{
+    std::condition_variable &cv = blocking ? mBlockingCv : mWorkCv;
+    std::deque<std::pair<int, uint32_t>> &queue = blocking ? mBlockingWork : mWork;
+    auto ready = [this, &queue] { return mExit || !queue.empty(); };
+    std::pair<int, uint32_t> work;
+
+    std::unique_lock<std::mutex> lock(mLock);
+    while (1) {
+        if (!blocking) {
+            cv.wait(lock, ready);
+        } else if (!cv.wait_for(lock, std::chrono::milliseconds(REACTOR_BLOCKING_IDLE_MS),
+                                ready)) {
+            retireBlockingWorker_l();
+            break;
+        }
+        if (mExit)
+            break;
+        work = queue.front();
+        queue.pop_front();
+        if (blocking)
+            mBlockingIdle--;
+        lock.unlock();
+        run(work.first, work.second);
+        lock.lock();
+        if (blocking)
+            mBlockingIdle++;
+    }
+}
+
+/* called with mLock held by an idle blocking worker that is about to exit */
+void Reactor::retireBlockingWorker_l()
+{
+    std::thread::id self = std::this_thread::get_id();
+    uint64_t val = 1;
+
+    mBlockingIdle--;
+    for (auto iter = mBlockingWorkers.begin(); iter != mBlockingWorkers.end(); iter++) {
+        if (iter->get_id() == self) {
+            mRetiredWorkers.push_back(std::move(*iter));
+            mBlockingWorkers.erase(iter);
+            break;
+        }
+    }
+    /* for the dispatcher to join this thread */
+    if (write(mWakeFd, &val, sizeof(val)) < 0)
+        PAL_ERR(LOG_TAG, "failed to wake dispatcher, %s", strerror(errno));
+    PAL_INFO(LOG_TAG, "blocking lane shrunk to %zu workers", mBlockingWorkers.size());
+}
+
+/*
+ * Retired workers only have to return after dropping mLock, so joining
+ * them with mLock held does not wait on anything that needs it.
+ */
+void Reactor::joinRetiredWorkers_l()
+{
+    for (auto &worker : mRetiredWorkers) {
+        if (worker.joinable())
+            worker.join();
+    }
+    mRetiredWorkers.clear();
+}
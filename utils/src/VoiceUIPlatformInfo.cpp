@@ -75,7 +75,11 @@ VUISecondStageConfig::VUISecondStageConfig() :
     module_lib_(""),
     sample_rate_(16000),
     bit_width_(16),
-    channels_(1)
+    channels_(1),
+    early_decision_(false),
+    early_reject_margin_(0),
+    early_reject_after_kw_end_(0),
+    read_only_input_(false)
 {
 }
 
@@ -105,6 +109,14 @@ void VUISecondStageConfig::HandleStartTag(const char *tag, const char **attribs)
                 bit_width_ = std::stoi(attribs[++i]);
             } else if (!strcmp(attribs[i], "channel_count")) {
                 channels_ = std::stoi(attribs[++i]);
+            } else if (!strcmp(attribs[i], "early_decision")) {
+                early_decision_ = !strcmp(attribs[++i], "true");
+            } else if (!strcmp(attribs[i], "early_reject_margin")) {
+                early_reject_margin_ = std::stoi(attribs[++i]);
+            } else if (!strcmp(attribs[i], "early_reject_after_kw_end")) {
+                early_reject_after_kw_end_ = std::stoi(attribs[++i]);
+            } else if (!strcmp(attribs[i], "read_only_input")) {
+                read_only_input_ = !strcmp(attribs[++i], "true");
             }
             ++i;
         }
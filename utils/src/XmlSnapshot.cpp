@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2024 Qualcomm Innovation Center, Inc. All rights reserved.
+ * SPDX-License-Identifier: BSD-3-Clause-Clear
+ */
+
+#define LOG_TAG "PAL: XmlSnapshot"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "XmlSnapshot.h"
+#include "PalCommon.h"
+
+#define FNV_OFFSET_BASIS_64 0xcbf29ce484222325ULL
+#define FNV_PRIME_64        0x100000001b3ULL
+
+uint64_t XmlSnapshot::hash(const uint8_t *buf, size_t size, uint64_t seed)
+{
+    uint64_t h = seed ? seed : FNV_OFFSET_BASIS_64;
+
+    for (size_t i = 0; i < size; i++) {
+        h ^= buf[i];
+        h *= FNV_PRIME_64;
+    }
+    return h;
+}
+
+std::string XmlSnapshot::getSnapshotPath(const std::string &xmlFile)
+{
+    size_t pos = xmlFile.find_last_of('/');
+    std::string name = (pos == std::string::npos) ? xmlFile : xmlFile.substr(pos + 1);
+
+    return std::string(PAL_XML_SNAPSHOT_DIR) + "/" + name + XML_SNAPSHOT_EXT;
+}
+
+uint32_t XmlSnapshot::addString(struct recorder *rec, const char *s, size_t len)
+{
+    uint32_t off = rec->strings.size();
+
+    rec->strings.insert(rec->strings.end(), s, s + len);
+    rec->strings.push_back('\0');
+    return off;
+}
+
+void XmlSnapshot::recordStart(void *userdata, const XML_Char *tag_name,
+                              const XML_Char **attr)
+{
+    struct recorder *rec = (struct recorder *)userdata;
+    xml_snapshot_event_t evt = {};
+
+    evt.type = XML_SNAPSHOT_EVT_START;
+    evt.str_off = addString(rec, tag_name, strlen(tag_name));
+    evt.attr_idx = rec->attrs.size();
+    for (int i = 0; attr[i]; i++) {
+        rec->attrs.push_back(addString(rec, attr[i], strlen(attr[i])));
+        evt.len++;
+    }
+    rec->events.push_back(evt);
+
+    rec->startTag(rec->userdata, tag_name, attr);
+}
+
+void XmlSnapshot::recordEnd(void *userdata, const XML_Char *tag_name)
+{
+    struct recorder *rec = (struct recorder *)userdata;
+    xml_snapshot_event_t evt = {};
+
+    evt.type = XML_SNAPSHOT_EVT_END;
+    evt.str_off = addString(rec, tag_name, strlen(tag_name));
+    rec->events.push_back(evt);
+
+    rec->endTag(rec->userdata, tag_name);
+}
+
+void XmlSnapshot::recordData(void *userdata, const XML_Char *s, int len)
+{
+    struct recorder *rec = (struct recorder *)userdata;
+    xml_snapshot_event_t evt = {};
+
+    evt.type = XML_SNAPSHOT_EVT_DATA;
+    evt.str_off = addString(rec, s, len);
+    evt.len = len;
+    rec->events.push_back(evt);
+
+    rec->dataHandler(rec->userdata, s, len);
+}
+
+int XmlSnapshot::parseXml(const uint8_t *xml, size_t size, struct recorder *rec)
+{
+    XML_Parser parser;
+    int ret = 0;
+
+    parser = XML_ParserCreate(NULL);
+    if (!parser) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "Failed to create XML ret %d", ret);
+        return ret;
+    }
+
+    XML_SetUserData(parser, rec);
+    XML_SetElementHandler(parser, recordStart, recordEnd);
+    XML_SetCharacterDataHandler(parser, recordData);
+
+    if (XML_Parse(parser, (const char *)xml, size, 1) == XML_STATUS_ERROR) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "XML parse failed at line %lu: %s",
+                (unsigned long)XML_GetCurrentLineNumber(parser),
+                XML_ErrorString(XML_GetErrorCode(parser)));
+    }
+
+    XML_ParserFree(parser);
+    return ret;
+}
+
+int XmlSnapshot::replay(const std::string &snapFile, const struct stat &xmlStat,
+                        uint64_t xmlHash, void *userdata,
+                        XML_StartElementHandler startTag,
+                        XML_EndElementHandler endTag,
+                        XML_CharacterDataHandler dataHandler)
+{
+    int fd, ret = 0;
+    struct stat st;
+    uint8_t *base = NULL;
+    const xml_snapshot_header_t *hdr;
+    const xml_snapshot_event_t *events;
+    const uint32_t *attrs;
+    const char *strings;
+    size_t bodySize;
+    std::vector<const XML_Char *> attrPtrs;
+
+    fd = open(snapFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -ENOENT;
+
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(xml_snapshot_header_t)) {
+        ret = -EINVAL;
+        goto closeFd;
+    }
+
+    /*
+     * Writable private mapping: some handlers strtok_r() their attributes
+     * in place, those pages get copied on write and the file is untouched.
+     */
+    base = (uint8_t *)mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        base = NULL;
+        ret = -errno;
+        goto closeFd;
+    }
+
+    hdr = (const xml_snapshot_header_t *)base;
+    if (hdr->magic != XML_SNAPSHOT_MAGIC || hdr->version != XML_SNAPSHOT_VERSION ||
+        hdr->xml_size != (uint64_t)xmlStat.st_size ||
+        hdr->xml_mtime_sec != (int64_t)xmlStat.st_mtim.tv_sec ||
+        hdr->xml_mtime_nsec != (int64_t)xmlStat.st_mtim.tv_nsec ||
+        hdr->xml_hash != xmlHash) {
+        PAL_INFO(LOG_TAG, "snapshot %s is stale", snapFile.c_str());
+        ret = -ESTALE;
+        goto unmap;
+    }
+
+    bodySize = (size_t)hdr->num_events * sizeof(xml_snapshot_event_t) +
+               (size_t)hdr->num_attrs * sizeof(uint32_t) + hdr->strings_size;
+    if (bodySize != st.st_size - sizeof(xml_snapshot_header_t) || hdr->strings_size == 0 ||
+        hdr->body_hash != hash(base + sizeof(*hdr), bodySize, 0)) {
+        PAL_ERR(LOG_TAG, "snapshot %s is corrupt", snapFile.c_str());
+        ret = -EINVAL;
+        goto unmap;
+    }
+
+    events = (const xml_snapshot_event_t *)(base + sizeof(*hdr));
+    attrs = (const uint32_t *)(events + hdr->num_events);
+    strings = (const char *)(attrs + hdr->num_attrs);
+    if (strings[hdr->strings_size - 1] != '\0') {
+        ret = -EINVAL;
+        goto unmap;
+    }
+
+    /* validate everything up front so a bad file never replays half way */
+    for (uint32_t i = 0; i < hdr->num_events; i++) {
+        const xml_snapshot_event_t &evt = events[i];
+
+        if (evt.str_off >= hdr->strings_size ||
+            (evt.type == XML_SNAPSHOT_EVT_DATA &&
+             (uint64_t)evt.str_off + evt.len >= hdr->strings_size) ||
+            (evt.type == XML_SNAPSHOT_EVT_START &&
+             (uint64_t)evt.attr_idx + evt.len > hdr->num_attrs) ||
+            evt.type > XML_SNAPSHOT_EVT_DATA) {
+            ret = -EINVAL;
+            goto unmap;
+        }
+    }
+    for (uint32_t i = 0; i < hdr->num_attrs; i++) {
+        if (attrs[i] >= hdr->strings_size) {
+            ret = -EINVAL;
+            goto unmap;
+        }
+    }
+
+    for (uint32_t i = 0; i < hdr->num_events; i++) {
+        const xml_snapshot_event_t &evt = events[i];
+
+        switch (evt.type) {
+        case XML_SNAPSHOT_EVT_START:
+            attrPtrs.clear();
+            for (uint32_t j = 0; j < evt.len; j++)
+                attrPtrs.push_back(strings + attrs[evt.attr_idx + j]);
+            attrPtrs.push_back(NULL);
+            startTag(userdata, strings + evt.str_off, attrPtrs.data());
+            break;
+        case XML_SNAPSHOT_EVT_END:
+            endTag(userdata, strings + evt.str_off);
+            break;
+        case XML_SNAPSHOT_EVT_DATA:
+            dataHandler(userdata, strings + evt.str_off, evt.len);
+            break;
+        }
+    }
+
+unmap:
+    munmap(base, st.st_size);
+closeFd:
+    close(fd);
+    return ret;
+}
+
+int XmlSnapshot::write(const std::string &snapFile, const struct stat &xmlStat,
+                       uint64_t xmlHash, struct recorder *rec)
+{
+    int ret = 0;
+    FILE *fp = NULL;
+    xml_snapshot_header_t hdr = {};
+    std::string tmpFile = snapFile + ".tmp";
+    size_t eventsSize = rec->events.size() * sizeof(xml_snapshot_event_t);
+    size_t attrsSize = rec->attrs.size() * sizeof(uint32_t);
+
+    hdr.magic = XML_SNAPSHOT_MAGIC;
+    hdr.version = XML_SNAPSHOT_VERSION;
+    hdr.xml_size = xmlStat.st_size;
+    hdr.xml_mtime_sec = xmlStat.st_mtim.tv_sec;
+    hdr.xml_mtime_nsec = xmlStat.st_mtim.tv_nsec;
+    hdr.xml_hash = xmlHash;
+    hdr.num_events = rec->events.size();
+    hdr.num_attrs = rec->attrs.size();
+    hdr.strings_size = rec->strings.size();
+    hdr.body_hash = hash((const uint8_t *)rec->events.data(), eventsSize, 0);
+    hdr.body_hash = hash((const uint8_t *)rec->attrs.data(), attrsSize, hdr.body_hash);
+    hdr.body_hash = hash((const uint8_t *)rec->strings.data(), rec->strings.size(),
+                         hdr.body_hash);
+
+    fp = fopen(tmpFile.c_str(), "wb");
+    if (!fp) {
+        ret = -errno;
+        PAL_DBG(LOG_TAG, "cannot create %s, ret %d", tmpFile.c_str(), ret);
+        return ret;
+    }
+
+    if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1 ||
+        (eventsSize && fwrite(rec->events.data(), eventsSize, 1, fp) != 1) ||
+        (attrsSize && fwrite(rec->attrs.data(), attrsSize, 1, fp) != 1) ||
+        (rec->strings.size() && fwrite(rec->strings.data(), rec->strings.size(), 1, fp) != 1) ||
+        fflush(fp) || fsync(fileno(fp))) {
+        ret = -EIO;
+    }
+    fclose(fp);
+
+    if (!ret && rename(tmpFile.c_str(), snapFile.c_str()))
+        ret = -errno;
+    if (ret) {
+        PAL_ERR(LOG_TAG, "failed to write snapshot %s, ret %d", snapFile.c_str(), ret);
+        unlink(tmpFile.c_str());
+    }
+    return ret;
+}
+
+int XmlSnapshot::parse(const std::string &xmlFile, void *userdata,
+                       XML_StartElementHandler startTag,
+                       XML_EndElementHandler endTag,
+                       XML_CharacterDataHandler dataHandler)
+{
+    int fd, ret = 0;
+    struct stat st;
+    uint8_t *xml = NULL;
+    uint64_t xmlHash;
+    struct recorder rec;
+    std::string snapFile = getSnapshotPath(xmlFile);
+
+    fd = open(xmlFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ret = -ENOENT;
+        PAL_ERR(LOG_TAG, "Failed to open xml file name %s ret %d", xmlFile.c_str(), ret);
+        return ret;
+    }
+
+    if (fstat(fd, &st) || st.st_size == 0) {
+        ret = -EINVAL;
+        PAL_ERR(LOG_TAG, "invalid xml file %s", xmlFile.c_str());
+        goto closeFd;
+    }
+
+    xml = (uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (xml == MAP_FAILED) {
+        ret = -errno;
+        PAL_ERR(LOG_TAG, "mmap of %s failed ret %d", xmlFile.c_str(), ret);
+        goto closeFd;
+    }
+
+    xmlHash = hash(xml, st.st_size, 0);
+    if (!replay(snapFile, st, xmlHash, userdata, startTag, endTag, dataHandler)) {
+        PAL_INFO(LOG_TAG, "%s loaded from snapshot", xmlFile.c_str());
+        goto unmap;
+    }
+
+    rec.userdata = userdata;
+    rec.startTag = startTag;
+    rec.endTag = endTag;
+    rec.dataHandler = dataHandler;
+    ret = parseXml(xml, st.st_size, &rec);
+    if (ret) {
+        PAL_ERR(LOG_TAG, "XML parsing failed for %s file ret %d", xmlFile.c_str(), ret);
+        goto unmap;
+    }
+    write(snapFile, st, xmlHash, &rec);
+
+unmap:
+    munmap(xml, st.st_size);
+closeFd:
+    close(fd);
+    return ret;
+}